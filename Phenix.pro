@@ -10,10 +10,14 @@ MOC_DIR=moc
 #Just something to add our exe icon
 RC_FILE = myapp.rc
 CONFIG-=app_bundle
+CONFIG+=c++11
 QT+=gui opengl core
 SOURCES += \
     src/gl/Camera.cpp \
-    #src/common/HDRLoader.cpp \
+    src/common/HDRLoader.cpp \
+    src/common/AutoExposure.cpp \
+    src/common/RobustAccumulator.cpp \
+    src/common/ImageExporter.cpp \
     src/ui/mainwindow.cpp \
     src/ui/OpenGLWidget.cpp \
     src/renderer/PathTraceCamera.cpp \
@@ -21,6 +25,8 @@ SOURCES += \
     src/gl/ShaderProgram.cpp \
     src/gl/ShaderUtils.cpp \
     src/gl/Text.cpp \
+    src/gl/FrameGraph.cpp \
+    src/gl/TextureStreamer.cpp \
     src/gl/Texture.cpp \
     src/gl/TextureLoader.cpp \
     src/gl/TextureUtils.cpp \
@@ -33,7 +39,22 @@ SOURCES += \
     src/geometry/Mesh.cpp \
     src/ui/InspectorMenu.cpp \
     src/ui/OptixQListWidgetItem.cpp \
-    src/ui/GeometryAttribEditor.cpp
+    src/ui/GeometryAttribEditor.cpp \
+    src/renderer/FrameHandoff.cpp \
+    src/renderer/SceneEditQueue.cpp \
+    src/renderer/RenderThread.cpp \
+    src/renderer/Checkpoint.cpp \
+    src/renderer/Film.cpp \
+    src/perf/PerfMetrics.cpp \
+    src/perf/TraceEvents.cpp \
+    src/perf/RenderBenchmark.cpp \
+    src/perf/ImageError.cpp \
+    src/perf/SceneGenerator.cpp \
+    src/perf/ScalingBenchmark.cpp \
+    src/perf/InteractionRecorder.cpp \
+    src/perf/InteractionReplay.cpp \
+    src/perf/LatencyTracker.cpp \
+    src/perf/CostMap.cpp
     #src/lights/Light.cpp \
     #src/lights/LightManager.cpp
 
@@ -41,7 +62,7 @@ SOURCES += \
 
 HEADERS += \
     include/gl/Camera.h \
-    #include/common/HDRLoader.h \
+    include/common/HDRLoader.h \
     include/ui/mainwindow.h \
     include/ui/OpenGLWidget.h \
     include/renderer/PathTraceCamera.h \
@@ -50,10 +71,21 @@ HEADERS += \
     include/gl/ShaderProgram.h \
     include/gl/ShaderUtils.h \
     include/gl/Text.h \
+    include/gl/FrameGraph.h \
+    include/gl/TextureStreamer.h \
     include/gl/Texture.h \
     include/gl/TextureLoader.h \
     include/gl/TextureUtils.h \
     include/common/helpers.h \
+    include/common/intersect.h \
+    include/common/cost.h \
+    include/common/path_stats.h \
+    include/common/film_filter.h \
+    include/common/accumulate.h \
+    include/common/AutoExposure.h \
+    include/common/RobustAccumulator.h \
+    include/common/ParallelFor.h \
+    include/common/ImageExporter.h \
     #include/lights/Light.h \
     #include/lights/LightManager.h
     include/common/AbstractOptixObject.h \
@@ -66,7 +98,22 @@ HEADERS += \
     include/geometry/Mesh.h \
     include/ui/InspectorMenu.h \
     include/ui/OptixQListWidgetItem.h \
-    include/ui/GeometryAttribEditor.h
+    include/ui/GeometryAttribEditor.h \
+    include/renderer/FrameHandoff.h \
+    include/renderer/SceneEditQueue.h \
+    include/renderer/RenderThread.h \
+    include/renderer/Checkpoint.h \
+    include/renderer/Film.h \
+    include/perf/PerfMetrics.h \
+    include/perf/TraceEvents.h \
+    include/perf/RenderBenchmark.h \
+    include/perf/ImageError.h \
+    include/perf/SceneGenerator.h \
+    include/perf/ScalingBenchmark.h \
+    include/perf/InteractionRecorder.h \
+    include/perf/InteractionReplay.h \
+    include/perf/LatencyTracker.h \
+    include/perf/CostMap.h
 
 
 INCLUDEPATH +=./include
@@ -82,6 +129,50 @@ unix:QMAKE_CXXFLAGS_WARN_ON += "-Wno-unused-parameter"
 QMAKE_CXXFLAGS+= -msse -msse2 -msse3
 macx:QMAKE_CXXFLAGS+= -arch x86_64
 macx:INCLUDEPATH+=/usr/local/include/
+
+# "make bench" runs our render benchmark headless and writes its results to bench_results.json
+bench.target = bench
+bench.depends = $$TARGET
+bench.commands = ./$$TARGET --bench bench_results.json
+QMAKE_EXTRA_TARGETS += bench
+
+# "make convergence" records error against render time curves of our benchmark scenes to convergence.csv
+convergence.target = convergence
+convergence.depends = $$TARGET
+convergence.commands = ./$$TARGET --convergence convergence.csv
+QMAKE_EXTRA_TARGETS += convergence
+
+# "make scaling" sweeps procedurally generated scenes up to 100M triangles and 10k lights, writing scaling.csv
+scaling.target = scaling
+scaling.depends = $$TARGET
+scaling.commands = ./$$TARGET --scaling scaling.csv
+QMAKE_EXTRA_TARGETS += scaling
+
+# "make intersect_bench" builds and runs our host side intersection microbenchmarks in bench/
+intersect_bench.target = intersect_bench
+intersect_bench.commands = cd $$PWD/bench && $$QMAKE_QMAKE IntersectBench.pro && $(MAKE) && ./IntersectBench
+QMAKE_EXTRA_TARGETS += intersect_bench
+
+# "make cost_map" builds and runs our CPU cost heat maps of our cornell box in bench/, and checks our tiled CPU film
+cost_map.target = cost_map
+cost_map.commands = cd $$PWD/bench && $$QMAKE_QMAKE CostMapTool.pro && $(MAKE) && ./CostMapTool --filter=gaussian
+QMAKE_EXTRA_TARGETS += cost_map
+
+# "make accumulate_bench" builds and runs our CPU check of how precisely we accumulate frames and clamp fireflies in bench/
+accumulate_bench.target = accumulate_bench
+accumulate_bench.commands = cd $$PWD/bench && $$QMAKE_QMAKE AccumulateBench.pro && $(MAKE) && ./AccumulateBench
+QMAKE_EXTRA_TARGETS += accumulate_bench
+
+# "make auto_exposure_check" builds and runs our check of our SSE luminance measurement and CPU resolve in bench/
+auto_exposure_check.target = auto_exposure_check
+auto_exposure_check.commands = cd $$PWD/bench && $$QMAKE_QMAKE AutoExposureCheck.pro && $(MAKE) && ./AutoExposureCheck
+QMAKE_EXTRA_TARGETS += auto_exposure_check
+
+# "make texture_streamer_check" builds and runs our check of our texture streaming on Mesa's software OpenGL in bench/
+texture_streamer_check.target = texture_streamer_check
+texture_streamer_check.commands = cd $$PWD/bench && $$QMAKE_QMAKE TextureStreamerCheck.pro && $(MAKE) && LIBGL_ALWAYS_SOFTWARE=1 ./TextureStreamerCheck
+QMAKE_EXTRA_TARGETS += texture_streamer_check
+
 # define the _DEBUG flag for the graphics lib
 
 unix:LIBS += -L/usr/local/lib
@@ -128,7 +219,8 @@ OTHER_FILES += shaders/*.glsl \
 
 #Optix Stuff
 message(The project will be installed in $$PWD)
-CUDA_SOURCES +=  "$$PWD"/optixSrc/parallelogram.cu \
+CUDA_SOURCES +=  "$$PWD"/optixSrc/display_resolve.cu \
+                 "$$PWD"/optixSrc/parallelogram.cu \
                  "$$PWD"/optixSrc/path_tracer.cu \
                  "$$PWD"/optixSrc/sphere.cu \
                  "$$PWD"/optixSrc/triangle_mesh.cu
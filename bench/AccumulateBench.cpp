@@ -0,0 +1,149 @@
+/// @file AccumulateBench.cpp
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Checks how precisely and how robustly RobustAccumulator, and so our path tracer, accumulates a long sequence
+/// @brief of frames. Every pixel of our frames is drawn from the same heavy tailed distribution, a little noise with
+/// @brief the odd firefly far brighter than everything else, as our renders of small bright lights are. Our frames
+/// @brief are accumulated in float, Kahan compensated float and double, and through our clamped and median of means
+/// @brief estimators. We print the RMS error of each against the mean of our frames summed in double, and against
+/// @brief the mean of our distribution without its fireflies, what our estimators trade their bias for.
+/// @brief Fails if Kahan compensation doesn't beat plain float, or if either estimator doesn't beat our plain mean
+/// @brief against our distribution without its fireflies.
+/// @brief Usage: AccumulateBench [--pixels=<pixels per frame>] [--frames=<number of frames>]
+/// @brief                        [--firefly-chance=<chance a sample is a firefly>] [--seed=<seed>]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include "common/RobustAccumulator.h"
+#include "common/random.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief our distribution, a sample is uniform over [g_low,g_high) or a firefly of g_fireflyValue
+//----------------------------------------------------------------------------------------------------------------------
+static const float g_low = 0.25f;
+static const float g_high = 0.75f;
+static const float g_fireflyValue = 500.f;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the colour our samples are scaled by so each channel has a different mean
+//----------------------------------------------------------------------------------------------------------------------
+static const float g_tint[3] = {1.f,0.8f,0.6f};
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief one of the accumulators we compare
+//----------------------------------------------------------------------------------------------------------------------
+struct Candidate
+{
+    std::string m_name;
+    RobustAccumulator *m_accumulator;
+    double m_referenceError;
+    double m_distributionError;
+    double m_ms;
+};
+//----------------------------------------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    unsigned int numPixels = 256;
+    unsigned int numFrames = 200000;
+    float fireflyChance = 1e-4f;
+    unsigned int seed = 0;
+    for(int i=1;i<argc;i++)
+    {
+        if(std::strncmp(argv[i],"--pixels=",9)==0) numPixels = std::atoi(argv[i]+9);
+        else if(std::strncmp(argv[i],"--frames=",9)==0) numFrames = std::atoi(argv[i]+9);
+        else if(std::strncmp(argv[i],"--firefly-chance=",17)==0) fireflyChance = std::atof(argv[i]+17);
+        else if(std::strncmp(argv[i],"--seed=",7)==0) seed = std::atoi(argv[i]+7);
+        else
+        {
+            std::cerr<<"Unknown argument "<<argv[i]<<std::endl;
+            return 1;
+        }
+    }
+    if(numPixels==0 || numFrames==0)
+    {
+        std::cerr<<"Pixels and frames must be greater than 0"<<std::endl;
+        return 1;
+    }
+
+    Candidate candidates[] = {
+        {"Float",new RobustAccumulator(numPixels,RobustAccumulator::Float),0.0,0.0,0.0},
+        {"Kahan",new RobustAccumulator(numPixels,RobustAccumulator::Kahan),0.0,0.0,0.0},
+        {"Double",new RobustAccumulator(numPixels,RobustAccumulator::Double),0.0,0.0,0.0},
+        {"Kahan clamped",new RobustAccumulator(numPixels,RobustAccumulator::Kahan,RobustAccumulator::Clamped),0.0,0.0,0.0},
+        {"Kahan median of means",new RobustAccumulator(numPixels,RobustAccumulator::Kahan,RobustAccumulator::MedianOfMeans),0.0,0.0,0.0}
+    };
+    const unsigned int numCandidates = sizeof(candidates)/sizeof(Candidate);
+
+    // Our reference is a plain sum of every frame in double
+    std::vector<double> reference(numPixels*3,0.0);
+    std::vector<float> frame(numPixels*4,1.f);
+    for(unsigned int f=0;f<numFrames;f++)
+    {
+        for(unsigned int i=0;i<numPixels;i++)
+        {
+            RandomStream rng = sample_stream(i,f,seed);
+            float value = (rnd(rng)<fireflyChance) ? g_fireflyValue : g_low+(g_high-g_low)*rnd(rng);
+            for(int c=0;c<3;c++)
+            {
+                frame[i*4+c] = value*g_tint[c];
+                reference[i*3+c] += frame[i*4+c];
+            }
+        }
+        for(unsigned int a=0;a<numCandidates;a++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            candidates[a].m_accumulator->addFrame(&frame[0]);
+            candidates[a].m_ms += std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+        }
+    }
+
+    std::vector<float> estimate(numPixels*4);
+    double numValues = numPixels*3.0;
+    for(unsigned int a=0;a<numCandidates;a++)
+    {
+        candidates[a].m_accumulator->resolve(&estimate[0]);
+        double referenceError = 0.0;
+        double distributionError = 0.0;
+        for(unsigned int i=0;i<numPixels;i++)
+        {
+            for(int c=0;c<3;c++)
+            {
+                double e = estimate[i*4+c];
+                double r = reference[i*3+c]/numFrames - e;
+                double d = 0.5*(g_low+g_high)*g_tint[c] - e;
+                referenceError += r*r;
+                distributionError += d*d;
+            }
+        }
+        candidates[a].m_referenceError = std::sqrt(referenceError/numValues);
+        candidates[a].m_distributionError = std::sqrt(distributionError/numValues);
+    }
+
+    std::cout<<numFrames<<" frames of "<<numPixels<<" pixels, 1 in "<<std::fixed<<std::setprecision(0)<<1.f/fireflyChance
+             <<" samples a firefly of "<<g_fireflyValue<<"\n";
+    std::cout<<std::left<<std::setw(24)<<"Accumulator"<<std::right<<std::setw(20)<<"RMS vs reference"
+             <<std::setw(24)<<"RMS vs no fireflies"<<std::setw(12)<<"ms"<<"\n";
+    std::cout<<std::string(80,'-')<<"\n";
+    for(unsigned int a=0;a<numCandidates;a++)
+    {
+        std::cout<<std::left<<std::setw(24)<<candidates[a].m_name<<std::right<<std::scientific<<std::setprecision(3)
+                 <<std::setw(20)<<candidates[a].m_referenceError<<std::setw(24)<<candidates[a].m_distributionError
+                 <<std::fixed<<std::setprecision(1)<<std::setw(12)<<candidates[a].m_ms<<"\n";
+    }
+
+    // Kahan must be closer to our reference than plain float, and our firefly estimators closer than our plain mean
+    // to our distribution without its fireflies, which is what they are there for
+    bool kahanWins = candidates[1].m_referenceError<candidates[0].m_referenceError;
+    if(!kahanWins) std::cout<<"Kahan compensation was no more precise than plain float\n";
+    bool clampWins = candidates[3].m_distributionError<candidates[1].m_distributionError;
+    if(!clampWins) std::cout<<"Clamping fireflies did no better than our plain mean\n";
+    bool medianWins = candidates[4].m_distributionError<candidates[1].m_distributionError;
+    if(!medianWins) std::cout<<"Our median of means did no better than our plain mean\n";
+    std::cout<<std::flush;
+    for(unsigned int a=0;a<numCandidates;a++) delete candidates[a].m_accumulator;
+    return (kahanWins && clampWins && medianWins) ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+/// @file AutoExposureCheck.cpp
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Checks our auto exposure against simple references on a random HDR image spanning 20 stops, with some black
+/// @brief pixels and a size that doesn't fill a group of four. Our SSE measure() is compared with measureScalar(),
+/// @brief the log average must agree to within a small fraction of a stop, the max exactly and only pixels on the edge
+/// @brief of a bin may land in its neighbour. Our CPU resolve is compared with a resolve done in double, exposing,
+/// @brief tonemapping and converting to sRGB each pixel with its chromaticity kept exactly, for the parameters auto
+/// @brief exposure picks and for a plain clamped exposure. Fails if any of these disagree.
+/// @brief Usage: AutoExposureCheck [--width=<width>] [--height=<height>] [--seed=<seed>]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include "common/AutoExposure.h"
+#include "common/random.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief how far measure() may stray from measureScalar(), as a fraction of our log average and of our pixels
+//----------------------------------------------------------------------------------------------------------------------
+static const double g_logAverageTolerance = 1e-4;
+static const double g_histogramTolerance = 1e-3;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief most a channel of our resolve may stray from our reference, in 8 bit steps
+//----------------------------------------------------------------------------------------------------------------------
+static const int g_resolveTolerance = 1;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the key of the tonemap in common/helpers.h
+//----------------------------------------------------------------------------------------------------------------------
+static const double g_tonemapKey = 0.04;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief sRGB transfer function in double
+/// @param _c - linear value (double)
+/// @returns our value encoded in [0,1] (double)
+//----------------------------------------------------------------------------------------------------------------------
+static double linearToSrgb(double _c)
+{
+    _c = std::min(std::max(_c,0.0),1.0);
+    return (_c<=0.0031308) ? 12.92*_c : 1.055*std::pow(_c,1.0/2.4)-0.055;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief resolves a pixel for display in double. Our tonemap only maps luminance, so rather than going through Yxy
+/// @brief as common/helpers.h does our colour is simply scaled by how much its luminance was.
+/// @param _rgba - our pixel (const float*)
+/// @param _params - parameters to resolve with (AutoExposure::Params)
+/// @param _out - returns our RGB in [0,255] before rounding (double*)
+//----------------------------------------------------------------------------------------------------------------------
+static void referenceResolve(const float *_rgba, const AutoExposure::Params &_params, double *_out)
+{
+    double c[3];
+    for(int i=0;i<3;i++) c[i] = std::max((double)_rgba[i]*_params.m_exposure,0.0);
+    if(_params.m_tonemap)
+    {
+        double y = 0.2126*c[0] + 0.7152*c[1] + 0.0722*c[2];
+        double scale = 0.0;
+        if(y>0.0)
+        {
+            double yRel = g_tonemapKey*y/_params.m_logAverage;
+            double white = _params.m_white;
+            scale = yRel*(1.0+yRel/(white*white))/(1.0+yRel)/y;
+        }
+        for(int i=0;i<3;i++) c[i] *= scale;
+    }
+    for(int i=0;i<3;i++) _out[i] = linearToSrgb(c[i])*255.0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief compares our resolve with our reference
+/// @param _hdr - our image (DisplayFrame)
+/// @param _params - parameters to resolve with (AutoExposure::Params)
+/// @param _name - what to call these parameters (const char*)
+/// @returns if every channel was within g_resolveTolerance of our reference (bool)
+//----------------------------------------------------------------------------------------------------------------------
+static bool checkResolve(const DisplayFrame &_hdr, const AutoExposure::Params &_params, const char *_name)
+{
+    DisplayFrame resolved;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    AutoExposure::resolve(_hdr,_params,resolved);
+    double ms = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+
+    unsigned int numPixels = _hdr.m_width*_hdr.m_height;
+    int maxDiff = 0;
+    unsigned int numDiffering = 0;
+    for(unsigned int i=0;i<numPixels;i++)
+    {
+        double reference[3];
+        referenceResolve(&_hdr.m_pixels[i*4],_params,reference);
+        bool differs = false;
+        for(int c=0;c<3;c++)
+        {
+            int diff = std::abs((int)resolved.m_display[i*4+c]-(int)std::floor(reference[c]+0.5));
+            maxDiff = std::max(maxDiff,diff);
+            differs |= diff>0;
+        }
+        if(differs) numDiffering++;
+    }
+    bool ok = maxDiff<=g_resolveTolerance && resolved.m_format==DisplayFrame::RGBA8;
+    std::cout<<std::left<<std::setw(28)<<_name<<std::right<<std::fixed<<std::setprecision(2)
+             <<" exposure "<<_params.m_exposure<<", log average "<<std::setprecision(4)<<_params.m_logAverage
+             <<", white "<<_params.m_white<<"\n";
+    std::cout<<"    "<<numDiffering<<" pixels off by up to "<<maxDiff<<" in 255, "<<std::setprecision(1)<<ms<<" ms"
+             <<((ok) ? "" : "  FAILED")<<"\n";
+    return ok;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    unsigned int width = 1021;
+    unsigned int height = 767;
+    unsigned int seed = 0;
+    for(int i=1;i<argc;i++)
+    {
+        if(std::strncmp(argv[i],"--width=",8)==0) width = std::atoi(argv[i]+8);
+        else if(std::strncmp(argv[i],"--height=",9)==0) height = std::atoi(argv[i]+9);
+        else if(std::strncmp(argv[i],"--seed=",7)==0) seed = std::atoi(argv[i]+7);
+        else
+        {
+            std::cerr<<"Unknown argument "<<argv[i]<<std::endl;
+            return 1;
+        }
+    }
+    if(width==0 || height==0)
+    {
+        std::cerr<<"Width and height must be greater than 0"<<std::endl;
+        return 1;
+    }
+
+    // Luminance spread evenly in log2 from 2^-12 to 2^8 with a random hue, and one pixel in a hundred black
+    unsigned int numPixels = width*height;
+    DisplayFrame hdr;
+    hdr.m_width = width;
+    hdr.m_height = height;
+    hdr.m_format = DisplayFrame::RGBA32F;
+    hdr.m_pixels.resize(numPixels*4);
+    for(unsigned int i=0;i<numPixels;i++)
+    {
+        RandomStream rng = sample_stream(i,0,seed);
+        float *p = &hdr.m_pixels[i*4];
+        float value = (rnd(rng)<0.01f) ? 0.f : std::exp2(-12.f+20.f*rnd(rng));
+        for(int c=0;c<3;c++) p[c] = value*(0.2f+0.8f*rnd(rng));
+        p[3] = 1.f;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    AutoExposure::LuminanceStats stats = AutoExposure::measure(&hdr.m_pixels[0],numPixels);
+    double measureMs = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+    start = std::chrono::steady_clock::now();
+    AutoExposure::LuminanceStats reference = AutoExposure::measureScalar(&hdr.m_pixels[0],numPixels);
+    double scalarMs = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+
+    double logAverageError = std::fabs(stats.m_logAverage-reference.m_logAverage)/reference.m_logAverage;
+    // Every pixel that moved bin is counted once leaving one bin and once arriving in another
+    unsigned int moved = 0;
+    for(int b=0;b<AutoExposure::NumBins;b++) moved += std::abs((int)stats.m_histogram[b]-(int)reference.m_histogram[b]);
+    moved /= 2;
+    bool measureOk = logAverageError<=g_logAverageTolerance && stats.m_max==reference.m_max &&
+                     moved<=g_histogramTolerance*numPixels && stats.m_numPixels==reference.m_numPixels;
+
+    std::cout<<width<<"x"<<height<<" image\n";
+    std::cout<<"measure "<<std::fixed<<std::setprecision(1)<<measureMs<<" ms, measureScalar "<<scalarMs<<" ms\n";
+    std::cout<<"    log average "<<std::scientific<<std::setprecision(6)<<stats.m_logAverage<<" vs "<<reference.m_logAverage
+             <<", relative error "<<std::setprecision(2)<<logAverageError<<"\n";
+    std::cout<<"    max "<<std::setprecision(6)<<stats.m_max<<" vs "<<reference.m_max<<", "<<moved
+             <<" pixels in a different bin"<<((measureOk) ? "" : "  FAILED")<<"\n";
+
+    AutoExposure autoExposure;
+    autoExposure.update(reference,0.f);
+    AutoExposure::Params params;
+    autoExposure.getParams(params);
+    bool resolveOk = checkResolve(hdr,params,"resolve auto exposure");
+    AutoExposure::Params clamped;
+    clamped.m_exposure = 4.f;
+    clamped.m_tonemap = false;
+    resolveOk &= checkResolve(hdr,clamped,"resolve clamped exposure");
+
+    std::cout<<std::flush;
+    return (measureOk && resolveOk) ? 0 : 1;
+}
@@ -0,0 +1,28 @@
+# Host only check of our SSE luminance measurement and CPU display resolve, see AutoExposureCheck.cpp.
+# These only need the OptiX and CUDA headers, not Qt or a GPU.
+TARGET=AutoExposureCheck
+OBJECTS_DIR=obj
+CONFIG-=qt app_bundle
+CONFIG+=console c++11 release
+SOURCES += AutoExposureCheck.cpp \
+           ../src/common/AutoExposure.cpp
+HEADERS += ../include/common/AutoExposure.h \
+           ../include/renderer/FrameHandoff.h \
+           ../include/common/helpers.h \
+           ../include/common/ParallelFor.h \
+           ../include/common/random.h
+INCLUDEPATH += ../include
+DESTDIR=./
+
+QMAKE_CXXFLAGS+= -msse -msse2
+macx:QMAKE_CXXFLAGS+= -arch x86_64
+
+# The same OptiX and CUDA install locations as Phenix.pro
+macx:CUDA_DIR = /Developer/NVIDIA/CUDA-6.5
+linux:CUDA_DIR = /usr/local/cuda-6.5
+win32:CUDA_DIR = "C:\Program Files\NVIDIA GPU Computing Toolkit\CUDA\v8.0"
+INCLUDEPATH += $$CUDA_DIR/include
+macx:INCLUDEPATH += /Developer/OptiX/include
+linux:INCLUDEPATH += /usr/local/OptiX/include
+win32:INCLUDEPATH += "C:\ProgramData\NVIDIA Corporation\OptiX SDK 4.0.2\include"
+win32:DEFINES += NOMINMAX _USE_MATH_DEFINES
@@ -0,0 +1,190 @@
+/// @file CostMapTool.cpp
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Renders the cost heat maps of our cornell box on the CPU with CostMap, so they can be looked at and checked
+/// @brief on machines without a GPU. Writes one heat map per counter as <out>_<counter>.pfm and prints the mean and
+/// @brief max of each counter. Random triangles can be added to our box to see how our cost scales with geometry.
+/// @brief With --filter our image is also rendered through a Film with that filter, once split into tiles across all
+/// @brief of our cores and once as a single tile on one thread. Prints how much faster our tiles were and how far
+/// @brief apart our two images are, writes our image as <out>_image.pfm and fails if they don't agree.
+/// @brief Usage: CostMapTool [--width=<pixels>] [--height=<pixels>] [--samples=<sqrt samples per pixel>]
+/// @brief                    [--frame=<frame number>] [--triangles=<random triangles>] [--out=<path prefix>]
+/// @brief                    [--filter=<box|tent|gaussian|blackman-harris>] [--frames=<frames of our image>]
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <cmath>
+#include <thread>
+#include "perf/CostMap.h"
+#include "perf/ImageError.h"
+#include "renderer/Film.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief small deterministic random number generator so every run adds the same triangles
+//----------------------------------------------------------------------------------------------------------------------
+static unsigned int g_seed = 1234567u;
+static float randf(float _min, float _max)
+{
+    g_seed = g_seed*1664525u + 1013904223u;
+    return _min + (_max-_min)*((g_seed>>8)*(1.0f/16777216.0f));
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief largest difference we allow between our tiled and single tile images, only the order our splats are
+/// @brief summed in differs between them
+//----------------------------------------------------------------------------------------------------------------------
+static const float g_tileTolerance = 1e-4f;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief finds a filter from its name, ignoring case
+/// @param _name - name of our filter (std::string)
+/// @param _filter - returns our filter (Film::Filter)
+/// @returns if we found it (bool)
+//----------------------------------------------------------------------------------------------------------------------
+static bool findFilter(const std::string &_name, Film::Filter &_filter)
+{
+    for(int f=0;f<Film::NumFilters;f++)
+    {
+        std::string name = Film::getFilterName((Film::Filter)f);
+        if(name.size()!=_name.size()) continue;
+        bool match = true;
+        for(unsigned int i=0;i<name.size();i++) match &= std::tolower(name[i])==std::tolower(_name[i]);
+        if(match)
+        {
+            _filter = (Film::Filter)f;
+            return true;
+        }
+    }
+    return false;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief renders some frames of our image into a film
+/// @returns how long we took in milliseconds (double)
+//----------------------------------------------------------------------------------------------------------------------
+static double renderFilm(CostMap &_costMap, Film &_film, unsigned int _firstFrame, unsigned int _numFrames)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(unsigned int f=0;f<_numFrames;f++) _costMap.renderImage(_film,_firstFrame+f);
+    return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    unsigned int width = 256;
+    unsigned int height = 256;
+    unsigned int samples = 2;
+    unsigned int frame = 0;
+    unsigned int numTriangles = 0;
+    std::string out = "cost_map";
+    bool renderImage = false;
+    Film::Filter filter = Film::Box;
+    unsigned int numFrames = 4;
+    for(int i=1;i<argc;i++)
+    {
+        if(std::strncmp(argv[i],"--width=",8)==0) width = std::atoi(argv[i]+8);
+        else if(std::strncmp(argv[i],"--height=",9)==0) height = std::atoi(argv[i]+9);
+        else if(std::strncmp(argv[i],"--samples=",10)==0) samples = std::atoi(argv[i]+10);
+        else if(std::strncmp(argv[i],"--frame=",8)==0) frame = std::atoi(argv[i]+8);
+        else if(std::strncmp(argv[i],"--triangles=",12)==0) numTriangles = std::atoi(argv[i]+12);
+        else if(std::strncmp(argv[i],"--out=",6)==0) out = argv[i]+6;
+        else if(std::strncmp(argv[i],"--frames=",9)==0) numFrames = std::max(std::atoi(argv[i]+9),1);
+        else if(std::strncmp(argv[i],"--filter=",9)==0)
+        {
+            renderImage = true;
+            if(!findFilter(argv[i]+9,filter))
+            {
+                std::cerr<<"Unknown filter "<<argv[i]+9<<std::endl;
+                return 1;
+            }
+        }
+        else
+        {
+            std::cerr<<"Unknown argument "<<argv[i]<<std::endl;
+            return 1;
+        }
+    }
+    if(width==0 || height==0)
+    {
+        std::cerr<<"Width and height must be greater than 0"<<std::endl;
+        return 1;
+    }
+
+    CostMap costMap;
+    costMap.loadCornellBox();
+    // The same field of view our path tracer uses for this aspect ratio
+    costMap.setCamera(optix::make_float3(278.0f,273.0f,-900.0f),optix::make_float3(278.0f,273.0f,0.0f),
+                      optix::make_float3(0.0f,1.0f,0.0f),35.f*width/height,35.f);
+    costMap.setNumSamples(samples);
+    const optix::float3 grey = optix::make_float3(0.7f,0.7f,0.7f);
+    for(unsigned int i=0;i<numTriangles;i++)
+    {
+        optix::float3 p = optix::make_float3(randf(20.f,536.f),randf(0.f,400.f),randf(20.f,540.f));
+        optix::float3 e1 = optix::make_float3(randf(-20.f,20.f),randf(-20.f,20.f),randf(-20.f,20.f));
+        optix::float3 e2 = optix::make_float3(randf(-20.f,20.f),randf(-20.f,20.f),randf(-20.f,20.f));
+        costMap.addTriangle(p,p+e1,p+e2,grey);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    costMap.build();
+    double buildMs = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+    start = std::chrono::steady_clock::now();
+    DisplayFrame cost;
+    costMap.render(width,height,cost,frame);
+    double renderMs = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+
+    std::cout<<costMap.getNumTriangles()<<" triangles in "<<costMap.getNumNodes()<<" BVH nodes, built in "<<std::fixed
+             <<std::setprecision(2)<<buildMs<<"ms, "<<width<<"x"<<height<<" at "<<samples*samples
+             <<" samples per pixel rendered in "<<renderMs<<"ms\n";
+    std::cout<<std::left<<std::setw(20)<<"Counter"<<std::right<<std::setw(12)<<"Mean"<<std::setw(12)<<"Max"<<"\n";
+    std::cout<<std::string(44,'-')<<"\n";
+    bool written = true;
+    for(int c=0;c<CostMap::NumCounters;c++)
+    {
+        CostMap::Counter counter = (CostMap::Counter)c;
+        double total = 0.0;
+        for(unsigned int i=c;i<cost.m_pixels.size();i+=4) total += cost.m_pixels[i];
+        std::cout<<std::left<<std::setw(20)<<CostMap::getCounterName(counter)<<std::right<<std::setw(12)
+                 <<total/(width*height)<<std::setw(12)<<CostMap::getMax(cost,counter)<<"\n";
+
+        DisplayFrame heatMap;
+        CostMap::toHeatMap(cost,counter,heatMap);
+        std::string name = CostMap::getCounterName(counter);
+        for(unsigned int j=0;j<name.size();j++) if(name[j]==' ') name[j] = '_';
+        written &= ImageError::writePFM(out+"_"+name+".pfm",heatMap);
+    }
+
+    bool agree = true;
+    if(renderImage)
+    {
+        // The same frames through our tiles across all of our cores and through a single tile on one thread
+        Film tiled(width,height,filter);
+        Film single(width,height,filter,0.f,std::max(width,height));
+        double tiledMs = renderFilm(costMap,tiled,frame,numFrames);
+        double singleMs = renderFilm(costMap,single,frame,numFrames);
+        DisplayFrame tiledImage, singleImage;
+        tiled.resolve(tiledImage);
+        single.resolve(singleImage);
+        float maxDiff = 0.f;
+        double mean = 0.0;
+        for(unsigned int i=0;i<tiledImage.m_pixels.size();i++)
+        {
+            maxDiff = std::max(maxDiff,std::fabs(tiledImage.m_pixels[i]-singleImage.m_pixels[i]));
+            if(i%4!=3) mean += tiledImage.m_pixels[i];
+        }
+        mean /= width*height*3.0;
+        agree = maxDiff<=g_tileTolerance && mean==mean;
+
+        std::cout<<"\n"<<Film::getFilterName(filter)<<" filter, radius "<<tiled.getRadius()<<", "<<numFrames
+                 <<" frames of "<<samples*samples<<" samples per pixel\n";
+        std::cout<<tiled.getNumTiles()<<" tiles on "<<std::max(std::thread::hardware_concurrency(),1u)<<" threads "
+                 <<tiledMs<<"ms, 1 tile on 1 thread "<<singleMs<<"ms, "<<singleMs/std::max(tiledMs,1e-3)<<"x faster\n";
+        std::cout<<"Mean radiance "<<std::setprecision(4)<<mean<<", largest difference between our tiled and single "
+                 <<"tile images "<<std::scientific<<maxDiff<<((agree) ? "" : ", they don't agree")<<"\n";
+        written &= ImageError::writePFM(out+"_image.pfm",tiledImage);
+    }
+    std::cout<<std::flush;
+    return (written && agree) ? 0 : 1;
+}
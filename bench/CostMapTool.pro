@@ -0,0 +1,30 @@
+# Host only CPU cost heat maps of our cornell box, see CostMapTool.cpp.
+# These only need the OptiX and CUDA headers, not Qt or a GPU.
+TARGET=CostMapTool
+OBJECTS_DIR=obj
+CONFIG-=qt app_bundle
+CONFIG+=console c++11 release
+SOURCES += CostMapTool.cpp \
+           ../src/perf/CostMap.cpp \
+           ../src/perf/ImageError.cpp \
+           ../src/renderer/Film.cpp
+HEADERS += ../include/perf/CostMap.h \
+           ../include/perf/ImageError.h \
+           ../include/common/intersect.h \
+           ../include/common/random.h \
+           ../include/renderer/Film.h \
+           ../include/common/film_filter.h
+INCLUDEPATH += ../include
+DESTDIR=./
+
+macx:QMAKE_CXXFLAGS+= -arch x86_64
+
+# The same OptiX and CUDA install locations as Phenix.pro
+macx:CUDA_DIR = /Developer/NVIDIA/CUDA-6.5
+linux:CUDA_DIR = /usr/local/cuda-6.5
+win32:CUDA_DIR = "C:\Program Files\NVIDIA GPU Computing Toolkit\CUDA\v8.0"
+INCLUDEPATH += $$CUDA_DIR/include
+macx:INCLUDEPATH += /Developer/OptiX/include
+linux:INCLUDEPATH += /usr/local/OptiX/include
+win32:INCLUDEPATH += "C:\ProgramData\NVIDIA Corporation\OptiX SDK 4.0.2\include"
+win32:DEFINES += NOMINMAX _USE_MATH_DEFINES
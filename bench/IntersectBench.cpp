@@ -0,0 +1,371 @@
+/// @file IntersectBench.cpp
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Microbenchmarks of our ray/primitive intersection tests on the host. Each benchmark fires a fixed set of
+/// @brief random rays at a set of random primitives and reports how many ray/primitive tests we manage a second,
+/// @brief for both the scalar tests our OptiX programs use and their SSE versions. This lets us evaluate changes to
+/// @brief our intersection maths without going through the whole GPU pipeline.
+/// @brief Usage: IntersectBench [--benchmark_filter=<substring>] [--benchmark_min_time=<seconds>]
+/// @brief                       [--benchmark_format=<console|json>] [--rays=<number of rays>]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include "common/intersect.h"
+#include "IntersectSSE.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief our synthetic rays in both the layouts our tests take
+//----------------------------------------------------------------------------------------------------------------------
+struct RaySet
+{
+    std::vector<optix::float3> m_origins;
+    std::vector<optix::float3> m_directions;
+    std::vector<RayPacket4> m_packets;
+    float m_tmin;
+    float m_tmax;
+};
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief our synthetic primitives
+//----------------------------------------------------------------------------------------------------------------------
+struct Triangle{optix::float3 p0,p1,p2;};
+struct SphereData{optix::float3 center; float radius;};
+struct ParallelogramData{optix::float4 plane; optix::float3 anchor,v1,v2;};
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the result of running a benchmark
+//----------------------------------------------------------------------------------------------------------------------
+struct BenchResult
+{
+    std::string m_name;
+    unsigned long long m_iterations;
+    unsigned long long m_tests;
+    unsigned long long m_hits;
+    double m_seconds;
+};
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief small deterministic random number generator so every run tests the same rays
+//----------------------------------------------------------------------------------------------------------------------
+static unsigned int g_seed = 1234567u;
+static float randf(float _min, float _max)
+{
+    g_seed = g_seed*1664525u + 1013904223u;
+    return _min + (_max-_min)*((g_seed>>8)*(1.0f/16777216.0f));
+}
+static optix::float3 randf3(float _min, float _max)
+{
+    float x = randf(_min,_max);
+    float y = randf(_min,_max);
+    float z = randf(_min,_max);
+    return optix::make_float3(x,y,z);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief number of bits set in the mask of one of our SSE tests
+//----------------------------------------------------------------------------------------------------------------------
+static inline unsigned int popcount4(int _mask)
+{
+    static const unsigned int bits[16] = {0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4};
+    return bits[_mask&15];
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief creates rays from in front of the unit cube aimed at points within it
+/// @param _numRays - number of rays to create, rounded up to a multiple of 4 (unsigned int)
+//----------------------------------------------------------------------------------------------------------------------
+RaySet createRays(unsigned int _numRays)
+{
+    RaySet rays;
+    _numRays = (_numRays+3)&~3u;
+    rays.m_tmin = 1e-4f;
+    rays.m_tmax = 1e16f;
+    rays.m_origins.resize(_numRays);
+    rays.m_directions.resize(_numRays);
+    for(unsigned int i=0;i<_numRays;i++)
+    {
+        optix::float3 o = randf3(-1.f,1.f) + optix::make_float3(0.f,0.f,-4.f);
+        optix::float3 target = randf3(-1.f,1.f);
+        rays.m_origins[i] = o;
+        rays.m_directions[i] = optix::normalize(target-o);
+    }
+    rays.m_packets.resize(_numRays/4);
+    for(unsigned int p=0;p<_numRays/4;p++)
+    {
+        const optix::float3 *o = &rays.m_origins[p*4];
+        const optix::float3 *d = &rays.m_directions[p*4];
+        RayPacket4 &packet = rays.m_packets[p];
+        packet.ox = _mm_setr_ps(o[0].x,o[1].x,o[2].x,o[3].x);
+        packet.oy = _mm_setr_ps(o[0].y,o[1].y,o[2].y,o[3].y);
+        packet.oz = _mm_setr_ps(o[0].z,o[1].z,o[2].z,o[3].z);
+        packet.dx = _mm_setr_ps(d[0].x,d[1].x,d[2].x,d[3].x);
+        packet.dy = _mm_setr_ps(d[0].y,d[1].y,d[2].y,d[3].y);
+        packet.dz = _mm_setr_ps(d[0].z,d[1].z,d[2].z,d[3].z);
+        packet.tmin = _mm_set1_ps(rays.m_tmin);
+        packet.tmax = _mm_set1_ps(rays.m_tmax);
+    }
+    return rays;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief creates our random primitives within the unit cube
+//----------------------------------------------------------------------------------------------------------------------
+std::vector<Triangle> createTriangles(unsigned int _num)
+{
+    std::vector<Triangle> triangles(_num);
+    for(unsigned int i=0;i<_num;i++)
+    {
+        optix::float3 c = randf3(-0.5f,0.5f);
+        triangles[i].p0 = c + randf3(-0.8f,0.8f);
+        triangles[i].p1 = c + randf3(-0.8f,0.8f);
+        triangles[i].p2 = c + randf3(-0.8f,0.8f);
+    }
+    return triangles;
+}
+//----------------------------------------------------------------------------------------------------------------------
+std::vector<SphereData> createSpheres(unsigned int _num)
+{
+    std::vector<SphereData> spheres(_num);
+    for(unsigned int i=0;i<_num;i++)
+    {
+        spheres[i].center = randf3(-0.5f,0.5f);
+        spheres[i].radius = randf(0.2f,0.6f);
+    }
+    return spheres;
+}
+//----------------------------------------------------------------------------------------------------------------------
+std::vector<ParallelogramData> createParallelograms(unsigned int _num)
+{
+    // Set up the same way our Parallelogram class does
+    std::vector<ParallelogramData> parallelograms(_num);
+    for(unsigned int i=0;i<_num;i++)
+    {
+        optix::float3 anchor = randf3(-1.f,0.f);
+        optix::float3 offset1 = randf3(0.2f,1.2f);
+        optix::float3 offset2 = randf3(-1.f,1.f);
+        optix::float3 normal = optix::normalize(optix::cross(offset2,offset1));
+        parallelograms[i].plane = optix::make_float4(normal,optix::dot(normal,anchor));
+        parallelograms[i].anchor = anchor;
+        parallelograms[i].v1 = offset1/optix::dot(offset1,offset1);
+        parallelograms[i].v2 = offset2/optix::dot(offset2,offset2);
+    }
+    return parallelograms;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief one pass of every ray against every primitive
+/// @returns number of hits so our tests can't be optimised away (unsigned long long)
+//----------------------------------------------------------------------------------------------------------------------
+unsigned long long triangleScalar(const RaySet &_rays, const std::vector<Triangle> &_triangles)
+{
+    unsigned long long hits = 0;
+    optix::float3 n;
+    float t,beta,gamma;
+    for(unsigned int p=0;p<_triangles.size();p++)
+    {
+        const Triangle &tri = _triangles[p];
+        for(unsigned int r=0;r<_rays.m_origins.size();r++)
+        {
+            hits += intersectTriangle(_rays.m_origins[r],_rays.m_directions[r],_rays.m_tmin,_rays.m_tmax,
+                                      tri.p0,tri.p1,tri.p2,n,t,beta,gamma);
+        }
+    }
+    return hits;
+}
+//----------------------------------------------------------------------------------------------------------------------
+unsigned long long triangleSSE(const RaySet &_rays, const std::vector<Triangle> &_triangles)
+{
+    unsigned long long hits = 0;
+    __m128 t,beta,gamma;
+    for(unsigned int p=0;p<_triangles.size();p++)
+    {
+        const Triangle &tri = _triangles[p];
+        for(unsigned int r=0;r<_rays.m_packets.size();r++)
+        {
+            hits += popcount4(intersectTriangle4(_rays.m_packets[r],tri.p0,tri.p1,tri.p2,t,beta,gamma));
+        }
+    }
+    return hits;
+}
+//----------------------------------------------------------------------------------------------------------------------
+unsigned long long sphereScalar(const RaySet &_rays, const std::vector<SphereData> &_spheres)
+{
+    unsigned long long hits = 0;
+    float root1,root2;
+    for(unsigned int p=0;p<_spheres.size();p++)
+    {
+        const SphereData &sphere = _spheres[p];
+        for(unsigned int r=0;r<_rays.m_origins.size();r++)
+        {
+            if(intersectSphere(_rays.m_origins[r],_rays.m_directions[r],sphere.center,sphere.radius,root1,root2))
+            {
+                // The same checks rtPotentialIntersection makes in our sphere program
+                hits += ((root1>_rays.m_tmin && root1<_rays.m_tmax) || (root2>_rays.m_tmin && root2<_rays.m_tmax));
+            }
+        }
+    }
+    return hits;
+}
+//----------------------------------------------------------------------------------------------------------------------
+unsigned long long sphereSSE(const RaySet &_rays, const std::vector<SphereData> &_spheres)
+{
+    unsigned long long hits = 0;
+    __m128 root1,root2;
+    for(unsigned int p=0;p<_spheres.size();p++)
+    {
+        const SphereData &sphere = _spheres[p];
+        for(unsigned int r=0;r<_rays.m_packets.size();r++)
+        {
+            const RayPacket4 &rays = _rays.m_packets[r];
+            int mask = intersectSphere4(rays,sphere.center,sphere.radius,root1,root2);
+            __m128 in1 = _mm_and_ps(_mm_cmpgt_ps(root1,rays.tmin),_mm_cmplt_ps(root1,rays.tmax));
+            __m128 in2 = _mm_and_ps(_mm_cmpgt_ps(root2,rays.tmin),_mm_cmplt_ps(root2,rays.tmax));
+            hits += popcount4(mask & _mm_movemask_ps(_mm_or_ps(in1,in2)));
+        }
+    }
+    return hits;
+}
+//----------------------------------------------------------------------------------------------------------------------
+unsigned long long parallelogramScalar(const RaySet &_rays, const std::vector<ParallelogramData> &_parallelograms)
+{
+    unsigned long long hits = 0;
+    float t,a1,a2;
+    for(unsigned int p=0;p<_parallelograms.size();p++)
+    {
+        const ParallelogramData &pg = _parallelograms[p];
+        for(unsigned int r=0;r<_rays.m_origins.size();r++)
+        {
+            hits += intersectParallelogram(_rays.m_origins[r],_rays.m_directions[r],_rays.m_tmin,_rays.m_tmax,
+                                           pg.plane,pg.anchor,pg.v1,pg.v2,t,a1,a2);
+        }
+    }
+    return hits;
+}
+//----------------------------------------------------------------------------------------------------------------------
+unsigned long long parallelogramSSE(const RaySet &_rays, const std::vector<ParallelogramData> &_parallelograms)
+{
+    unsigned long long hits = 0;
+    __m128 t,a1,a2;
+    for(unsigned int p=0;p<_parallelograms.size();p++)
+    {
+        const ParallelogramData &pg = _parallelograms[p];
+        for(unsigned int r=0;r<_rays.m_packets.size();r++)
+        {
+            hits += popcount4(intersectParallelogram4(_rays.m_packets[r],pg.plane,pg.anchor,pg.v1,pg.v2,t,a1,a2));
+        }
+    }
+    return hits;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief runs a benchmark pass repeatedly until we have run for at least our minimum time
+/// @param _name - name of our benchmark (std::string)
+/// @param _pass - a pass of our benchmark returning its number of hits (Func)
+/// @param _testsPerPass - number of ray/primitive tests in a pass (unsigned long long)
+/// @param _minTime - minimum time to run for in seconds (double)
+//----------------------------------------------------------------------------------------------------------------------
+template<typename Func>
+BenchResult runBenchmark(const std::string &_name, Func _pass, unsigned long long _testsPerPass, double _minTime)
+{
+    BenchResult result;
+    result.m_name = _name;
+    result.m_iterations = 0;
+    result.m_hits = 0;
+
+    // Warm up our caches before we start timing
+    _pass();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do
+    {
+        result.m_hits += _pass();
+        result.m_iterations++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    }
+    while(elapsed<_minTime);
+
+    result.m_seconds = elapsed;
+    result.m_tests = result.m_iterations*_testsPerPass;
+    return result;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    std::string filter;
+    double minTime = 0.5;
+    bool json = false;
+    unsigned int numRays = 1<<16;
+    const unsigned int numPrimitives = 64;
+    for(int i=1;i<argc;i++)
+    {
+        if(std::strncmp(argv[i],"--benchmark_filter=",19)==0) filter = argv[i]+19;
+        else if(std::strncmp(argv[i],"--benchmark_min_time=",21)==0) minTime = std::atof(argv[i]+21);
+        else if(std::strcmp(argv[i],"--benchmark_format=json")==0) json = true;
+        else if(std::strncmp(argv[i],"--rays=",7)==0) numRays = std::atoi(argv[i]+7);
+        else
+        {
+            std::cerr<<"Unknown argument "<<argv[i]<<std::endl;
+            return 1;
+        }
+    }
+
+    RaySet rays = createRays(numRays);
+    std::vector<Triangle> triangles = createTriangles(numPrimitives);
+    std::vector<SphereData> spheres = createSpheres(numPrimitives);
+    std::vector<ParallelogramData> parallelograms = createParallelograms(numPrimitives);
+    unsigned long long testsPerPass = (unsigned long long)rays.m_origins.size()*numPrimitives;
+
+    std::vector<BenchResult> results;
+    #define RUN_BENCHMARK(name,func,prims) \
+        if(filter.empty() || std::string(name).find(filter)!=std::string::npos) \
+            results.push_back(runBenchmark(name,[&](){return func(rays,prims);},testsPerPass,minTime));
+    RUN_BENCHMARK("triangle/scalar",triangleScalar,triangles)
+    RUN_BENCHMARK("triangle/sse",triangleSSE,triangles)
+    RUN_BENCHMARK("sphere/scalar",sphereScalar,spheres)
+    RUN_BENCHMARK("sphere/sse",sphereSSE,spheres)
+    RUN_BENCHMARK("parallelogram/scalar",parallelogramScalar,parallelograms)
+    RUN_BENCHMARK("parallelogram/sse",parallelogramSSE,parallelograms)
+    #undef RUN_BENCHMARK
+
+    if(json)
+    {
+        std::cout<<"{\n  \"context\": {\"rays\": "<<rays.m_origins.size()<<", \"primitives\": "<<numPrimitives<<"},\n  \"benchmarks\": [";
+        for(unsigned int i=0;i<results.size();i++)
+        {
+            const BenchResult &r = results[i];
+            std::cout<<((i)?",":"")<<"\n    {\"name\": \""<<r.m_name<<"\", \"iterations\": "<<r.m_iterations
+                     <<", \"real_time_ns_per_ray\": "<<r.m_seconds*1e9/r.m_tests<<", \"rays_per_second\": "<<r.m_tests/r.m_seconds
+                     <<", \"hit_rate\": "<<(double)r.m_hits/r.m_tests<<"}";
+        }
+        std::cout<<"\n  ]\n}"<<std::endl;
+    }
+    else
+    {
+        std::cout<<rays.m_origins.size()<<" rays against "<<numPrimitives<<" primitives per iteration\n";
+        std::cout<<std::left<<std::setw(24)<<"Benchmark"<<std::right<<std::setw(14)<<"ns/ray"<<std::setw(12)<<"Iterations"
+                 <<std::setw(14)<<"Mrays/s"<<std::setw(10)<<"Hit rate"<<"\n";
+        std::cout<<std::string(74,'-')<<"\n";
+        for(unsigned int i=0;i<results.size();i++)
+        {
+            const BenchResult &r = results[i];
+            std::cout<<std::left<<std::setw(24)<<r.m_name<<std::right<<std::fixed<<std::setprecision(3)
+                     <<std::setw(14)<<r.m_seconds*1e9/r.m_tests<<std::setw(12)<<r.m_iterations
+                     <<std::setw(14)<<std::setprecision(1)<<r.m_tests/r.m_seconds/1e6
+                     <<std::setw(10)<<std::setprecision(3)<<(double)r.m_hits/r.m_tests<<"\n";
+        }
+    }
+
+    // Our scalar and SSE tests should agree on what they hit
+    for(unsigned int i=0;i+1<results.size();i++)
+    {
+        const BenchResult &a = results[i];
+        const BenchResult &b = results[i+1];
+        if(a.m_name.compare(0,a.m_name.find('/'),b.m_name,0,b.m_name.find('/'))!=0) continue;
+        double rateA = (double)a.m_hits/a.m_tests;
+        double rateB = (double)b.m_hits/b.m_tests;
+        if(std::abs(rateA-rateB)>1e-3)
+        {
+            std::cerr<<"Warning: "<<a.m_name<<" and "<<b.m_name<<" disagree on hit rate ("<<rateA<<" vs "<<rateB<<")"<<std::endl;
+        }
+    }
+    return 0;
+}
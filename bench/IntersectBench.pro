@@ -0,0 +1,25 @@
+# Host only microbenchmarks of our intersection tests, see IntersectBench.cpp.
+# These only need the OptiX and CUDA headers, not Qt or a GPU.
+TARGET=IntersectBench
+OBJECTS_DIR=obj
+CONFIG-=qt app_bundle
+CONFIG+=console c++11 release
+SOURCES += IntersectBench.cpp
+HEADERS += IntersectSSE.h \
+           ../include/common/intersect.h
+INCLUDEPATH += ../include
+DESTDIR=./
+
+QMAKE_CXXFLAGS+= -msse -msse2 -msse3
+macx:QMAKE_CXXFLAGS+= -arch x86_64
+linux-*:QMAKE_CXXFLAGS += -march=native
+
+# The same OptiX and CUDA install locations as Phenix.pro
+macx:CUDA_DIR = /Developer/NVIDIA/CUDA-6.5
+linux:CUDA_DIR = /usr/local/cuda-6.5
+win32:CUDA_DIR = "C:\Program Files\NVIDIA GPU Computing Toolkit\CUDA\v8.0"
+INCLUDEPATH += $$CUDA_DIR/include
+macx:INCLUDEPATH += /Developer/OptiX/include
+linux:INCLUDEPATH += /usr/local/OptiX/include
+win32:INCLUDEPATH += "C:\ProgramData\NVIDIA Corporation\OptiX SDK 4.0.2\include"
+win32:DEFINES += NOMINMAX _USE_MATH_DEFINES
@@ -0,0 +1,149 @@
+#ifndef INTERSECTSSE_H
+#define INTERSECTSSE_H
+
+/// @file IntersectSSE.h
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief SSE versions of the intersection tests in common/intersect.h that test a packet of four rays against
+/// @brief one primitive at a time. These are host only and exist so our microbenchmarks can compare against the
+/// @brief scalar tests our OptiX programs use.
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <optixu/optixu_math_namespace.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief four rays stored as structure of arrays
+//----------------------------------------------------------------------------------------------------------------------
+struct RayPacket4
+{
+    __m128 ox, oy, oz;
+    __m128 dx, dy, dz;
+    __m128 tmin, tmax;
+};
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief three component vector of SSE registers
+//----------------------------------------------------------------------------------------------------------------------
+struct Vec3x4
+{
+    __m128 x, y, z;
+};
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief splats a float3 across all four lanes
+//----------------------------------------------------------------------------------------------------------------------
+static inline Vec3x4 splat(const optix::float3 &_v)
+{
+    Vec3x4 r = {_mm_set1_ps(_v.x),_mm_set1_ps(_v.y),_mm_set1_ps(_v.z)};
+    return r;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static inline __m128 dot(const Vec3x4 &_a, const Vec3x4 &_b)
+{
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_a.x,_b.x),_mm_mul_ps(_a.y,_b.y)),_mm_mul_ps(_a.z,_b.z));
+}
+//----------------------------------------------------------------------------------------------------------------------
+static inline Vec3x4 cross(const Vec3x4 &_a, const Vec3x4 &_b)
+{
+    Vec3x4 r = {_mm_sub_ps(_mm_mul_ps(_a.y,_b.z),_mm_mul_ps(_a.z,_b.y)),
+                _mm_sub_ps(_mm_mul_ps(_a.z,_b.x),_mm_mul_ps(_a.x,_b.z)),
+                _mm_sub_ps(_mm_mul_ps(_a.x,_b.y),_mm_mul_ps(_a.y,_b.x))};
+    return r;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief four ray version of intersectTriangle
+/// @param _rays - our rays (RayPacket4)
+/// @param _p0, _p1, _p2 - vertices of our triangle (optix::float3)
+/// @param _t - returns the distance along each ray of its hit (__m128)
+/// @param _beta, _gamma - returns the barycentric coordinates of each hit (__m128)
+/// @returns a mask with bit i set if ray i hits our triangle (int)
+//----------------------------------------------------------------------------------------------------------------------
+static inline int intersectTriangle4(const RayPacket4 &_rays, const optix::float3 &_p0, const optix::float3 &_p1,
+                                     const optix::float3 &_p2, __m128 &_t, __m128 &_beta, __m128 &_gamma)
+{
+    // Everything that only depends on our triangle is done once in scalar
+    const optix::float3 e0s = _p1 - _p0;
+    const optix::float3 e1s = _p0 - _p2;
+    const Vec3x4 e0 = splat(e0s);
+    const Vec3x4 e1 = splat(e1s);
+    const Vec3x4 n = splat(optix::cross(e1s,e0s));
+
+    const Vec3x4 d = {_rays.dx,_rays.dy,_rays.dz};
+    const __m128 invDn = _mm_div_ps(_mm_set1_ps(1.0f),dot(n,d));
+    const Vec3x4 e2 = {_mm_mul_ps(invDn,_mm_sub_ps(_mm_set1_ps(_p0.x),_rays.ox)),
+                       _mm_mul_ps(invDn,_mm_sub_ps(_mm_set1_ps(_p0.y),_rays.oy)),
+                       _mm_mul_ps(invDn,_mm_sub_ps(_mm_set1_ps(_p0.z),_rays.oz))};
+    const Vec3x4 i = cross(d,e2);
+
+    _beta = dot(i,e1);
+    _gamma = dot(i,e0);
+    _t = dot(n,e2);
+
+    const __m128 zero = _mm_setzero_ps();
+    __m128 mask = _mm_and_ps(_mm_cmplt_ps(_t,_rays.tmax),_mm_cmpgt_ps(_t,_rays.tmin));
+    mask = _mm_and_ps(mask,_mm_cmpge_ps(_beta,zero));
+    mask = _mm_and_ps(mask,_mm_cmpge_ps(_gamma,zero));
+    mask = _mm_and_ps(mask,_mm_cmple_ps(_mm_add_ps(_beta,_gamma),_mm_set1_ps(1.0f)));
+    return _mm_movemask_ps(mask);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief four ray version of intersectSphere
+/// @param _rays - our rays (RayPacket4)
+/// @param _center - center of our sphere (optix::float3)
+/// @param _radius - radius of our sphere (float)
+/// @param _root1, _root2 - returns the distances to the intersections of each ray (__m128)
+/// @returns a mask with bit i set if the line of ray i hits our sphere (int)
+//----------------------------------------------------------------------------------------------------------------------
+static inline int intersectSphere4(const RayPacket4 &_rays, const optix::float3 &_center, float _radius,
+                                   __m128 &_root1, __m128 &_root2)
+{
+    const Vec3x4 O = {_mm_sub_ps(_rays.ox,_mm_set1_ps(_center.x)),
+                      _mm_sub_ps(_rays.oy,_mm_set1_ps(_center.y)),
+                      _mm_sub_ps(_rays.oz,_mm_set1_ps(_center.z))};
+    const Vec3x4 d = {_rays.dx,_rays.dy,_rays.dz};
+    const __m128 a = dot(d,d);
+    const __m128 b = _mm_mul_ps(_mm_set1_ps(2.0f),dot(d,O));
+    const __m128 c = _mm_sub_ps(dot(O,O),_mm_set1_ps(_radius*_radius));
+    const __m128 disc = _mm_sub_ps(_mm_mul_ps(b,b),_mm_mul_ps(_mm_set1_ps(4.0f),_mm_mul_ps(a,c)));
+    const __m128 mask = _mm_cmpgt_ps(disc,_mm_setzero_ps());
+    // Lanes that miss take the root of a negative number, their roots are garbage but masked off
+    const __m128 sdisc = _mm_sqrt_ps(_mm_max_ps(disc,_mm_setzero_ps()));
+    const __m128 inv2a = _mm_div_ps(_mm_set1_ps(1.0f),_mm_mul_ps(_mm_set1_ps(2.0f),a));
+    const __m128 negb = _mm_sub_ps(_mm_setzero_ps(),b);
+    _root1 = _mm_mul_ps(_mm_sub_ps(negb,sdisc),inv2a);
+    _root2 = _mm_mul_ps(_mm_add_ps(negb,sdisc),inv2a);
+    return _mm_movemask_ps(mask);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief four ray version of intersectParallelogram
+/// @param _rays - our rays (RayPacket4)
+/// @param _plane - normal and distance from the origin of the plane of our parallelogram (optix::float4)
+/// @param _anchor - corner of our parallelogram (optix::float3)
+/// @param _v1, _v2 - edges of our parallelogram scaled by one over their length squared (optix::float3)
+/// @param _t - returns the distance along each ray of its hit (__m128)
+/// @param _a1, _a2 - returns the coordinates of each hit along each edge (__m128)
+/// @returns a mask with bit i set if ray i hits our parallelogram (int)
+//----------------------------------------------------------------------------------------------------------------------
+static inline int intersectParallelogram4(const RayPacket4 &_rays, const optix::float4 &_plane,
+                                          const optix::float3 &_anchor, const optix::float3 &_v1,
+                                          const optix::float3 &_v2, __m128 &_t, __m128 &_a1, __m128 &_a2)
+{
+    const Vec3x4 n = splat(optix::make_float3(_plane));
+    const Vec3x4 o = {_rays.ox,_rays.oy,_rays.oz};
+    const Vec3x4 d = {_rays.dx,_rays.dy,_rays.dz};
+    _t = _mm_div_ps(_mm_sub_ps(_mm_set1_ps(_plane.w),dot(n,o)),dot(d,n));
+    const Vec3x4 vi = {_mm_sub_ps(_mm_add_ps(o.x,_mm_mul_ps(d.x,_t)),_mm_set1_ps(_anchor.x)),
+                       _mm_sub_ps(_mm_add_ps(o.y,_mm_mul_ps(d.y,_t)),_mm_set1_ps(_anchor.y)),
+                       _mm_sub_ps(_mm_add_ps(o.z,_mm_mul_ps(d.z,_t)),_mm_set1_ps(_anchor.z))};
+    _a1 = dot(splat(_v1),vi);
+    _a2 = dot(splat(_v2),vi);
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128 mask = _mm_and_ps(_mm_cmpgt_ps(_t,_rays.tmin),_mm_cmplt_ps(_t,_rays.tmax));
+    mask = _mm_and_ps(mask,_mm_and_ps(_mm_cmpge_ps(_a1,zero),_mm_cmple_ps(_a1,one)));
+    mask = _mm_and_ps(mask,_mm_and_ps(_mm_cmpge_ps(_a2,zero),_mm_cmple_ps(_a2,one)));
+    return _mm_movemask_ps(mask);
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif // INTERSECTSSE_H
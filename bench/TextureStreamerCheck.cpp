@@ -0,0 +1,233 @@
+/// @file TextureStreamerCheck.cpp
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Checks TextureStreamer in an offscreen OpenGL 4.1 context, such as Mesa's software rasterizer under
+/// @brief LIBGL_ALWAYS_SOFTWARE=1. For both our persistently mapped and our orphaned pixel buffers, and for each of
+/// @brief our frame formats, we stream random frames into our texture, one at a time and in bursts longer than our
+/// @brief ring, and through a resize, reading our texture back with glGetTexImage after each and comparing it with
+/// @brief our frame bit for bit. A frame whose frame number and edit version we already have must be skipped and
+/// @brief leave our texture as it was, and the next edit version must be uploaded again. Fails if any of these
+/// @brief don't hold or the GL raises an error. Persistent buffers are skipped where the driver doesn't have them.
+/// @brief Usage: TextureStreamerCheck [--width=<width>] [--height=<height>]
+
+// GLEW has to be included before any other GL header, including Qt's
+#include "gl/TextureStreamer.h"
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QSurfaceFormat>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <cstring>
+#include <cstdlib>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief number of pixel buffers in our ring, and how many frames we stream one at a time and in a burst
+//----------------------------------------------------------------------------------------------------------------------
+static const unsigned int g_numBuffers = 3;
+static const unsigned int g_numFrames = 8;
+static const unsigned int g_burstFrames = 2*g_numBuffers+1;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief name of a frame format
+//----------------------------------------------------------------------------------------------------------------------
+static const char *formatName(DisplayFrame::Format _format)
+{
+    switch(_format)
+    {
+        case(DisplayFrame::RGBA16F): return "RGBA16F";
+        case(DisplayFrame::RGBA8): return "RGBA8";
+        default: return "RGBA32F";
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief fills a frame with random pixels. Our halves and floats are finite and normal so that no driver has any
+/// @brief excuse to change their bits on the way through.
+/// @param _frame - frame to fill (DisplayFrame)
+/// @param _width - width of our frame (unsigned int)
+/// @param _height - height of our frame (unsigned int)
+/// @param _format - format of our frame (DisplayFrame::Format)
+/// @param _frameNumber - frame number of our frame, also seeds our pixels (unsigned int)
+/// @param _editVersion - edit version of our frame (unsigned long)
+//----------------------------------------------------------------------------------------------------------------------
+static void fillFrame(DisplayFrame &_frame, unsigned int _width, unsigned int _height, DisplayFrame::Format _format,
+                      unsigned int _frameNumber, unsigned long _editVersion)
+{
+    std::mt19937 rng(_frameNumber*7919u+(unsigned int)_editVersion);
+    unsigned int numValues = _width*_height*4;
+    _frame.m_width = _width;
+    _frame.m_height = _height;
+    _frame.m_format = _format;
+    _frame.m_frameNumber = _frameNumber;
+    _frame.m_editVersion = _editVersion;
+    _frame.m_cost = false;
+    _frame.m_pixels.clear();
+    _frame.m_display.clear();
+    if(_format==DisplayFrame::RGBA32F)
+    {
+        std::uniform_real_distribution<float> value(0.f,1000.f);
+        _frame.m_pixels.resize(numValues);
+        for(unsigned int i=0;i<numValues;i++) _frame.m_pixels[i] = value(rng);
+    }
+    else if(_format==DisplayFrame::RGBA16F)
+    {
+        // Exponents 1 to 30 are neither denormal, infinite nor NaN
+        _frame.m_display.resize(numValues*sizeof(unsigned short));
+        unsigned short *halves = reinterpret_cast<unsigned short*>(&_frame.m_display[0]);
+        for(unsigned int i=0;i<numValues;i++) halves[i] = (unsigned short)((1+rng()%30)<<10 | (rng()&0x3ff));
+    }
+    else
+    {
+        _frame.m_display.resize(numValues);
+        for(unsigned int i=0;i<numValues;i++) _frame.m_display[i] = (unsigned char)(rng()&0xff);
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief reads our texture back and compares it with a frame
+/// @param _streamer - our streamer (TextureStreamer)
+/// @param _frame - the frame our texture should hold (DisplayFrame)
+/// @returns if our texture holds exactly our frame (bool)
+//----------------------------------------------------------------------------------------------------------------------
+static bool textureMatches(TextureStreamer &_streamer, const DisplayFrame &_frame)
+{
+    GLenum type = GL_FLOAT;
+    if(_frame.m_format==DisplayFrame::RGBA16F) type = GL_HALF_FLOAT;
+    if(_frame.m_format==DisplayFrame::RGBA8) type = GL_UNSIGNED_BYTE;
+    size_t size = (size_t)_frame.m_width*_frame.m_height*DisplayFrame::getBytesPerPixel(_frame.m_format);
+    GLint width = 0, height = 0;
+    glBindTexture(GL_TEXTURE_2D,_streamer.getTextureID());
+    glGetTexLevelParameteriv(GL_TEXTURE_2D,0,GL_TEXTURE_WIDTH,&width);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D,0,GL_TEXTURE_HEIGHT,&height);
+    if((unsigned int)width!=_frame.m_width || (unsigned int)height!=_frame.m_height) return false;
+    // Our readback is poisoned first so a read that writes nothing can't pass
+    std::vector<unsigned char> readback(size,0xcd);
+    glPixelStorei(GL_PACK_ALIGNMENT,4);
+    glGetTexImage(GL_TEXTURE_2D,0,GL_RGBA,type,&readback[0]);
+    glBindTexture(GL_TEXTURE_2D,0);
+    return std::memcmp(&readback[0],_frame.getData(),size)==0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief runs all of our checks on one kind of pixel buffer and one format
+/// @param _persistent - if we ask for persistently mapped buffers (bool)
+/// @param _format - format of our frames (DisplayFrame::Format)
+/// @param _width - width of our frames (unsigned int)
+/// @param _height - height of our frames (unsigned int)
+/// @returns if everything held (bool)
+//----------------------------------------------------------------------------------------------------------------------
+static bool checkStreamer(bool _persistent, DisplayFrame::Format _format, unsigned int _width, unsigned int _height)
+{
+    TextureStreamer streamer(g_numBuffers,_persistent);
+    std::cout<<std::left<<std::setw(12)<<((_persistent) ? "persistent" : "orphaned")<<std::setw(10)<<formatName(_format);
+    if(streamer.isPersistent()!=_persistent)
+    {
+        std::cout<<"skipped, not supported by this driver"<<std::endl;
+        return true;
+    }
+
+    const char *failure = 0;
+    DisplayFrame frame;
+    unsigned int frameNumber = 1;
+    // One at a time, read back after every upload
+    for(unsigned int i=0;i<g_numFrames && !failure;i++,frameNumber++)
+    {
+        fillFrame(frame,_width,_height,_format,frameNumber,0);
+        if(!streamer.upload(frame)) failure = "a new frame was skipped";
+        else if(!textureMatches(streamer,frame)) failure = "texture differs from our frame";
+    }
+    // In a burst that goes round our ring more than twice before we read back
+    for(unsigned int i=0;i<g_burstFrames && !failure;i++,frameNumber++)
+    {
+        fillFrame(frame,_width,_height,_format,frameNumber,0);
+        if(!streamer.upload(frame)) failure = "a new frame was skipped";
+    }
+    if(!failure && !textureMatches(streamer,frame)) failure = "texture differs from the last frame of a burst";
+    // Through a resize, which reallocates our texture and buffers
+    if(!failure)
+    {
+        fillFrame(frame,_width/2+1,_height/3+1,_format,frameNumber++,0);
+        if(!streamer.upload(frame) || !textureMatches(streamer,frame)) failure = "texture differs after a resize";
+    }
+    // The same frame number and edit version is the frame we already have, even if its pixels differ
+    if(!failure)
+    {
+        DisplayFrame same;
+        fillFrame(same,frame.m_width,frame.m_height,_format,frame.m_frameNumber,frame.m_editVersion+1);
+        same.m_editVersion = frame.m_editVersion;
+        if(streamer.upload(same)) failure = "a frame we already have was uploaded again";
+        else if(!textureMatches(streamer,frame)) failure = "a skipped frame changed our texture";
+    }
+    // but an edit restarts our frame numbers so the next edit version must be uploaded
+    if(!failure)
+    {
+        fillFrame(frame,frame.m_width,frame.m_height,_format,frame.m_frameNumber,frame.m_editVersion+1);
+        if(!streamer.upload(frame)) failure = "a frame of a new edit was skipped";
+        else if(!textureMatches(streamer,frame)) failure = "texture differs from a frame of a new edit";
+    }
+    GLenum error = glGetError();
+    if(!failure && error!=GL_NO_ERROR) failure = "GL error";
+
+    if(failure) std::cout<<"FAILED, "<<failure;
+    else std::cout<<"ok";
+    if(error!=GL_NO_ERROR) std::cout<<" 0x"<<std::hex<<error<<std::dec;
+    std::cout<<std::endl;
+    return !failure;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    QGuiApplication app(argc,argv);
+    unsigned int width = 317;
+    unsigned int height = 211;
+    for(int i=1;i<argc;i++)
+    {
+        if(std::strncmp(argv[i],"--width=",8)==0) width = std::atoi(argv[i]+8);
+        else if(std::strncmp(argv[i],"--height=",9)==0) height = std::atoi(argv[i]+9);
+        else
+        {
+            std::cerr<<"Unknown argument "<<argv[i]<<std::endl;
+            return 1;
+        }
+    }
+    if(width==0 || height==0)
+    {
+        std::cerr<<"Width and height must be greater than 0"<<std::endl;
+        return 1;
+    }
+
+    // The same 4.1 core profile our widget asks for
+    QSurfaceFormat format;
+    format.setVersion(4,1);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    QOpenGLContext context;
+    context.setFormat(format);
+    QOffscreenSurface surface;
+    surface.setFormat(format);
+    surface.create();
+    if(!context.create() || !context.makeCurrent(&surface))
+    {
+        std::cerr<<"Could not create an OpenGL 4.1 context"<<std::endl;
+        return 1;
+    }
+#ifndef DARWIN
+    glewExperimental = GL_TRUE;
+    if(glewInit()!=GLEW_OK)
+    {
+        std::cerr<<"GLEW IS NOT OK!!! "<<std::endl;
+        return 1;
+    }
+    // GLEW can raise an error looking for extensions the old way in a core profile
+    glGetError();
+#endif
+    std::cout<<"OpenGL "<<glGetString(GL_VERSION)<<" on "<<glGetString(GL_RENDERER)<<", "<<width<<"x"<<height
+             <<" frames"<<std::endl;
+
+    const DisplayFrame::Format formats[] = {DisplayFrame::RGBA32F,DisplayFrame::RGBA16F,DisplayFrame::RGBA8};
+    bool ok = true;
+    for(int p=0;p<2;p++)
+        for(int f=0;f<3;f++)
+            ok &= checkStreamer(p==0,formats[f],width,height);
+
+    context.doneCurrent();
+    return (ok) ? 0 : 1;
+}
@@ -0,0 +1,32 @@
+# Checks our texture streaming in an offscreen OpenGL context, see TextureStreamerCheck.cpp.
+# Needs Qt 5 for its offscreen surface and GLEW, but not OptiX, CUDA or a GPU. Run it under LIBGL_ALWAYS_SOFTWARE=1
+# to use Mesa's software rasterizer, and under xvfb-run on a machine without a display.
+TARGET=TextureStreamerCheck
+OBJECTS_DIR=obj
+QT+=gui core
+CONFIG-=app_bundle
+CONFIG+=console c++11 release
+SOURCES += TextureStreamerCheck.cpp \
+           ../src/gl/TextureStreamer.cpp \
+           ../src/renderer/FrameHandoff.cpp
+HEADERS += ../include/gl/TextureStreamer.h \
+           ../include/renderer/FrameHandoff.h
+INCLUDEPATH += ../include
+DESTDIR=./
+
+macx:QMAKE_CXXFLAGS+= -arch x86_64
+macx:DEFINES += DARWIN
+
+# The same GL setup as Phenix.pro
+unix:LIBS += -L/usr/local/lib
+linux-*{
+                DEFINES += LINUX
+                LIBS += -lGLEW
+}
+win32:{
+    DEFINES+=WIN32
+    DEFINES+=_WIN32
+    DEFINES += GLEW_STATIC
+    LIBS+= -lopengl32 -lglew32s
+    DEFINES += NOMINMAX
+}
@@ -0,0 +1,145 @@
+#ifndef AUTOEXPOSURE_H
+#define AUTOEXPOSURE_H
+
+/// @class AutoExposure
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Measures the luminance of our HDR images and picks the parameters of the tonemap in common/helpers.h from
+/// @brief it. Our measurement is a parallel SSE reduction giving the log average and max luminance of an image along
+/// @brief with a histogram of its log luminance. Our key is the mean of the middle of that histogram so a few very
+/// @brief dark or very bright pixels can't swing our exposure, and it is smoothed over time so our view adapts
+/// @brief rather than flickering as our image converges. There is also a scalar version of our measurement and a
+/// @brief CPU resolve matching our display resolve program so that we can check both without a GPU.
+
+#include "renderer/FrameHandoff.h"
+
+class AutoExposure
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of bins in our histogram and the range of log2 luminance they cover
+    //----------------------------------------------------------------------------------------------------------------------
+    static const int NumBins = 64;
+    static const int MinLog2 = -16;
+    static const int MaxLog2 = 16;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the luminance of an image
+    //----------------------------------------------------------------------------------------------------------------------
+    struct LuminanceStats
+    {
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief log average luminance, exp of the mean of log(delta+Y) as in Reinhard et al.
+        //----------------------------------------------------------------------------------------------------------------------
+        float m_logAverage;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief largest luminance
+        //----------------------------------------------------------------------------------------------------------------------
+        float m_max;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief number of pixels in each bin of our log2 luminance histogram, black pixels aren't counted
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_histogram[NumBins];
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief number of pixels we measured
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_numPixels;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the parameters our images are resolved for display with
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Params
+    {
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief linear scale applied before our tonemap
+        //----------------------------------------------------------------------------------------------------------------------
+        float m_exposure;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief if we tonemap, otherwise our exposed image is clamped
+        //----------------------------------------------------------------------------------------------------------------------
+        bool m_tonemap;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief the Y_log_av and Y_max of our tonemap
+        //----------------------------------------------------------------------------------------------------------------------
+        float m_logAverage;
+        float m_white;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief default constructor, leaves our image as it is apart from compressing luminance above 4
+        //----------------------------------------------------------------------------------------------------------------------
+        Params() : m_exposure(1.f), m_tonemap(true), m_logAverage(0.04f), m_white(4.f){}
+        //----------------------------------------------------------------------------------------------------------------------
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief default constructor
+    //----------------------------------------------------------------------------------------------------------------------
+    AutoExposure();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief measures the luminance of an RGBA float image with SSE across all of our cores
+    /// @param _rgba - our pixels (const float*)
+    /// @param _numPixels - number of pixels in our image (unsigned int)
+    /// @returns our luminance (LuminanceStats)
+    //----------------------------------------------------------------------------------------------------------------------
+    static LuminanceStats measure(const float *_rgba, unsigned int _numPixels);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief measures the luminance of an RGBA float image one pixel at a time on the calling thread. Our reference
+    /// @brief for measure(), which approximates its logs so agrees to within a small fraction of a stop.
+    /// @param _rgba - our pixels (const float*)
+    /// @param _numPixels - number of pixels in our image (unsigned int)
+    /// @returns our luminance (LuminanceStats)
+    //----------------------------------------------------------------------------------------------------------------------
+    static LuminanceStats measureScalar(const float *_rgba, unsigned int _numPixels);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief adapts our key and white point towards those of a newly measured image
+    /// @param _stats - luminance of our image (LuminanceStats)
+    /// @param _seconds - time since our last update, 0 to snap straight to our new image (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    void update(const LuminanceStats &_stats, float _seconds);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief forgets our history so our next update snaps to its image, for when our scene changes completely
+    //----------------------------------------------------------------------------------------------------------------------
+    inline void reset(){m_valid = false;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief fills in the tonemap parameters of our current adaptation, leaving our exposure and tonemap flag alone
+    /// @param _params - parameters to fill in (Params)
+    //----------------------------------------------------------------------------------------------------------------------
+    void getParams(Params &_params) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets the fraction of our pixels, darkest first, our key is averaged between
+    /// @param _low - fraction of our darkest pixels ignored (float)
+    /// @param _high - fraction of our pixels below the brightest we use (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setPercentiles(float _low, float _high);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets how quickly we adapt, the fraction of the way to our target we move in a second is 1-exp(-_rate)
+    //----------------------------------------------------------------------------------------------------------------------
+    inline void setAdaptationRate(float _rate){m_rate = _rate;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief resolves an RGBA float image for display on the CPU in the same way as our display resolve program
+    /// @param _hdr - our image, must be RGBA32F (DisplayFrame)
+    /// @param _params - parameters to resolve with (Params)
+    /// @param _out - returns an RGBA8 copy of our image (DisplayFrame)
+    //----------------------------------------------------------------------------------------------------------------------
+    static void resolve(const DisplayFrame &_hdr, const Params &_params, DisplayFrame &_out);
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our smoothed log2 key and white luminance
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_log2Key;
+    float m_log2White;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief if we have adapted to any image yet
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_valid;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the fraction of our pixels our key is averaged between
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_lowPercentile;
+    float m_highPercentile;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief how quickly we adapt
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_rate;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // AUTOEXPOSURE_H
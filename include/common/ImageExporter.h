@@ -0,0 +1,171 @@
+#ifndef IMAGEEXPORTER_H
+#define IMAGEEXPORTER_H
+
+/// @class ImageExporter
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Singleton writing our frames to disk on a small pool of background threads so that our render doesn't stop
+/// @brief while we save, and a slow write to disk doesn't hold up the conversion of the next frame in our queue.
+/// @brief 8 bit images are written through QImage, float images as PFM, as Radiance .hdr with the RLE scanlines our
+/// @brief HDRLoader reads, or as uncompressed scanline OpenEXR with half or float channels. Our frames are converted
+/// @brief a row at a time across all of our cores, with SSE for our RGBE, half and 8 bit packing.
+
+#include "renderer/FrameHandoff.h"
+#include "common/AutoExposure.h"
+#include <string>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+class ImageExporter
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the formats we can write
+    //----------------------------------------------------------------------------------------------------------------------
+    enum Format{PNG,JPEG,BMP,GIF,PFM,HDR,EXRHalf,EXRFloat,NumFormats};
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns an instance of our singleton class
+    //----------------------------------------------------------------------------------------------------------------------
+    static ImageExporter *getInstance();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief destructor, finishes any exports still waiting before returning
+    //----------------------------------------------------------------------------------------------------------------------
+    ~ImageExporter();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns if a format holds our raw float radiance rather than an image resolved for display
+    //----------------------------------------------------------------------------------------------------------------------
+    static inline bool isFloat(Format _format){return _format>=PFM && _format<NumFormats;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns the file extension of a format without its dot
+    //----------------------------------------------------------------------------------------------------------------------
+    static const char *getExtension(Format _format);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns the name filter of a format for our file dialogs, e.g. "PNG (*.png)"
+    //----------------------------------------------------------------------------------------------------------------------
+    static const char *getFileFilter(Format _format);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns the name filters of all of our formats separated by ;; as our file dialogs want them
+    //----------------------------------------------------------------------------------------------------------------------
+    static std::string getFileFilters();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns the format of a name filter selected in our file dialogs
+    /// @param _filter - the selected name filter (std::string)
+    /// @returns our format, PNG if we don't know our filter (Format)
+    //----------------------------------------------------------------------------------------------------------------------
+    static Format getFormat(const std::string &_filter);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes a frame on the calling thread
+    /// @param _path - file to write (std::string)
+    /// @param _frame - our frame, float formats need an RGBA32F frame (DisplayFrame)
+    /// @param _format - format to write (Format)
+    /// @param _params - parameters RGBA32F frames are resolved with for our 8 bit formats (AutoExposure::Params)
+    /// @param _resolve - if RGBA32F frames are resolved for our 8 bit formats, otherwise they are only clamped (bool)
+    /// @returns if our frame was written (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    static bool write(const std::string &_path, const DisplayFrame &_frame, Format _format,
+                      const AutoExposure::Params &_params = AutoExposure::Params(), bool _resolve = true);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief queues a frame to be written by our background threads, our frame is taken so this returns immediately
+    /// @param _path - file to write (std::string)
+    /// @param _frame - our frame, left empty (DisplayFrame)
+    /// @param _format - format to write (Format)
+    /// @param _params - parameters RGBA32F frames are resolved with for our 8 bit formats (AutoExposure::Params)
+    /// @param _resolve - if RGBA32F frames are resolved for our 8 bit formats, otherwise they are only clamped (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    void exportAsync(const std::string &_path, DisplayFrame &_frame, Format _format,
+                     const AutoExposure::Params &_params = AutoExposure::Params(), bool _resolve = true);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns the number of exports queued or being written
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int getNumPending();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of frames we write at once, each is converted across all of our cores
+    //----------------------------------------------------------------------------------------------------------------------
+    static const unsigned int m_numThreads = 2;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief converts RGBA floats to RGBE with SSE, negative and NaN values are written as 0
+    /// @param _rgba - our pixels (const float*)
+    /// @param _rgbe - returns 4 bytes per pixel (unsigned char*)
+    /// @param _numPixels - number of pixels to convert (unsigned int)
+    //----------------------------------------------------------------------------------------------------------------------
+    static void toRGBE(const float *_rgba, unsigned char *_rgbe, unsigned int _numPixels);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief converts floats to halfs with SSE, rounding to nearest. Values too large for a half become infinite.
+    /// @param _src - our floats (const float*)
+    /// @param _dst - returns our halfs (unsigned short*)
+    /// @param _count - number of values to convert (unsigned int)
+    //----------------------------------------------------------------------------------------------------------------------
+    static void toHalf(const float *_src, unsigned short *_dst, unsigned int _count);
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief Constructor, starts our background threads
+    //----------------------------------------------------------------------------------------------------------------------
+    ImageExporter();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a frame waiting to be written
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Job
+    {
+        std::string m_path;
+        DisplayFrame m_frame;
+        Format m_format;
+        AutoExposure::Params m_params;
+        bool m_resolve;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief run by each of our background threads, writes our queued jobs until we are destroyed
+    //----------------------------------------------------------------------------------------------------------------------
+    void run();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes an 8 bit image through QImage
+    //----------------------------------------------------------------------------------------------------------------------
+    static bool writeLDR(const std::string &_path, const DisplayFrame &_frame, Format _format,
+                         const AutoExposure::Params &_params, bool _resolve);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes a Radiance .hdr image with RLE scanlines
+    //----------------------------------------------------------------------------------------------------------------------
+    static bool writeHDR(const std::string &_path, const DisplayFrame &_frame);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes an uncompressed scanline OpenEXR image
+    /// @param _half - if our channels are half, otherwise float (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    static bool writeEXR(const std::string &_path, const DisplayFrame &_frame, bool _half);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief run length encodes a scanline of RGBE pixels in the new style RLE of Radiance
+    /// @param _rgbe - our pixels (const unsigned char*)
+    /// @param _width - number of pixels in our scanline, 8 to 0x7fff (unsigned int)
+    /// @param _out - returns our encoded scanline (std::vector<unsigned char>)
+    //----------------------------------------------------------------------------------------------------------------------
+    static void encodeScanline(const unsigned char *_rgbe, unsigned int _width, std::vector<unsigned char> &_out);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief mutex to protect our queue
+    //----------------------------------------------------------------------------------------------------------------------
+    std::mutex m_mutex;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief signalled when a job is queued or we are destroyed
+    //----------------------------------------------------------------------------------------------------------------------
+    std::condition_variable m_wake;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief frames waiting to be written
+    //----------------------------------------------------------------------------------------------------------------------
+    std::deque<Job*> m_jobs;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of jobs our background threads are writing
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_numBusy;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set to stop our background threads once our queue is empty
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_quit;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our background threads
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<std::thread> m_threads;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // IMAGEEXPORTER_H
@@ -0,0 +1,55 @@
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+/// @file ParallelFor.h
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Splits a range of work into contiguous chunks run on their own threads. Each chunk is told its index so that
+/// @brief reductions can keep a partial result per chunk and combine them once we return. Small ranges are run on the
+/// @brief calling thread so the cost of starting threads is only paid when there is enough work to hide it.
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief returns the number of chunks parallelFor will split a range into
+/// @param _count - number of items in our range (unsigned int)
+/// @param _grain - smallest number of items worth giving a thread (unsigned int)
+/// @returns number of chunks, at least 1 (unsigned int)
+//----------------------------------------------------------------------------------------------------------------------
+inline unsigned int parallelForChunks(unsigned int _count, unsigned int _grain)
+{
+    unsigned int threads = std::max(std::thread::hardware_concurrency(),1u);
+    return std::max(std::min(threads,_count/std::max(_grain,1u)),1u);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief calls _func(begin,end,chunk) for each chunk of [0,_count), one chunk per thread. Returns once all are done.
+/// @param _count - number of items in our range (unsigned int)
+/// @param _grain - smallest number of items worth giving a thread (unsigned int)
+/// @param _func - function to call for each chunk (void(unsigned int,unsigned int,unsigned int))
+//----------------------------------------------------------------------------------------------------------------------
+template<typename Func>
+void parallelFor(unsigned int _count, unsigned int _grain, Func _func)
+{
+    unsigned int chunks = parallelForChunks(_count,_grain);
+    if(chunks==1)
+    {
+        _func(0u,_count,0u);
+        return;
+    }
+    // The calling thread takes our last chunk rather than sitting idle
+    std::vector<std::thread> threads;
+    threads.reserve(chunks-1);
+    unsigned int chunkSize = (_count+chunks-1)/chunks;
+    for(unsigned int c=0;c<chunks-1;c++)
+    {
+        unsigned int begin = std::min(c*chunkSize,_count);
+        unsigned int end = std::min(begin+chunkSize,_count);
+        threads.push_back(std::thread(_func,begin,end,c));
+    }
+    _func(std::min((chunks-1)*chunkSize,_count),_count,chunks-1);
+    for(unsigned int i=0;i<threads.size();i++) threads[i].join();
+}
+
+#endif // PARALLELFOR_H
@@ -0,0 +1,114 @@
+#ifndef ROBUSTACCUMULATOR_H
+#define ROBUSTACCUMULATOR_H
+
+/// @class RobustAccumulator
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Accumulates a sequence of frames into an estimate of our image on our CPU, so that how precisely we
+/// @brief accumulate and how we deal with fireflies can be checked without a GPU. Our running means are kept in
+/// @brief float32 as our path tracer does, in float32 with Kahan compensation using the same code as our path tracer
+/// @brief from common/accumulate.h, or in double. Our estimate is either their plain mean, our mean with each frame
+/// @brief clamped to some standard deviations above it as our path tracer can, or a median of means. For a median of
+/// @brief means our frames are dealt round a number of buckets and we take the bucket whose mean has the median
+/// @brief luminance, so a firefly only ever lands in one bucket and is outvoted by the rest. That only holds while
+/// @brief fewer than half of our buckets have caught a firefly, roughly while frames times the chance of a firefly
+/// @brief stays below 0.7 times our number of buckets. Past that our median lands on a bucket with fireflies in it
+/// @brief and is barely better than our plain mean, so longer renders or brighter scenes need more buckets. Our 64
+/// @brief by default cope with one firefly in every 10000 frames over 200000 frames. All of our work is split across
+/// @brief our cores by pixel.
+
+#include <vector>
+#include "common/accumulate.h"
+
+class RobustAccumulator
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief how precisely we keep our running means
+    //----------------------------------------------------------------------------------------------------------------------
+    enum Precision{Float,Kahan,Double};
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief how we estimate our image from our frames
+    //----------------------------------------------------------------------------------------------------------------------
+    enum Estimator{Mean,Clamped,MedianOfMeans};
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief constructor
+    /// @param _numPixels - number of pixels in our frames (unsigned int)
+    /// @param _precision - how precisely we keep our running means (Precision)
+    /// @param _estimator - how we estimate our image (Estimator)
+    /// @param _numBuckets - number of buckets our median of means deals our frames into, each as big as a mean (unsigned int)
+    /// @param _sigmas - standard deviations above our mean our clamped estimate allows (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    RobustAccumulator(unsigned int _numPixels, Precision _precision = Kahan, Estimator _estimator = Mean,
+                      unsigned int _numBuckets = 64, float _sigmas = FIREFLY_DEFAULT_SIGMAS);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief forgets every frame we have accumulated
+    //----------------------------------------------------------------------------------------------------------------------
+    void clear();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accumulates a frame
+    /// @param _rgba - RGBA of each of our pixels, our alpha is ignored (const float*)
+    //----------------------------------------------------------------------------------------------------------------------
+    void addFrame(const float *_rgba);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes our estimate of our image
+    /// @param _rgba - returns RGBA of each of our pixels, our alpha is 1 (float*)
+    //----------------------------------------------------------------------------------------------------------------------
+    void resolve(float *_rgba) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessors to our settings and the number of frames we have accumulated
+    //----------------------------------------------------------------------------------------------------------------------
+    inline unsigned int getNumPixels(){return m_numPixels;}
+    inline Precision getPrecision(){return m_precision;}
+    inline Estimator getEstimator(){return m_estimator;}
+    inline unsigned int getNumBuckets(){return m_numBuckets;}
+    inline unsigned int getNumFrames(){return m_numFrames;}
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief moves one of our running means towards a value
+    /// @param _index - index of our mean, bucket*numPixels+pixel (unsigned int)
+    /// @param _value - our value (optix::float3)
+    /// @param _n - number of values in our mean including this one (unsigned int)
+    /// @param _means - our means, RGB (std::vector<float>)
+    /// @param _compensation - what our means are short by, RGB (std::vector<float>)
+    /// @param _doubles - our means when we keep them in double, RGB (std::vector<double>)
+    //----------------------------------------------------------------------------------------------------------------------
+    void accumulate(unsigned int _index, const optix::float3 &_value, unsigned int _n, std::vector<float> &_means,
+                    std::vector<float> &_compensation, std::vector<double> &_doubles);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief reads back one of our running means
+    //----------------------------------------------------------------------------------------------------------------------
+    optix::float3 getMean(unsigned int _index, const std::vector<float> &_means, const std::vector<double> &_doubles) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of pixels in our frames
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_numPixels;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our settings
+    //----------------------------------------------------------------------------------------------------------------------
+    Precision m_precision;
+    Estimator m_estimator;
+    unsigned int m_numBuckets;
+    float m_sigmas;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of frames we have accumulated
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_numFrames;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the running mean of each of our buckets, bucket by bucket, and what float32 has rounded away from them.
+    /// @brief Only our median of means has more than one bucket.
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<float> m_means;
+    std::vector<float> m_compensation;
+    std::vector<double> m_doubles;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the running mean of the square of our frames our clamped estimate takes our deviation from
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<float> m_moments;
+    std::vector<float> m_momentCompensation;
+    std::vector<double> m_momentDoubles;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // ROBUSTACCUMULATOR_H
@@ -0,0 +1,92 @@
+#ifndef ACCUMULATE_H
+#define ACCUMULATE_H
+
+/// @file accumulate.h
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief How our path tracer folds each launch into the running mean of a pixel, shared by path_tracer.cu and
+/// @brief RobustAccumulator so that the same code can be checked on our CPU. Our running mean is updated a little
+/// @brief at a time, by 1/n of the difference to our new estimate, so in float32 most of that update is rounded away
+/// @brief once n reaches the thousands. We carry what was rounded away in a compensation term as in Kahan summation.
+/// @brief Fireflies, the rare paths that find a bright light through a small chance, are clamped to a number of
+/// @brief standard deviations above our mean taken from the second moment we accumulate alongside it.
+
+#include <optixu/optixu_math_namespace.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief number of launches we accumulate before our variance is trusted enough to clamp fireflies with
+//----------------------------------------------------------------------------------------------------------------------
+#define FIREFLY_MIN_FRAMES 16
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief number of standard deviations above our mean we clamp to when fireflies are suppressed
+//----------------------------------------------------------------------------------------------------------------------
+#define FIREFLY_DEFAULT_SIGMAS 4.0f
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief adds a value to a sum, carrying what is rounded away in a compensation term
+/// @param sum - our sum (float3)
+/// @param compensation - what our sum is short by, 0 to start with (float3)
+/// @param value - value to add (float3)
+//----------------------------------------------------------------------------------------------------------------------
+static __host__ __device__ __inline__ void kahan_add(optix::float3 &sum, optix::float3 &compensation, const optix::float3 &value)
+{
+  optix::float3 y = value - compensation;
+  optix::float3 t = sum + y;
+  compensation = (t - sum) - y;
+  sum = t;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief moves a running mean towards our n'th estimate
+/// @param mean - mean of our first n-1 estimates (float3)
+/// @param compensation - what our mean is short by, only used if compensate is set (float3)
+/// @param value - our n'th estimate (float3)
+/// @param n - number of estimates including this one, 1 or more (unsigned int)
+/// @param compensate - if we carry what is rounded away, otherwise this is the lerp we have always done (bool)
+//----------------------------------------------------------------------------------------------------------------------
+static __host__ __device__ __inline__ void accumulate_mean(optix::float3 &mean, optix::float3 &compensation,
+                                                           const optix::float3 &value, unsigned int n, bool compensate)
+{
+  if (n <= 1)
+  {
+    mean = value;
+    compensation = optix::make_float3(0.0f);
+  }
+  else if (compensate)
+  {
+    kahan_add(mean, compensation, (value - mean) / (float)n);
+  }
+  else
+  {
+    mean = optix::lerp(mean, value, 1.0f / (float)n);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief scales a firefly down to a number of standard deviations above the mean of our pixel. Our whole colour is
+/// @brief scaled so its hue is kept. A pixel that has only ever been black has no deviation to allow anything, so
+/// @brief our limit never falls below sigmas times our mean either. This biases our image darker where fireflies
+/// @brief are clamped, in exchange for it converging in a fraction of the time.
+/// @param value - our estimate (float3)
+/// @param mean - mean of our pixel so far (float3)
+/// @param moment - mean of the square of our pixel so far (float3)
+/// @param n - number of estimates in our mean, we don't clamp until we have FIREFLY_MIN_FRAMES (unsigned int)
+/// @param sigmas - how many standard deviations above our mean we allow, 0 to never clamp (float)
+/// @returns our clamped estimate (float3)
+//----------------------------------------------------------------------------------------------------------------------
+static __host__ __device__ __inline__ optix::float3 clamp_firefly(const optix::float3 &value, const optix::float3 &mean,
+                                                                  const optix::float3 &moment, unsigned int n, float sigmas)
+{
+  if (sigmas <= 0.0f || n < FIREFLY_MIN_FRAMES) return value;
+  optix::float3 deviation = optix::make_float3(sqrtf(fmaxf(moment.x - mean.x*mean.x, 0.0f)),
+                                               sqrtf(fmaxf(moment.y - mean.y*mean.y, 0.0f)),
+                                               sqrtf(fmaxf(moment.z - mean.z*mean.z, 0.0f)));
+  optix::float3 limit = mean + sigmas * optix::fmaxf(deviation, mean);
+  float scale = 1.0f;
+  if (value.x > limit.x) scale = fminf(scale, limit.x / value.x);
+  if (value.y > limit.y) scale = fminf(scale, limit.y / value.y);
+  if (value.z > limit.z) scale = fminf(scale, limit.z / value.z);
+  return value * scale;
+}
+
+#endif // ACCUMULATE_H
@@ -0,0 +1,30 @@
+#ifndef COST_H
+#define COST_H
+
+/// @file cost.h
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Per pixel work counters for our cost heat map, shared by our ray generation and intersection programs.
+/// @brief OptiX runs every program called for a launch index on the same thread so the counters need no atomics.
+/// @brief Nothing is written unless debug_cost is set so they cost a single branch when we're not profiling.
+
+#include <optix.h>
+#include <optixu/optixu_math_namespace.h>
+
+rtDeclareVariable(unsigned int,  debug_cost, , );
+rtDeclareVariable(optix::uint2,  cost_launch_index, rtLaunchIndex, );
+// Pixel our launch starts at when only a region of our image is traced, see AbstractOptixRenderer::setRenderRegion.
+// Declared here so our intersection programs and our ray generation program share it.
+rtDeclareVariable(optix::uint2,  region_offset, , );
+rtBuffer<unsigned int, 2>        prim_tests;
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief counts a ray/primitive test against the pixel of the ray being traced
+//----------------------------------------------------------------------------------------------------------------------
+static __device__ __inline__ void countPrimitiveTest()
+{
+    if(debug_cost) prim_tests[cost_launch_index + region_offset]++;
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif // COST_H
@@ -0,0 +1,22 @@
+#ifndef FILM_FILTER_H
+#define FILM_FILTER_H
+
+/// @file film_filter.h
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Layout of the reconstruction filter table shared by path_tracer.cu and Film. Plain defines so it can be
+/// @brief included by both nvcc and our host code. Our GPU can't splat a sample into its neighbouring pixels without
+/// @brief atomics so it importance samples our filter instead, warping each sample's position in its pixel through
+/// @brief the inverse CDF of our filter. Our table holds that inverse CDF for one axis of our separable filter,
+/// @brief FILM_FILTER_TABLE_SIZE+1 offsets in pixels from our pixel centre for u = 0 to 1 in equal steps.
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief number of steps in our filter tables
+//----------------------------------------------------------------------------------------------------------------------
+#define FILM_FILTER_TABLE_SIZE 64
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief largest filter radius in pixels we allow, a sample reaches at most 2*FILM_MAX_RADIUS+1 pixels along an axis
+//----------------------------------------------------------------------------------------------------------------------
+#define FILM_MAX_RADIUS 4
+
+#endif // FILM_FILTER_H
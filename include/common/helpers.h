@@ -235,3 +235,15 @@ static __host__ __device__ __inline__ optix::float3 tonemap( const optix::float3
 }
 
 
+// Linear to sRGB transfer function for a display value in [0,1]
+static __host__ __device__ __inline__ float linear2srgb( float c )
+{
+  c = optix::clamp( c, 0.0f, 1.0f );
+  return ( c <= 0.0031308f ) ? 12.92f * c : 1.055f * powf( c, 1.0f / 2.4f ) - 0.055f;
+}
+
+static __host__ __device__ __inline__ optix::float3 linear2srgb( const optix::float3 &c )
+{
+  return optix::make_float3( linear2srgb( c.x ), linear2srgb( c.y ), linear2srgb( c.z ) );
+}
+
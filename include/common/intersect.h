@@ -0,0 +1,102 @@
+#ifndef INTERSECT_H
+#define INTERSECT_H
+
+/// @file intersect.h
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Ray/primitive intersection tests shared by our OptiX intersection programs and host code such as our
+/// @brief intersection microbenchmarks. They only do the maths, reporting the intersection to OptiX and filling in
+/// @brief attributes is left to the programs that call them.
+
+#include <optixu/optixu_math_namespace.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief intersects a ray with a triangle using the Moller-Trumbore test
+/// @param _o - origin of our ray (optix::float3)
+/// @param _d - direction of our ray (optix::float3)
+/// @param _tmin - closest distance along our ray we accept a hit (float)
+/// @param _tmax - furthest distance along our ray we accept a hit (float)
+/// @param _p0, _p1, _p2 - vertices of our triangle (optix::float3)
+/// @param _n - returns the unnormalized geometric normal of our triangle (optix::float3)
+/// @param _t - returns the distance along our ray of our hit (float)
+/// @param _beta, _gamma - returns the barycentric coordinates of our hit for _p1 and _p2 (float)
+/// @returns true if our ray hits our triangle between _tmin and _tmax (bool)
+//----------------------------------------------------------------------------------------------------------------------
+static __host__ __device__ __inline__ bool intersectTriangle(const optix::float3 &_o, const optix::float3 &_d,
+                                                             float _tmin, float _tmax,
+                                                             const optix::float3 &_p0, const optix::float3 &_p1,
+                                                             const optix::float3 &_p2, optix::float3 &_n,
+                                                             float &_t, float &_beta, float &_gamma)
+{
+    const optix::float3 e0 = _p1 - _p0;
+    const optix::float3 e1 = _p0 - _p2;
+    _n = optix::cross(e1,e0);
+
+    const optix::float3 e2 = (1.0f/optix::dot(_n,_d)) * (_p0 - _o);
+    const optix::float3 i = optix::cross(_d,e2);
+
+    _beta = optix::dot(i,e1);
+    _gamma = optix::dot(i,e0);
+    _t = optix::dot(_n,e2);
+
+    return ( (_t<_tmax) & (_t>_tmin) & (_beta>=0.0f) & (_gamma>=0.0f) & (_beta+_gamma<=1.0f) );
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief intersects a ray with a sphere
+/// @param _o - origin of our ray (optix::float3)
+/// @param _d - direction of our ray (optix::float3)
+/// @param _center - center of our sphere (optix::float3)
+/// @param _radius - radius of our sphere (float)
+/// @param _root1 - returns the distance to our nearest intersection (float)
+/// @param _root2 - returns the distance to our furthest intersection (float)
+/// @returns true if the line of our ray hits our sphere, the roots still need checking against the ray interval (bool)
+//----------------------------------------------------------------------------------------------------------------------
+static __host__ __device__ __inline__ bool intersectSphere(const optix::float3 &_o, const optix::float3 &_d,
+                                                           const optix::float3 &_center, float _radius,
+                                                           float &_root1, float &_root2)
+{
+    const optix::float3 O = _o - _center;
+    const float a = optix::dot(_d,_d);
+    const float b = 2.0f * optix::dot(_d,O);
+    const float c = optix::dot(O,O) - (_radius*_radius);
+    const float disc = b*b - (4.0f*a*c);
+    if(disc<=0.0f) return false;
+    const float sdisc = sqrtf(disc);
+    const float inv2a = 1.0f/(2.0f*a);
+    _root1 = (-b - sdisc) * inv2a;
+    _root2 = (-b + sdisc) * inv2a;
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief intersects a ray with a parallelogram
+/// @param _o - origin of our ray (optix::float3)
+/// @param _d - direction of our ray (optix::float3)
+/// @param _tmin - closest distance along our ray we accept a hit (float)
+/// @param _tmax - furthest distance along our ray we accept a hit (float)
+/// @param _plane - normal and distance from the origin of the plane of our parallelogram (optix::float4)
+/// @param _anchor - corner of our parallelogram (optix::float3)
+/// @param _v1, _v2 - edges of our parallelogram scaled by one over their length squared (optix::float3)
+/// @param _t - returns the distance along our ray of our hit (float)
+/// @param _a1, _a2 - returns the coordinates of our hit along each edge (float)
+/// @returns true if our ray hits our parallelogram between _tmin and _tmax (bool)
+//----------------------------------------------------------------------------------------------------------------------
+static __host__ __device__ __inline__ bool intersectParallelogram(const optix::float3 &_o, const optix::float3 &_d,
+                                                                  float _tmin, float _tmax,
+                                                                  const optix::float4 &_plane,
+                                                                  const optix::float3 &_anchor,
+                                                                  const optix::float3 &_v1, const optix::float3 &_v2,
+                                                                  float &_t, float &_a1, float &_a2)
+{
+    const optix::float3 n = optix::make_float3(_plane);
+    const float dt = optix::dot(_d,n);
+    _t = (_plane.w - optix::dot(n,_o))/dt;
+    if(!(_t>_tmin && _t<_tmax)) return false;
+    const optix::float3 vi = (_o + _d*_t) - _anchor;
+    _a1 = optix::dot(_v1,vi);
+    if(_a1<0.0f || _a1>1.0f) return false;
+    _a2 = optix::dot(_v2,vi);
+    return (_a2>=0.0f && _a2<=1.0f);
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif // INTERSECT_H
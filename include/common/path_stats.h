@@ -0,0 +1,30 @@
+#ifndef PATH_STATS_H
+#define PATH_STATS_H
+
+/// @file path_stats.h
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Layout of the path statistics our path tracer collects alongside its ray counts, shared by
+/// @brief path_tracer.cu and PerfMetrics. Plain defines so it can be included by both nvcc and our host code.
+/// @brief Our counter buffer holds a histogram of path lengths followed by the number of paths ending for each
+/// @brief reason. A second float buffer holds the throughput of our paths summed for each reason they ended.
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief number of bins in our path length histogram. Bin i counts paths of i+1 segments, our last bin also
+/// @brief counts every longer path.
+//----------------------------------------------------------------------------------------------------------------------
+#define PATH_STATS_LENGTH_BINS 16
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the reasons a path ends
+//----------------------------------------------------------------------------------------------------------------------
+#define PATH_STATS_MISS 0
+#define PATH_STATS_EMITTER 1
+#define PATH_STATS_RUSSIAN_ROULETTE 2
+#define PATH_STATS_MAX_DEPTH 3
+#define PATH_STATS_NUM_TERMINATIONS 4
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief size of our counter buffer, our histogram then our termination counts
+//----------------------------------------------------------------------------------------------------------------------
+#define PATH_STATS_SIZE (PATH_STATS_LENGTH_BINS + PATH_STATS_NUM_TERMINATIONS)
+
+#endif // PATH_STATS_H
@@ -60,53 +60,74 @@ static __host__ __device__ __inline__ float rnd(unsigned int &prev)
   return ((float) lcg(prev) / (float) 0x01000000);
 }
 
-// Multiply with carry
-static __host__ __inline__ unsigned int mwc()
+// Counter based random numbers. Rather than carrying state from one number to the next each number is a hash of
+// the pixel, the sample of that pixel and the dimension of that sample it is drawn for, so an image comes out bit
+// identical however many threads render it, in whatever order its pixels or tiles are rendered, on the host or device.
+
+// Output permutation of a PCG step used as a 32 bit integer hash
+static __host__ __device__ __inline__ unsigned int pcg_hash( unsigned int v )
 {
-  static unsigned long long r[4];
-  static unsigned long long carry;
-  static bool init = false;
-  if( !init ) {
-    init = true;
-    unsigned int seed = 7654321u, seed0, seed1, seed2, seed3;
-    r[0] = seed0 = lcg2(seed);
-    r[1] = seed1 = lcg2(seed0);
-    r[2] = seed2 = lcg2(seed1);
-    r[3] = seed3 = lcg2(seed2);
-    carry = lcg2(seed3);
-  }
+  unsigned int state = v * 747796405u + 2891336453u;
+  unsigned int word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+  return (word >> 22u) ^ word;
+}
+
+// The random numbers of one sample of one pixel, each draw takes the next dimension. Our pixel and sample are kept
+// as separate words rather than folded into one 32 bit key, where two pixels whose difference matched that of the
+// hashes of their samples would share every random number.
+struct RandomStream
+{
+  unsigned int pixel;
+  unsigned int sample;
+  unsigned int dimension;
+};
 
-  unsigned long long sum = 2111111111ull * r[3] +
-                           1492ull       * r[2] +
-                           1776ull       * r[1] +
-                           5115ull       * r[0] +
-                           1ull          * carry;
-  r[3]   = r[2];
-  r[2]   = r[1];
-  r[1]   = r[0];
-  r[0]   = static_cast<unsigned int>(sum);        // lower half
-  carry  = static_cast<unsigned int>(sum >> 32);  // upper half
-  return static_cast<unsigned int>(r[0]);
+// Stream of a sample. Sample is the index of our sample over the whole render, not just this launch, and seed
+// picks a different but equally repeatable sequence of images.
+static __host__ __device__ __inline__ RandomStream sample_stream( unsigned int pixel, unsigned int sample, unsigned int seed )
+{
+  RandomStream stream;
+  stream.pixel = pixel;
+  stream.sample = pcg_hash( pcg_hash( seed ) ^ sample );
+  stream.dimension = 0u;
+  return stream;
 }
 
-static __host__ __inline__ unsigned int random1u()
+// Random unsigned int for any dimension of a stream, in any order. Each word is hashed in turn so no two streams
+// can trade one word off against another for more than the odd dimension.
+static __host__ __device__ __inline__ unsigned int random1u( const RandomStream &stream, unsigned int dimension )
 {
-#if 0
-  return rand();
-#else
-  return mwc();
-#endif
+  return pcg_hash( pcg_hash( stream.sample ^ pcg_hash( dimension ) ) ^ stream.pixel );
+}
+
+// Random unsigned int from the next dimension of a stream
+static __host__ __device__ __inline__ unsigned int random1u( RandomStream &stream )
+{
+  return random1u( stream, stream.dimension++ );
+}
+
+// Random float in [0, 1) from the next dimension of a stream, 24 bits so it can't round up to 1
+static __host__ __device__ __inline__ float rnd( RandomStream &stream )
+{
+  return ((float) (random1u( stream ) >> 8) / (float) 0x01000000);
+}
+
+// Random unsigned int for one index of a host side sequence. Unlike a generator with hidden state this is safe to
+// call from any number of threads and each index always gets the same number.
+static __host__ __inline__ unsigned int random1u( unsigned int index, unsigned int seed = 0u )
+{
+  return pcg_hash( index + pcg_hash( seed ) );
 }
 
-static __host__ __inline__ optix::uint2 random2u()
+static __host__ __inline__ optix::uint2 random2u( unsigned int index, unsigned int seed = 0u )
 {
-  return optix::make_uint2(random1u(), random1u());
+  return optix::make_uint2(random1u(2u*index, seed), random1u(2u*index+1u, seed));
 }
 
-static __host__ __inline__ void fillRandBuffer( unsigned int *seeds, unsigned int N )
+static __host__ __inline__ void fillRandBuffer( unsigned int *seeds, unsigned int N, unsigned int seed = 0u )
 {
   for( unsigned int i=0; i<N; ++i ) 
-    seeds[i] = mwc();
+    seeds[i] = random1u(i, seed);
 }
 
 static __host__ __device__ __inline__ unsigned int rot_seed( unsigned int seed, unsigned int frame )
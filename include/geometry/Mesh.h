@@ -28,6 +28,13 @@ public:
     //----------------------------------------------------------------------------------------------------------------------
     Mesh(std::string _path, optix::Context &_context);
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief instancing constructor. Our instance shares the buffers and acceleration structure of the mesh it
+    /// @brief instances but has its own transform and material. Instances must be deleted before their mesh.
+    /// @param _context - the context to create our geometry within
+    /// @param _instance - the mesh to instance (Mesh)
+    //----------------------------------------------------------------------------------------------------------------------
+    Mesh(optix::Context &_context, Mesh &_instance);
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief our destructor
     //----------------------------------------------------------------------------------------------------------------------
     ~Mesh();
@@ -37,10 +44,27 @@ public:
     //----------------------------------------------------------------------------------------------------------------------
     void importGeometry(std::string _loc);
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets our geometry from triangles in memory rather than importing them from file.
+    /// @brief The data of our vectors is swapped into our mesh to save copying large meshes so they are left empty.
+    /// @param _vertices - triangle list of vertex positions, 3 per triangle (std::vector<optix::float3>)
+    /// @param _normals - a normal per vertex or empty to use the geometric normal (std::vector<optix::float3>)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setTriangles(std::vector<optix::float3> &_vertices, std::vector<optix::float3> &_normals);
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief accessor to query number of polygons
     //----------------------------------------------------------------------------------------------------------------------
     inline int getNumPolygons(){return m_numPolygons;}
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief calculates the object space bounding box of our mesh
+    /// @param _min - returns the minimum corner of our bounding box (optix::float3)
+    /// @param _max - returns the maximum corner of our bounding box (optix::float3)
+    //----------------------------------------------------------------------------------------------------------------------
+    void getBounds(optix::float3 &_min, optix::float3 &_max);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns the size of the data we hold on the host for our mesh in bytes
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t getHostMemoryUsage();
+    //----------------------------------------------------------------------------------------------------------------------
 protected:
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief extracts all meshes and sub meshes from file into our host arrays
@@ -71,14 +95,18 @@ private:
     //----------------------------------------------------------------------------------------------------------------------
     static optix::Program m_meshBB;
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief static bool to declare if we have created our static intersect and bb programs
+    /// @brief the context we created our static intersect and bb programs in, so we create them again in a new context
     //----------------------------------------------------------------------------------------------------------------------
-    static bool m_init;
+    static optix::Context m_programContext;
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief number of polygons in our mesh
     //----------------------------------------------------------------------------------------------------------------------
     int m_numPolygons;
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief if we are an instance of another mesh and so don't own our buffers
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_isInstance;
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief our vertex buffer
     //----------------------------------------------------------------------------------------------------------------------
     optix::Buffer m_vertexBuffer;
@@ -30,9 +30,9 @@ private:
     //----------------------------------------------------------------------------------------------------------------------
     static optix::Program m_parallelogramBB;
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief static bool to declare if we have created our static intersect and bb programs
+    /// @brief the context we created our static intersect and bb programs in, so we create them again in a new context
     //----------------------------------------------------------------------------------------------------------------------
-    static bool m_init;
+    static optix::Context m_programContext;
     //----------------------------------------------------------------------------------------------------------------------
 };
 
@@ -0,0 +1,109 @@
+#ifndef FRAMEGRAPH_H
+#define FRAMEGRAPH_H
+
+/// @class FrameGraph
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Rolling graph of our frame times for our HUD. Each displayed frame is a column showing the time since our
+/// @brief last frame with the part of it spent tracing drawn over it, along with guide lines at 30 and 60 frames per
+/// @brief second. Our samples live in a fixed ring and the whole graph is drawn as lines from a single dynamic
+/// @brief vertex buffer with one draw call. Needs a valid OpenGL context to be constructed.
+
+#ifdef DARWIN
+    #include <OpenGL/gl3.h>
+#else
+    #include <GL/glew.h>
+    #ifndef WIN32
+        #include <GL/gl.h>
+    #endif
+#endif
+#include <vector>
+#include "gl/ShaderProgram.h"
+
+class FrameGraph
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief default constructor, creates our shader and vertex buffer
+    /// @param _numSamples - number of frames our graph shows, one pixel wide each (unsigned int)
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit FrameGraph(unsigned int _numSamples = 240);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief destructor, frees our GL resources
+    //----------------------------------------------------------------------------------------------------------------------
+    ~FrameGraph();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief adds a frame to our graph, replacing our oldest
+    /// @param _frameMs - time since our last frame was displayed in milliseconds (float)
+    /// @param _traceMs - time spent tracing our frame in milliseconds (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    void addSample(float _frameMs, float _traceMs);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets the size of our screen so we can draw in pixels
+    //----------------------------------------------------------------------------------------------------------------------
+    void setScreenSize(int _w, int _h);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief draws our graph with its top left corner at _x,_y in pixels, 0,0 being the top left of our screen.
+    /// @brief Our scale fits our slowest frame but never shows less than 30 frames per second.
+    /// @param _x, _y - position of our graph (float)
+    /// @param _height - height of our graph in pixels (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    void draw(float _x, float _y, float _height);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the width of our graph in pixels
+    //----------------------------------------------------------------------------------------------------------------------
+    inline unsigned int getWidth() const {return m_numSamples;}
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a vertex of our graph, in pixels
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Vertex
+    {
+        float m_x, m_y;
+        float m_r, m_g, m_b;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief adds a line to our vertices
+    //----------------------------------------------------------------------------------------------------------------------
+    void addLine(float _x0, float _y0, float _x1, float _y1, float _r, float _g, float _b);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of frames our graph shows
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_numSamples;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ring of our frame and trace times
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<float> m_frameMs;
+    std::vector<float> m_traceMs;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief index our next sample is written to and the number of samples we hold
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_next;
+    unsigned int m_count;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief vertices we build each draw, kept so we don't allocate every frame
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<Vertex> m_vertices;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our shader
+    //----------------------------------------------------------------------------------------------------------------------
+    ShaderProgram *m_shader;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief locations of our screen scale uniforms
+    //----------------------------------------------------------------------------------------------------------------------
+    GLint m_scaleXLoc;
+    GLint m_scaleYLoc;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our VAO and dynamic VBO, big enough for every line we can draw
+    //----------------------------------------------------------------------------------------------------------------------
+    GLuint m_VAO;
+    GLuint m_VBO;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of vertices our VBO can hold
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_maxVertices;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // FRAMEGRAPH_H
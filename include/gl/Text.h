@@ -25,13 +25,12 @@
 /// @version 1.0
 /// @date 10/10/11 Initial version
 /// @todo support unicode ASCII is so 1980's ;-0
-/// This class will generate billboard textures and VertexArrayObjects
-/// for each of the font glyphs, this means we need a valid OpenGL context before
-/// using this class, therefore it should be constructed in initalizeGL or after.
+/// This class will pack all of the font glyphs into a single atlas texture, this means we need a valid
+/// OpenGL context before using this class, therefore it should be constructed in initalizeGL or after.
 /// Note for efficiency once the font has been created we can only change the colour, if you
 /// need different sizes / emphasis you will need to create a new Text object with the
-/// desired size / emphasis. This is accelerated as much as possible but text rendering will sometimes be slow
-/// as we bind a new texture for each char being drawn
+/// desired size / emphasis. Each string is built into one dynamic vertex buffer and drawn with a
+/// single draw call from our atlas, so a whole multi line HUD costs one draw.
 /// for more details look at the blog post here
 /// http://jonmacey.blogspot.com/2011/10/text-rendering-using-opengl-32.html
 //----------------------------------------------------------------------------------------------------------------------
@@ -45,6 +44,7 @@
 #endif
 
 #include <QtCore/QHash>
+#include <vector>
 #include <QFont>
 #include <glm/glm.hpp>
 #include "gl/ShaderProgram.h"
@@ -54,16 +54,17 @@ class Text
 {
 public:
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief a structure to hold the font char texture id
-  /// and the vao. The vao for each font will be a different size
-  /// need to investigate is a scale would be quicker / more efficient
-  /// than storing multiple billboards (some will be the same size)
+  /// @brief a structure to hold where a font char is in our atlas
   //----------------------------------------------------------------------------------------------------------------------
   struct FontChar
   {
     int width; /// @brief the width of the font
-    GLuint textureID; /// @brief the texture id of the font billboard
-    GLuint vao; /// a vao handle for the font
+    int x; /// @brief the position of the glyph in our atlas in pixels
+    int y;
+    float s0; /// @brief the texture co-ords of the glyph in our atlas
+    float t0;
+    float s1;
+    float t1;
   };
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief ctor must pass in a ready constructed QFont make sure the size and emphasis
@@ -87,6 +88,7 @@ public:
   /// @param[in] _x the x position of the text in screen space
   /// @param[in] _y the y position of the text in screen space
   /// @param[in] _text the text to draw (this is limited to ASCII chars ' '->'~' at present but unicode will be done soon
+  /// a '\n' starts a new line at _x one line height further down
   //----------------------------------------------------------------------------------------------------------------------
   void renderText(float _x, float _y, const QString &_text ) const;
   //----------------------------------------------------------------------------------------------------------------------
@@ -107,6 +109,10 @@ public:
   void setColour( float _r, float _g,  float _b  );
 
   void setTransform(float _x, float _y);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the height of a line of our text in pixels
+  //----------------------------------------------------------------------------------------------------------------------
+  inline float getLineHeight() const {return m_lineHeight;}
 private:
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief a hash to store our FontChar data looked up by the char we want
@@ -119,6 +125,51 @@ private:
   //----------------------------------------------------------------------------------------------------------------------
   ShaderProgram *m_textShader;
   //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the locations of the uniforms of our shader, looked up once at construction
+  //----------------------------------------------------------------------------------------------------------------------
+  GLint m_texLoc;
+  GLint m_xPosLoc;
+  GLint m_yPosLoc;
+  GLint m_scaleXLoc;
+  GLint m_scaleYLoc;
+  GLint m_colourLoc;
+  GLint m_transformLoc;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the texture all of our glyphs are packed into
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint m_atlasID;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a vertex of the quads of our strings, x,y in pixels relative to the start of our string and u,v in our atlas
+  //----------------------------------------------------------------------------------------------------------------------
+  struct TextVertex
+  {
+    float x;
+    float y;
+    float u;
+    float v;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the vertices of the last string we drew, kept so we don't allocate every draw
+  //----------------------------------------------------------------------------------------------------------------------
+  mutable std::vector<TextVertex> m_vertices;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the vao and dynamic vbo our strings are drawn from
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint m_vao;
+  GLuint m_vbo;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the size of our vbo in bytes, it grows to fit the longest string we draw
+  //----------------------------------------------------------------------------------------------------------------------
+  mutable GLsizeiptr m_vboSize;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the height of our glyphs in pixels
+  //----------------------------------------------------------------------------------------------------------------------
+  float m_fontHeight;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the height of a line of our text in pixels
+  //----------------------------------------------------------------------------------------------------------------------
+  float m_lineHeight;
+  //----------------------------------------------------------------------------------------------------------------------
 
 };
 
@@ -0,0 +1,122 @@
+#ifndef TEXTURESTREAMER_H
+#define TEXTURESTREAMER_H
+
+/// @class TextureStreamer
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Streams RGBA frames into a texture through a ring of pixel buffer objects.
+/// @brief Our texture storage is only allocated when our frame size changes, immutable where the driver supports it,
+/// @brief and every upload is a glTexSubImage2D from the next buffer of our ring so the copy to the GPU can run
+/// @brief while we carry on drawing. Where ARB_buffer_storage is supported our buffers are mapped once and stay
+/// @brief mapped with a fence guarding each one, a frame whose buffer is still being read when its fence times out
+/// @brief is uploaded straight from its pixels instead. Otherwise each upload orphans and maps its buffer. Nothing here
+/// @brief needs more than core GL 4.1 so it also runs on Mesa's software rasterizer and on OS X.
+
+#ifdef DARWIN
+    #include <OpenGL/gl3.h>
+#else
+    #include <GL/glew.h>
+    #ifndef WIN32
+        #include <GL/gl.h>
+    #endif
+#endif
+#include <vector>
+#include "renderer/FrameHandoff.h"
+
+class TextureStreamer
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief default constructor, creates our texture. Needs a valid OpenGL context.
+    /// @param _numBuffers - number of pixel buffers in our ring (unsigned int)
+    /// @param _allowPersistent - use persistently mapped buffers if the driver supports them (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit TextureStreamer(unsigned int _numBuffers = 3, bool _allowPersistent = true);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief destructor, frees our texture and buffers
+    //----------------------------------------------------------------------------------------------------------------------
+    ~TextureStreamer();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief uploads a frame to our texture, reallocating our storage if its size or format has changed
+    /// @param _pixels - RGBA pixels of our frame (const void*)
+    /// @param _width - width of our frame (unsigned int)
+    /// @param _height - height of our frame (unsigned int)
+    /// @param _internalFormat - format of our pixels, GL_RGBA32F, GL_RGBA16F or GL_RGBA8 (GLenum)
+    //----------------------------------------------------------------------------------------------------------------------
+    void upload(const void *_pixels, unsigned int _width, unsigned int _height, GLenum _internalFormat = GL_RGBA32F);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief uploads a frame from our renderer unless it is the frame already in our texture, so we never copy a
+    /// @brief framebuffer that hasn't changed. Frames are told apart by their frame number, edit version, format and
+    /// @brief if they hold our cost view.
+    /// @param _frame - our frame (DisplayFrame)
+    /// @returns if our frame was uploaded (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    bool upload(const DisplayFrame &_frame);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to our texture
+    //----------------------------------------------------------------------------------------------------------------------
+    inline GLuint getTextureID(){return m_texID;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns if our buffers are persistently mapped
+    //----------------------------------------------------------------------------------------------------------------------
+    inline bool isPersistent(){return m_persistent;}
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a pixel buffer of our ring
+    //----------------------------------------------------------------------------------------------------------------------
+    struct PixelBuffer
+    {
+        GLuint m_id;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief our persistent mapping, null when we map each upload
+        //----------------------------------------------------------------------------------------------------------------------
+        void *m_mapped;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief signalled when the last upload from this buffer has finished reading it
+        //----------------------------------------------------------------------------------------------------------------------
+        GLsync m_fence;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief (re)creates our texture storage and pixel buffers for a frame size and format
+    //----------------------------------------------------------------------------------------------------------------------
+    void allocate(unsigned int _width, unsigned int _height, GLenum _internalFormat);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns the pixel type and size in bytes of a pixel of one of our formats
+    //----------------------------------------------------------------------------------------------------------------------
+    static GLenum getPixelType(GLenum _internalFormat, unsigned int &_bytesPerPixel);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief frees our pixel buffers
+    //----------------------------------------------------------------------------------------------------------------------
+    void freeBuffers();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our texture
+    //----------------------------------------------------------------------------------------------------------------------
+    GLuint m_texID;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief size and format of our texture
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_width;
+    unsigned int m_height;
+    GLenum m_internalFormat;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our ring of pixel buffers and the buffer our next upload uses
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<PixelBuffer> m_buffers;
+    unsigned int m_next;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief if we persistently map our buffers and if we have immutable texture storage
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_persistent;
+    bool m_immutable;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the renderer frame in our texture, only valid if it was uploaded as a frame
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_hasFrame;
+    unsigned int m_frameNumber;
+    unsigned long m_editVersion;
+    bool m_cost;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // TEXTURESTREAMER_H
@@ -75,6 +75,10 @@ public:
     //----------------------------------------------------------------------------------------------------------------------
     void transformLights(glm::mat4 _trans);
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief queues an upload of all our lights to our light buffer before the next launch
+    //----------------------------------------------------------------------------------------------------------------------
+    void queueLightUpload();
+    //----------------------------------------------------------------------------------------------------------------------
 signals:
     void updateScene();
 private:
@@ -0,0 +1,246 @@
+#ifndef COSTMAP_H
+#define COSTMAP_H
+
+/// @class CostMap
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief CPU reference of the per pixel cost view of our path tracer so it can be tested without a GPU. Traces the
+/// @brief same paths as path_tracer.cu, with the same random numbers, next event estimation and russian roulette,
+/// @brief through a simple BVH of our own over a triangle soup. Unlike OptiX we can see inside our traversal so we
+/// @brief count the BVH nodes each pixel visits where our GPU can only count clock cycles. Also holds the false
+/// @brief colour ramp our display shader draws our cost with so heat maps can be written to file from anywhere.
+/// @brief Our paths also carry the radiance our path tracer would, so we can render our image on the CPU too, one
+/// @brief tile of a Film per thread.
+
+#include <vector>
+#include <string>
+#include <optixu/optixu_math_namespace.h>
+#include "lights/ParallelogramLight.h"
+#include "renderer/FrameHandoff.h"
+#include "renderer/Film.h"
+#include "common/random.h"
+
+class CostMap
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the counters of our cost in the order they are stored in each pixel. Our GPU stores thousands of clock
+    /// @brief cycles in place of the BVH nodes we count here.
+    //----------------------------------------------------------------------------------------------------------------------
+    enum Counter{PrimitivesTested,NodesVisited,PathLength,ShadowRays,NumCounters};
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns the name of a counter
+    /// @param _counter - counter (Counter)
+    /// @param _gpu - if we want the name of the counter as our GPU measures it (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    static const char *getCounterName(Counter _counter, bool _gpu = false);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the false colour ramp of our heat map, a polynomial fit of Google's Turbo colour map
+    /// @param _t - position on our ramp, clamped to [0,1] (float)
+    /// @returns our colour (optix::float3)
+    //----------------------------------------------------------------------------------------------------------------------
+    static optix::float3 heatMapColour(float _t);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns the largest value of a counter in a cost frame
+    //----------------------------------------------------------------------------------------------------------------------
+    static float getMax(const DisplayFrame &_cost, Counter _counter);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief draws one counter of a cost frame as a heat map, log scaled so a few expensive pixels don't wash out
+    /// @brief the rest of our image. The same mapping as our display shader.
+    /// @param _cost - frame of our cost (DisplayFrame)
+    /// @param _counter - counter to draw (Counter)
+    /// @param _image - returns our heat map (DisplayFrame)
+    /// @param _max - value drawn at the top of our ramp, 0 to use the largest value in our frame (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    static void toHeatMap(const DisplayFrame &_cost, Counter _counter, DisplayFrame &_image, float _max = 0.f);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief default constructor, creates an empty scene with the camera of our path tracer
+    //----------------------------------------------------------------------------------------------------------------------
+    CostMap();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief adds a triangle to our scene. Our BVH needs rebuilding before our next render.
+    /// @param _p0, _p1, _p2 - vertices of our triangle (optix::float3)
+    /// @param _diffuse - diffuse colour of our triangle (optix::float3)
+    /// @param _emission - emission of our triangle, anything non zero is treated as a light like our diffuseEmitter
+    //----------------------------------------------------------------------------------------------------------------------
+    void addTriangle(const optix::float3 &_p0, const optix::float3 &_p1, const optix::float3 &_p2,
+                     const optix::float3 &_diffuse, const optix::float3 &_emission = optix::make_float3(0.f));
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief adds a parallelogram to our scene as two triangles
+    /// @param _anchor - corner of our parallelogram (optix::float3)
+    /// @param _v1, _v2 - edges of our parallelogram (optix::float3)
+    /// @param _diffuse - diffuse colour of our parallelogram (optix::float3)
+    /// @param _emission - emission of our parallelogram (optix::float3)
+    //----------------------------------------------------------------------------------------------------------------------
+    void addParallelogram(const optix::float3 &_anchor, const optix::float3 &_v1, const optix::float3 &_v2,
+                          const optix::float3 &_diffuse, const optix::float3 &_emission = optix::make_float3(0.f));
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief loads the walls and light of the cornell box of PathTracerScene::loadCornellBox
+    //----------------------------------------------------------------------------------------------------------------------
+    void loadCornellBox();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets the lights sampled for direct lighting
+    /// @param _lights - lights in our scene (std::vector<ParallelogramLight>)
+    //----------------------------------------------------------------------------------------------------------------------
+    inline void setLights(const std::vector<ParallelogramLight> &_lights){m_lights = _lights;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets our camera as PathTraceCamera::setParameters does
+    /// @param _eye - position of our camera (optix::float3)
+    /// @param _lookat - point our camera looks at (optix::float3)
+    /// @param _up - up vector of our camera (optix::float3)
+    /// @param _hfov, _vfov - horizontal and vertical field of view in degrees (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setCamera(const optix::float3 &_eye, const optix::float3 &_lookat, const optix::float3 &_up, float _hfov, float _vfov);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets our camera, see PathTraceCamera::getEyeUVW
+    //----------------------------------------------------------------------------------------------------------------------
+    void setCamera(const optix::float3 &_eye, const optix::float3 &_U, const optix::float3 &_V, const optix::float3 &_W);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets the square root of the number of samples we take per pixel
+    //----------------------------------------------------------------------------------------------------------------------
+    inline void setNumSamples(unsigned int _sqrtNumSamples){m_sqrtNumSamples = (_sqrtNumSamples) ? _sqrtNumSamples : 1u;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets the filter our cost samples are placed with, as PathTracerScene::setFilter does
+    /// @param _filter - our filter (Film::Filter)
+    /// @param _radius - radius of our filter in pixels, 0 for its default (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setFilter(Film::Filter _filter, float _radius = 0.f);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the number of triangles in our scene
+    //----------------------------------------------------------------------------------------------------------------------
+    inline unsigned int getNumTriangles(){return m_triangles.size();}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the number of nodes in our BVH
+    //----------------------------------------------------------------------------------------------------------------------
+    inline unsigned int getNumNodes(){return m_nodes.size();}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief builds our BVH, done by render if our scene has changed
+    //----------------------------------------------------------------------------------------------------------------------
+    void build();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief renders the cost of one frame of our scene. Each pixel holds our counters averaged per sample.
+    /// @param _width - width of our frame (unsigned int)
+    /// @param _height - height of our frame (unsigned int)
+    /// @param _cost - returns our cost (DisplayFrame)
+    /// @param _frameNumber - frame number to seed our random numbers with, as our path tracer does (unsigned int)
+    //----------------------------------------------------------------------------------------------------------------------
+    void render(unsigned int _width, unsigned int _height, DisplayFrame &_cost, unsigned int _frameNumber = 0);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief renders one frame of our image into a film across all of our cores. Our samples are spread evenly over
+    /// @brief each pixel and splatted with the filter of our film, call again with the next frame number to add more.
+    /// @param _film - film to add our samples to, its size is the size of our image (Film)
+    /// @param _frameNumber - frame number to seed our random numbers with, as our path tracer does (unsigned int)
+    //----------------------------------------------------------------------------------------------------------------------
+    void renderImage(Film &_film, unsigned int _frameNumber = 0);
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a triangle of our scene with its material
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Triangle
+    {
+        optix::float3 m_p0, m_p1, m_p2;
+        optix::float3 m_diffuse;
+        optix::float3 m_emission;
+        bool m_emitter;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a node of our BVH. Leaves hold m_count triangles from m_first, inner nodes have their children at
+    /// @brief m_first and m_first+1.
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Node
+    {
+        optix::float3 m_min;
+        optix::float3 m_max;
+        unsigned int m_first;
+        unsigned int m_count;
+        unsigned int m_axis;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the work done by our traversals
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Counters
+    {
+        unsigned int m_nodes;
+        unsigned int m_primitives;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief recursively builds a node over m_triangles[_first,_first+_count)
+    //----------------------------------------------------------------------------------------------------------------------
+    void buildNode(unsigned int _node, unsigned int _first, unsigned int _count);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief traces a ray through our BVH
+    /// @param _o, _d - origin and direction of our ray (optix::float3)
+    /// @param _tmin, _tmax - interval along our ray we accept hits in (float)
+    /// @param _anyHit - stop at the first hit on a triangle that casts shadows, as our shadow rays do (bool)
+    /// @param _counters - our traversal work is added to this (Counters)
+    /// @param _t - returns the distance to our hit (float)
+    /// @returns index of the triangle we hit, -1 if we missed (int)
+    //----------------------------------------------------------------------------------------------------------------------
+    int trace(const optix::float3 &_o, const optix::float3 &_d, float _tmin, float _tmax, bool _anyHit,
+              Counters &_counters, float &_t);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief traces a path from our camera as pathtrace_camera does
+    /// @param _o, _d - origin and direction of our camera ray (optix::float3)
+    /// @param _rng - random numbers of our sample (RandomStream)
+    /// @param _counters - our traversal work is added to this (Counters)
+    /// @param _segments - the number of segments of our path is added to this (unsigned int)
+    /// @param _shadowRays - the number of shadow rays we cast is added to this (unsigned int)
+    /// @returns the radiance our path carries (optix::float3)
+    //----------------------------------------------------------------------------------------------------------------------
+    optix::float3 tracePath(optix::float3 _o, optix::float3 _d, RandomStream &_rng, Counters &_counters,
+                            unsigned int &_segments, unsigned int &_shadowRays);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief warps a position across our pixel through our filter table, as sample_filter in path_tracer.cu
+    /// @param _u - position across our pixel in [0,1) (float)
+    /// @returns offset from our pixel centre in pixels (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    float sampleFilter(float _u);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our triangles, reordered by our BVH build
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<Triangle> m_triangles;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our BVH, m_nodes[0] is our root
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<Node> m_nodes;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief if our triangles have changed since our BVH was built
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_dirty;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the lights sampled by our next event estimation
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<ParallelogramLight> m_lights;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our camera
+    //----------------------------------------------------------------------------------------------------------------------
+    optix::float3 m_eye, m_U, m_V, m_W;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief square root of the number of samples per pixel
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_sqrtNumSamples;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief inverse CDF of our filter our cost samples are placed with, see film_filter.h
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_filterTable[FILM_FILTER_TABLE_SIZE+1];
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief depth our russian roulette starts at
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_rrBeginDepth;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief most segments a path can have
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_maxDepth;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief epsilon we offset our rays by
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_sceneEpsilon;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief max triangles in a leaf of our BVH
+    //----------------------------------------------------------------------------------------------------------------------
+    static const unsigned int m_maxLeafSize = 4;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // COSTMAP_H
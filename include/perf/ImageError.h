@@ -0,0 +1,110 @@
+#ifndef IMAGEERROR_H
+#define IMAGEERROR_H
+
+/// @class ImageError
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Error metrics between a render and a reference of the same scene, used to measure how quickly our
+/// @brief renders converge. Also reads and writes the PFM files we store our reference images in.
+
+#include <string>
+#include <vector>
+#include "renderer/FrameHandoff.h"
+
+class ImageError
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief all of our metrics for one image
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Errors
+    {
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief root mean squared error
+        //----------------------------------------------------------------------------------------------------------------------
+        double m_rmse;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief root mean squared error divided by the mean of our reference
+        //----------------------------------------------------------------------------------------------------------------------
+        double m_relativeRMSE;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief mean of the squared error of each pixel divided by its squared reference value
+        //----------------------------------------------------------------------------------------------------------------------
+        double m_relativeMSE;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief mean of our FLIP style perceptual error, between 0 and 1
+        //----------------------------------------------------------------------------------------------------------------------
+        double m_flip;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief computes all of our metrics. Every metric is -1 if our images don't match in size.
+    /// @param _image - image to measure (DisplayFrame)
+    /// @param _reference - image to measure against (DisplayFrame)
+    /// @returns our errors (Errors)
+    //----------------------------------------------------------------------------------------------------------------------
+    static Errors compare(const DisplayFrame &_image, const DisplayFrame &_reference);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief root mean squared error of the RGB channels of two float4 images
+    /// @returns our error or -1 if our images don't match in size (double)
+    //----------------------------------------------------------------------------------------------------------------------
+    static double rmse(const DisplayFrame &_image, const DisplayFrame &_reference);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief root mean squared error divided by the mean of our reference
+    /// @returns our error or -1 if our images don't match in size or our reference is black (double)
+    //----------------------------------------------------------------------------------------------------------------------
+    static double relativeRMSE(const DisplayFrame &_image, const DisplayFrame &_reference);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief relative mean squared error, (image-reference)^2/(reference^2+epsilon) averaged over all channels.
+    /// @brief Unlike RMSE, dark areas of the image count as much as bright ones.
+    /// @returns our error or -1 if our images don't match in size (double)
+    //----------------------------------------------------------------------------------------------------------------------
+    static double relativeMSE(const DisplayFrame &_image, const DisplayFrame &_reference);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief A perceptual error modelled on NVIDIA's FLIP. Both images are tone mapped, filtered by an approximation
+    /// @brief of the contrast sensitivity of our eyes and compared in a perceptually uniform colour space, with the
+    /// @brief difference boosted where edges and points differ. It is a cheaper approximation rather than an exact
+    /// @brief implementation so is only comparable with itself.
+    /// @param _pixelsPerDegree - pixels per degree of visual angle our images are viewed at (float)
+    /// @returns mean error between 0 and 1 or -1 if our images don't match in size (double)
+    //----------------------------------------------------------------------------------------------------------------------
+    static double flip(const DisplayFrame &_image, const DisplayFrame &_reference, float _pixelsPerDegree = 67.f);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief reads a colour PFM image into a float4 image
+    /// @param _path - path of our file (std::string)
+    /// @param _frame - returns our image (DisplayFrame)
+    /// @returns true on success (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    static bool readPFM(const std::string &_path, DisplayFrame &_frame);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes the RGB channels of a float4 image as a colour PFM image
+    /// @param _path - path of our file (std::string)
+    /// @param _frame - image to write (DisplayFrame)
+    /// @returns true on success (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    static bool writePFM(const std::string &_path, const DisplayFrame &_frame);
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns if two images can be compared
+    //----------------------------------------------------------------------------------------------------------------------
+    static bool matches(const DisplayFrame &_image, const DisplayFrame &_reference);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief converts a float4 image to the linear YCxCz opponent colour space FLIP filters in
+    //----------------------------------------------------------------------------------------------------------------------
+    static void toYCxCz(const DisplayFrame &_frame, std::vector<float> &_ycxcz);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief separable gaussian blur of one channel of a 3 channel image
+    /// @param _image - image to blur in place (std::vector<float>)
+    /// @param _channel - channel to blur (int)
+    /// @param _sigma - standard deviation of our gaussian in pixels (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    static void blurChannel(std::vector<float> &_image, unsigned int _width, unsigned int _height, int _channel, float _sigma);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief computes the edge and point feature strength of each pixel of a single channel image
+    //----------------------------------------------------------------------------------------------------------------------
+    static void features(const std::vector<float> &_luminance, unsigned int _width, unsigned int _height, float _sigma,
+                         std::vector<float> &_edges, std::vector<float> &_points);
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // IMAGEERROR_H
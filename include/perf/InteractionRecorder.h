@@ -0,0 +1,148 @@
+#ifndef INTERACTIONRECORDER_H
+#define INTERACTIONRECORDER_H
+
+/// @class InteractionRecorder
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Singleton recording the mouse, wheel and key events our OpenGLWidget receives along with the resize and
+/// @brief transform calls they make on our renderer, so an interactive session can be replayed by InteractionReplay
+/// @brief to measure how responsive we are. Recording is switched on by setting the environment variable
+/// @brief PHENIX_RECORD to the file to write, or to 1 to write phenix_interaction.txt. Events are only recorded from
+/// @brief the GUI thread so need no locking.
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+class InteractionRecorder
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the types of event we record
+    //----------------------------------------------------------------------------------------------------------------------
+    enum EventType
+    {
+        MousePress,
+        MouseRelease,
+        MouseMove,
+        Wheel,
+        KeyPress,
+        KeyRelease,
+        Resize,     ///< a resize of our renderer
+        Transform,  ///< a global transform set on our renderer
+        NumEventTypes
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a recorded event
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Event
+    {
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief time in milliseconds since recording started
+        //----------------------------------------------------------------------------------------------------------------------
+        double m_timeMs;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief what happened
+        //----------------------------------------------------------------------------------------------------------------------
+        EventType m_type;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief mouse position of mouse events or the resolution of resizes
+        //----------------------------------------------------------------------------------------------------------------------
+        int m_x;
+        int m_y;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief mouse buttons, wheel delta or key depending on our type
+        //----------------------------------------------------------------------------------------------------------------------
+        int m_value;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief transform and inverse transform of transform events
+        //----------------------------------------------------------------------------------------------------------------------
+        float m_trans[16];
+        float m_invTrans[16];
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief returns if this event is input from our user rather than a call on our renderer
+        //----------------------------------------------------------------------------------------------------------------------
+        inline bool isInput() const {return m_type!=Resize && m_type!=Transform;}
+        //----------------------------------------------------------------------------------------------------------------------
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns an instance of our singleton class
+    //----------------------------------------------------------------------------------------------------------------------
+    static InteractionRecorder *getInstance();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns the name of an event type as written to file
+    //----------------------------------------------------------------------------------------------------------------------
+    static const char *getEventTypeName(EventType _type);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns if we are recording
+    //----------------------------------------------------------------------------------------------------------------------
+    inline bool isEnabled(){return m_enabled;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief records a mouse, wheel or key event
+    /// @param _type - type of our event (EventType)
+    /// @param _x - x position of our mouse (int)
+    /// @param _y - y position of our mouse (int)
+    /// @param _value - mouse buttons, wheel delta or key (int)
+    //----------------------------------------------------------------------------------------------------------------------
+    void recordInput(EventType _type, int _x, int _y, int _value);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief records a resize of our renderer
+    /// @param _width - width of our renderer (int)
+    /// @param _height - height of our renderer (int)
+    //----------------------------------------------------------------------------------------------------------------------
+    void recordResize(int _width, int _height);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief records a global transform set on our renderer
+    /// @param _trans - transform matrix (float*)
+    /// @param _invTrans - inverse transform (float*)
+    //----------------------------------------------------------------------------------------------------------------------
+    void recordTransform(const float *_trans, const float *_invTrans);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes all events recorded so far to the file given by PHENIX_RECORD
+    /// @returns true on success (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    bool flush();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes events to file, one per line
+    /// @param _path - path of file to write (std::string)
+    /// @param _events - events to write (std::vector<Event>)
+    /// @returns true on success (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    static bool save(const std::string &_path, const std::vector<Event> &_events);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief reads events written by save
+    /// @param _path - path of file to read (std::string)
+    /// @param _events - returns our events (std::vector<Event>)
+    /// @returns true on success (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    static bool load(const std::string &_path, std::vector<Event> &_events);
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief Constructor. Reads PHENIX_RECORD.
+    //----------------------------------------------------------------------------------------------------------------------
+    InteractionRecorder();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns a new event of a type stamped with the current time
+    //----------------------------------------------------------------------------------------------------------------------
+    Event createEvent(EventType _type);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief if we are recording
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_enabled;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief path of the file we write our events to
+    //----------------------------------------------------------------------------------------------------------------------
+    std::string m_path;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief time our recording starts from
+    //----------------------------------------------------------------------------------------------------------------------
+    std::chrono::steady_clock::time_point m_start;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our recorded events
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<Event> m_events;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // INTERACTIONRECORDER_H
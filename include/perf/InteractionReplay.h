@@ -0,0 +1,115 @@
+#ifndef INTERACTIONREPLAY_H
+#define INTERACTIONREPLAY_H
+
+/// @class InteractionReplay
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Replays an interaction recorded by InteractionRecorder headless against our default scene and measures
+/// @brief how responsive we are. Playback is driven by the recorded events rather than the clock so every run does
+/// @brief the same work: for each input that changed our renderer we apply its resize and transform calls, launch
+/// @brief and read back a frame. Latency is the time from applying an input to having its frame ready to display.
+/// @brief Unlike our render thread, we never merge transforms that arrive faster than we render so this measures
+/// @brief the worst case of an interaction.
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include "perf/InteractionRecorder.h"
+#include "perf/LatencyTracker.h"
+#include "renderer/PathTracer.h"
+
+class InteractionReplay
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a frame rendered in response to an input
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Frame
+    {
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief index of the input event this frame responds to
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_event;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief time of that input in our recording
+        //----------------------------------------------------------------------------------------------------------------------
+        double m_recordedMs;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief time from applying our input to our frame being ready to display
+        //----------------------------------------------------------------------------------------------------------------------
+        double m_latencyMs;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief time of our launch alone
+        //----------------------------------------------------------------------------------------------------------------------
+        double m_frameMs;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief resolution we rendered at
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_width;
+        unsigned int m_height;
+        //----------------------------------------------------------------------------------------------------------------------
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief default constructor
+    //----------------------------------------------------------------------------------------------------------------------
+    InteractionReplay();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief replays a recording
+    /// @param _path - path of our recording (std::string)
+    /// @returns true on success (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    bool run(const std::string &_path);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the frames of our last replay
+    //----------------------------------------------------------------------------------------------------------------------
+    inline const std::vector<Frame> &getFrames(){return m_frames;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the percentiles of the latency of our last replay
+    //----------------------------------------------------------------------------------------------------------------------
+    inline const LatencyTracker::Percentiles &getLatency(){return m_latency;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the percentiles of the frame times of our last replay
+    //----------------------------------------------------------------------------------------------------------------------
+    inline const LatencyTracker::Percentiles &getFrameTimes(){return m_frameTimes;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes our percentiles and frames as JSON
+    //----------------------------------------------------------------------------------------------------------------------
+    void dumpJSON(std::ostream &_out);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes our percentiles and frames as JSON to file
+    /// @param _path - path of file to write (std::string)
+    /// @returns true on success (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    bool writeJSON(const std::string &_path);
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief applies a resize or transform event to our renderer
+    //----------------------------------------------------------------------------------------------------------------------
+    void apply(PathTracerScene *_renderer, InteractionRecorder::Event &_event);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief launches our renderer once, returning the time of our launch
+    //----------------------------------------------------------------------------------------------------------------------
+    double launch(PathTracerScene *_renderer);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the recording we replayed
+    //----------------------------------------------------------------------------------------------------------------------
+    std::string m_recording;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of events in our recording and how many were inputs
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_numEvents;
+    unsigned int m_numInputs;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the frames we rendered
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<Frame> m_frames;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief percentiles of our latencies and frame times
+    //----------------------------------------------------------------------------------------------------------------------
+    LatencyTracker::Percentiles m_latency;
+    LatencyTracker::Percentiles m_frameTimes;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // INTERACTIONREPLAY_H
@@ -0,0 +1,101 @@
+#ifndef LATENCYTRACKER_H
+#define LATENCYTRACKER_H
+
+/// @class LatencyTracker
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Singleton measuring input to photon latency, the time from our user moving the mouse to our view showing
+/// @brief the result. Each input that changes our scene is stamped with the version of the edit it pushed to our
+/// @brief SceneEditQueue. Displayed frames carry the version of the last edit applied before they were launched, so
+/// @brief the first frame displayed with a version at least that of an input is the one that shows it. Edits merged
+/// @brief in our queue resolve when the edit that replaced them is shown. The latency of our most recent inputs is
+/// @brief kept so we can report percentiles of it, which FPS alone hides.
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <chrono>
+
+class LatencyTracker
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief percentiles of a set of timings
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Percentiles
+    {
+        unsigned int m_count;
+        double m_mean;
+        double m_p50;
+        double m_p95;
+        double m_p99;
+        double m_max;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief computes the percentiles of a set of timings with the nearest rank method
+    /// @param _values - our timings (std::vector<double>)
+    /// @returns our percentiles, all 0 if we have no timings (Percentiles)
+    //----------------------------------------------------------------------------------------------------------------------
+    static Percentiles computePercentiles(std::vector<double> _values);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns an instance of our singleton class
+    //----------------------------------------------------------------------------------------------------------------------
+    static LatencyTracker *getInstance();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief records that an input received at a time pushed an edit to our scene
+    /// @param _version - version of the edit returned from our SceneEditQueue (unsigned long)
+    /// @param _inputTime - when our input was received (std::chrono::steady_clock::time_point)
+    //----------------------------------------------------------------------------------------------------------------------
+    void inputQueued(unsigned long _version, std::chrono::steady_clock::time_point _inputTime);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief records that a frame is now on screen, completing the latency of every input it shows
+    /// @param _version - version of the last edit applied before our frame was launched (unsigned long)
+    //----------------------------------------------------------------------------------------------------------------------
+    void frameDisplayed(unsigned long _version);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns the percentiles of the latency of our most recent inputs in milliseconds
+    //----------------------------------------------------------------------------------------------------------------------
+    Percentiles getPercentiles();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the number of latencies we keep
+    //----------------------------------------------------------------------------------------------------------------------
+    static const unsigned int m_historySize = 1024;
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief Constructor
+    //----------------------------------------------------------------------------------------------------------------------
+    LatencyTracker();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief an input waiting to be displayed
+    //----------------------------------------------------------------------------------------------------------------------
+    struct PendingInput
+    {
+        unsigned long m_version;
+        std::chrono::steady_clock::time_point m_time;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief mutex to protect our inputs and history
+    //----------------------------------------------------------------------------------------------------------------------
+    std::mutex m_mutex;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief inputs waiting to be displayed, in version order
+    //----------------------------------------------------------------------------------------------------------------------
+    std::deque<PendingInput> m_pending;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ring of our most recent latencies in milliseconds
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<double> m_history;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of latencies ever recorded
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned long m_numRecorded;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our percentiles are cached until a new latency is recorded as they are read every paint
+    //----------------------------------------------------------------------------------------------------------------------
+    Percentiles m_percentiles;
+    bool m_percentilesDirty;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // LATENCYTRACKER_H
@@ -0,0 +1,336 @@
+#ifndef PERFMETRICS_H
+#define PERFMETRICS_H
+
+/// @class PerfMetrics
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Singleton collecting performance metrics from around the application.
+/// @brief Scoped timers feed running statistics for each instrumented section. Sections timed on the render thread
+/// @brief between beginLaunch() and endLaunch() are also attributed to that launch, along with the rays it traced
+/// @brief and the statistics of its paths.
+/// @brief Completed launch records go into a fixed size lock free ring that can be read from any thread while the
+/// @brief render thread keeps writing, and can be dumped as CSV or JSON. Our JSON also holds the input latency
+/// @brief percentiles of our LatencyTracker and the memory last reported in use by our renderer.
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <thread>
+#include <chrono>
+#include "common/path_stats.h"
+
+class PerfMetrics
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the sections of our application we time
+    //----------------------------------------------------------------------------------------------------------------------
+    enum Section{Trace,AccelBuild,CameraUpdate,BufferUpload,OutputReadback,TextureUpload,MeshImport,HDRImport,DisplayResolve,NumSections};
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief running statistics for a section
+    //----------------------------------------------------------------------------------------------------------------------
+    struct SectionStats
+    {
+        unsigned long m_count;
+        double m_totalMs;
+        double m_minMs;
+        double m_maxMs;
+        double m_lastMs;
+        inline double getAverageMs() const {return (m_count) ? m_totalMs/m_count : 0.0;}
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the reasons a path of our path tracer ends
+    //----------------------------------------------------------------------------------------------------------------------
+    enum PathTermination{Miss=PATH_STATS_MISS,EmitterHit=PATH_STATS_EMITTER,RussianRoulette=PATH_STATS_RUSSIAN_ROULETTE,
+                         MaxDepth=PATH_STATS_MAX_DEPTH,NumTerminations=PATH_STATS_NUM_TERMINATIONS};
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of bins in our path length histogram, the last bin also counts every longer path
+    //----------------------------------------------------------------------------------------------------------------------
+    static const unsigned int m_pathLengthBins = PATH_STATS_LENGTH_BINS;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the statistics of the paths traced by our path tracer
+    //----------------------------------------------------------------------------------------------------------------------
+    struct PathStats
+    {
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief histogram of our path lengths, bin i counts paths of i+1 segments
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned long long m_lengths[m_pathLengthBins];
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief number of paths ending for each reason
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned long long m_terminations[NumTerminations];
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief max component of the throughput of our paths as they ended, summed for each reason
+        //----------------------------------------------------------------------------------------------------------------------
+        double m_throughput[NumTerminations];
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief adds the statistics of more paths to ours
+        //----------------------------------------------------------------------------------------------------------------------
+        void add(const PathStats &_stats);
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief total number of paths
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned long long getNumPaths() const;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief mean number of segments in our paths. Paths in our last bin count as its length so this is a lower bound.
+        //----------------------------------------------------------------------------------------------------------------------
+        double getMeanLength() const;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief mean throughput of the paths that ended for a reason
+        //----------------------------------------------------------------------------------------------------------------------
+        inline double getMeanThroughput(PathTermination _reason) const
+        {return (m_terminations[_reason]) ? m_throughput[_reason]/m_terminations[_reason] : 0.0;}
+        //----------------------------------------------------------------------------------------------------------------------
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns the name of a reason a path ends
+    //----------------------------------------------------------------------------------------------------------------------
+    static const char *getTerminationName(PathTermination _reason);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the metrics of a single launch of our renderer
+    //----------------------------------------------------------------------------------------------------------------------
+    struct LaunchRecord
+    {
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief the index of this launch since our application started
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned long m_index;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief time in milliseconds since our metrics started that this launch completed
+        //----------------------------------------------------------------------------------------------------------------------
+        double m_timeStampMs;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief the accumulated frame number of our renderer after this launch
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_frameNumber;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief resolution of this launch
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_width;
+        unsigned int m_height;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief total time from beginLaunch to endLaunch
+        //----------------------------------------------------------------------------------------------------------------------
+        double m_totalMs;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief time spent in each section during this launch
+        //----------------------------------------------------------------------------------------------------------------------
+        double m_sectionMs[NumSections];
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief number of rays traced from our camera, as path bounces and for shadows. 0 if ray counting is off.
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned long long m_cameraRays;
+        unsigned long long m_bounceRays;
+        unsigned long long m_shadowRays;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief total rays traced in this launch
+        //----------------------------------------------------------------------------------------------------------------------
+        inline unsigned long long getTotalRays() const {return m_cameraRays+m_bounceRays+m_shadowRays;}
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief statistics of the paths traced in this launch. All 0 if ray counting is off.
+        //----------------------------------------------------------------------------------------------------------------------
+        PathStats m_pathStats;
+        //----------------------------------------------------------------------------------------------------------------------
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief memory in use by our renderer
+    //----------------------------------------------------------------------------------------------------------------------
+    struct MemoryUsage
+    {
+        unsigned long long m_hostBytes;
+        unsigned long long m_deviceUsedBytes;
+        unsigned long long m_deviceTotalBytes;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns an instance of our singleton class
+    //----------------------------------------------------------------------------------------------------------------------
+    static PerfMetrics *getInstance();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns the name of a section
+    /// @param _section - section (Section)
+    //----------------------------------------------------------------------------------------------------------------------
+    static const char *getSectionName(Section _section);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief milliseconds since our metrics started. Used for time stamps.
+    //----------------------------------------------------------------------------------------------------------------------
+    double getElapsedMs();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief records time spent in a section. Safe to call from any thread.
+    /// @param _section - section the time was spent in (Section)
+    /// @param _ms - time spent in milliseconds (double)
+    //----------------------------------------------------------------------------------------------------------------------
+    void addSectionTime(Section _section, double _ms);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the running statistics of a section
+    /// @param _section - section (Section)
+    //----------------------------------------------------------------------------------------------------------------------
+    SectionStats getSectionStats(Section _section);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief starts a launch record. Sections timed on the calling thread are attributed to it until it ends.
+    //----------------------------------------------------------------------------------------------------------------------
+    void beginLaunch();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets the rays traced by the current launch. Must be called from the thread that began the launch.
+    //----------------------------------------------------------------------------------------------------------------------
+    void setLaunchRayCounts(unsigned long long _camera, unsigned long long _bounce, unsigned long long _shadow);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets the statistics of the paths traced by the current launch. Must be called from the thread that began
+    /// @brief the launch.
+    //----------------------------------------------------------------------------------------------------------------------
+    void setLaunchPathStats(const PathStats &_stats);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief completes the current launch record and publishes it to our ring
+    /// @param _frameNumber - accumulated frame number after this launch (unsigned int)
+    /// @param _width - launch width (unsigned int)
+    /// @param _height - launch height (unsigned int)
+    //----------------------------------------------------------------------------------------------------------------------
+    void endLaunch(unsigned int _frameNumber, unsigned int _width, unsigned int _height);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief abandons the current launch record, for when nothing was launched after all
+    //----------------------------------------------------------------------------------------------------------------------
+    void cancelLaunch();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief records the memory in use by our renderer. Safe to call from any thread.
+    /// @param _usage - memory in use (MemoryUsage)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setMemoryUsage(const MemoryUsage &_usage);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the memory last reported in use by our renderer, all 0 if none has been reported
+    //----------------------------------------------------------------------------------------------------------------------
+    MemoryUsage getMemoryUsage();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief total number of launches recorded
+    //----------------------------------------------------------------------------------------------------------------------
+    inline unsigned long getNumLaunches(){return m_written;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief copies the most recent launch records out of our ring, oldest first. Safe to call from any thread.
+    /// @param _records - vector to fill (std::vector<LaunchRecord>)
+    /// @param _max - max number of records to return (unsigned int)
+    //----------------------------------------------------------------------------------------------------------------------
+    void getRecentLaunches(std::vector<LaunchRecord> &_records, unsigned int _max = m_ringSize);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief copies the most recent launch record
+    /// @returns false if there are no launches recorded (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    bool getLatestLaunch(LaunchRecord &_record);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes the launches in our ring as CSV
+    //----------------------------------------------------------------------------------------------------------------------
+    void dumpCSV(std::ostream &_out);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes our section statistics, the path statistics of our ring summed and the launches in our ring as JSON
+    //----------------------------------------------------------------------------------------------------------------------
+    void dumpJSON(std::ostream &_out);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes our metrics to file, JSON if the path ends in .json otherwise CSV
+    /// @param _path - path of file to write (std::string)
+    /// @returns true on success (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    bool writeToFile(const std::string &_path);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the number of launch records kept in our ring
+    //----------------------------------------------------------------------------------------------------------------------
+    static const unsigned int m_ringSize = 4096;
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief Constructor
+    //----------------------------------------------------------------------------------------------------------------------
+    PerfMetrics();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief lock free running statistics of a section, stored in nanoseconds
+    //----------------------------------------------------------------------------------------------------------------------
+    struct AtomicSectionStats
+    {
+        std::atomic<unsigned long> m_count;
+        std::atomic<unsigned long long> m_totalNs;
+        std::atomic<unsigned long long> m_minNs;
+        std::atomic<unsigned long long> m_maxNs;
+        std::atomic<unsigned long long> m_lastNs;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a slot in our ring. The sequence number is odd while the slot is being written.
+    //----------------------------------------------------------------------------------------------------------------------
+    struct RingSlot
+    {
+        std::atomic<unsigned long> m_sequence;
+        LaunchRecord m_record;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief copies a record out of a slot if it is not being written and still holds launch _index
+    //----------------------------------------------------------------------------------------------------------------------
+    bool readSlot(unsigned long _index, LaunchRecord &_record);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief time our metrics started
+    //----------------------------------------------------------------------------------------------------------------------
+    std::chrono::steady_clock::time_point m_start;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief statistics of each section
+    //----------------------------------------------------------------------------------------------------------------------
+    AtomicSectionStats m_sections[NumSections];
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our ring of launch records
+    //----------------------------------------------------------------------------------------------------------------------
+    RingSlot m_ring[m_ringSize];
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of launches written to our ring
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<unsigned long> m_written;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the launch currently being recorded. Only touched by m_launchThread.
+    //----------------------------------------------------------------------------------------------------------------------
+    LaunchRecord m_current;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief time the current launch began
+    //----------------------------------------------------------------------------------------------------------------------
+    std::chrono::steady_clock::time_point m_currentStart;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief if a launch is currently being recorded
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<bool> m_inLaunch;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the thread recording the current launch
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<std::thread::id> m_launchThread;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief memory last reported in use by our renderer. Each is read and written on its own so a reader may see
+    /// @brief a mix of two reports, which is fine for display.
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<unsigned long long> m_hostMemory;
+    std::atomic<unsigned long long> m_deviceMemoryUsed;
+    std::atomic<unsigned long long> m_deviceMemoryTotal;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class PerfScopedTimer
+/// @brief Times the scope it lives in and records it against a section of our PerfMetrics
+//----------------------------------------------------------------------------------------------------------------------
+class PerfScopedTimer
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief starts our timer
+    /// @param _section - section to record our time against (PerfMetrics::Section)
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit PerfScopedTimer(PerfMetrics::Section _section) : m_section(_section), m_start(std::chrono::steady_clock::now()){}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief records the time since we were created
+    //----------------------------------------------------------------------------------------------------------------------
+    ~PerfScopedTimer();
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief section we are timing
+    //----------------------------------------------------------------------------------------------------------------------
+    PerfMetrics::Section m_section;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief time we started
+    //----------------------------------------------------------------------------------------------------------------------
+    std::chrono::steady_clock::time_point m_start;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // PERFMETRICS_H
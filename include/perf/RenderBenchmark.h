@@ -0,0 +1,254 @@
+#ifndef RENDERBENCHMARK_H
+#define RENDERBENCHMARK_H
+
+/// @class RenderBenchmark
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Renders a fixed set of scenes headless and measures how fast we trace them.
+/// @brief For each scene we record import and build times, Mrays/s, the render time to reach a number of samples
+/// @brief per pixel and the render time to converge to within a relative RMSE of a reference render of the same scene.
+/// @brief The reference is rendered first with independent random numbers so the measured run can't match it by chance.
+/// @brief Scenes whose assets can't be found are reported as skipped rather than failing the whole run.
+/// @brief References are stored as PFM images in our reference directory and reused by later runs, delete them
+/// @brief to render new ones after changing a scene. We can also record error against time curves of each scene
+/// @brief so that changes trading speed for variance can be compared by the error they reach in a given time.
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include "renderer/PathTracer.h"
+#include "perf/PerfMetrics.h"
+#include "perf/ImageError.h"
+
+class RenderBenchmark
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief settings for our benchmark
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Settings
+    {
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief resolution we render at
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_width;
+        unsigned int m_height;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief samples per pixel we time our render to
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_targetSpp;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief samples per pixel of our reference render
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_referenceSpp;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief we give up on reaching our target RMSE after this many samples per pixel
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_maxSpp;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief RMSE relative to the mean of our reference we time our render to
+        //----------------------------------------------------------------------------------------------------------------------
+        float m_targetRMSE;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief bounces before our russian roulette starts and the max depth of our paths in our measured runs.
+        /// @brief Our references are always rendered with the defaults of our renderer so their error shows any bias.
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_rrBeginDepth;
+        unsigned int m_maxDepth;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief paths to the assets of our scenes
+        //----------------------------------------------------------------------------------------------------------------------
+        std::string m_killerooPath;
+        std::string m_scanPath;
+        std::string m_hdriPath;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief directory we store our reference images in, empty to never store them
+        //----------------------------------------------------------------------------------------------------------------------
+        std::string m_referenceDir;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief render times we measure the error of our image at when recording convergence
+        //----------------------------------------------------------------------------------------------------------------------
+        std::vector<double> m_checkpointsMs;
+        //----------------------------------------------------------------------------------------------------------------------
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the results of benchmarking a scene
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Result
+    {
+        std::string m_scene;
+        bool m_skipped;
+        std::string m_skipReason;
+        unsigned int m_numPolygons;
+        unsigned int m_numLights;
+        unsigned int m_sppPerLaunch;
+        double m_setupMs;
+        double m_meshImportMs;
+        double m_bufferUploadMs;
+        double m_hdrImportMs;
+        double m_firstLaunchMs;
+        double m_accelBuildMs;
+        double m_mraysPerSec;
+        unsigned long long m_totalRays;
+        unsigned int m_launches;
+        PerfMetrics::PathStats m_pathStats;
+        double m_timeToTargetSppMs;
+        double m_timeToTargetRMSEMs;
+        unsigned int m_sppAtTargetRMSE;
+        double m_finalRMSE;
+        bool m_referenceStored;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the error of our image at a point in our render
+    //----------------------------------------------------------------------------------------------------------------------
+    struct ConvergencePoint
+    {
+        double m_checkpointMs;
+        double m_renderMs;
+        unsigned int m_spp;
+        ImageError::Errors m_errors;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the error against time curve of a scene
+    //----------------------------------------------------------------------------------------------------------------------
+    struct ConvergenceCurve
+    {
+        std::string m_scene;
+        bool m_skipped;
+        std::string m_skipReason;
+        std::vector<ConvergencePoint> m_points;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the settings we use if none are given
+    //----------------------------------------------------------------------------------------------------------------------
+    static Settings defaultSettings();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief default constructor
+    /// @param _settings - settings for our benchmark (Settings)
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit RenderBenchmark(const Settings &_settings = defaultSettings());
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief renders all of our scenes
+    //----------------------------------------------------------------------------------------------------------------------
+    void run();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to our results
+    //----------------------------------------------------------------------------------------------------------------------
+    inline const std::vector<Result> &getResults(){return m_results;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes our settings and results as JSON
+    //----------------------------------------------------------------------------------------------------------------------
+    void dumpJSON(std::ostream &_out);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes our settings and results as JSON to file
+    /// @param _path - path of file to write (std::string)
+    /// @returns true on success (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    bool writeJSON(const std::string &_path);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief renders each of our scenes progressively, measuring its error at each of our checkpoints
+    //----------------------------------------------------------------------------------------------------------------------
+    void runConvergence();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to our convergence curves
+    //----------------------------------------------------------------------------------------------------------------------
+    inline const std::vector<ConvergenceCurve> &getConvergenceCurves(){return m_curves;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes our convergence curves as CSV, one row per scene and checkpoint
+    //----------------------------------------------------------------------------------------------------------------------
+    void dumpConvergenceCSV(std::ostream &_out);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes our convergence curves as JSON
+    //----------------------------------------------------------------------------------------------------------------------
+    void dumpConvergenceJSON(std::ostream &_out);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes our convergence curves to file, as JSON if our path ends in .json otherwise as CSV
+    /// @param _path - path of file to write (std::string)
+    /// @returns true on success (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    bool writeConvergence(const std::string &_path);
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our benchmark scenes
+    //----------------------------------------------------------------------------------------------------------------------
+    enum Scene{CornellBox,Killeroo,Scan,ManyLights,HDRI,NumScenes};
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns the name of a scene
+    //----------------------------------------------------------------------------------------------------------------------
+    static const char *getSceneName(Scene _scene);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets up, renders and tears down a scene
+    //----------------------------------------------------------------------------------------------------------------------
+    Result runScene(Scene _scene);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets up, progressively renders and tears down a scene, measuring its error at each of our checkpoints
+    //----------------------------------------------------------------------------------------------------------------------
+    ConvergenceCurve runConvergenceScene(Scene _scene);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief creates a renderer and loads a scene into it, timing how long it takes
+    /// @param _scene - scene to load (Scene)
+    /// @param _result - result to fill in our setup times and if our scene was skipped (Result)
+    /// @returns our renderer, to be deleted with teardownScene (PathTracerScene*)
+    //----------------------------------------------------------------------------------------------------------------------
+    PathTracerScene *setupScene(Scene _scene, Result &_result);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief deletes a renderer created by setupScene along with its geometry
+    //----------------------------------------------------------------------------------------------------------------------
+    void teardownScene(PathTracerScene *_renderer);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief path of the stored reference of a scene at our resolution
+    /// @returns our path or an empty string if we don't store references (std::string)
+    //----------------------------------------------------------------------------------------------------------------------
+    std::string getReferencePath(Scene _scene);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief loads our stored reference of a scene or renders and stores a new one. Either way our renderer has
+    /// @brief launched at least once afterwards, so programs are compiled and acceleration structures built.
+    /// @param _scene - scene of our reference (Scene)
+    /// @param _renderer - renderer with our scene loaded (PathTracerScene*)
+    /// @param _result - result to record our first launch time in (Result)
+    /// @param _reference - returns our reference (DisplayFrame)
+    //----------------------------------------------------------------------------------------------------------------------
+    void getReference(Scene _scene, PathTracerScene *_renderer, Result &_result, DisplayFrame &_reference);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief loads the contents of a scene into our renderer
+    /// @param _scene - scene to load (Scene)
+    /// @param _renderer - renderer to load it into (PathTracerScene*)
+    /// @param _result - result to fill in our scene statistics or reason for skipping (Result)
+    /// @returns false if our scene could not be loaded (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    bool loadScene(Scene _scene, PathTracerScene *_renderer, Result &_result);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief imports a mesh and adds it to our renderer
+    /// @returns the mesh or null if it could not be imported (Mesh*)
+    //----------------------------------------------------------------------------------------------------------------------
+    Mesh *addMesh(const std::string &_path, PathTracerScene *_renderer, Result &_result);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief launches our renderer once, recording the launch in our PerfMetrics
+    /// @returns the launch record (PerfMetrics::LaunchRecord)
+    //----------------------------------------------------------------------------------------------------------------------
+    PerfMetrics::LaunchRecord launch(PathTracerScene *_renderer);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our settings
+    //----------------------------------------------------------------------------------------------------------------------
+    Settings m_settings;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our results
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<Result> m_results;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our convergence curves
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<ConvergenceCurve> m_curves;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief names of the devices we rendered with
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<std::string> m_devices;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief geometry we have added to the scene we're currently rendering
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<AbstractOptixGeometry*> m_geometry;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // RENDERBENCHMARK_H
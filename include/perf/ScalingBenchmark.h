@@ -0,0 +1,132 @@
+#ifndef SCALINGBENCHMARK_H
+#define SCALINGBENCHMARK_H
+
+/// @class ScalingBenchmark
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Sweeps procedurally generated scenes over growing triangle, light and instance counts to chart how our
+/// @brief generation, upload, acceleration structure builds, memory use and frame times scale. Each configuration
+/// @brief gets a fresh renderer so nothing is cached between them. A sweep stops at the first configuration that
+/// @brief fails, such as running out of device memory, and records why.
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include "perf/SceneGenerator.h"
+#include "perf/PerfMetrics.h"
+
+class ScalingBenchmark
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief settings for our sweeps
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Settings
+    {
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief resolution we render at
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_width;
+        unsigned int m_height;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief number of launches we average our frame time over
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_numFrames;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief largest number of triangles in our triangle sweep
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned long long m_maxTriangles;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief largest number of lights in our light sweep
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_maxLights;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief largest number of instances in our instance sweep
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_maxInstances;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief the scene every configuration starts from, each sweep then overrides what it varies
+        //----------------------------------------------------------------------------------------------------------------------
+        SceneGenerator::Settings m_scene;
+        //----------------------------------------------------------------------------------------------------------------------
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the results of one configuration of a sweep
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Result
+    {
+        std::string m_sweep;
+        unsigned int m_numSpheres;
+        SceneGenerator::Stats m_scene;
+        double m_firstLaunchMs;
+        double m_accelBuildMs;
+        double m_deviceMB;
+        double m_frameMs;
+        double m_mraysPerSec;
+        std::string m_status;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the settings we use if none are given, up to 100M triangles, 10k lights and 1000 instances
+    //----------------------------------------------------------------------------------------------------------------------
+    static Settings defaultSettings();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief default constructor
+    /// @param _settings - settings for our sweeps (Settings)
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit ScalingBenchmark(const Settings &_settings = defaultSettings());
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief runs all of our sweeps
+    //----------------------------------------------------------------------------------------------------------------------
+    void run();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to our results
+    //----------------------------------------------------------------------------------------------------------------------
+    inline const std::vector<Result> &getResults(){return m_results;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes our results as CSV, one row per configuration
+    //----------------------------------------------------------------------------------------------------------------------
+    void dumpCSV(std::ostream &_out);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes our results as CSV to file
+    /// @param _path - path of file to write (std::string)
+    /// @returns true on success (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    bool writeCSV(const std::string &_path);
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief runs a sweep, multiplying what it varies by 10 each configuration until it passes its maximum
+    /// @param _name - name of our sweep (std::string)
+    /// @param _value - the setting of our scene our sweep varies (T SceneGenerator::Settings::*)
+    /// @param _first - first value of our sweep (T)
+    /// @param _max - largest value of our sweep (T)
+    //----------------------------------------------------------------------------------------------------------------------
+    template<typename T>
+    void runSweep(const std::string &_name, T SceneGenerator::Settings::*_value, T _first, T _max);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief generates and renders one configuration
+    /// @param _sweep - name of the sweep this configuration is part of (std::string)
+    /// @param _scene - scene to generate (SceneGenerator::Settings)
+    /// @returns our result (Result)
+    //----------------------------------------------------------------------------------------------------------------------
+    Result runConfig(const std::string &_sweep, const SceneGenerator::Settings &_scene);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief launches our renderer once, recording its metrics
+    //----------------------------------------------------------------------------------------------------------------------
+    PerfMetrics::LaunchRecord launch(PathTracerScene *_renderer);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief available memory of the first device of a renderer in bytes
+    //----------------------------------------------------------------------------------------------------------------------
+    double getAvailableDeviceBytes(PathTracerScene *_renderer);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our settings
+    //----------------------------------------------------------------------------------------------------------------------
+    Settings m_settings;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our results
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<Result> m_results;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // SCALINGBENCHMARK_H
@@ -0,0 +1,173 @@
+#ifndef SCENEGENERATOR_H
+#define SCENEGENERATOR_H
+
+/// @class SceneGenerator
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Generates procedural scenes of a given size straight into our renderer, without going through files, so
+/// @brief we can stress test how import, acceleration structure builds, memory and frame times scale.
+/// @brief A scene is made of meshes of random triangles, instances of those meshes, spheres and parallelogram lights,
+/// @brief all placed within a bounding box following one of our spatial distributions. Generation is deterministic
+/// @brief for a given seed so runs can be compared.
+
+#include <vector>
+#include "renderer/PathTracer.h"
+#include "geometry/Mesh.h"
+#include "geometry/Sphere.h"
+
+class SceneGenerator
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief how we place triangles within meshes and objects within our scene
+    //----------------------------------------------------------------------------------------------------------------------
+    enum Distribution
+    {
+        Uniform,    ///< uniformly throughout our bounds
+        Clustered,  ///< in gaussian clusters, like the dense detail of production scenes
+        Planar      ///< scattered over the floor of our bounds, like a landscape
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief what to generate
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Settings
+    {
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief total number of unique triangles, split evenly between our meshes
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned long long m_numTriangles;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief number of unique meshes
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_numMeshes;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief number of extra instances of our meshes, these share the geometry of the mesh they instance
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_numInstances;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief number of parallelogram lights
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_numLights;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief number of spheres
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_numSpheres;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief how we distribute everything
+        //----------------------------------------------------------------------------------------------------------------------
+        Distribution m_distribution;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief number of clusters when our distribution is clustered
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_numClusters;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief scale of our triangles relative to the size that would just fill each mesh
+        //----------------------------------------------------------------------------------------------------------------------
+        float m_triangleScale;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief bounds of our scene
+        //----------------------------------------------------------------------------------------------------------------------
+        optix::float3 m_boundsMin;
+        optix::float3 m_boundsMax;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief seed of our random numbers
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_seed;
+        //----------------------------------------------------------------------------------------------------------------------
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief statistics of what we generated
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Stats
+    {
+        double m_generateMs;
+        double m_uploadMs;
+        unsigned long long m_numTriangles;
+        unsigned long long m_numInstancedTriangles;
+        unsigned int m_numObjects;
+        unsigned int m_numLights;
+        size_t m_hostBytes;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the settings we use if none are given, a million triangles in the bounds of our Cornell box
+    //----------------------------------------------------------------------------------------------------------------------
+    static Settings defaultSettings();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief default constructor
+    /// @param _settings - what to generate (Settings)
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit SceneGenerator(const Settings &_settings = defaultSettings());
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief destructor, our geometry must have been removed from our renderer with clear first
+    //----------------------------------------------------------------------------------------------------------------------
+    ~SceneGenerator();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief generates our scene and adds it to a renderer, replacing its lights
+    /// @param _renderer - renderer to add our scene to (PathTracerScene*)
+    //----------------------------------------------------------------------------------------------------------------------
+    void generate(PathTracerScene *_renderer);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief removes everything we generated from a renderer and deletes it
+    /// @param _renderer - renderer we generated our scene in (PathTracerScene*)
+    //----------------------------------------------------------------------------------------------------------------------
+    void clear(PathTracerScene *_renderer);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the statistics of our last generated scene
+    //----------------------------------------------------------------------------------------------------------------------
+    inline const Stats &getStats(){return m_stats;}
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns a random number in [0,1)
+    //----------------------------------------------------------------------------------------------------------------------
+    float random();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns a random point within a box following our distribution
+    /// @param _min - minimum corner of our box (optix::float3)
+    /// @param _max - maximum corner of our box (optix::float3)
+    /// @param _clusters - centres of our clusters in [0,1]^3 relative to our box (std::vector<optix::float3>)
+    //----------------------------------------------------------------------------------------------------------------------
+    optix::float3 samplePosition(const optix::float3 &_min, const optix::float3 &_max, const std::vector<optix::float3> &_clusters);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief generates a set of cluster centres in [0,1]^3
+    //----------------------------------------------------------------------------------------------------------------------
+    void createClusters(std::vector<optix::float3> &_clusters);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief generates the triangles of a mesh within a box centred on the origin
+    /// @param _numTriangles - number of triangles to generate (unsigned long long)
+    /// @param _extent - size of our box (float)
+    /// @param _vertices - returns our triangle list (std::vector<optix::float3>)
+    //----------------------------------------------------------------------------------------------------------------------
+    void generateTriangles(unsigned long long _numTriangles, float _extent, std::vector<optix::float3> &_vertices);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief generates our lights over the top of our bounds
+    //----------------------------------------------------------------------------------------------------------------------
+    void generateLights(std::vector<ParallelogramLight> &_lights);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our settings
+    //----------------------------------------------------------------------------------------------------------------------
+    Settings m_settings;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief statistics of our last generated scene
+    //----------------------------------------------------------------------------------------------------------------------
+    Stats m_stats;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief state of our random number generator
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_rngState;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our unique meshes
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<Mesh*> m_meshes;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief instances of our meshes
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<Mesh*> m_instances;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our spheres
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<Sphere*> m_spheres;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // SCENEGENERATOR_H
@@ -0,0 +1,138 @@
+#ifndef TRACEEVENTS_H
+#define TRACEEVENTS_H
+
+/// @class TraceEvents
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Singleton recording timed events in the Chrome trace event format so that startup and frames can be
+/// @brief inspected in chrome://tracing or Perfetto. Recording is switched on by setting the environment variable
+/// @brief PHENIX_TRACE to the file to write, or to 1 to write phenix_trace.json. When it is not set a scope costs
+/// @brief next to nothing so they can be left in place around per frame work.
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+
+class TraceEvents
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns an instance of our singleton class
+    //----------------------------------------------------------------------------------------------------------------------
+    static TraceEvents *getInstance();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns if we are recording events
+    //----------------------------------------------------------------------------------------------------------------------
+    inline bool isEnabled(){return m_enabled;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief records a complete event on the calling thread
+    /// @param _name - name of our event (std::string)
+    /// @param _category - category of our event (const char*)
+    /// @param _start - time our event started (std::chrono::steady_clock::time_point)
+    /// @param _end - time our event ended (std::chrono::steady_clock::time_point)
+    //----------------------------------------------------------------------------------------------------------------------
+    void addEvent(const std::string &_name, const char *_category, std::chrono::steady_clock::time_point _start, std::chrono::steady_clock::time_point _end);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief names the calling thread in our trace
+    /// @param _name - name of the thread (std::string)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setThreadName(const std::string &_name);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes all events recorded so far to the file given by PHENIX_TRACE
+    /// @returns true on success (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    bool flush();
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief Constructor. Reads PHENIX_TRACE.
+    //----------------------------------------------------------------------------------------------------------------------
+    TraceEvents();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a recorded event
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Event
+    {
+        std::string m_name;
+        const char *m_category;
+        double m_startUs;
+        double m_durationUs;
+        int m_threadId;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns a small id for the calling thread, must be called with m_mutex locked
+    //----------------------------------------------------------------------------------------------------------------------
+    int getThreadId();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief if we are recording events
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_enabled;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief path of the file we write our events to
+    //----------------------------------------------------------------------------------------------------------------------
+    std::string m_path;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief time our trace starts from
+    //----------------------------------------------------------------------------------------------------------------------
+    std::chrono::steady_clock::time_point m_start;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief mutex to protect our events
+    //----------------------------------------------------------------------------------------------------------------------
+    std::mutex m_mutex;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our recorded events
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<Event> m_events;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief small ids we give each thread that records an event
+    //----------------------------------------------------------------------------------------------------------------------
+    std::map<std::thread::id,int> m_threadIds;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief names of our threads by id
+    //----------------------------------------------------------------------------------------------------------------------
+    std::map<int,std::string> m_threadNames;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class TraceScope
+/// @brief Records the scope it lives in as a trace event if tracing is enabled
+//----------------------------------------------------------------------------------------------------------------------
+class TraceScope
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief starts our event
+    /// @param _name - name of our event (std::string)
+    /// @param _category - category of our event (const char*)
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit TraceScope(const std::string &_name, const char *_category = "startup");
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief records our event
+    //----------------------------------------------------------------------------------------------------------------------
+    ~TraceScope();
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief if tracing was enabled when we started
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_enabled;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief name of our event
+    //----------------------------------------------------------------------------------------------------------------------
+    std::string m_name;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief category of our event
+    //----------------------------------------------------------------------------------------------------------------------
+    const char *m_category;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief time we started
+    //----------------------------------------------------------------------------------------------------------------------
+    std::chrono::steady_clock::time_point m_start;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // TRACEEVENTS_H
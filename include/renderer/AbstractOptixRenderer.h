@@ -14,6 +14,11 @@
 #include <optixu/optixpp_namespace.h>
 #include <optixu/optixu_matrix_namespace.h>
 #include <geometry/AbstractOptixGeometry.h>
+#include <QMutex>
+#include "renderer/SceneEditQueue.h"
+#include "renderer/FrameHandoff.h"
+#include "renderer/Checkpoint.h"
+#include "renderer/Film.h"
 
 class AbstractOptixRenderer
 {
@@ -41,6 +46,27 @@ public:
     //----------------------------------------------------------------------------------------------------------------------
     virtual void trace();
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief restricts our launches to a region of our image, the rest of our image keeps what it last had. Our
+    /// @brief region is kept as fractions of our image so it stays over the same part of it when we are resized.
+    /// @param _x, _y - bottom left corner of our region as a fraction of our image (float)
+    /// @param _width, _height - size of our region as a fraction of our image (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void setRenderRegion(float _x, float _y, float _width, float _height);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief goes back to launching our whole image
+    //----------------------------------------------------------------------------------------------------------------------
+    inline void clearRenderRegion(){setRenderRegion(0.f,0.f,1.f,1.f);}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns if our launches are restricted to a region of our image
+    //----------------------------------------------------------------------------------------------------------------------
+    inline bool hasRenderRegion(){return m_region[0]>0.f || m_region[1]>0.f || m_region[2]<1.f || m_region[3]<1.f;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns the pixels our region covers at our current resolution, at least one pixel in each direction
+    /// @param _x, _y - returns the bottom left pixel of our region (unsigned int)
+    /// @param _width, _height - returns the size of our region in pixels (unsigned int)
+    //----------------------------------------------------------------------------------------------------------------------
+    void getRenderRegion(unsigned int &_x, unsigned int &_y, unsigned int &_width, unsigned int &_height);
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief sets a transformation to the scene. Normally global transformation to geometry.
     /// @param _trans - transform matrix (float*)
     /// @param _invTrans - inverse transform (float*)
@@ -62,6 +88,47 @@ public:
     //----------------------------------------------------------------------------------------------------------------------
     virtual void rebuildScene(){}
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief virtual function to switch our output between our image and the per pixel cost of rendering it
+    /// @param _enable - if we wish to output our cost (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void setCostView(bool _enable){}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief virtual function to set the format the frames we display are resolved into
+    /// @param _format - format of our display frames, RGBA32F displays our accumulation buffer as is (DisplayFrame::Format)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void setDisplayFormat(DisplayFrame::Format _format){}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief virtual function to set the exposure applied when resolving the frames we display
+    /// @param _stops - exposure in stops, 0 leaves our image as is (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void setExposure(float _stops){}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief virtual function to toggle tonemapping of the frames we display
+    /// @param _enable - if we wish to tonemap (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void setTonemap(bool _enable){}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief virtual function to toggle picking our tonemap from the luminance of the frames we display
+    /// @param _enable - if we wish to use auto exposure (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void setAutoExposure(bool _enable){}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief virtual function to set the filter our image is reconstructed with
+    /// @param _filter - our filter (Film::Filter)
+    /// @param _radius - radius of our filter in pixels, 0 for its default (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void setFilter(Film::Filter _filter, float _radius = 0.f){}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief virtual function to set how many standard deviations above its mean a pixel's fireflies are clamped to
+    /// @param _sigmas - standard deviations, 0 to never clamp (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void setFireflyClamp(float _sigmas){}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief virtual function to toggle carrying what float32 rounds away when accumulating our image
+    /// @param _enable - if we compensate our accumulation (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void setCompensatedAccumulation(bool _enable){}
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief accessor to the optix context
     //----------------------------------------------------------------------------------------------------------------------
     inline optix::Context getContext(){return m_context;}
@@ -134,7 +201,86 @@ public:
     //----------------------------------------------------------------------------------------------------------------------
     inline optix::Material getDefaultMaterial(){return m_defaultMat;}
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief copies the contents of our output buffer into a host side frame
+    /// @param _frame - frame to copy our output into (DisplayFrame)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void copyOutput(DisplayFrame &_frame);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief copies the frame we display into a host side frame. By default this is a copy of our output but
+    /// @brief renderers can resolve it into a smaller display format first. The context mutex must be held.
+    /// @param _frame - frame to copy our display image into (DisplayFrame)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void copyDisplay(DisplayFrame &_frame){copyOutput(_frame);}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief copies the accumulation state of our render into a checkpoint. The context mutex must be held.
+    /// @param _checkpoint - returns our state (Checkpoint)
+    /// @returns false if there is nothing to checkpoint or we don't support it (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual bool saveCheckpoint(Checkpoint &_checkpoint){return false;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief carries on the render a checkpoint was saved from. The context mutex must be held.
+    /// @param _checkpoint - our state (Checkpoint)
+    /// @returns false if our checkpoint doesn't match our scene or resolution, our render is left as it was (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual bool restoreCheckpoint(const Checkpoint &_checkpoint){return false;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the number of frames accumulated in our output buffer
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual unsigned int getFrameNumber(){return 0;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the number of samples per pixel each of our launches takes
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual unsigned int getSamplesPerLaunch(){return 1;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief reports the host memory used by our context and the memory in use on our devices to our PerfMetrics.
+    /// @brief Our device memory is summed over all of our enabled devices. The context mutex must be held when calling this.
+    //----------------------------------------------------------------------------------------------------------------------
+    void reportMemoryUsage();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the queue of scene edits waiting to be applied before our next launch
+    /// @returns edit queue (SceneEditQueue*)
+    //----------------------------------------------------------------------------------------------------------------------
+    inline SceneEditQueue *getEditQueue(){return &m_editQueue;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief applies all pending scene edits as one batch, rebuilding our scene at most once.
+    /// @brief The context mutex must be held when calling this.
+    /// @returns true if any edits were applied (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    bool applyEdits();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the mutex guarding our context. Must be held by anyone using the context
+    /// @brief while our renderer is being driven by another thread.
+    /// @returns context mutex (QMutex*)
+    //----------------------------------------------------------------------------------------------------------------------
+    inline QMutex *getContextMutex(){return &m_contextMutex;}
+    //----------------------------------------------------------------------------------------------------------------------
 protected:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief copies the contents of a float buffer of our context into a host side frame
+    /// @param _buffer - buffer to copy (optix::Buffer)
+    /// @param _frame - frame to copy our buffer into (DisplayFrame)
+    //----------------------------------------------------------------------------------------------------------------------
+    void copyBuffer(optix::Buffer _buffer, DisplayFrame &_frame);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief copies a buffer of our context already resolved for display into a host side frame
+    /// @param _buffer - buffer to copy (optix::Buffer)
+    /// @param _format - format of our buffer, RGBA16F or RGBA8 (DisplayFrame::Format)
+    /// @param _frame - frame to copy our buffer into (DisplayFrame)
+    //----------------------------------------------------------------------------------------------------------------------
+    void copyDisplayBuffer(optix::Buffer _buffer, DisplayFrame::Format _format, DisplayFrame &_frame);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief fills in everything but the pixels of a frame we are about to copy into
+    /// @param _frame - our frame (DisplayFrame)
+    /// @param _width, _height - size of our frame (unsigned int)
+    /// @param _format - format of our frame (DisplayFrame::Format)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setFrameInfo(DisplayFrame &_frame, unsigned int _width, unsigned int _height, DisplayFrame::Format _format);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief launches an entry point of our context over our render region, or our whole image
+    /// @param _entryPointIndex - entry point to launch (unsigned int)
+    /// @param _fullFrame - if we launch our whole image whatever our region (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    void launchRegion(unsigned int _entryPointIndex, bool _fullFrame = false);
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief our output buffer
     //----------------------------------------------------------------------------------------------------------------------
@@ -156,12 +302,24 @@ protected:
     //----------------------------------------------------------------------------------------------------------------------
     optix::Material m_defaultMat;
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our render region as fractions of our image, x, y, width and height from our bottom left
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_region[4];
+    //----------------------------------------------------------------------------------------------------------------------
 private:
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief An intance of the optix engine
     //----------------------------------------------------------------------------------------------------------------------
     optix::Context m_context;
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief scene edits waiting to be applied
+    //----------------------------------------------------------------------------------------------------------------------
+    SceneEditQueue m_editQueue;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief mutex guarding our context
+    //----------------------------------------------------------------------------------------------------------------------
+    QMutex m_contextMutex;
+    //----------------------------------------------------------------------------------------------------------------------
 };
 
 #endif // ABSTRACTOPTIXRENDERER_H
@@ -0,0 +1,86 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+/// @class Checkpoint
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief The accumulation state of a render, enough to carry on from where it left off after our process is killed.
+/// @brief Holds our accumulated image and the second moment of our launches that our variance comes from, our frame
+/// @brief number and sample seed so that our next launch continues our sequence of random numbers, our camera and a
+/// @brief hash of our scene so that we never resume into a different scene. Written as a compact binary file of
+/// @brief RGB floats in host byte order with a checksum, to a temporary file that is renamed over our last
+/// @brief checkpoint so a kill part way through a write still leaves that one intact.
+
+#include <vector>
+#include <string>
+
+struct Checkpoint
+{
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief resolution of our accumulation buffers
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_width;
+    unsigned int m_height;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of frames accumulated, our next launch continues from here
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_frameNumber;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief seed mixed into the key of every sample's random numbers
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_sampleSeed;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief samples per pixel of each of our launches
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_samplesPerLaunch;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief hash of everything in our scene that changes our image other than our camera
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned long long m_sceneHash;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our camera, its eye, look at and up followed by its horizontal and vertical fov
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_camera[11];
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the global transform our view is rotated and moved around our scene with
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_globalTransform[16];
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief RGB of our accumulated image, rows bottom to top
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<float> m_accumulation;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief RGB mean of the square of each of our launches. Minus the square of our image this is the variance of a
+    /// @brief launch, and divided by our frame number the variance of our image.
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<float> m_variance;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief default constructor, an empty checkpoint
+    //----------------------------------------------------------------------------------------------------------------------
+    Checkpoint();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief writes a checkpoint, replacing any already at our path only once it has been written in full
+    /// @param _path - file to write (std::string)
+    /// @param _checkpoint - our checkpoint (Checkpoint)
+    /// @returns if our checkpoint was written (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    static bool write(const std::string &_path, const Checkpoint &_checkpoint);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief reads a checkpoint, checking it is complete and was written by a host like ours
+    /// @param _path - file to read (std::string)
+    /// @param _checkpoint - returns our checkpoint (Checkpoint)
+    /// @returns if our checkpoint was read (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    static bool read(const std::string &_path, Checkpoint &_checkpoint);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief 64 bit FNV-1a hash of some bytes, continuing from a previous hash so several can be combined
+    /// @param _data - bytes to hash (const void*)
+    /// @param _size - number of bytes (size_t)
+    /// @param _hash - previous hash, the FNV offset basis to start a new one (unsigned long long)
+    /// @returns our hash (unsigned long long)
+    //----------------------------------------------------------------------------------------------------------------------
+    static unsigned long long hash(const void *_data, size_t _size, unsigned long long _hash = 14695981039346656037ULL);
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,171 @@
+#ifndef FILM_H
+#define FILM_H
+
+/// @class Film
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Reconstructs an image from samples with a box, tent, Gaussian or Blackman-Harris filter for our CPU renders.
+/// @brief Each sample is splatted into every pixel our filter reaches, weighted from a table of our filter built when
+/// @brief it is set. Our film is split into tiles each with a buffer of its own padded by our filter radius, so the
+/// @brief thread rendering a tile can splat across its border without atomics. Our tiles are merged a row at a time
+/// @brief once they are done so no two threads ever write the same pixel. Our GPU can't do the same without atomics
+/// @brief so it importance samples our filter with the table from buildSampleTable instead, see film_filter.h.
+
+#include <vector>
+#include <optixu/optixu_math_namespace.h>
+#include "common/film_filter.h"
+#include "common/ParallelFor.h"
+#include "renderer/FrameHandoff.h"
+
+class Film
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our reconstruction filters
+    //----------------------------------------------------------------------------------------------------------------------
+    enum Filter{Box,Tent,Gaussian,BlackmanHarris,NumFilters};
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a tile of our film and the buffer it splats into, padded by our filter radius and clipped to our film
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Tile
+    {
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief the pixels whose samples belong to this tile, [m_x0,m_x1) by [m_y0,m_y1)
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_x0, m_y0, m_x1, m_y1;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief first pixel and size of our padded buffer
+        //----------------------------------------------------------------------------------------------------------------------
+        unsigned int m_px0, m_py0, m_width, m_height;
+        //----------------------------------------------------------------------------------------------------------------------
+        /// @brief our weighted sums of RGB followed by the sum of our weights for each pixel of our padded buffer
+        //----------------------------------------------------------------------------------------------------------------------
+        std::vector<float> m_pixels;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns the name of a filter
+    //----------------------------------------------------------------------------------------------------------------------
+    static const char *getFilterName(Filter _filter);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns the radius in pixels a filter is used with if we aren't given one
+    //----------------------------------------------------------------------------------------------------------------------
+    static float getDefaultRadius(Filter _filter);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief evaluates one axis of a filter, our filters are separable
+    /// @param _filter - filter to evaluate (Filter)
+    /// @param _x - distance from our pixel centre in pixels (float)
+    /// @param _radius - radius of our filter in pixels, we are 0 from here on (float)
+    /// @returns our unnormalised weight (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    static float evaluate(Filter _filter, float _x, float _radius);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief builds the inverse CDF of one axis of a filter for importance sampling it
+    /// @param _filter - filter to sample (Filter)
+    /// @param _radius - radius of our filter in pixels (float)
+    /// @param _table - returns FILM_FILTER_TABLE_SIZE+1 offsets from our pixel centre for u = 0 to 1 (float*)
+    //----------------------------------------------------------------------------------------------------------------------
+    static void buildSampleTable(Filter _filter, float _radius, float *_table);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief largest radius we allow, FILM_MAX_RADIUS. Our padding and the pixels a sample reaches grow with it.
+    //----------------------------------------------------------------------------------------------------------------------
+    static const float m_maxRadius;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief constructor
+    /// @param _width - width of our film (unsigned int)
+    /// @param _height - height of our film (unsigned int)
+    /// @param _filter - our filter (Filter)
+    /// @param _radius - radius of our filter in pixels, 0 for its default (float)
+    /// @param _tileSize - width and height of our tiles in pixels (unsigned int)
+    //----------------------------------------------------------------------------------------------------------------------
+    Film(unsigned int _width, unsigned int _height, Filter _filter = Box, float _radius = 0.f, unsigned int _tileSize = 32);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets our filter, our film is cleared as its tiles are padded for our new radius
+    /// @param _filter - our filter (Filter)
+    /// @param _radius - radius of our filter in pixels, 0 for its default (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setFilter(Filter _filter, float _radius = 0.f);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief resizes our film, clearing it
+    //----------------------------------------------------------------------------------------------------------------------
+    void resize(unsigned int _width, unsigned int _height);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief clears our film and its tiles
+    //----------------------------------------------------------------------------------------------------------------------
+    void clear();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessors to our size and filter
+    //----------------------------------------------------------------------------------------------------------------------
+    inline unsigned int getWidth(){return m_width;}
+    inline unsigned int getHeight(){return m_height;}
+    inline Filter getFilter(){return m_filter;}
+    inline float getRadius(){return m_radius;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessors to our tiles
+    //----------------------------------------------------------------------------------------------------------------------
+    inline unsigned int getNumTiles(){return m_tiles.size();}
+    inline Tile &getTile(unsigned int _i){return m_tiles[_i];}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief splats a sample into a tile. Only the thread rendering our tile may call this for it.
+    /// @param _tile - the tile whose pixels our sample was taken in (Tile)
+    /// @param _x, _y - position of our sample on our film in pixels, pixel centres are at +0.5 (float)
+    /// @param _radiance - our sample (optix::float3)
+    //----------------------------------------------------------------------------------------------------------------------
+    void addSample(Tile &_tile, float _x, float _y, const optix::float3 &_radiance) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief renders each of our tiles across all of our cores then merges them into our film
+    /// @param _func - called once for each tile on the thread that owns it (void(Tile&))
+    //----------------------------------------------------------------------------------------------------------------------
+    template<typename Func>
+    void renderTiles(Func _func)
+    {
+        parallelFor(m_tiles.size(),1,[&](unsigned int _begin, unsigned int _end, unsigned int)
+        {
+            for(unsigned int i=_begin;i<_end;i++) _func(m_tiles[i]);
+        });
+        merge();
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief adds what has been splatted into our tiles to our film and clears them
+    //----------------------------------------------------------------------------------------------------------------------
+    void merge();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief divides our film by its weights
+    /// @param _frame - returns our image as an RGBA32F frame, rows bottom to top (DisplayFrame)
+    //----------------------------------------------------------------------------------------------------------------------
+    void resolve(DisplayFrame &_frame) const;
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief splits our film into tiles padded for our filter radius
+    //----------------------------------------------------------------------------------------------------------------------
+    void buildTiles();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief size of our film
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_width;
+    unsigned int m_height;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief width and height of our tiles
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_tileSize;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our filter and its radius in pixels
+    //----------------------------------------------------------------------------------------------------------------------
+    Filter m_filter;
+    float m_radius;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief one axis of our filter from our pixel centre to our radius in equal steps
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_weights[FILM_FILTER_TABLE_SIZE];
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our tiles
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<Tile> m_tiles;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief weighted sums of RGB followed by the sum of our weights for each pixel of our film
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<float> m_pixels;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // FILM_H
@@ -0,0 +1,141 @@
+#ifndef FRAMEHANDOFF_H
+#define FRAMEHANDOFF_H
+
+/// @class FrameHandoff
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Lock free hand off of completed frames from our render thread to the GUI thread.
+/// @brief The render thread always writes into its back frame and the GUI always displays its front frame.
+/// @brief A third spare frame sits between them so that publishing and acquiring is a single atomic exchange
+/// @brief and neither side ever has to wait on the other.
+
+#include <vector>
+#include <atomic>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief a host side copy of a completed frame from our renderer
+//----------------------------------------------------------------------------------------------------------------------
+struct DisplayFrame
+{
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the formats our frame can be held in. RGBA32F frames are our raw accumulation buffer held in m_pixels,
+    /// @brief the others have been resolved for display with exposure, tonemapping and sRGB and are held in m_display.
+    //----------------------------------------------------------------------------------------------------------------------
+    enum Format{RGBA32F,RGBA16F,RGBA8};
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief RGBA float pixel data of our frame
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<float> m_pixels;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief pixel data of our frame resolved for display, empty for RGBA32F frames
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<unsigned char> m_display;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the format of our frame
+    //----------------------------------------------------------------------------------------------------------------------
+    Format m_format;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief width of our frame
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_width;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief height of our frame
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_height;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the number of accumulated frames in this image
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_frameNumber;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the number of samples per pixel accumulated in this image
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_samples;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the version of the last scene edit applied before this frame was launched
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned long m_editVersion;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief true if our pixels hold the per pixel work counters of our cost view rather than colours
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_cost;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief default constructor
+    //----------------------------------------------------------------------------------------------------------------------
+    DisplayFrame() : m_format(RGBA32F), m_width(0), m_height(0), m_frameNumber(0), m_samples(0), m_editVersion(0), m_cost(false){}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns if our frame holds any pixels
+    //----------------------------------------------------------------------------------------------------------------------
+    inline bool isEmpty() const {return (m_format==RGBA32F) ? m_pixels.empty() : m_display.empty();}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the pixels of our frame in our format
+    //----------------------------------------------------------------------------------------------------------------------
+    inline const void *getData() const {return (m_format==RGBA32F) ? (const void*)&m_pixels[0] : (const void*)&m_display[0];}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief reads a pixel of our frame as floats whatever our format
+    /// @param _index - index of our pixel (unsigned int)
+    /// @param _rgba - the 4 channels of our pixel (float*)
+    //----------------------------------------------------------------------------------------------------------------------
+    void getPixel(unsigned int _index, float *_rgba) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns the number of bytes in a pixel of a format
+    //----------------------------------------------------------------------------------------------------------------------
+    static unsigned int getBytesPerPixel(Format _format);
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+class FrameHandoff
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief default constructor
+    //----------------------------------------------------------------------------------------------------------------------
+    FrameHandoff();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the frame our render thread should write into. Only to be used by the render thread.
+    /// @returns back frame (DisplayFrame)
+    //----------------------------------------------------------------------------------------------------------------------
+    inline DisplayFrame &backFrame(){return m_frames[m_back];}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief publishes our back frame so that it can be acquired by the GUI. Only to be used by the render thread.
+    //----------------------------------------------------------------------------------------------------------------------
+    void publish();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief swaps in the latest published frame if there is one. Only to be used by the GUI thread.
+    /// @returns true if our front frame has changed (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    bool acquire();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the frame currently being displayed. Only to be used by the GUI thread.
+    /// @returns front frame (DisplayFrame)
+    //----------------------------------------------------------------------------------------------------------------------
+    inline const DisplayFrame &frontFrame() const {return m_frames[m_front];}
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief bit set in m_ready when the spare frame holds a frame that hasn't been acquired yet
+    //----------------------------------------------------------------------------------------------------------------------
+    static const int m_freshBit = 4;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief mask to extract the frame index from m_ready
+    //----------------------------------------------------------------------------------------------------------------------
+    static const int m_indexMask = 3;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our three frames
+    //----------------------------------------------------------------------------------------------------------------------
+    DisplayFrame m_frames[3];
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief index of the frame owned by the render thread
+    //----------------------------------------------------------------------------------------------------------------------
+    int m_back;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief index of the frame owned by the GUI thread
+    //----------------------------------------------------------------------------------------------------------------------
+    int m_front;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief index of the spare frame shared between both threads and whether it is fresh
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<int> m_ready;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // FRAMEHANDOFF_H
@@ -12,11 +12,13 @@
 
 
 #include <QImage>
+#include <chrono>
 
 #include <glm/glm.hpp>
 #include "common/random.h"
 #include "lights/ParallelogramLight.h"
 #include "common/helpers.h"
+#include "common/AutoExposure.h"
 #include "renderer/PathTraceCamera.h"
 #include "geometry/Mesh.h"
 
@@ -42,10 +44,14 @@ public:
     //----------------------------------------------------------------------------------------------------------------------
     ~PathTracerScene();
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief initialise our class
+    /// @brief initialise our class and load our test scene
     //----------------------------------------------------------------------------------------------------------------------
     void initialize();
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief initialise our context, camera and default material with an empty scene
+    //----------------------------------------------------------------------------------------------------------------------
+    void initializeContext();
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief our trace function that launches our Optix context
     //----------------------------------------------------------------------------------------------------------------------
     void trace();
@@ -72,6 +78,13 @@ public:
     //----------------------------------------------------------------------------------------------------------------------
     void resize(unsigned int _width,unsigned int _height);
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief restricts our launches to a region of our image. The pixels of a region that only shrinks ours have had
+    /// @brief every frame we have so we carry on accumulating, anything else restarts our render.
+    /// @param _x, _y - bottom left corner of our region as a fraction of our image (float)
+    /// @param _width, _height - size of our region as a fraction of our image (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void setRenderRegion(float _x, float _y, float _width, float _height);
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief signals if our camera has changed
     //----------------------------------------------------------------------------------------------------------------------
     inline void signalCameraChanged(){m_cameraChanged=true;}
@@ -84,6 +97,14 @@ public:
     //----------------------------------------------------------------------------------------------------------------------
     inline void signalSceneChanged(){m_frame = 0;}
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the number of frames accumulated in our output buffer
+    //----------------------------------------------------------------------------------------------------------------------
+    inline unsigned int getFrameNumber(){return m_frame;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the number of samples per pixel each of our launches takes
+    //----------------------------------------------------------------------------------------------------------------------
+    inline unsigned int getSamplesPerLaunch(){return m_sqrt_num_samples*m_sqrt_num_samples;}
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief updates our camera the instance of our camera
     //----------------------------------------------------------------------------------------------------------------------
     void updateCamera();
@@ -97,14 +118,23 @@ public:
     //----------------------------------------------------------------------------------------------------------------------
     void cleanTopAcceleration();
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief sets the max ray depth in our path tracer
+    /// @brief sets the max ray depth in our path tracer, the most segments a path can have before it is ended
     //----------------------------------------------------------------------------------------------------------------------
-    inline void setMaxRayDepth(int _depth){getContext()["maxDepth"]->setUint(_depth); m_maxRayDepth = _depth;}
+    inline void setMaxRayDepth(int _depth){getContext()["maxDepth"]->setUint(_depth); m_maxRayDepth = _depth; m_frame = 0;}
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief accesor to the max ray depth of our path tracer
     //----------------------------------------------------------------------------------------------------------------------
     inline int getMaxRayDepth(){return m_maxRayDepth;}
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets the number of bounces before our russian roulette starts ending paths. Our accumulation is restarted.
+    /// @param _depth - bounces before russian roulette, 1 by default (unsigned int)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setRRBeginDepth(unsigned int _depth);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the number of bounces before our russian roulette starts
+    //----------------------------------------------------------------------------------------------------------------------
+    inline unsigned int getRRBeginDepth(){return m_rr_begin_depth;}
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief mutator for our global transform
     /// @param _trans - desired global transform
     //----------------------------------------------------------------------------------------------------------------------
@@ -130,7 +160,150 @@ public:
     //----------------------------------------------------------------------------------------------------------------------
     void loadTestGeomtry();
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief loads the walls and light of our cornell box
+    //----------------------------------------------------------------------------------------------------------------------
+    void loadCornellBox();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets the lights sampled by our path tracer for direct lighting
+    /// @param _lights - lights in our scene (std::vector<ParallelogramLight>)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setLights(const std::vector<ParallelogramLight> &_lights);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief lights our scene with an HDR environment map instead of our background colour
+    /// @param _path - path to a radiance .hdr file, empty to go back to our background colour (std::string)
+    /// @returns false if the map could not be loaded (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    bool setEnvironmentMap(const std::string &_path);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief seeds the random numbers of every sample so two renders of the same scene are independent
+    /// @param _seed - our seed, 0 by default (unsigned int)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setSampleSeed(unsigned int _seed);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief enables counting the camera, bounce and shadow rays of each launch along with the lengths of our paths,
+    /// @brief why they ended and their throughput when they did. Counts are reported to our PerfMetrics.
+    /// @brief This costs a few atomics per path and extra buffer uploads and readbacks per launch.
+    /// @param _count - if we wish to count rays (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setRayCounting(bool _count);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns if we are counting rays
+    //----------------------------------------------------------------------------------------------------------------------
+    inline bool isRayCounting(){return m_countRays;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief switches our output between our image and the per pixel cost of rendering it. Our cost is the primitives
+    /// @brief tested, thousands of clock cycles spent, path segments and shadow rays of each pixel averaged per sample.
+    /// @brief Our accumulation is restarted so the two never mix.
+    /// @param _enable - if we wish to output our cost (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void setCostView(bool _enable);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns if we are outputting our cost
+    //----------------------------------------------------------------------------------------------------------------------
+    inline bool isCostView(){return m_costView;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief copies our image, or our cost if our cost view is enabled, into a host side frame
+    /// @param _frame - frame to copy our output into (DisplayFrame)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void copyOutput(DisplayFrame &_frame);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief resolves our image into our display format with a launch of our resolve program and copies it into a host
+    /// @brief side frame. Our cost and RGBA32F frames are copied as they are.
+    /// @param _frame - frame to copy our display image into (DisplayFrame)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void copyDisplay(DisplayFrame &_frame);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets the format our display frames are resolved into
+    /// @param _format - format of our display frames (DisplayFrame::Format)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void setDisplayFormat(DisplayFrame::Format _format);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the format our display frames are resolved into
+    //----------------------------------------------------------------------------------------------------------------------
+    inline DisplayFrame::Format getDisplayFormat(){return m_displayFormat;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets the filter our image is reconstructed with. Our samples are placed by importance sampling our
+    /// @brief filter rather than splatted into their neighbours so our launch doesn't need atomics. Restarts our render.
+    /// @param _filter - our filter (Film::Filter)
+    /// @param _radius - radius of our filter in pixels, 0 for its default (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void setFilter(Film::Filter _filter, float _radius = 0.f);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessors to our filter and its radius
+    //----------------------------------------------------------------------------------------------------------------------
+    inline Film::Filter getFilter(){return m_filter;}
+    inline float getFilterRadius(){return m_filterRadius;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets how many standard deviations above its mean each launch's estimate of a pixel is clamped to. This
+    /// @brief darkens our image where fireflies are clamped so it restarts our render and is part of our scene hash.
+    /// @param _sigmas - standard deviations, 0 to never clamp (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void setFireflyClamp(float _sigmas);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief toggles carrying what float32 rounds away when accumulating our image, see common/accumulate.h
+    /// @param _enable - if we compensate our accumulation (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void setCompensatedAccumulation(bool _enable);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessors to our firefly clamp and if we compensate our accumulation
+    //----------------------------------------------------------------------------------------------------------------------
+    inline float getFireflyClamp(){return m_fireflySigmas;}
+    inline bool getCompensatedAccumulation(){return m_compensateAccumulation;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets the exposure applied when resolving our display frames
+    /// @param _stops - exposure in stops (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void setExposure(float _stops);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief toggles tonemapping of our display frames
+    /// @param _enable - if we wish to tonemap (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void setTonemap(bool _enable);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets the parameters of our tonemap, see tonemap() in common/helpers.h
+    /// @param _logAverage - log average luminance of our image (float)
+    /// @param _white - the smallest luminance mapped to white (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setTonemapParams(float _logAverage, float _white);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief toggles picking our tonemap parameters from the luminance of our image. Our exposure is still applied
+    /// @brief on top so it can be used to bias what we pick.
+    /// @param _enable - if we wish to use auto exposure (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void setAutoExposure(bool _enable);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the parameters our display frames are resolved with
+    //----------------------------------------------------------------------------------------------------------------------
+    inline const AutoExposure::Params &getDisplayParams(){return m_displayParams;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief copies our accumulated image, its variance, frame number, seed and camera into a checkpoint
+    /// @param _checkpoint - returns our state (Checkpoint)
+    /// @returns false if we have nothing accumulated, are outputting our cost or only tracing a region (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual bool saveCheckpoint(Checkpoint &_checkpoint);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief carries on the render a checkpoint was saved from, if it was of this scene at our resolution
+    /// @param _checkpoint - our state (Checkpoint)
+    /// @returns false if our checkpoint doesn't match, our render is left as it was (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual bool restoreCheckpoint(const Checkpoint &_checkpoint);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief hashes everything in our scene that changes our image other than our camera and global transform. Our
+    /// @brief geometry is hashed by its transforms, primitive counts and colours rather than its vertices so this is
+    /// @brief cheap enough to call whenever we checkpoint.
+    /// @returns our hash (unsigned long long)
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned long long getSceneHash();
+    //----------------------------------------------------------------------------------------------------------------------
 private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief measures our output and adapts our tonemap to it, at most every 100ms
+    //----------------------------------------------------------------------------------------------------------------------
+    void updateAutoExposure();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief zeroes what our output and variance buffers are short by, for when it no longer matches what is in them
+    //----------------------------------------------------------------------------------------------------------------------
+    void clearCompensation();
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief total number of polygons in the scene
     //----------------------------------------------------------------------------------------------------------------------
@@ -160,7 +333,7 @@ private:
     //----------------------------------------------------------------------------------------------------------------------
     PathTraceCamera *m_camera;
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief the depth of our ray?
+    /// @brief the number of bounces before our russian roulette starts
     //----------------------------------------------------------------------------------------------------------------------
     unsigned int m_rr_begin_depth;
     //----------------------------------------------------------------------------------------------------------------------
@@ -189,6 +362,98 @@ private:
     //----------------------------------------------------------------------------------------------------------------------
     Mesh *m_testMesh;
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief if we are counting the rays of each launch
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_countRays;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief buffer our path tracer counts camera, bounce and shadow rays into
+    //----------------------------------------------------------------------------------------------------------------------
+    optix::Buffer m_rayCounterBuffer;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief buffers our path tracer writes our path statistics to, see common/path_stats.h
+    //----------------------------------------------------------------------------------------------------------------------
+    optix::Buffer m_pathStatsBuffer;
+    optix::Buffer m_pathThroughputBuffer;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief if we are outputting our cost rather than our image
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_costView;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set when our buffers have been resized so our next launch fills our whole image, even if we only
+    /// @brief trace a region, rather than leaving whatever our resize left outside of it
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_traceFullFrame;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief per pixel cost our path tracer writes when our cost view is enabled
+    //----------------------------------------------------------------------------------------------------------------------
+    optix::Buffer m_costBuffer;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief per pixel count of primitives tested by our intersection programs in the current launch
+    //----------------------------------------------------------------------------------------------------------------------
+    optix::Buffer m_primTestBuffer;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the format our display frames are resolved into
+    //----------------------------------------------------------------------------------------------------------------------
+    DisplayFrame::Format m_displayFormat;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief buffer our resolve program writes our display frames to, 1x1 while we display RGBA32F frames
+    //----------------------------------------------------------------------------------------------------------------------
+    optix::Buffer m_displayBuffer;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our resolve programs for each of our display formats
+    //----------------------------------------------------------------------------------------------------------------------
+    optix::Program m_resolveRGBA8;
+    optix::Program m_resolveRGBA16F;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the parameters our display frames are resolved with
+    //----------------------------------------------------------------------------------------------------------------------
+    AutoExposure::Params m_displayParams;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our auto exposure, if it is enabled and when we last measured our output for it
+    //----------------------------------------------------------------------------------------------------------------------
+    AutoExposure m_autoExposure;
+    bool m_autoExposureEnabled;
+    bool m_exposureMeasured;
+    std::chrono::steady_clock::time_point m_lastExposureUpdate;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the lights sampled by our path tracer
+    //----------------------------------------------------------------------------------------------------------------------
+    optix::Buffer m_lightBuffer;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief per pixel mean of the square of each of our launches, our variance is this minus the square of our output
+    //----------------------------------------------------------------------------------------------------------------------
+    optix::Buffer m_varianceBuffer;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief seed mixed into the key of every sample's random numbers, picking another repeatable sequence of images
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_sampleSeed;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief path of our environment map, empty if we are lit by our background colour
+    //----------------------------------------------------------------------------------------------------------------------
+    std::string m_environmentMap;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the inverse CDF of our filter our samples are placed with, see film_filter.h
+    //----------------------------------------------------------------------------------------------------------------------
+    optix::Buffer m_filterBuffer;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our filter and its radius in pixels
+    //----------------------------------------------------------------------------------------------------------------------
+    Film::Filter m_filter;
+    float m_filterRadius;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief what our output and variance buffers are short by from float32 rounding
+    //----------------------------------------------------------------------------------------------------------------------
+    optix::Buffer m_compensationBuffer;
+    optix::Buffer m_varianceCompensationBuffer;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief standard deviations above its mean a pixel's fireflies are clamped to, 0 to never clamp
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_fireflySigmas;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief if we carry what float32 rounds away when accumulating our image
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_compensateAccumulation;
+    //----------------------------------------------------------------------------------------------------------------------
 };
 
 #endif // PATHTRACERSCENE_H
@@ -0,0 +1,267 @@
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+
+/// @class RenderThread
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief Drives our renderer on its own thread so that a slow launch never blocks the GUI.
+/// @brief Each iteration applies any queued scene edits, launches our renderer and hands the
+/// @brief completed frame to the GUI through a FrameHandoff. When there is nothing to do, i.e. rendering is paused,
+/// @brief timed out, converged or our view is hidden, the thread sleeps until it is woken by an edit or a change of state.
+/// @brief Long renders can be saved every so many samples per pixel. Our accumulation buffer is copied out between
+/// @brief launches and handed to our ImageExporter so we carry on rendering while it is written. The GUI asks for its
+/// @brief own saves of our accumulation the same way, so it never has to wait on our context.
+/// @brief Our accumulation can also be checkpointed every so many seconds, written on a thread of its own, so that a
+/// @brief render killed part way through can be resumed rather than started again.
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <vector>
+#include "renderer/AbstractOptixRenderer.h"
+#include "renderer/FrameHandoff.h"
+#include "common/ImageExporter.h"
+
+class RenderThread : public QThread
+{
+    Q_OBJECT
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief default constructor
+    /// @param _renderer - the renderer to drive from this thread (AbstractOptixRenderer)
+    /// @param _parent - parent object (QObject)
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit RenderThread(AbstractOptixRenderer *_renderer, QObject *_parent = 0);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief default destructor. Stops our thread if it is still running.
+    //----------------------------------------------------------------------------------------------------------------------
+    ~RenderThread();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief asks our thread to finish and waits for it to do so
+    //----------------------------------------------------------------------------------------------------------------------
+    void stop();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the frames produced by this thread
+    /// @returns frame handoff (FrameHandoff*)
+    //----------------------------------------------------------------------------------------------------------------------
+    inline FrameHandoff *getFrameHandoff(){return &m_frames;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief mutator to pause or resume rendering
+    /// @param _render - if we wish to render (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    inline void setRendering(bool _render){m_render = _render; wake();}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns if we are currently rendering
+    //----------------------------------------------------------------------------------------------------------------------
+    inline bool isRendering(){return m_render;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief mutator for our render timeout
+    /// @param _timeout - timeout in seconds, 0 for no timeout (int)
+    //----------------------------------------------------------------------------------------------------------------------
+    inline void setTimeOutDur(int _timeout){m_timeOut = _timeout; wake();}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns if our render has timed out
+    //----------------------------------------------------------------------------------------------------------------------
+    inline bool hasTimedOut(){return m_timedOut;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief restarts our render timeout
+    //----------------------------------------------------------------------------------------------------------------------
+    void resetTimeOut();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief mutator for the number of frames to accumulate before we consider our render converged and stop
+    /// @param _maxFrames - max number of frames, 0 for no limit (unsigned int)
+    //----------------------------------------------------------------------------------------------------------------------
+    inline void setMaxFrames(unsigned int _maxFrames){m_maxFrames = _maxFrames; wake();}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets how often our render is saved
+    /// @param _samples - samples per pixel between saves, 0 to stop saving (unsigned int)
+    /// @param _path - our files are written to this path followed by their samples per pixel (std::string)
+    /// @param _format - format to save in (ImageExporter::Format)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setAutoSave(unsigned int _samples, const std::string &_path, ImageExporter::Format _format);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief asks for our accumulation buffer to be saved. It is copied out between our launches, or straight away
+    /// @brief if we are sleeping, and written by our ImageExporter, so this returns immediately.
+    /// @param _path - file to write (std::string)
+    /// @param _format - format to save in (ImageExporter::Format)
+    //----------------------------------------------------------------------------------------------------------------------
+    void saveOutput(const std::string &_path, ImageExporter::Format _format);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets how often our accumulation is checkpointed
+    /// @param _path - file our checkpoints are written to, each replaces the last (std::string)
+    /// @param _seconds - seconds between checkpoints, 0 to stop checkpointing (unsigned int)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setCheckpoint(const std::string &_path, unsigned int _seconds);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief reads a checkpoint and queues it to be restored before our next launch, after any edits already queued
+    /// @brief such as our resize. Our renderer only restores it if it is of the same scene at the same resolution.
+    /// @param _path - checkpoint to resume (std::string)
+    /// @returns false if our checkpoint could not be read (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    bool resume(const std::string &_path);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief tells us if whatever is displaying our frames can be seen. We don't render when it can't.
+    /// @param _visible - if our frames can be seen (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    inline void setVisible(bool _visible){m_visible = _visible; wake();}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns true if our thread is currently sleeping with nothing to do
+    //----------------------------------------------------------------------------------------------------------------------
+    inline bool isIdle(){return m_idle;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief wakes our thread if it is sleeping so that it re-evaluates if there is work to do
+    //----------------------------------------------------------------------------------------------------------------------
+    void wake();
+    //----------------------------------------------------------------------------------------------------------------------
+signals:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief emitted from our render thread every time a new frame has been published
+    //----------------------------------------------------------------------------------------------------------------------
+    void frameReady();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief emitted from our render thread when it goes to sleep or wakes up to render
+    //----------------------------------------------------------------------------------------------------------------------
+    void idleChanged(bool _idle);
+    //----------------------------------------------------------------------------------------------------------------------
+protected:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our render loop
+    //----------------------------------------------------------------------------------------------------------------------
+    void run();
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief saves our render if it has passed another multiple of our auto save samples. Only called from our render
+    /// @brief loop while we hold our context.
+    /// @param _frame - the frame we have just copied out of our renderer (DisplayFrame)
+    //----------------------------------------------------------------------------------------------------------------------
+    void autoSave(const DisplayFrame &_frame);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief copies our accumulation out for any saves the GUI has asked for and starts writing them. Only called
+    /// @brief from our render loop while we hold our context.
+    //----------------------------------------------------------------------------------------------------------------------
+    void savePending();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief copies our accumulation into a checkpoint if our interval has passed and starts writing it. Only called
+    /// @brief from our render loop while we hold our context.
+    //----------------------------------------------------------------------------------------------------------------------
+    void checkpoint();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the renderer we are driving
+    //----------------------------------------------------------------------------------------------------------------------
+    AbstractOptixRenderer *m_renderer;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our completed frames
+    //----------------------------------------------------------------------------------------------------------------------
+    FrameHandoff m_frames;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief flag to tell our render loop to finish
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<bool> m_stop;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief if we wish to render or not
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<bool> m_render;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief render timeout in seconds
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<int> m_timeOut;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief if our render has timed out
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<bool> m_timedOut;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief time our timeout started in msecs since epoch
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<qint64> m_timeOutStart;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of frames after which our render is converged, 0 for no limit
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<unsigned int> m_maxFrames;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief if our frames can be seen
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<bool> m_visible;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief samples per pixel between auto saves, 0 to not save
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<unsigned int> m_autoSaveSamples;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief mutex to protect our auto save path and format
+    //----------------------------------------------------------------------------------------------------------------------
+    QMutex m_autoSaveMutex;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief path our auto saves are written to, followed by their samples per pixel
+    //----------------------------------------------------------------------------------------------------------------------
+    std::string m_autoSavePath;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief format of our auto saves
+    //----------------------------------------------------------------------------------------------------------------------
+    ImageExporter::Format m_autoSaveFormat;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief samples per pixel of our last auto save. Only used by our render thread.
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_lastAutoSave;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a save the GUI has asked for
+    //----------------------------------------------------------------------------------------------------------------------
+    struct PendingSave
+    {
+        std::string m_path;
+        ImageExporter::Format m_format;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief mutex to protect our pending saves
+    //----------------------------------------------------------------------------------------------------------------------
+    QMutex m_saveMutex;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief saves the GUI has asked for that we haven't started yet
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<PendingSave> m_pendingSaves;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief seconds between checkpoints, 0 to not checkpoint
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<unsigned int> m_checkpointInterval;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief mutex to protect our checkpoint path
+    //----------------------------------------------------------------------------------------------------------------------
+    QMutex m_checkpointMutex;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief file our checkpoints are written to
+    //----------------------------------------------------------------------------------------------------------------------
+    std::string m_checkpointPath;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief time of our last checkpoint in msecs since epoch. Only used by our render thread.
+    //----------------------------------------------------------------------------------------------------------------------
+    qint64 m_lastCheckpoint;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief thread writing our last checkpoint, joined before the next is started
+    //----------------------------------------------------------------------------------------------------------------------
+    std::thread m_checkpointThread;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief if our checkpoint thread is still writing, we skip checkpoints rather than wait for it
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<bool> m_checkpointWriting;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief if our thread is sleeping
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<bool> m_idle;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief mutex used with our wait condition
+    //----------------------------------------------------------------------------------------------------------------------
+    QMutex m_wakeMutex;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief wait condition our thread sleeps on when there is nothing to do
+    //----------------------------------------------------------------------------------------------------------------------
+    QWaitCondition m_wakeCondition;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set when we have been woken so that a wake just before we sleep isn't lost
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_wakePending;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // RENDERTHREAD_H
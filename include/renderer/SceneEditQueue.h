@@ -0,0 +1,120 @@
+#ifndef SCENEEDITQUEUE_H
+#define SCENEEDITQUEUE_H
+
+/// @class SceneEditQueue
+/// @date 19/10/16
+/// @author Declan Russell
+/// @brief A versioned queue of scene edits pushed by the GUI and applied by the render thread before its next launch.
+/// @brief Edits can be keyed by the object they change and the type of change. A keyed edit replaces any pending
+/// @brief edit with the same key so that a storm of GUI changes to one object is applied once per frame. Edits that
+/// @brief invalidate the scene only flag it, leaving the owner of the queue to rebuild once for the whole batch.
+/// @brief Pushing only ever holds the lock long enough to append so the GUI never waits on a launch.
+
+#include <vector>
+#include <map>
+#include <atomic>
+#include <functional>
+#include <QMutex>
+
+class SceneEditQueue
+{
+public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief typedef for an edit to our scene
+    //----------------------------------------------------------------------------------------------------------------------
+    typedef std::function<void()> Edit;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the type of change an edit makes to an object. Pending edits with the same object and type are merged.
+    //----------------------------------------------------------------------------------------------------------------------
+    enum EditType{Transform,Attributes,Material,Lights,Resize,Camera};
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief default constructor
+    //----------------------------------------------------------------------------------------------------------------------
+    SceneEditQueue();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief adds an edit to our queue that will never be merged with any other edit
+    /// @param _edit - edit to apply to our scene (Edit)
+    /// @param _rebuildScene - if this edit requires our scene to be rebuilt (bool)
+    /// @returns the version of this edit (unsigned long)
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned long push(Edit _edit, bool _rebuildScene = false);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief adds an edit to our queue replacing any pending edit of the same type to the same object
+    /// @param _object - the object this edit changes (const void*)
+    /// @param _type - the type of change (EditType)
+    /// @param _edit - edit to apply to our scene (Edit)
+    /// @param _rebuildScene - if this edit requires our scene to be rebuilt (bool)
+    /// @returns the version of this edit (unsigned long)
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned long push(const void *_object, EditType _type, Edit _edit, bool _rebuildScene = false);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief applies all pending edits in version order. Should be called from the thread that owns the scene.
+    /// @param _rebuildScene - set to true if any applied edit requires our scene to be rebuilt (bool*)
+    /// @returns true if any edits were applied (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    bool apply(bool *_rebuildScene = 0);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief returns if we have any edits waiting to be applied
+    //----------------------------------------------------------------------------------------------------------------------
+    bool isEmpty();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the version of the most recently pushed edit
+    //----------------------------------------------------------------------------------------------------------------------
+    inline unsigned long getVersion(){return m_version;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor to the version of the most recently applied edit. Once this is greater than or equal to the
+    /// @brief version returned from a push that edit is visible in our scene.
+    //----------------------------------------------------------------------------------------------------------------------
+    inline unsigned long getAppliedVersion(){return m_appliedVersion;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets a function to be called after every push, used to wake whoever applies our edits
+    /// @param _notifier - function to call, pass an empty function to clear (std::function<void()>)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setPushNotifier(std::function<void()> _notifier);
+    //----------------------------------------------------------------------------------------------------------------------
+private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief an edit waiting to be applied
+    //----------------------------------------------------------------------------------------------------------------------
+    struct PendingEdit
+    {
+        Edit m_edit;
+        bool m_rebuildScene;
+        unsigned long m_version;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief typedef for the key we merge edits with
+    //----------------------------------------------------------------------------------------------------------------------
+    typedef std::pair<const void*,int> EditKey;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sorts pending edits by version
+    //----------------------------------------------------------------------------------------------------------------------
+    static bool olderThan(const PendingEdit &_a, const PendingEdit &_b){return _a.m_version < _b.m_version;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief mutex to protect our pending edits
+    //----------------------------------------------------------------------------------------------------------------------
+    QMutex m_mutex;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief edits waiting to be applied
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<PendingEdit> m_pending;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief index into m_pending of the pending edit for each key
+    //----------------------------------------------------------------------------------------------------------------------
+    std::map<EditKey,unsigned int> m_keyed;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief version of the most recently pushed edit
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<unsigned long> m_version;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief version of the most recently applied edit
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<unsigned long> m_appliedVersion;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief called after every push
+    //----------------------------------------------------------------------------------------------------------------------
+    std::function<void()> m_pushNotifier;
+    //----------------------------------------------------------------------------------------------------------------------
+};
+
+#endif // SCENEEDITQUEUE_H
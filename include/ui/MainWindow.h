@@ -21,6 +21,12 @@ public:
     //----------------------------------------------------------------------------------------------------------------------
     ~MainWindow();
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief checkpoints our render every so many seconds, resuming from our checkpoint if it already exists
+    /// @param _path - file our checkpoints are written to (QString)
+    /// @param _seconds - seconds between checkpoints (int)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setCheckpoint(QString _path, int _seconds);
+    //----------------------------------------------------------------------------------------------------------------------
 
 public slots:
     //----------------------------------------------------------------------------------------------------------------------
@@ -40,6 +46,19 @@ public slots:
     //----------------------------------------------------------------------------------------------------------------------
     void importMesh();
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief export performance metrics slot
+    //----------------------------------------------------------------------------------------------------------------------
+    void exportMetrics();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief slot to enable or disable counting rays in our path tracer
+    /// @param _count - if we wish to count rays (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setRayCounting(bool _count);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief slot to ask how often and where our render should be saved while it renders
+    //----------------------------------------------------------------------------------------------------------------------
+    void setAutoSave();
+    //----------------------------------------------------------------------------------------------------------------------
 
 
 private:
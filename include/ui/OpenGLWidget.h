@@ -17,13 +17,19 @@
 #include <QTime>
 #include <QGridLayout>
 #include <QLineEdit>
+#include <QRubberBand>
+#include <chrono>
 
 #define GLM_FORCE_RADIANS
 #include "gl/Camera.h"
 #include "gl/ShaderProgram.h"
 #include "gl/Shader.h"
 #include "gl/Text.h"
+#include "gl/FrameGraph.h"
+#include "gl/TextureStreamer.h"
 #include "renderer/AbstractOptixRenderer.h"
+#include "renderer/RenderThread.h"
+#include "perf/CostMap.h"
 
 
 
@@ -62,10 +68,6 @@ public:
     //----------------------------------------------------------------------------------------------------------------------
     void mouseMoveEvent(QMouseEvent *_event);
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief a timer event function from the Q_object
-    //----------------------------------------------------------------------------------------------------------------------
-    void timerEvent(QTimerEvent *);//
-    //----------------------------------------------------------------------------------------------------------------------
     /// @brief A function called when a mouse button is pressed
     //----------------------------------------------------------------------------------------------------------------------
     void mousePressEvent(QMouseEvent *_event);
@@ -86,13 +88,25 @@ public:
     //----------------------------------------------------------------------------------------------------------------------
     void keyReleaseEvent(QKeyEvent *_event);
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief called when our widget is shown, including when our window is restored from being minimised
+    //----------------------------------------------------------------------------------------------------------------------
+    void showEvent(QShowEvent *_event);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief called when our widget is hidden, including when our window is minimised
+    //----------------------------------------------------------------------------------------------------------------------
+    void hideEvent(QHideEvent *_event);
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief Returns a string containing the environment map
     //----------------------------------------------------------------------------------------------------------------------
     inline QString getEnvironmentMap(){return m_environmentMap;}
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief stops our render thread. Must be called before our renderer is destroyed.
+    //----------------------------------------------------------------------------------------------------------------------
+    void stopRendering();
+    //----------------------------------------------------------------------------------------------------------------------
 public slots:
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief saves render to image file
+    /// @brief saves render to an 8 bit or float image file, written in the background while we keep rendering
     //----------------------------------------------------------------------------------------------------------------------
     void saveImage();
     //----------------------------------------------------------------------------------------------------------------------
@@ -102,7 +116,25 @@ public slots:
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief a mutator for our timeout duration
     //----------------------------------------------------------------------------------------------------------------------
-    inline void setTimeOutDur(int _timeout){m_timedOut = _timeout;}
+    void setTimeOutDur(int _timeout);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a mutator for the number of frames to accumulate before we stop rendering
+    /// @param _maxFrames - max number of frames, 0 for no limit
+    //----------------------------------------------------------------------------------------------------------------------
+    void setMaxFrames(int _maxFrames);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief saves our render in the background every so many samples per pixel while we carry on rendering
+    /// @param _samples - samples per pixel between saves, 0 to stop saving
+    /// @param _path - our files are written to this path followed by their samples per pixel
+    /// @param _format - format to save in
+    //----------------------------------------------------------------------------------------------------------------------
+    void setAutoSave(int _samples, QString _path, ImageExporter::Format _format);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief checkpoints our render every so many seconds, resuming from our checkpoint if it already exists
+    /// @param _path - file our checkpoints are written to
+    /// @param _seconds - seconds between checkpoints, 0 to stop checkpointing
+    //----------------------------------------------------------------------------------------------------------------------
+    void setCheckpoint(QString _path, int _seconds);
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief slot to set the max depth we wish rays to travers while moving our scene camera
     /// @param _depth - desired ray depth
@@ -124,7 +156,45 @@ public slots:
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief toggles rendering of the scene
     //----------------------------------------------------------------------------------------------------------------------
-    inline bool toggleRender(){m_render = !m_render; return m_render;}
+    inline bool toggleRender(){setRender(!m_render); return m_render;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief cycles our view through our image and a heat map of each counter of the cost of rendering it
+    //----------------------------------------------------------------------------------------------------------------------
+    void cycleCostView();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief cycles the format our frames are resolved into for display through RGBA8, RGBA16F and RGBA32F
+    //----------------------------------------------------------------------------------------------------------------------
+    void cycleDisplayFormat();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sets the exposure our frames are displayed with
+    /// @param _stops - exposure in stops (float)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setExposure(float _stops);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief toggles tonemapping of the frames we display
+    //----------------------------------------------------------------------------------------------------------------------
+    void toggleTonemap();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief toggles picking our tonemap from the luminance of the frames we display
+    //----------------------------------------------------------------------------------------------------------------------
+    void toggleAutoExposure();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief cycles the filter our image is reconstructed with through box, tent, Gaussian and Blackman-Harris
+    //----------------------------------------------------------------------------------------------------------------------
+    void cycleFilter();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief toggles clamping fireflies to a few standard deviations above the mean of their pixel
+    //----------------------------------------------------------------------------------------------------------------------
+    void toggleFireflyClamp();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief restricts our render to a rectangle of our widget, the rest of our image keeps what it last had
+    /// @param _rect - our rectangle in widget coordinates, empty to render our whole image again (QRect)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setRenderRegion(QRect _rect);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief moves our rubber band back over our render region when we are resized
+    //----------------------------------------------------------------------------------------------------------------------
+    void updateRubberBand();
     //----------------------------------------------------------------------------------------------------------------------
 
 private:
@@ -137,10 +207,36 @@ private:
     //----------------------------------------------------------------------------------------------------------------------
     AbstractOptixRenderer *m_renderer;
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the thread our renderer is launched from
+    //----------------------------------------------------------------------------------------------------------------------
+    RenderThread *m_renderThread;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief pauses or resumes rendering
+    /// @param _render - if we wish to render (bool)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setRender(bool _render);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief queues a change of resolution of our renderer
+    /// @param _width - resolution width
+    /// @param _height - resolution height
+    //----------------------------------------------------------------------------------------------------------------------
+    void queueResize(int _width, int _height);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief queues a new global transform for our renderer
+    /// @param _trans - transform matrix (float*)
+    /// @param _invTrans - inverse transform (float*)
+    //----------------------------------------------------------------------------------------------------------------------
+    void queueGlobalTransform(float *_trans, float *_invTrans);
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief timer for the FPS count
     //----------------------------------------------------------------------------------------------------------------------
     QTime m_FPSTimer;
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief time the input we are handling was received, zero when we are not handling input. Edits queued while
+    /// @brief handling input are tracked so we can measure how long they take to reach the screen.
+    //----------------------------------------------------------------------------------------------------------------------
+    std::chrono::steady_clock::time_point m_inputTime;
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief a bool to define if we want to draw the HUD
     //----------------------------------------------------------------------------------------------------------------------
     bool m_drawHud;
@@ -149,6 +245,18 @@ private:
     //----------------------------------------------------------------------------------------------------------------------
     Text *m_textDrawer;
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief rolling graph of our frame times drawn under our HUD
+    //----------------------------------------------------------------------------------------------------------------------
+    FrameGraph *m_frameGraph;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief time we last displayed a new frame, for our frame graph
+    //----------------------------------------------------------------------------------------------------------------------
+    std::chrono::steady_clock::time_point m_lastFrameTime;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief time our last paintGL took including uploading and presenting our frame, shown on our HUD
+    //----------------------------------------------------------------------------------------------------------------------
+    double m_displayMs;
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief the max depth we wish rays to travers while moving our scene camera
     //----------------------------------------------------------------------------------------------------------------------
     int m_cameraMovRayDepth;
@@ -165,9 +273,9 @@ private:
     //----------------------------------------------------------------------------------------------------------------------
     GLuint m_VBO[2];
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief handle to the texture we will project onto our plane
+    /// @brief streams our frames into the texture we will project onto our plane
     //----------------------------------------------------------------------------------------------------------------------
-    GLuint m_texID;
+    TextureStreamer *m_textureStreamer;
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief Shader Program
     //----------------------------------------------------------------------------------------------------------------------
@@ -182,6 +290,35 @@ private:
     //----------------------------------------------------------------------------------------------------------------------
     GLuint m_modelViewProjectionLoc;
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief locations of the uniforms selecting and scaling the heat map of our cost view
+    //----------------------------------------------------------------------------------------------------------------------
+    GLuint m_heatMapCounterLoc;
+    GLuint m_heatMapMaxLoc;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the counter of our cost view we are drawing plus one, 0 to draw our image
+    //----------------------------------------------------------------------------------------------------------------------
+    int m_heatMapCounter;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the largest value of each counter in the cost frame we are displaying, the top of our heat map
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_costMax[CostMap::NumCounters];
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the format we have asked our frames to be resolved into, our exposure in stops, if we tonemap
+    /// @brief and if our tonemap is picked by our auto exposure
+    //----------------------------------------------------------------------------------------------------------------------
+    DisplayFrame::Format m_displayFormat;
+    float m_exposure;
+    bool m_tonemap;
+    bool m_autoExposure;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the filter we have asked our image to be reconstructed with
+    //----------------------------------------------------------------------------------------------------------------------
+    Film::Filter m_filter;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief if we have asked for fireflies to be clamped
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_fireflyClamp;
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief Height of the window
     //----------------------------------------------------------------------------------------------------------------------
     int m_height;
@@ -253,15 +390,40 @@ private:
     //----------------------------------------------------------------------------------------------------------------------
     int m_timedOut;
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief used for calculating the timeout
+    /// @brief number of frames to accumulate before we stop rendering, 0 for no limit
+    //----------------------------------------------------------------------------------------------------------------------
+    int m_maxFrames;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief samples per pixel between auto saves, 0 to not save, along with where and how they are saved
     //----------------------------------------------------------------------------------------------------------------------
-    QTime m_timeOutStart;
+    int m_autoSaveSamples;
+    QString m_autoSavePath;
+    ImageExporter::Format m_autoSaveFormat;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief where and how often our render is checkpointed, and if we are still to resume from our checkpoint
+    //----------------------------------------------------------------------------------------------------------------------
+    QString m_checkpointPath;
+    int m_checkpointInterval;
+    bool m_resumeCheckpoint;
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief The environment map location
     //----------------------------------------------------------------------------------------------------------------------
     QString m_environmentMap;
     //----------------------------------------------------------------------------------------------------------------------
     bool m_translateEnvironment;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the rubber band shift dragging our left mouse selects a render region with, left up to mark our region
+    //----------------------------------------------------------------------------------------------------------------------
+    QRubberBand *m_rubberBand;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief if we are selecting a render region and the corner we started it from
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_selectingRegion;
+    QPoint m_regionOrigin;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief our render region as fractions of our widget, null when we render our whole image
+    //----------------------------------------------------------------------------------------------------------------------
+    QRectF m_renderRegion;
 
 };
 
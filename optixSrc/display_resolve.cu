@@ -0,0 +1,65 @@
+#include <optix_world.h>
+#include "common/helpers.h"
+
+using namespace optix;
+
+//----------------------------------------------------------------------------------------------------------------------
+// Resolves our float accumulation buffer into the image we display. Our output buffer stays the accumulation target,
+// this only reads it. Exposure is applied first, then our tonemap and finally the sRGB transfer function so that the
+// result can be stored in 8 or 16 bits per channel and displayed without any more work.
+//----------------------------------------------------------------------------------------------------------------------
+
+rtDeclareVariable(uint2,         launch_index, rtLaunchIndex, );
+
+rtDeclareVariable(float,         exposure, , );
+rtDeclareVariable(unsigned int,  tonemap_enabled, , );
+rtDeclareVariable(float,         tonemap_log_av, , );
+rtDeclareVariable(float,         tonemap_white, , );
+
+rtBuffer<float4, 2>              output_buffer;
+rtBuffer<uchar4, 2>              display_buffer_rgba8;
+rtBuffer<ushort4, 2>             display_buffer_rgba16f;
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief maps a pixel of our accumulation buffer to a display value in [0,1]
+//----------------------------------------------------------------------------------------------------------------------
+static __device__ __inline__ float3 resolvePixel()
+{
+    float3 c = fmaxf(make_float3(output_buffer[launch_index]) * exposure, make_float3(0.f));
+    // Black pixels have no chromaticity so would come out of our tonemap as NaNs
+    if(tonemap_enabled)
+        c = (c.x + c.y + c.z > 0.f) ? tonemap(c, tonemap_log_av, tonemap_white) : make_float3(0.f);
+    return linear2srgb(c);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief converts a float in [0,1] to a half. Small values are flushed to zero as they are below what we can display.
+//----------------------------------------------------------------------------------------------------------------------
+static __device__ __inline__ unsigned short float2half(float f)
+{
+    unsigned int bits = __float_as_uint(f);
+    unsigned int sign = (bits >> 16) & 0x8000u;
+    int exponent = (int)((bits >> 23) & 0xffu) - 127 + 15;
+    // Round to nearest, a carry out of our mantissa bumps our exponent
+    unsigned int mantissa = (bits & 0x7fffffu) + 0x1000u;
+    if(mantissa & 0x800000u)
+    {
+        mantissa = 0;
+        exponent++;
+    }
+    if(exponent <= 0) return sign;
+    if(exponent >= 31) return sign | 0x7c00u;
+    return sign | (exponent << 10) | (mantissa >> 13);
+}
+
+RT_PROGRAM void resolve_rgba8()
+{
+    float3 c = resolvePixel() * 255.f + 0.5f;
+    display_buffer_rgba8[launch_index] = make_uchar4((unsigned char)c.x, (unsigned char)c.y, (unsigned char)c.z, 255u);
+}
+
+RT_PROGRAM void resolve_rgba16f()
+{
+    float3 c = resolvePixel();
+    display_buffer_rgba16f[launch_index] = make_ushort4(float2half(c.x), float2half(c.y), float2half(c.z), float2half(1.f));
+}
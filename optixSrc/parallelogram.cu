@@ -20,6 +20,8 @@
  */
 
 #include <optix_world.h>
+#include "common/intersect.h"
+#include "common/cost.h"
 
 using namespace optix;
 
@@ -37,23 +39,14 @@ rtDeclareVariable(optix::Ray, ray, rtCurrentRay, );
 
 RT_PROGRAM void intersect(int primIdx)
 {
-    float3 n = make_float3( plane );
-    float dt = dot(ray.direction, n );
-    float t = (plane.w - dot(n, ray.origin))/dt;
-    if( t > ray.tmin && t < ray.tmax ) {
-        float3 p = ray.origin + ray.direction * t;
-        float3 vi = p - anchor;
-        float a1 = dot(v1, vi);
-        if(a1 >= 0 && a1 <= 1){
-            float a2 = dot(v2, vi);
-            if(a2 >= 0 && a2 <= 1){
-                if( rtPotentialIntersection( t ) ) {
-                    shading_normal = geometric_normal = n;
-                    texcoord = make_float3(a1,a2,0);
-                    lgt_idx = lgt_instance;
-                    rtReportIntersection( 0 );
-                }
-            }
+    countPrimitiveTest();
+    float t, a1, a2;
+    if( intersectParallelogram( ray.origin, ray.direction, ray.tmin, ray.tmax, plane, anchor, v1, v2, t, a1, a2 ) ) {
+        if( rtPotentialIntersection( t ) ) {
+            shading_normal = geometric_normal = make_float3( plane );
+            texcoord = make_float3(a1,a2,0);
+            lgt_idx = lgt_instance;
+            rtReportIntersection( 0 );
         }
     }
 }
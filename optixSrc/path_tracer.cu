@@ -29,6 +29,10 @@
 #include <optixu/optixu_math_namespace.h>
 #include "lights/ParallelogramLight.h"
 #include "common/random.h"
+#include "common/cost.h"
+#include "common/path_stats.h"
+#include "common/film_filter.h"
+#include "common/accumulate.h"
 #include <stdio.h>
 
 using namespace optix;
@@ -40,10 +44,12 @@ struct PerRayData_pathtrace
     float3 attenuation;
     float3 origin;
     float3 direction;
-    unsigned int seed;
+    RandomStream rng;
     int depth;
     int countEmitted;
     int done;
+    int emitterHit;
+    unsigned int shadowRays;
 };
 
 struct PerRayData_pathtrace_shadow
@@ -72,36 +78,106 @@ rtDeclareVariable(float3,        V, , );
 rtDeclareVariable(float3,        W, , );
 rtDeclareVariable(float3,        bad_color, , );
 rtDeclareVariable(unsigned int,  frame_number, , );
+rtDeclareVariable(unsigned int,  sample_seed, , );
 rtDeclareVariable(unsigned int,  sqrt_num_samples, , );
 rtDeclareVariable(unsigned int,  rr_begin_depth, , );
+rtDeclareVariable(unsigned int,  maxDepth, , );
 rtDeclareVariable(unsigned int,  pathtrace_ray_type, , );
 rtDeclareVariable(unsigned int,  pathtrace_shadow_ray_type, , );
 
 rtBuffer<float4, 2>              output_buffer;
+// Mean of the square of each launch's estimate of a pixel, accumulated alongside our output so that our variance is
+// variance_buffer - output_buffer^2. Kept for checkpoints and anything that wants to know how noisy a pixel is.
+rtBuffer<float4, 2>              variance_buffer;
+// What our output and variance are short by from float32 rounding, see common/accumulate.h. Only used when
+// compensate_accumulation is set, RGB for our output and RGB for our variance.
+rtBuffer<float4, 2>              compensation_buffer;
+rtBuffer<float4, 2>              variance_compensation_buffer;
+rtDeclareVariable(unsigned int,  compensate_accumulation, , );
+// Standard deviations above its mean a launch's estimate of a pixel is clamped to, 0 to never clamp
+rtDeclareVariable(float,         firefly_sigmas, , );
 rtBuffer<ParallelogramLight>     lights;
 
+// Inverse CDF of one axis of our reconstruction filter, offsets in pixels from our pixel centre for u = 0 to 1.
+// See common/film_filter.h, a box filter leaves our samples spread evenly over our pixel.
+rtBuffer<float>                  filter_table;
+
+// Per launch ray counts, [0] camera rays, [1] bounce rays, [2] shadow rays.
+// Only written when count_rays is set so that the atomics cost nothing when we're not profiling.
+rtDeclareVariable(unsigned int,  count_rays, , );
+rtBuffer<unsigned int>           ray_counters;
+
+// Per launch path statistics, also only written when count_rays is set. See common/path_stats.h for their layout.
+// path_throughput holds the max component of the throughput of our paths as they end, summed for each reason.
+rtBuffer<unsigned int>           path_stats;
+rtBuffer<float>                  path_throughput;
+
+// Per pixel cost of our paths averaged per sample and over our accumulated frames, only written when debug_cost is set.
+// x primitives tested, y thousands of clock cycles spent in our launch, z path segments, w shadow rays.
+// OptiX doesn't tell us how many BVH nodes it visits so our clock is the closest measure of traversal we have.
+rtBuffer<float4, 2>              cost_buffer;
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief records the length of a path, why it ended and its throughput when it did
+//----------------------------------------------------------------------------------------------------------------------
+static __device__ __inline__ void recordPath(unsigned int segments, unsigned int termination, float3 throughput)
+{
+    atomicAdd(&path_stats[min(segments, (unsigned int)PATH_STATS_LENGTH_BINS) - 1], 1u);
+    atomicAdd(&path_stats[PATH_STATS_LENGTH_BINS + termination], 1u);
+    atomicAdd(&path_throughput[termination], fmaxf(throughput));
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief warps a position across our pixel through our filter table into an offset from our pixel centre
+//----------------------------------------------------------------------------------------------------------------------
+static __device__ __inline__ float sample_filter(float u)
+{
+    float f = u * FILM_FILTER_TABLE_SIZE;
+    int i = min((int)f, FILM_FILTER_TABLE_SIZE - 1);
+    return lerp(filter_table[i], filter_table[i + 1], f - i);
+}
 
 RT_PROGRAM void pathtrace_camera()
 {
     size_t2 screen = output_buffer.size();
+    // Our pixel in our whole image, our launch may only cover a region of it
+    uint2 pixel_coord = launch_index + region_offset;
 
     float2 inv_screen = 1.0f/make_float2(screen) * 2.f;
-    float2 pixel = (make_float2(launch_index)) * inv_screen - 1.f;
+    float2 pixel = (make_float2(pixel_coord)) * inv_screen - 1.f;
 
-    float2 jitter_scale = inv_screen / sqrt_num_samples;
     unsigned int samples_per_pixel = sqrt_num_samples*sqrt_num_samples;
     float3 result = make_float3(0.0f);
 
-    unsigned int seed = tea<16>(screen.x*launch_index.y+launch_index.x, frame_number);
+    // Each sample draws from a stream of its own keyed by its index over our whole render, so our image doesn't
+    // depend on how our launch is scheduled
+    unsigned int pixel_index = screen.x*pixel_coord.y+pixel_coord.x;
+    unsigned int first_sample = frame_number*samples_per_pixel;
+    unsigned int num_camera_rays = 0;
+    unsigned int num_bounce_rays = 0;
+    unsigned int num_shadow_rays = 0;
+    long long start_clock = 0;
+    if (debug_cost)
+    {
+        prim_tests[pixel_coord] = 0u;
+        start_clock = clock64();
+    }
     do 
     {
         //
-        // Sample pixel using jittering
+        // Sample pixel using jittering, warped by our filter so our image is reconstructed with it
         //
-        unsigned int x = samples_per_pixel%sqrt_num_samples;
-        unsigned int y = samples_per_pixel/sqrt_num_samples;
-        float2 jitter = make_float2(x-rnd(seed), y-rnd(seed));
-        float2 d = pixel + jitter*jitter_scale;
+        unsigned int stratum = samples_per_pixel-1;
+        unsigned int x = stratum%sqrt_num_samples;
+        unsigned int y = stratum/sqrt_num_samples;
+        RandomStream rng = sample_stream(pixel_index, first_sample+stratum, sample_seed);
+        float jx = rnd(rng);
+        float jy = rnd(rng);
+        float2 u = make_float2(x+jx, y+jy) / (float)sqrt_num_samples;
+        float2 offset = make_float2(sample_filter(u.x), sample_filter(u.y));
+        float2 d = pixel + (offset+0.5f)*inv_screen;
         float3 ray_origin = eye;
         float3 ray_direction = normalize(d.x*U + d.y*V + W);
 
@@ -111,8 +187,11 @@ RT_PROGRAM void pathtrace_camera()
         prd.attenuation = make_float3(1.f);
         prd.countEmitted = true;
         prd.done = false;
-        prd.seed = seed;
+        prd.emitterHit = false;
+        prd.rng = rng;
         prd.depth = 0;
+        prd.shadowRays = 0;
+        unsigned int segments = 0;
 
         // Each iteration is a segment of the ray path.  The closest hit will
         // return new segments to be traced here.
@@ -120,10 +199,14 @@ RT_PROGRAM void pathtrace_camera()
         {
             Ray ray = make_Ray(ray_origin, ray_direction, pathtrace_ray_type, scene_epsilon, RT_DEFAULT_MAX);
             rtTrace(top_object, ray, prd);
+            if(prd.depth == 0) num_camera_rays++;
+            else num_bounce_rays++;
+            segments++;
 
             if(prd.done)
             {
                 // We have hit the background or a luminaire
+                if(count_rays) recordPath(segments, prd.emitterHit ? PATH_STATS_EMITTER : PATH_STATS_MISS, prd.attenuation);
                 prd.result += prd.radiance * prd.attenuation;
                 break;
             }
@@ -132,21 +215,31 @@ RT_PROGRAM void pathtrace_camera()
             if(prd.depth >= rr_begin_depth)
             {
                 float pcont = fmaxf(prd.attenuation);
-                if(rnd(prd.seed) >= pcont)
+                if(rnd(prd.rng) >= pcont)
+                {
+                    if(count_rays) recordPath(segments, PATH_STATS_RUSSIAN_ROULETTE, prd.attenuation);
                     break;
+                }
                 prd.attenuation /= pcont;
             }
 
             prd.depth++;
             prd.result += prd.radiance * prd.attenuation;
 
+            // Hard limit on our path length, direct lighting of our last hit has already been added
+            if(prd.depth >= maxDepth)
+            {
+                if(count_rays) recordPath(segments, PATH_STATS_MAX_DEPTH, prd.attenuation);
+                break;
+            }
+
             // Update ray data for the next path segment
             ray_origin = prd.origin;
             ray_direction = prd.direction;
         }
 
         result += prd.result;
-        seed = prd.seed;
+        num_shadow_rays += prd.shadowRays;
     } while (--samples_per_pixel);
 
     //
@@ -154,15 +247,50 @@ RT_PROGRAM void pathtrace_camera()
     //
     float3 pixel_color = result/(sqrt_num_samples*sqrt_num_samples);
 
+    if (count_rays)
+    {
+        atomicAdd(&ray_counters[0], num_camera_rays);
+        atomicAdd(&ray_counters[1], num_bounce_rays);
+        atomicAdd(&ray_counters[2], num_shadow_rays);
+    }
+
+    if (debug_cost)
+    {
+        float spp = (float)(sqrt_num_samples*sqrt_num_samples);
+        float4 cost = make_float4( (float)prim_tests[pixel_coord],
+                                   (float)(clock64() - start_clock) * 0.001f,
+                                   (float)(num_camera_rays + num_bounce_rays),
+                                   (float)num_shadow_rays ) / spp;
+        if (frame_number > 1)
+            cost_buffer[pixel_coord] = lerp( cost_buffer[pixel_coord], cost, 1.0f / (float)frame_number );
+        else
+            cost_buffer[pixel_coord] = cost;
+    }
+
+    float3 color = make_float3(0.0f);
+    float3 moment = make_float3(0.0f);
+    float3 color_compensation = make_float3(0.0f);
+    float3 moment_compensation = make_float3(0.0f);
     if (frame_number > 1)
     {
-        float a = 1.0f / (float)frame_number;
-        float3 old_color = make_float3(output_buffer[launch_index]);
-        output_buffer[launch_index] = make_float4( lerp( old_color, pixel_color, a ), 1.0f );
+        color = make_float3(output_buffer[pixel_coord]);
+        moment = make_float3(variance_buffer[pixel_coord]);
+        if (compensate_accumulation)
+        {
+            color_compensation = make_float3(compensation_buffer[pixel_coord]);
+            moment_compensation = make_float3(variance_compensation_buffer[pixel_coord]);
+        }
+        // Our moment takes our clamped estimate too so that one firefly can't loosen our clamp for the next
+        pixel_color = clamp_firefly(pixel_color, color, moment, frame_number - 1, firefly_sigmas);
     }
-    else
+    accumulate_mean(color, color_compensation, pixel_color, frame_number, compensate_accumulation);
+    accumulate_mean(moment, moment_compensation, pixel_color*pixel_color, frame_number, compensate_accumulation);
+    output_buffer[pixel_coord] = make_float4(color, 1.0f);
+    variance_buffer[pixel_coord] = make_float4(moment, 0.0f);
+    if (compensate_accumulation)
     {
-        output_buffer[launch_index] = make_float4(pixel_color, 1.0f);
+        compensation_buffer[pixel_coord] = make_float4(color_compensation, 0.0f);
+        variance_compensation_buffer[pixel_coord] = make_float4(moment_compensation, 0.0f);
     }
 }
 
@@ -179,6 +307,7 @@ RT_PROGRAM void diffuseEmitter()
 {
     current_prd.radiance = current_prd.countEmitted ? emission_color : make_float3(0.f);
     current_prd.done = true;
+    current_prd.emitterHit = true;
 }
 
 
@@ -211,8 +340,8 @@ RT_PROGRAM void diffuse()
     //
     current_prd.origin = hitpoint;
 
-    float z1=rnd(current_prd.seed);
-    float z2=rnd(current_prd.seed);
+    float z1=rnd(current_prd.rng);
+    float z2=rnd(current_prd.rng);
     float3 p;
     cosine_sample_hemisphere(z1, z2, p);
     optix::Onb onb( ffnormal );
@@ -234,8 +363,8 @@ RT_PROGRAM void diffuse()
     {
         // Choose random point on light
         ParallelogramLight light = lights[i];
-        const float z1 = rnd(current_prd.seed);
-        const float z2 = rnd(current_prd.seed);
+        const float z1 = rnd(current_prd.rng);
+        const float z2 = rnd(current_prd.rng);
         const float3 light_pos = light.corner + light.v1 * z1 + light.v2 * z2;
 
         // Calculate properties of light sample (for area based pdf)
@@ -252,6 +381,7 @@ RT_PROGRAM void diffuse()
             // Note: bias both ends of the shadow ray, in case the light is also present as geometry in the scene.
             Ray shadow_ray = make_Ray( hitpoint, L, pathtrace_shadow_ray_type, scene_epsilon, Ldist - scene_epsilon );
             rtTrace(top_object, shadow_ray, shadow_prd);
+            current_prd.shadowRays++;
 
             if(!shadow_prd.inShadow)
             {
@@ -296,8 +426,8 @@ RT_PROGRAM void reflection()
 //    {
 //        // Choose random point on light
 //        ParallelogramLight light = lights[i];
-//        const float z1 = rnd(current_prd.seed);
-//        const float z2 = rnd(current_prd.seed);
+//        const float z1 = rnd(current_prd.rng);
+//        const float z2 = rnd(current_prd.rng);
 //        const float3 light_pos = light.corner + light.v1 * z1 + light.v2 * z2;
 
 //        // Calculate properties of light sample (for area based pdf)
@@ -352,7 +482,7 @@ RT_PROGRAM void shadow()
 
 RT_PROGRAM void exception()
 {
-    output_buffer[launch_index] = make_float4(bad_color, 1.0f);
+    output_buffer[launch_index + region_offset] = make_float4(bad_color, 1.0f);
 }
 
 
@@ -371,3 +501,22 @@ RT_PROGRAM void miss()
 }
 
 
+//-----------------------------------------------------------------------------
+//
+//  Environment map miss program
+//
+//-----------------------------------------------------------------------------
+
+rtTextureSampler<float4, 2> envmap;
+
+RT_PROGRAM void envmap_miss()
+{
+    float theta = atan2f( ray.direction.x, ray.direction.z );
+    float phi   = M_PIf * 0.5f -  acosf( ray.direction.y );
+    float u     = (theta + M_PIf) * (0.5f * M_1_PIf);
+    float v     = 0.5f * ( 1.0f + sin(phi) );
+    current_prd.radiance = make_float3( tex2D(envmap, u, v) );
+    current_prd.done = true;
+}
+
+
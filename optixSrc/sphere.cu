@@ -1,4 +1,6 @@
 #include <optix_world.h>
+#include "common/intersect.h"
+#include "common/cost.h"
 #define M_PI       3.14159265358979323846
 
 using namespace optix;
@@ -13,16 +15,12 @@ rtDeclareVariable(int, lgt_idx, attribute lgt_idx, );
 rtDeclareVariable(optix::Ray, ray, rtCurrentRay, );
 
 RT_PROGRAM void intersect_sphere(int primIdx){
+    countPrimitiveTest();
     float3 center = make_float3( sphere.x, sphere.y, sphere.z );
     float radius = sphere.w;
     float3 O = ray.origin - center;
-    float a = dot( ray.direction, ray.direction);
-    float b = 2.0 * dot( ray.direction, O );
-    float c = dot(O , O) - (radius*radius);
-    float disc = b*b - (4 * a * c);
-    if( disc > 0.0f ) {
-        float sdisc = sqrtf( disc );
-        float root1 = (-b - sdisc) / (2 * a);
+    float root1, root2;
+    if( intersectSphere( ray.origin, ray.direction, center, radius, root1, root2 ) ) {
         bool check_second = true;
         if( rtPotentialIntersection( root1 ) ) {
             shading_normal = geometric_normal = ((O + root1*ray.direction))/radius;
@@ -35,7 +33,6 @@ RT_PROGRAM void intersect_sphere(int primIdx){
             }
         }
         if( check_second ) {
-            float root2 = (-b + sdisc) / ( 2 * a);
             if( rtPotentialIntersection( root2 ) ) {
                 shading_normal = geometric_normal =((O + root2*ray.direction))/radius;
                 float u = 0.5 + atan2(shading_normal.z, shading_normal.x) / (2*M_PI);
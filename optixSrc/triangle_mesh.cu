@@ -23,6 +23,8 @@
 #include <optixu/optixu_math_namespace.h>
 #include <optixu/optixu_matrix_namespace.h>
 #include <optixu/optixu_aabb_namespace.h>
+#include "common/intersect.h"
+#include "common/cost.h"
 
 using namespace optix;
 
@@ -46,6 +48,8 @@ rtDeclareVariable(optix::Ray, ray, rtCurrentRay, );
 
 RT_PROGRAM void mesh_intersect( int primIdx )
 {
+  countPrimitiveTest();
+
   int3 v_idx;
   v_idx.x = primIdx*3;
   v_idx.y = v_idx.x+1;
@@ -58,7 +62,7 @@ RT_PROGRAM void mesh_intersect( int primIdx )
   // Intersect ray with triangle
   float3 n;
   float  t, beta, gamma;
-  if( intersect_triangle( ray, p0, p1, p2, n, t, beta, gamma ) )
+  if( intersectTriangle( ray.origin, ray.direction, ray.tmin, ray.tmax, p0, p1, p2, n, t, beta, gamma ) )
   {
 
     if(  rtPotentialIntersection( t ) )
@@ -0,0 +1,12 @@
+#version 400
+in vec2 inVert;
+in vec3 inColour;
+out vec3 vertColour;
+uniform float scaleX;
+uniform float scaleY;
+void main()
+{
+    vertColour=inColour;
+    // Our vertices are in pixels with 0,0 at the top left of our screen
+    gl_Position=vec4((inVert.x*scaleX)-1.0,(inVert.y*scaleY)+1.0,0.0,1.0);
+}
@@ -6,7 +6,8 @@ uniform vec3 textColour;
 
 void main()
 {
-    vec4 text=texture(tex,vertUV.st-vec2(0,0.1)); // -0.1 in y is a quick hack to get rid of lines that appear above letters on windows
+    // our glyphs are padded in our atlas so we can sample them directly without picking up their neighbours
+    vec4 text=texture(tex,vertUV.st);
     fragColour.rgb=textColour.rgb;
     fragColour.a=text.a;
 }
@@ -1,12 +1,35 @@
 #version 400
 
 uniform sampler2D pathTraceTex;
+// 0 to draw our image, otherwise the counter of our cost view to draw as a heat map plus one
+uniform int heatMapCounter;
+// value of our counter drawn at the top of our heat map
+uniform float heatMapMax;
 in vec2 VTexCoord;
 
 out vec4 FragColor;
 
+// Polynomial fit of Google's Turbo colour map, keep in sync with CostMap::heatMapColour
+vec3 heatMapColour(float x)
+{
+    x = clamp(x, 0.0, 1.0);
+    vec4 v4 = vec4(1.0, x, x*x, x*x*x);
+    vec2 v2 = v4.zw * v4.z;
+    return clamp(vec3(dot(v4, vec4(0.13572138, 4.61539260, -42.66032258, 132.13108234)) + dot(v2, vec2(-152.94239396, 59.28637943)),
+                      dot(v4, vec4(0.09140261, 2.19418839, 4.84296658, -14.18503333)) + dot(v2, vec2(4.27729857, 2.82956604)),
+                      dot(v4, vec4(0.10667330, 12.64194608, -60.58204836, 110.36276771)) + dot(v2, vec2(-89.90310912, 27.34824973))),
+                 0.0, 1.0);
+}
+
 void main(void)
 {
     vec4 colour = texture(pathTraceTex, VTexCoord);
+    if(heatMapCounter > 0)
+    {
+        // Log scaled so a few expensive pixels don't wash out the rest of our image
+        float value = colour[heatMapCounter-1];
+        float t = (heatMapMax > 0.0) ? log(1.0 + value)/log(1.0 + heatMapMax) : 0.0;
+        colour = vec4(heatMapColour(t), 1.0);
+    }
     FragColor = colour;
 }
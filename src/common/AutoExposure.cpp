@@ -0,0 +1,272 @@
+#include "common/AutoExposure.h"
+#include "common/ParallelFor.h"
+#include "common/helpers.h"
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief added to our luminance before taking its log so black pixels don't send our average to zero
+//----------------------------------------------------------------------------------------------------------------------
+static const float g_logDelta = 1e-4f;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the key of the tonemap in common/helpers.h
+//----------------------------------------------------------------------------------------------------------------------
+static const float g_tonemapKey = 0.04f;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief fraction of our pixels darker than our white point
+//----------------------------------------------------------------------------------------------------------------------
+static const double g_whitePercentile = 0.999;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief number of pixels worth giving a thread
+//----------------------------------------------------------------------------------------------------------------------
+static const unsigned int g_grain = 1<<16;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief log2 of four positive floats. Splits off our exponent and uses the series of ln((1+t)/(1-t)) for our
+/// @brief mantissa, t is at most 1/3 so four terms are accurate to a few millionths.
+//----------------------------------------------------------------------------------------------------------------------
+static inline __m128 log2x4(__m128 _x)
+{
+    __m128i bits = _mm_castps_si128(_x);
+    __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits,23),_mm_set1_epi32(127)));
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits,_mm_set1_epi32(0x7fffff)),_mm_set1_epi32(0x3f800000)));
+    __m128 one = _mm_set1_ps(1.f);
+    __m128 t = _mm_div_ps(_mm_sub_ps(m,one),_mm_add_ps(m,one));
+    __m128 t2 = _mm_mul_ps(t,t);
+    __m128 series = _mm_add_ps(_mm_set1_ps(1.f/5.f),_mm_mul_ps(t2,_mm_set1_ps(1.f/7.f)));
+    series = _mm_add_ps(_mm_set1_ps(1.f/3.f),_mm_mul_ps(t2,series));
+    series = _mm_add_ps(one,_mm_mul_ps(t2,series));
+    // 2/ln(2)
+    __m128 ln = _mm_mul_ps(_mm_mul_ps(t,series),_mm_set1_ps(2.885390082f));
+    return _mm_add_ps(exponent,ln);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief luminance of a pixel, matching rgb2Yxy in common/helpers.h
+//----------------------------------------------------------------------------------------------------------------------
+static inline float luminance(const float *_rgba)
+{
+    return std::max(0.2126f*_rgba[0] + 0.7152f*_rgba[1] + 0.0722f*_rgba[2],0.f);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief bin of our histogram a log2 luminance falls in
+//----------------------------------------------------------------------------------------------------------------------
+static inline int histogramBin(float _log2Y)
+{
+    int bin = (int)((_log2Y-AutoExposure::MinLog2)*(AutoExposure::NumBins/float(AutoExposure::MaxLog2-AutoExposure::MinLog2)));
+    return std::min(std::max(bin,0),AutoExposure::NumBins-1);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief partial result of one chunk of our measurement
+//----------------------------------------------------------------------------------------------------------------------
+struct PartialStats
+{
+    double m_sumLog2;
+    float m_max;
+    unsigned int m_histogram[AutoExposure::NumBins];
+};
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief combines our partial results
+//----------------------------------------------------------------------------------------------------------------------
+static AutoExposure::LuminanceStats combine(const std::vector<PartialStats> &_partials, unsigned int _numPixels)
+{
+    AutoExposure::LuminanceStats stats;
+    memset(&stats,0,sizeof(stats));
+    stats.m_numPixels = _numPixels;
+    double sumLog2 = 0.0;
+    for(unsigned int c=0;c<_partials.size();c++)
+    {
+        sumLog2 += _partials[c].m_sumLog2;
+        stats.m_max = std::max(stats.m_max,_partials[c].m_max);
+        for(int b=0;b<AutoExposure::NumBins;b++) stats.m_histogram[b] += _partials[c].m_histogram[b];
+    }
+    stats.m_logAverage = (_numPixels) ? (float)std::exp2(sumLog2/_numPixels) : 0.f;
+    return stats;
+}
+//----------------------------------------------------------------------------------------------------------------------
+AutoExposure::AutoExposure() : m_log2Key(0.f),
+                               m_log2White(0.f),
+                               m_valid(false),
+                               m_lowPercentile(0.5f),
+                               m_highPercentile(0.95f),
+                               m_rate(3.f)
+{
+}
+//----------------------------------------------------------------------------------------------------------------------
+AutoExposure::LuminanceStats AutoExposure::measure(const float *_rgba, unsigned int _numPixels)
+{
+    std::vector<PartialStats> partials(parallelForChunks(_numPixels,g_grain));
+    memset(&partials[0],0,partials.size()*sizeof(PartialStats));
+    parallelFor(_numPixels,g_grain,[&](unsigned int _begin, unsigned int _end, unsigned int _chunk)
+    {
+        PartialStats &partial = partials[_chunk];
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 delta = _mm_set1_ps(g_logDelta);
+        const __m128 black = _mm_set1_ps(std::exp2((float)MinLog2));
+        const __m128 binScale = _mm_set1_ps(NumBins/float(MaxLog2-MinLog2));
+        __m128 maxY = zero;
+        unsigned int i = _begin;
+        // Four pixels at a time, our float sums are flushed to our double every so often so they don't lose precision
+        while(i+4<=_end)
+        {
+            __m128 sumLog2 = zero;
+            unsigned int blockEnd = std::min(i+4096,_end);
+            for(;i+4<=blockEnd;i+=4)
+            {
+                const float *p = _rgba+i*4;
+                __m128 r = _mm_loadu_ps(p);
+                __m128 g = _mm_loadu_ps(p+4);
+                __m128 b = _mm_loadu_ps(p+8);
+                __m128 a = _mm_loadu_ps(p+12);
+                _MM_TRANSPOSE4_PS(r,g,b,a);
+                __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r,_mm_set1_ps(0.2126f)),_mm_mul_ps(g,_mm_set1_ps(0.7152f))),
+                                      _mm_mul_ps(b,_mm_set1_ps(0.0722f)));
+                // Our NaNs become 0 as max returns its second operand if either is a NaN
+                y = _mm_max_ps(y,zero);
+                maxY = _mm_max_ps(maxY,y);
+                sumLog2 = _mm_add_ps(sumLog2,log2x4(_mm_add_ps(y,delta)));
+
+                int mask = _mm_movemask_ps(_mm_cmpge_ps(y,black));
+                if(mask)
+                {
+                    __m128 bin = _mm_mul_ps(_mm_sub_ps(log2x4(y),_mm_set1_ps((float)MinLog2)),binScale);
+                    int bins[4];
+                    _mm_storeu_si128((__m128i*)bins,_mm_cvttps_epi32(bin));
+                    for(int l=0;l<4;l++)
+                        if(mask & (1<<l)) partial.m_histogram[std::min(std::max(bins[l],0),NumBins-1)]++;
+                }
+            }
+            float sums[4];
+            _mm_storeu_ps(sums,sumLog2);
+            partial.m_sumLog2 += (double)sums[0] + sums[1] + sums[2] + sums[3];
+        }
+        float maxs[4];
+        _mm_storeu_ps(maxs,maxY);
+        partial.m_max = std::max(std::max(maxs[0],maxs[1]),std::max(maxs[2],maxs[3]));
+        // Whatever doesn't fill a group of four
+        for(;i<_end;i++)
+        {
+            float y = luminance(_rgba+i*4);
+            if(!(y==y)) y = 0.f;
+            partial.m_max = std::max(partial.m_max,y);
+            partial.m_sumLog2 += std::log2(y+g_logDelta);
+            if(y>=std::exp2((float)MinLog2)) partial.m_histogram[histogramBin(std::log2(y))]++;
+        }
+    });
+    return combine(partials,_numPixels);
+}
+//----------------------------------------------------------------------------------------------------------------------
+AutoExposure::LuminanceStats AutoExposure::measureScalar(const float *_rgba, unsigned int _numPixels)
+{
+    std::vector<PartialStats> partials(1);
+    memset(&partials[0],0,sizeof(PartialStats));
+    PartialStats &partial = partials[0];
+    for(unsigned int i=0;i<_numPixels;i++)
+    {
+        float y = luminance(_rgba+i*4);
+        if(!(y==y)) y = 0.f;
+        partial.m_max = std::max(partial.m_max,y);
+        partial.m_sumLog2 += std::log2(y+g_logDelta);
+        if(y>=std::exp2((float)MinLog2)) partial.m_histogram[histogramBin(std::log2(y))]++;
+    }
+    return combine(partials,_numPixels);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void AutoExposure::setPercentiles(float _low, float _high)
+{
+    m_lowPercentile = std::min(std::max(_low,0.f),1.f);
+    m_highPercentile = std::min(std::max(_high,m_lowPercentile),1.f);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void AutoExposure::update(const LuminanceStats &_stats, float _seconds)
+{
+    unsigned int count = 0;
+    for(int b=0;b<NumBins;b++) count += _stats.m_histogram[b];
+    // Nothing but black, keep what we have
+    if(count==0) return;
+
+    // Mean log2 luminance of the pixels between our percentiles, each bin taken at its centre
+    const float binWidth = float(MaxLog2-MinLog2)/NumBins;
+    double low = m_lowPercentile*count;
+    double high = m_highPercentile*count;
+    // Our white point is the top of the bin holding our brightest pixels bar a few fireflies
+    double white = g_whitePercentile*count;
+    double below = 0.0, sum = 0.0, weight = 0.0;
+    float log2White = (float)MaxLog2;
+    bool foundWhite = false;
+    for(int b=0;b<NumBins;b++)
+    {
+        double n = _stats.m_histogram[b];
+        double used = std::min(below+n,high) - std::max(below,low);
+        if(used>0.0)
+        {
+            sum += used*(MinLog2+(b+0.5f)*binWidth);
+            weight += used;
+        }
+        below += n;
+        if(!foundWhite && below>=white)
+        {
+            log2White = MinLog2+(b+1)*binWidth;
+            foundWhite = true;
+        }
+    }
+    float log2Key = (weight>0.0) ? (float)(sum/weight) : std::log2(std::max(_stats.m_logAverage,1e-6f));
+    // but no brighter than our brightest pixel and never less bright than our key
+    log2White = std::max(std::min(log2White,std::log2(std::max(_stats.m_max,1e-6f))),log2Key);
+
+    if(!m_valid || _seconds<=0.f)
+    {
+        m_log2Key = log2Key;
+        m_log2White = log2White;
+        m_valid = true;
+        return;
+    }
+    // Adapt in log space so brightening and darkening by a stop take as long as each other
+    float k = 1.f-std::exp(-m_rate*_seconds);
+    m_log2Key += (log2Key-m_log2Key)*k;
+    m_log2White += (log2White-m_log2White)*k;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void AutoExposure::getParams(Params &_params) const
+{
+    if(!m_valid) return;
+    // Our tonemap scales luminance by key/Y_log_av and takes its white point in those scaled units
+    _params.m_logAverage = std::exp2(m_log2Key);
+    _params.m_white = std::max(g_tonemapKey*std::exp2(m_log2White-m_log2Key),1e-3f);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void AutoExposure::resolve(const DisplayFrame &_hdr, const Params &_params, DisplayFrame &_out)
+{
+    unsigned int numPixels = _hdr.m_width*_hdr.m_height;
+    _out.m_width = _hdr.m_width;
+    _out.m_height = _hdr.m_height;
+    _out.m_frameNumber = _hdr.m_frameNumber;
+    _out.m_samples = _hdr.m_samples;
+    _out.m_editVersion = _hdr.m_editVersion;
+    _out.m_cost = false;
+    _out.m_format = DisplayFrame::RGBA8;
+    _out.m_pixels.clear();
+    _out.m_display.resize(numPixels*4);
+    if(_hdr.m_format!=DisplayFrame::RGBA32F || _hdr.m_pixels.size()<(size_t)numPixels*4) return;
+
+    const float *in = &_hdr.m_pixels[0];
+    unsigned char *out = &_out.m_display[0];
+    parallelFor(numPixels,g_grain,[&](unsigned int _begin, unsigned int _end, unsigned int)
+    {
+        for(unsigned int i=_begin;i<_end;i++)
+        {
+            optix::float3 c = optix::make_float3(std::max(in[i*4]*_params.m_exposure,0.f),
+                                                 std::max(in[i*4+1]*_params.m_exposure,0.f),
+                                                 std::max(in[i*4+2]*_params.m_exposure,0.f));
+            if(_params.m_tonemap)
+                c = (c.x+c.y+c.z>0.f) ? tonemap(c,_params.m_logAverage,_params.m_white) : optix::make_float3(0.f);
+            c = linear2srgb(c);
+            out[i*4+0] = (unsigned char)(c.x*255.f+0.5f);
+            out[i*4+1] = (unsigned char)(c.y*255.f+0.5f);
+            out[i*4+2] = (unsigned char)(c.z*255.f+0.5f);
+            out[i*4+3] = 255;
+        }
+    });
+}
+//----------------------------------------------------------------------------------------------------------------------
@@ -19,7 +19,8 @@
  * SUCH DAMAGES
  */
 
-#include "HDRLoader.h"
+#include "common/HDRLoader.h"
+#include "perf/PerfMetrics.h"
 
 #include <math.h>
 #include <fstream>
@@ -216,7 +217,8 @@ namespace {
       return ReadScanlineNoRLE(inf, RGBEline, wid); // Found an old-format scanline
     }
 
-    if(size_t(size_t(c2)<<8 | size_t(c3)) != wid) throw HDRError("Scanline width inconsistent");
+    // char may be signed, widths with the top bit of their low byte set would sign extend
+    if(size_t(size_t((unsigned char)c2)<<8 | size_t((unsigned char)c3)) != wid) throw HDRError("Scanline width inconsistent");
 
     // This scanline is RLE.
     for(unsigned int ch=0; ch<4; ch++) {
@@ -344,6 +346,7 @@ optix::TextureSampler loadHDRTexture( optix::Context context,
                                       const std::string& filename,
                                       const optix::float3& default_color)
 {
+  PerfScopedTimer timer(PerfMetrics::HDRImport);
   // Create tex sampler and populate with default values
   optix::TextureSampler sampler = context->createTextureSampler();
   sampler->setWrapMode( 0, RT_WRAP_REPEAT );
@@ -0,0 +1,583 @@
+#include "common/ImageExporter.h"
+#include "common/ParallelFor.h"
+#include "perf/ImageError.h"
+#include <QImage>
+#include <QString>
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief number of rows worth giving a thread
+//----------------------------------------------------------------------------------------------------------------------
+static const unsigned int g_rowGrain = 32;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief writes a 32 bit value little endian whatever our host
+//----------------------------------------------------------------------------------------------------------------------
+static inline void putLE32(unsigned char *_dst, unsigned int _value)
+{
+    _dst[0] = _value & 0xff;
+    _dst[1] = (_value>>8) & 0xff;
+    _dst[2] = (_value>>16) & 0xff;
+    _dst[3] = (_value>>24) & 0xff;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief appends little endian values and null terminated strings to an OpenEXR header
+//----------------------------------------------------------------------------------------------------------------------
+static void appendInt(std::vector<unsigned char> &_out, unsigned int _value)
+{
+    unsigned char bytes[4];
+    putLE32(bytes,_value);
+    _out.insert(_out.end(),bytes,bytes+4);
+}
+static void appendFloat(std::vector<unsigned char> &_out, float _value)
+{
+    unsigned int bits;
+    memcpy(&bits,&_value,4);
+    appendInt(_out,bits);
+}
+static void appendString(std::vector<unsigned char> &_out, const char *_string)
+{
+    _out.insert(_out.end(),_string,_string+strlen(_string)+1);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief appends an attribute to an OpenEXR header, its name, type, size and value
+//----------------------------------------------------------------------------------------------------------------------
+static void appendAttribute(std::vector<unsigned char> &_out, const char *_name, const char *_type,
+                            const std::vector<unsigned char> &_value)
+{
+    appendString(_out,_name);
+    appendString(_out,_type);
+    appendInt(_out,(unsigned int)_value.size());
+    _out.insert(_out.end(),_value.begin(),_value.end());
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief swaps the red and blue of four RGBA8 pixels and sets their alpha, giving the 0xffRRGGBB of QImage::Format_RGB32
+//----------------------------------------------------------------------------------------------------------------------
+static inline __m128i rgbaToARGB(__m128i _rgba)
+{
+    __m128i byteMask = _mm_set1_epi32(0xff);
+    __m128i g = _mm_and_si128(_rgba,_mm_set1_epi32(0xff00));
+    __m128i r = _mm_slli_epi32(_mm_and_si128(_rgba,byteMask),16);
+    __m128i b = _mm_and_si128(_mm_srli_epi32(_rgba,16),byteMask);
+    return _mm_or_si128(_mm_or_si128(r,g),_mm_or_si128(b,_mm_set1_epi32(0xff000000)));
+}
+static inline unsigned int rgbaToARGB(const unsigned char *_rgba)
+{
+    return 0xff000000u | ((unsigned int)_rgba[0]<<16) | ((unsigned int)_rgba[1]<<8) | _rgba[2];
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief scalar versions of our conversions for the pixels left over at the end of our rows
+//----------------------------------------------------------------------------------------------------------------------
+static inline void floatToRGBE(const float *_rgba, unsigned char *_rgbe)
+{
+    float r = (_rgba[0]>0.f) ? std::min(_rgba[0],1.7e38f) : 0.f;
+    float g = (_rgba[1]>0.f) ? std::min(_rgba[1],1.7e38f) : 0.f;
+    float b = (_rgba[2]>0.f) ? std::min(_rgba[2],1.7e38f) : 0.f;
+    float v = std::max(r,std::max(g,b));
+    if(v<1e-32f)
+    {
+        _rgbe[0] = _rgbe[1] = _rgbe[2] = _rgbe[3] = 0;
+        return;
+    }
+    int e;
+    float scale = std::frexp(v,&e)*256.f/v;
+    _rgbe[0] = (unsigned char)(r*scale);
+    _rgbe[1] = (unsigned char)(g*scale);
+    _rgbe[2] = (unsigned char)(b*scale);
+    _rgbe[3] = (unsigned char)(e+128);
+}
+static inline unsigned short floatToHalf(float _f)
+{
+    unsigned int bits;
+    memcpy(&bits,&_f,4);
+    unsigned int sign = (bits>>16) & 0x8000u;
+    unsigned int abs = bits & 0x7fffffffu;
+    if(abs>0x7f800000u) return sign | 0x7e00u;
+    // Below our smallest normal half we are a denormal, a multiple of 2^-24
+    if(abs<(113u<<23))
+    {
+        float a;
+        memcpy(&a,&abs,4);
+        return sign | (unsigned short)std::nearbyint(a*16777216.f);
+    }
+    // Round to nearest even, a carry out of our mantissa bumps our exponent
+    unsigned int rounded = abs + 0xfffu + ((abs>>13)&1u);
+    unsigned int h = (rounded>>13) - (112u<<10);
+    return sign | ((h>0x7bffu) ? 0x7c00u : h);
+}
+//----------------------------------------------------------------------------------------------------------------------
+ImageExporter *ImageExporter::getInstance()
+{
+    static ImageExporter instance;
+    return &instance;
+}
+//----------------------------------------------------------------------------------------------------------------------
+ImageExporter::ImageExporter() : m_numBusy(0), m_quit(false)
+{
+    for(unsigned int i=0;i<m_numThreads;i++)
+        m_threads.push_back(std::thread(&ImageExporter::run,this));
+}
+//----------------------------------------------------------------------------------------------------------------------
+ImageExporter::~ImageExporter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for(unsigned int i=0;i<m_threads.size();i++) m_threads[i].join();
+}
+//----------------------------------------------------------------------------------------------------------------------
+const char *ImageExporter::getExtension(Format _format)
+{
+    switch(_format)
+    {
+        case(JPEG): return "jpeg";
+        case(BMP): return "bmp";
+        case(GIF): return "gif";
+        case(PFM): return "pfm";
+        case(HDR): return "hdr";
+        case(EXRHalf): case(EXRFloat): return "exr";
+        default: return "png";
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+const char *ImageExporter::getFileFilter(Format _format)
+{
+    switch(_format)
+    {
+        case(JPEG): return "JPEG (*.jpeg)";
+        case(BMP): return "BMP (*.bmp)";
+        case(GIF): return "GIF (*.gif)";
+        case(PFM): return "PFM (*.pfm)";
+        case(HDR): return "Radiance HDR (*.hdr)";
+        case(EXRHalf): return "OpenEXR half (*.exr)";
+        case(EXRFloat): return "OpenEXR float (*.exr)";
+        default: return "PNG (*.png)";
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+std::string ImageExporter::getFileFilters()
+{
+    std::string filters;
+    for(int i=0;i<NumFormats;i++)
+    {
+        if(i) filters += ";;";
+        filters += getFileFilter((Format)i);
+    }
+    return filters;
+}
+//----------------------------------------------------------------------------------------------------------------------
+ImageExporter::Format ImageExporter::getFormat(const std::string &_filter)
+{
+    for(int i=0;i<NumFormats;i++)
+        if(_filter==getFileFilter((Format)i)) return (Format)i;
+    return PNG;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void ImageExporter::exportAsync(const std::string &_path, DisplayFrame &_frame, Format _format,
+                                const AutoExposure::Params &_params, bool _resolve)
+{
+    Job *job = new Job;
+    job->m_path = _path;
+    std::swap(job->m_frame,_frame);
+    job->m_format = _format;
+    job->m_params = _params;
+    job->m_resolve = _resolve;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(job);
+    }
+    m_wake.notify_one();
+}
+//----------------------------------------------------------------------------------------------------------------------
+unsigned int ImageExporter::getNumPending()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return (unsigned int)m_jobs.size() + m_numBusy;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void ImageExporter::run()
+{
+    for(;;)
+    {
+        Job *job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while(m_jobs.empty() && !m_quit) m_wake.wait(lock);
+            // Anything still queued when we are destroyed is written before we go
+            if(m_jobs.empty()) return;
+            job = m_jobs.front();
+            m_jobs.pop_front();
+            m_numBusy++;
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if(write(job->m_path,job->m_frame,job->m_format,job->m_params,job->m_resolve))
+        {
+            double ms = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+            std::cerr<<"ImageExporter: wrote "<<job->m_path<<" ("<<job->m_frame.m_width<<"x"<<job->m_frame.m_height
+                     <<") in "<<ms<<"ms"<<std::endl;
+        }
+        delete job;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_numBusy--;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool ImageExporter::write(const std::string &_path, const DisplayFrame &_frame, Format _format,
+                          const AutoExposure::Params &_params, bool _resolve)
+{
+    if(_frame.isEmpty() || _path.empty())
+    {
+        std::cerr<<"ImageExporter: nothing to write to "<<_path<<std::endl;
+        return false;
+    }
+    if(isFloat(_format) && (_frame.m_format!=DisplayFrame::RGBA32F ||
+                            _frame.m_pixels.size()<(size_t)_frame.m_width*_frame.m_height*4))
+    {
+        std::cerr<<"ImageExporter: can only write RGBA32F frames to "<<_path<<std::endl;
+        return false;
+    }
+    switch(_format)
+    {
+        case(PFM): return ImageError::writePFM(_path,_frame);
+        case(HDR): return writeHDR(_path,_frame);
+        case(EXRHalf): return writeEXR(_path,_frame,true);
+        case(EXRFloat): return writeEXR(_path,_frame,false);
+        default: return writeLDR(_path,_frame,_format,_params,_resolve);
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void ImageExporter::toRGBE(const float *_rgba, unsigned char *_rgbe, unsigned int _numPixels)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 largest = _mm_set1_ps(1.7e38f);
+    const __m128 smallest = _mm_set1_ps(1e-32f);
+    unsigned int i=0;
+    for(;i+4<=_numPixels;i+=4)
+    {
+        __m128 r = _mm_loadu_ps(_rgba+i*4);
+        __m128 g = _mm_loadu_ps(_rgba+i*4+4);
+        __m128 b = _mm_loadu_ps(_rgba+i*4+8);
+        __m128 a = _mm_loadu_ps(_rgba+i*4+12);
+        _MM_TRANSPOSE4_PS(r,g,b,a);
+        // Max with zero first so NaNs come out as 0, and below 2^127 so our exponent fits in a byte
+        r = _mm_min_ps(_mm_max_ps(r,zero),largest);
+        g = _mm_min_ps(_mm_max_ps(g,zero),largest);
+        b = _mm_min_ps(_mm_max_ps(b,zero),largest);
+        __m128 v = _mm_max_ps(r,_mm_max_ps(g,b));
+        // frexp from our bits, v = m*2^e with m in [0.5,1) so our channels scale by 2^(8-e)
+        __m128i e = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(v),23),_mm_set1_epi32(126));
+        __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_sub_epi32(_mm_set1_epi32(135),e),23));
+        __m128i ri = _mm_cvttps_epi32(_mm_mul_ps(r,scale));
+        __m128i gi = _mm_cvttps_epi32(_mm_mul_ps(g,scale));
+        __m128i bi = _mm_cvttps_epi32(_mm_mul_ps(b,scale));
+        __m128i ei = _mm_add_epi32(e,_mm_set1_epi32(128));
+        __m128i rgbe = _mm_or_si128(_mm_or_si128(ri,_mm_slli_epi32(gi,8)),
+                                    _mm_or_si128(_mm_slli_epi32(bi,16),_mm_slli_epi32(ei,24)));
+        rgbe = _mm_and_si128(rgbe,_mm_castps_si128(_mm_cmpge_ps(v,smallest)));
+        _mm_storeu_si128((__m128i*)(_rgbe+i*4),rgbe);
+    }
+    for(;i<_numPixels;i++) floatToRGBE(_rgba+i*4,_rgbe+i*4);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void ImageExporter::toHalf(const float *_src, unsigned short *_dst, unsigned int _count)
+{
+    const __m128i absMask = _mm_set1_epi32(0x7fffffff);
+    const __m128i infinity = _mm_set1_epi32(0x7c00);
+    unsigned int i=0;
+    for(;i+4<=_count;i+=4)
+    {
+        __m128i bits = _mm_castps_si128(_mm_loadu_ps(_src+i));
+        __m128i sign = _mm_and_si128(_mm_srli_epi32(bits,16),_mm_set1_epi32(0x8000));
+        __m128i abs = _mm_and_si128(bits,absMask);
+        __m128i lsb = _mm_and_si128(_mm_srli_epi32(abs,13),_mm_set1_epi32(1));
+        __m128i rounded = _mm_add_epi32(abs,_mm_add_epi32(lsb,_mm_set1_epi32(0xfff)));
+        __m128i normal = _mm_sub_epi32(_mm_srli_epi32(rounded,13),_mm_set1_epi32(112<<10));
+        __m128i denormal = _mm_cvtps_epi32(_mm_mul_ps(_mm_castsi128_ps(abs),_mm_set1_ps(16777216.f)));
+        __m128i isDenormal = _mm_cmplt_epi32(abs,_mm_set1_epi32(113<<23));
+        __m128i h = _mm_or_si128(_mm_and_si128(isDenormal,denormal),_mm_andnot_si128(isDenormal,normal));
+        __m128i overflow = _mm_cmpgt_epi32(h,_mm_set1_epi32(0x7bff));
+        h = _mm_or_si128(_mm_and_si128(overflow,infinity),_mm_andnot_si128(overflow,h));
+        __m128i nan = _mm_cmpgt_epi32(abs,_mm_set1_epi32(0x7f800000));
+        h = _mm_or_si128(_mm_and_si128(nan,_mm_set1_epi32(0x7e00)),_mm_andnot_si128(nan,h));
+        h = _mm_or_si128(h,sign);
+        // Sign extend so our signed pack keeps our top bit
+        h = _mm_srai_epi32(_mm_slli_epi32(h,16),16);
+        _mm_storel_epi64((__m128i*)(_dst+i),_mm_packs_epi32(h,h));
+    }
+    for(;i<_count;i++) _dst[i] = floatToHalf(_src[i]);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool ImageExporter::writeLDR(const std::string &_path, const DisplayFrame &_frame, Format _format,
+                             const AutoExposure::Params &_params, bool _resolve)
+{
+    const DisplayFrame *image = &_frame;
+    DisplayFrame resolved;
+    if(_resolve && _frame.m_format==DisplayFrame::RGBA32F)
+    {
+        AutoExposure::resolve(_frame,_params,resolved);
+        image = &resolved;
+    }
+
+    unsigned int width = image->m_width;
+    unsigned int height = image->m_height;
+    QImage img(width,height,QImage::Format_RGB32);
+    // Detach our image once here so our threads can write straight into its rows
+    unsigned char *bits = img.bits();
+    int bytesPerLine = img.bytesPerLine();
+    parallelFor(height,g_rowGrain,[&](unsigned int _begin, unsigned int _end, unsigned int)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.f);
+        const __m128 scale = _mm_set1_ps(255.f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        float rgba[4];
+        for(unsigned int y=_begin;y<_end;y++)
+        {
+            // Our frames run bottom to top
+            unsigned int first = (height-y-1)*width;
+            unsigned int *dst = (unsigned int*)(bits+(size_t)y*bytesPerLine);
+            unsigned int x=0;
+            if(image->m_format==DisplayFrame::RGBA8)
+            {
+                const unsigned char *src = &image->m_display[(size_t)first*4];
+                for(;x+4<=width;x+=4)
+                    _mm_storeu_si128((__m128i*)(dst+x),rgbaToARGB(_mm_loadu_si128((const __m128i*)(src+x*4))));
+                for(;x<width;x++) dst[x] = rgbaToARGB(src+x*4);
+            }
+            else if(image->m_format==DisplayFrame::RGBA32F)
+            {
+                const float *src = &image->m_pixels[(size_t)first*4];
+                for(;x+4<=width;x+=4)
+                {
+                    __m128i p[4];
+                    for(int i=0;i<4;i++)
+                    {
+                        __m128 c = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src+(x+i)*4),zero),one);
+                        p[i] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c,scale),half));
+                    }
+                    __m128i rgba8 = _mm_packus_epi16(_mm_packs_epi32(p[0],p[1]),_mm_packs_epi32(p[2],p[3]));
+                    _mm_storeu_si128((__m128i*)(dst+x),rgbaToARGB(rgba8));
+                }
+            }
+            // Whatever is left over, and our half frames which are only read for saving
+            for(;x<width;x++)
+            {
+                image->getPixel(first+x,rgba);
+                unsigned char c[4];
+                for(int i=0;i<4;i++) c[i] = (unsigned char)(std::min(std::max(rgba[i],0.f),1.f)*255.f+0.5f);
+                dst[x] = rgbaToARGB(c);
+            }
+        }
+    });
+
+    const char *format;
+    switch(_format)
+    {
+        case(JPEG): format = "JPEG"; break;
+        case(BMP): format = "BMP"; break;
+        case(GIF): format = "GIF"; break;
+        default: format = "PNG"; break;
+    }
+    if(!img.save(QString::fromStdString(_path),format))
+    {
+        std::cerr<<"ImageExporter: could not write "<<_path<<" as "<<format<<std::endl;
+        return false;
+    }
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void ImageExporter::encodeScanline(const unsigned char *_rgbe, unsigned int _width, std::vector<unsigned char> &_out)
+{
+    _out.push_back(2);
+    _out.push_back(2);
+    _out.push_back((unsigned char)(_width>>8));
+    _out.push_back((unsigned char)(_width&0xff));
+    // Each channel in turn as runs of at least 4 equal bytes and spans of up to 128 literal bytes between them
+    const unsigned int minRun = 4;
+    for(unsigned int c=0;c<4;c++)
+    {
+        unsigned int cur = 0;
+        while(cur<_width)
+        {
+            // Find the start of our next run long enough to be worth encoding
+            unsigned int begRun = cur;
+            unsigned int runCount = 0;
+            unsigned int oldRunCount = 0;
+            while(runCount<minRun && begRun<_width)
+            {
+                begRun += runCount;
+                oldRunCount = runCount;
+                runCount = 1;
+                while(begRun+runCount<_width && runCount<127 &&
+                      _rgbe[begRun*4+c]==_rgbe[(begRun+runCount)*4+c]) runCount++;
+            }
+            // A short run right before our long one is still cheaper as a run than as literals
+            if(oldRunCount>1 && oldRunCount==begRun-cur)
+            {
+                _out.push_back((unsigned char)(128+oldRunCount));
+                _out.push_back(_rgbe[cur*4+c]);
+                cur = begRun;
+            }
+            while(cur<begRun)
+            {
+                unsigned int count = std::min(begRun-cur,128u);
+                _out.push_back((unsigned char)count);
+                for(unsigned int i=0;i<count;i++) _out.push_back(_rgbe[(cur+i)*4+c]);
+                cur += count;
+            }
+            if(runCount>=minRun)
+            {
+                _out.push_back((unsigned char)(128+runCount));
+                _out.push_back(_rgbe[begRun*4+c]);
+                cur += runCount;
+            }
+        }
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool ImageExporter::writeHDR(const std::string &_path, const DisplayFrame &_frame)
+{
+    unsigned int width = _frame.m_width;
+    unsigned int height = _frame.m_height;
+    // Scanlines outside of these widths can't be RLE encoded so are written flat
+    bool rle = width>=8 && width<=0x7fff;
+    std::vector<std::vector<unsigned char> > scanlines(height);
+    parallelFor(height,g_rowGrain,[&](unsigned int _begin, unsigned int _end, unsigned int)
+    {
+        std::vector<unsigned char> rgbe(width*4);
+        for(unsigned int y=_begin;y<_end;y++)
+        {
+            // -Y so our first scanline is our top row, our frames run bottom to top
+            toRGBE(&_frame.m_pixels[(size_t)(height-y-1)*width*4],&rgbe[0],width);
+            if(rle)
+            {
+                scanlines[y].reserve(width*4+4);
+                encodeScanline(&rgbe[0],width,scanlines[y]);
+            }
+            else
+            {
+                scanlines[y] = rgbe;
+            }
+        }
+    });
+
+    std::ofstream file(_path.c_str(),std::ios::binary);
+    if(!file.is_open())
+    {
+        std::cerr<<"ImageExporter: could not open "<<_path<<" for writing"<<std::endl;
+        return false;
+    }
+    file<<"#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y "<<height<<" +X "<<width<<"\n";
+    for(unsigned int y=0;y<height;y++)
+        file.write((const char*)&scanlines[y][0],scanlines[y].size());
+    return file.good();
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool ImageExporter::writeEXR(const std::string &_path, const DisplayFrame &_frame, bool _half)
+{
+    // Our header is written little endian whatever our host but our pixels are copied as they are
+    unsigned int one = 1;
+    if(*((unsigned char*)&one)!=1)
+    {
+        std::cerr<<"ImageExporter: OpenEXR can only be written on little endian hosts"<<std::endl;
+        return false;
+    }
+    unsigned int width = _frame.m_width;
+    unsigned int height = _frame.m_height;
+
+    std::vector<unsigned char> header;
+    appendInt(header,20000630);
+    appendInt(header,2);
+    // Our channels in the alphabetical order OpenEXR stores them, 1 is HALF and 2 is FLOAT
+    std::vector<unsigned char> value;
+    const char *channels[] = {"B","G","R"};
+    for(int c=0;c<3;c++)
+    {
+        appendString(value,channels[c]);
+        appendInt(value,(_half) ? 1 : 2);
+        appendInt(value,0);
+        appendInt(value,1);
+        appendInt(value,1);
+    }
+    value.push_back(0);
+    appendAttribute(header,"channels","chlist",value);
+    value.assign(1,0);
+    appendAttribute(header,"compression","compression",value);
+    value.clear();
+    appendInt(value,0);
+    appendInt(value,0);
+    appendInt(value,width-1);
+    appendInt(value,height-1);
+    appendAttribute(header,"dataWindow","box2i",value);
+    appendAttribute(header,"displayWindow","box2i",value);
+    value.assign(1,0);
+    appendAttribute(header,"lineOrder","lineOrder",value);
+    value.clear();
+    appendFloat(value,1.f);
+    appendAttribute(header,"pixelAspectRatio","float",value);
+    value.clear();
+    appendFloat(value,0.f);
+    appendFloat(value,0.f);
+    appendAttribute(header,"screenWindowCenter","v2f",value);
+    value.clear();
+    appendFloat(value,1.f);
+    appendAttribute(header,"screenWindowWidth","float",value);
+    header.push_back(0);
+
+    // Uncompressed so each of our scanline blocks is the same size, its y and size followed by each channel in turn
+    unsigned int bytesPerChannel = (_half) ? 2 : 4;
+    unsigned int dataSize = width*3*bytesPerChannel;
+    size_t blockSize = 8+dataSize;
+    size_t firstBlock = header.size()+(size_t)height*8;
+    std::vector<unsigned char> offsets(height*8);
+    for(unsigned int y=0;y<height;y++)
+    {
+        unsigned long long offset = firstBlock+y*blockSize;
+        putLE32(&offsets[y*8],(unsigned int)(offset&0xffffffffu));
+        putLE32(&offsets[y*8+4],(unsigned int)(offset>>32));
+    }
+
+    std::vector<unsigned char> blocks(height*blockSize);
+    parallelFor(height,g_rowGrain,[&](unsigned int _begin, unsigned int _end, unsigned int)
+    {
+        std::vector<float> planar(width*3);
+        for(unsigned int y=_begin;y<_end;y++)
+        {
+            // Increasing y so our first scanline is our top row, our frames run bottom to top
+            const float *src = &_frame.m_pixels[(size_t)(height-y-1)*width*4];
+            for(unsigned int x=0;x<width;x++)
+            {
+                planar[x] = src[x*4+2];
+                planar[width+x] = src[x*4+1];
+                planar[width*2+x] = src[x*4];
+            }
+            unsigned char *block = &blocks[y*blockSize];
+            putLE32(block,y);
+            putLE32(block+4,dataSize);
+            if(_half)
+                toHalf(&planar[0],(unsigned short*)(block+8),width*3);
+            else
+                memcpy(block+8,&planar[0],dataSize);
+        }
+    });
+
+    std::ofstream file(_path.c_str(),std::ios::binary);
+    if(!file.is_open())
+    {
+        std::cerr<<"ImageExporter: could not open "<<_path<<" for writing"<<std::endl;
+        return false;
+    }
+    file.write((const char*)&header[0],header.size());
+    file.write((const char*)&offsets[0],offsets.size());
+    file.write((const char*)&blocks[0],blocks.size());
+    return file.good();
+}
+//----------------------------------------------------------------------------------------------------------------------
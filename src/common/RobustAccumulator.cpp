@@ -0,0 +1,145 @@
+#include "common/RobustAccumulator.h"
+#include "common/ParallelFor.h"
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief smallest number of pixels worth giving a thread of their own
+//----------------------------------------------------------------------------------------------------------------------
+static const unsigned int g_grain = 1<<14;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief luminance of one of our means, what our median of means orders its buckets by
+//----------------------------------------------------------------------------------------------------------------------
+static inline float luminance(const optix::float3 &_rgb)
+{
+    return 0.2126f*_rgb.x + 0.7152f*_rgb.y + 0.0722f*_rgb.z;
+}
+//----------------------------------------------------------------------------------------------------------------------
+RobustAccumulator::RobustAccumulator(unsigned int _numPixels, Precision _precision, Estimator _estimator,
+                                     unsigned int _numBuckets, float _sigmas) : m_numPixels(_numPixels),
+                                                                                m_precision(_precision),
+                                                                                m_estimator(_estimator),
+                                                                                m_numBuckets(1),
+                                                                                m_sigmas(_sigmas),
+                                                                                m_numFrames(0)
+{
+    if(_estimator==MedianOfMeans) m_numBuckets = std::max(_numBuckets,1u);
+    size_t size = (size_t)m_numBuckets*m_numPixels*3;
+    if(_precision==Double)
+    {
+        m_doubles.resize(size);
+        if(_estimator==Clamped) m_momentDoubles.resize(m_numPixels*3);
+    }
+    else
+    {
+        m_means.resize(size);
+        if(_precision==Kahan) m_compensation.resize(size);
+        if(_estimator==Clamped)
+        {
+            m_moments.resize(m_numPixels*3);
+            if(_precision==Kahan) m_momentCompensation.resize(m_numPixels*3);
+        }
+    }
+    clear();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RobustAccumulator::clear()
+{
+    m_numFrames = 0;
+    std::fill(m_means.begin(),m_means.end(),0.f);
+    std::fill(m_compensation.begin(),m_compensation.end(),0.f);
+    std::fill(m_doubles.begin(),m_doubles.end(),0.0);
+    std::fill(m_moments.begin(),m_moments.end(),0.f);
+    std::fill(m_momentCompensation.begin(),m_momentCompensation.end(),0.f);
+    std::fill(m_momentDoubles.begin(),m_momentDoubles.end(),0.0);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RobustAccumulator::accumulate(unsigned int _index, const optix::float3 &_value, unsigned int _n, std::vector<float> &_means,
+                                   std::vector<float> &_compensation, std::vector<double> &_doubles)
+{
+    if(m_precision==Double)
+    {
+        double *mean = &_doubles[_index*3];
+        mean[0] += (_value.x-mean[0])/_n;
+        mean[1] += (_value.y-mean[1])/_n;
+        mean[2] += (_value.z-mean[2])/_n;
+        return;
+    }
+    float *mean = &_means[_index*3];
+    optix::float3 m = optix::make_float3(mean[0],mean[1],mean[2]);
+    optix::float3 c = optix::make_float3(0.f);
+    if(m_precision==Kahan) c = optix::make_float3(_compensation[_index*3],_compensation[_index*3+1],_compensation[_index*3+2]);
+    accumulate_mean(m,c,_value,_n,m_precision==Kahan);
+    mean[0] = m.x; mean[1] = m.y; mean[2] = m.z;
+    if(m_precision==Kahan)
+    {
+        _compensation[_index*3] = c.x;
+        _compensation[_index*3+1] = c.y;
+        _compensation[_index*3+2] = c.z;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+optix::float3 RobustAccumulator::getMean(unsigned int _index, const std::vector<float> &_means, const std::vector<double> &_doubles) const
+{
+    if(m_precision==Double) return optix::make_float3((float)_doubles[_index*3],(float)_doubles[_index*3+1],(float)_doubles[_index*3+2]);
+    return optix::make_float3(_means[_index*3],_means[_index*3+1],_means[_index*3+2]);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RobustAccumulator::addFrame(const float *_rgba)
+{
+    m_numFrames++;
+    // Our frames are dealt round our buckets so each holds every m_numBuckets'th frame
+    unsigned int bucket = (m_numFrames-1)%m_numBuckets;
+    unsigned int n = (m_numFrames-1)/m_numBuckets+1;
+    parallelFor(m_numPixels,g_grain,[&](unsigned int _begin, unsigned int _end, unsigned int)
+    {
+        for(unsigned int i=_begin;i<_end;i++)
+        {
+            optix::float3 value = optix::make_float3(_rgba[i*4],_rgba[i*4+1],_rgba[i*4+2]);
+            if(m_estimator==Clamped)
+            {
+                // As our path tracer does, our moment takes our clamped value so a firefly can't loosen our clamp
+                value = clamp_firefly(value,getMean(i,m_means,m_doubles),getMean(i,m_moments,m_momentDoubles),n-1,m_sigmas);
+                accumulate(i,value*value,n,m_moments,m_momentCompensation,m_momentDoubles);
+            }
+            accumulate(bucket*m_numPixels+i,value,n,m_means,m_compensation,m_doubles);
+        }
+    });
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RobustAccumulator::resolve(float *_rgba) const
+{
+    // Only the buckets that have been dealt a frame count towards our median
+    unsigned int numBuckets = std::min(m_numFrames,m_numBuckets);
+    parallelFor(m_numPixels,g_grain,[&](unsigned int _begin, unsigned int _end, unsigned int)
+    {
+        std::vector<optix::float3> means(m_numBuckets);
+        std::vector<float> keys(m_numBuckets);
+        std::vector<unsigned int> order(m_numBuckets);
+        for(unsigned int i=_begin;i<_end;i++)
+        {
+            optix::float3 estimate = optix::make_float3(0.f);
+            if(numBuckets==1)
+            {
+                estimate = getMean(i,m_means,m_doubles);
+            }
+            else if(numBuckets>1)
+            {
+                // Order our buckets by luminance and take our middle one, or the mean of our middle two
+                for(unsigned int b=0;b<numBuckets;b++)
+                {
+                    means[b] = getMean(b*m_numPixels+i,m_means,m_doubles);
+                    keys[b] = luminance(means[b]);
+                }
+                for(unsigned int b=0;b<numBuckets;b++) order[b] = b;
+                std::sort(order.begin(),order.begin()+numBuckets,[&](unsigned int _a, unsigned int _b){return keys[_a]<keys[_b];});
+                unsigned int middle = numBuckets/2;
+                estimate = (numBuckets%2) ? means[order[middle]] : (means[order[middle-1]]+means[order[middle]])*0.5f;
+            }
+            _rgba[i*4] = estimate.x;
+            _rgba[i*4+1] = estimate.y;
+            _rgba[i*4+2] = estimate.z;
+            _rgba[i*4+3] = 1.f;
+        }
+    });
+}
+//----------------------------------------------------------------------------------------------------------------------
@@ -1,4 +1,5 @@
 #include "geometry/AbstractOptixGeometry.h"
+#include "perf/TraceEvents.h"
 #include <iostream>
 #include <glm/mat4x4.hpp>
 #include <glm/gtx/transform.hpp>
@@ -48,11 +49,9 @@ AbstractOptixGeometry::AbstractOptixGeometry(optix::Context &_context, AbstractO
     m_geometryGroup = _context->createGeometryGroup();
     m_geometryGroup->setChildCount(1);
     m_geometryGroup->setChild(0,m_geometryInstance);
-    //create our acceleration method, in this case none becuase we only have one peice of geomtry
-    //set this acceleration in our geometry group
-    m_geometryGroup->setAcceleration(_context->createAcceleration("Sbvh","Bvh"));
-    m_geometryGroup->getAcceleration()->markDirty();
-    //Set the acceleration structure as dirty
+    // Share the acceleration structure of the geometry we instance. Our geometry is the same so
+    // there is no need to build and store another copy of it for every instance.
+    m_geometryGroup->setAcceleration(_instance.m_geometryGroup->getAcceleration());
     m_transform = _context->createTransform();
     // identity matrix to init our transformation
     float m[16];
@@ -63,6 +62,10 @@ AbstractOptixGeometry::AbstractOptixGeometry(optix::Context &_context, AbstractO
     m_transform->setMatrix(false,m,m);
     // Add our geometry group to our transform
     m_transform->setChild(m_geometryGroup);
+
+    m_pos = optix::make_float3(0.f);
+    m_scale = optix::make_float3(1.f);
+    m_rot = optix::make_float3(0.f);
 }
 //----------------------------------------------------------------------------------------------------------------------
 void AbstractOptixGeometry::createIntersectionProgram(std::string &_name)
@@ -85,6 +88,7 @@ void AbstractOptixGeometry::createIntersectionProgram(std::string &_name)
     }
 
     // If we have made it this far we're in good form. Lets hope it doesn't go wrong here!
+    TraceScope trace(std::string("create program ")+_name);
     m_intersectionProgram= getContext()->createProgramFromPTXFile(getPtxPath(),_name);
     m_geometry->setIntersectionProgram(m_intersectionProgram);
 
@@ -112,6 +116,7 @@ void AbstractOptixGeometry::createIntersectionProgram(const char *_name)
     }
 
     // If we have made it this far we're in good form. Lets hope it doesn't go wrong here!
+    TraceScope trace(std::string("create program ")+_name);
     m_intersectionProgram= getContext()->createProgramFromPTXFile(getPtxPath(),_name);
     m_geometry->setIntersectionProgram(m_intersectionProgram);
 
@@ -145,6 +150,7 @@ void AbstractOptixGeometry::createBBProgram(std::string &_name)
     }
 
     // If we have made it this far we're in good form. Lets hope it doesn't go wrong here!
+    TraceScope trace(std::string("create program ")+_name);
     m_BBProgram = getContext()->createProgramFromPTXFile(getPtxPath(),_name);
     m_geometry->setBoundingBoxProgram(m_BBProgram);
 
@@ -172,6 +178,7 @@ void AbstractOptixGeometry::createBBProgram(const char *_name)
     }
 
     // If we have made it this far we're in good form. Lets hope it doesn't go wrong here!
+    TraceScope trace(std::string("create program ")+_name);
     m_BBProgram = getContext()->createProgramFromPTXFile(getPtxPath(),_name);
     m_geometry->setBoundingBoxProgram(m_BBProgram);
 
@@ -1,43 +1,65 @@
 #include "geometry/Mesh.h"
+#include "perf/TraceEvents.h"
+#include "perf/PerfMetrics.h"
 #include <iostream>
 #include <sstream>
+#include <cstring>
 
 // Declare our static variables
 optix::Program Mesh::m_meshIntersect;
 optix::Program Mesh::m_meshBB;
-bool Mesh::m_init;
+optix::Context Mesh::m_programContext;
 
 //----------------------------------------------------------------------------------------------------------------------
 Mesh::Mesh(optix::Context &_context) : AbstractOptixGeometry(_context)
 {
     setPtxPath("ptx/triangle_mesh.cu.ptx");
-    if(!m_init)
+    if(m_programContext.get()!=getContext().get())
     {
+        TraceScope trace("create mesh programs");
         m_meshIntersect = getContext()->createProgramFromPTXFile(getPtxPath(),"mesh_intersect");
         m_meshBB = getContext()->createProgramFromPTXFile(getPtxPath(),"mesh_bounds");
-        m_init = true;
+        m_programContext = getContext();
     }
     setIntersectionProgram(m_meshIntersect);
     setBBProgram(m_meshBB);
     m_numPolygons = 0;
+    m_isInstance = false;
 }
 
 Mesh::Mesh(std::string _path, optix::Context &_context) : AbstractOptixGeometry(_context)
 {
     setPtxPath("ptx/triangle_mesh.cu.ptx");
-    if(!m_init)
+    if(m_programContext.get()!=getContext().get())
     {
+        TraceScope trace("create mesh programs");
         m_meshIntersect = getContext()->createProgramFromPTXFile(getPtxPath(),"mesh_intersect");
         m_meshBB = getContext()->createProgramFromPTXFile(getPtxPath(),"mesh_bounds");
-        m_init = true;
+        m_programContext = getContext();
     }
     setIntersectionProgram(m_meshIntersect);
     setBBProgram(m_meshBB);
     m_numPolygons = 0;
+    m_isInstance = false;
     importGeometry(_path);
 }
 //----------------------------------------------------------------------------------------------------------------------
+Mesh::Mesh(optix::Context &_context, Mesh &_instance) : AbstractOptixGeometry(_context,_instance)
+{
+    setPtxPath("ptx/triangle_mesh.cu.ptx");
+    m_numPolygons = _instance.m_numPolygons;
+    m_isInstance = true;
+    // Only keep handles to our buffers, our host data stays with the mesh we instance
+    m_vertexBuffer = _instance.m_vertexBuffer;
+    m_normalBuffer = _instance.m_normalBuffer;
+    m_texCoordsBuffer = _instance.m_texCoordsBuffer;
+    m_tangentsBuffer = _instance.m_tangentsBuffer;
+    m_bitangentsBuffer = _instance.m_bitangentsBuffer;
+}
+//----------------------------------------------------------------------------------------------------------------------
 Mesh::~Mesh(){
+    // Our buffers belong to the mesh we instance
+    if(m_isInstance || !m_vertexBuffer.get()) return;
     // Remove our GPU buffers
     m_vertexBuffer->destroy();
     m_normalBuffer->destroy();
@@ -52,16 +74,21 @@ void Mesh::importGeometry(std::string _loc){
         std::cerr<<"No context set cannot create geometry."<<std::endl;
         return;
     }
-    //import our mesh
-    Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(_loc.c_str(), aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace | aiProcess_Triangulate);
-    if(scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
     {
-        std::cerr<<"The file was not successfully opened: "<<_loc.c_str()<<std::endl;
-        return;
-    }
+        // time our import separately to our buffer upload in createBuffers
+        PerfScopedTimer timer(PerfMetrics::MeshImport);
+        TraceScope trace("import "+_loc);
+        //import our mesh
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(_loc.c_str(), aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace | aiProcess_Triangulate);
+        if(!scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+        {
+            std::cerr<<"The file was not successfully opened: "<<_loc.c_str()<<std::endl;
+            return;
+        }
 
-    extractMeshData(scene->mRootNode, scene);
+        extractMeshData(scene->mRootNode, scene);
+    }
 
     std::cout<<"Buffer sizes"<<std::endl;
     std::cout<<"Pos: "<<m_vertices.size()<<std::endl;
@@ -74,6 +101,45 @@ void Mesh::importGeometry(std::string _loc){
     createBuffers();
 }
 //----------------------------------------------------------------------------------------------------------------------
+void Mesh::setTriangles(std::vector<optix::float3> &_vertices, std::vector<optix::float3> &_normals)
+{
+    if(!contextSet())
+    {
+        std::cerr<<"No context set cannot create geometry."<<std::endl;
+        return;
+    }
+    if(m_isInstance)
+    {
+        std::cerr<<"Cannot set the triangles of a mesh instance."<<std::endl;
+        return;
+    }
+    if(!_normals.empty() && _normals.size()!=_vertices.size())
+    {
+        std::cerr<<"Mesh needs a normal per vertex, ignoring normals."<<std::endl;
+        _normals.clear();
+    }
+
+    m_vertices.clear();
+    m_normals.clear();
+    m_texCoords.clear();
+    m_tangents.clear();
+    m_bitangents.clear();
+    m_vertices.swap(_vertices);
+    m_normals.swap(_normals);
+    m_numPolygons = m_vertices.size()/3;
+
+    // Replacing our geometry so clear out our old buffers
+    if(m_vertexBuffer.get())
+    {
+        m_vertexBuffer->destroy();
+        m_normalBuffer->destroy();
+        m_texCoordsBuffer->destroy();
+        m_tangentsBuffer->destroy();
+        m_bitangentsBuffer->destroy();
+    }
+    createBuffers();
+}
+//----------------------------------------------------------------------------------------------------------------------
 void Mesh::extractMeshData(const aiNode *_node, const aiScene *_scene)
 {
     for (unsigned int i=0; i<_node->mNumMeshes; i++){
@@ -153,6 +219,7 @@ void Mesh::processMesh(const aiMesh *_mesh){
 }
 //----------------------------------------------------------------------------------------------------------------------
 void Mesh::createBuffers(){
+    PerfScopedTimer timer(PerfMetrics::BufferUpload);
 
     // Create vertex, normal, and texture_coordinate buffers
     m_vertexBuffer = getContext()->createBuffer( RT_BUFFER_INPUT, RT_FORMAT_FLOAT3, m_vertices.size() );
@@ -165,61 +232,32 @@ void Mesh::createBuffers(){
     m_tangentsBuffer->validate();
     m_bitangentsBuffer = getContext()->createBuffer( RT_BUFFER_INPUT, RT_FORMAT_FLOAT3, m_bitangents.size());
     m_bitangentsBuffer->validate();
-    //now lets write our information to our buffers
-    void *vertPtr = m_vertexBuffer->map();
-
-    optix::float3* vertData = (optix::float3*)vertPtr;
-    unsigned int i;
-    for(i=0; i<m_vertices.size();i++){
-        vertData[i].x = m_vertices[i].x;
-        vertData[i].y = m_vertices[i].y;
-        vertData[i].z = m_vertices[i].z;
+    //now lets write our information to our buffers, each only holds as many elements as we have data for
+    if(!m_vertices.empty())
+    {
+        memcpy(m_vertexBuffer->map(),&m_vertices[0],m_vertices.size()*sizeof(optix::float3));
+        m_vertexBuffer->unmap();
     }
-    m_vertexBuffer->unmap();
-
-    vertPtr = m_normalBuffer->map();
-    vertData = (optix::float3*)vertPtr;
-    for(i=0; i<m_vertices.size();i++){
-        vertData[i].x = m_normals[i].x;
-        vertData[i].y = m_normals[i].y;
-        vertData[i].z = m_normals[i].z;
+    if(!m_normals.empty())
+    {
+        memcpy(m_normalBuffer->map(),&m_normals[0],m_normals.size()*sizeof(optix::float3));
+        m_normalBuffer->unmap();
     }
-    m_normalBuffer->unmap();
-
-    void *texPtr = m_texCoordsBuffer->map();
-
-    optix::float3* texData = (optix::float3*)texPtr;
-
-    for(i=0; i<m_vertices.size();i++){
-        if (m_texCoords.size() > 0.0){
-            texData[i].x = m_texCoords[i].x;
-            texData[i].y = m_texCoords[i].y;
-            texData[i].z = 0.f;
-        }
-        else{
-            texData[i].x = texData[i].y = texData[i].z = 0.0;
-        }
+    if(!m_texCoords.empty())
+    {
+        memcpy(m_texCoordsBuffer->map(),&m_texCoords[0],m_texCoords.size()*sizeof(optix::float3));
+        m_texCoordsBuffer->unmap();
     }
-    m_texCoordsBuffer->unmap();
-
-    void *tangPtr = m_tangentsBuffer->map();
-    optix::float3* tangData = (optix::float3*)tangPtr;
-    for(i=0; i<m_tangents.size(); i++){
-        tangData[i].x = m_tangents[i].x;
-        tangData[i].y = m_tangents[i].y;
-        tangData[i].z = m_tangents[i].z;
+    if(!m_tangents.empty())
+    {
+        memcpy(m_tangentsBuffer->map(),&m_tangents[0],m_tangents.size()*sizeof(optix::float3));
+        m_tangentsBuffer->unmap();
     }
-    m_tangentsBuffer->unmap();
-
-    void *bitangPtr = m_bitangentsBuffer->map();
-    optix::float3* bitangData = (optix::float3*)bitangPtr;
-    for(i=0; i<m_bitangents.size(); i++){
-        bitangData[i].x = m_bitangents[i].x;
-        bitangData[i].y = m_bitangents[i].y;
-        bitangData[i].z = m_bitangents[i].z;
+    if(!m_bitangents.empty())
+    {
+        memcpy(m_bitangentsBuffer->map(),&m_bitangents[0],m_bitangents.size()*sizeof(optix::float3));
+        m_bitangentsBuffer->unmap();
     }
-    m_bitangentsBuffer->unmap();
-
 
     //set our buffers for our geomtry
     m_geometry["vertex_buffer"]->setBuffer( m_vertexBuffer );
@@ -235,3 +273,21 @@ void Mesh::createBuffers(){
     rebuildAcceleration();
 }
 //----------------------------------------------------------------------------------------------------------------------
+void Mesh::getBounds(optix::float3 &_min, optix::float3 &_max)
+{
+    _min = _max = optix::make_float3(0.f,0.f,0.f);
+    if(m_vertices.empty()) return;
+    _min = _max = m_vertices[0];
+    for(unsigned int i=1;i<m_vertices.size();i++)
+    {
+        _min = optix::fminf(_min,m_vertices[i]);
+        _max = optix::fmaxf(_max,m_vertices[i]);
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t Mesh::getHostMemoryUsage()
+{
+    return (m_vertices.capacity() + m_normals.capacity() + m_texCoords.capacity() +
+            m_tangents.capacity() + m_bitangents.capacity())*sizeof(optix::float3);
+}
+//----------------------------------------------------------------------------------------------------------------------
@@ -1,9 +1,10 @@
 #include "geometry/Parallelogram.h"
+#include "perf/TraceEvents.h"
 
 // Declare our static variables
 optix::Program Parallelogram::m_parallelogramIntersect;
 optix::Program Parallelogram::m_parallelogramBB;
-bool Parallelogram::m_init;
+optix::Context Parallelogram::m_programContext;
 
 //----------------------------------------------------------------------------------------------------------------------
 Parallelogram::Parallelogram(optix::Context &_context) : AbstractOptixGeometry(_context)
@@ -11,11 +12,12 @@ Parallelogram::Parallelogram(optix::Context &_context) : AbstractOptixGeometry(_
     // Set path to our parallelogram ptx file
     setPtxPath("ptx/parallelogram.cu.ptx");
     // If we havent initialized our intersect & BB programs lets do it now
-    if(!m_init)
+    if(m_programContext.get()!=getContext().get())
     {
+        TraceScope trace("create parallelogram programs");
         m_parallelogramIntersect = getContext()->createProgramFromPTXFile(getPtxPath(),"intersect");
         m_parallelogramBB = getContext()->createProgramFromPTXFile(getPtxPath(),"bounds");
-        m_init = true;
+        m_programContext = getContext();
     }
     setIntersectionProgram(m_parallelogramIntersect);
     setBBProgram(m_parallelogramBB);
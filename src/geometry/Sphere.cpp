@@ -1,9 +1,10 @@
 #include "geometry/Sphere.h"
+#include "perf/TraceEvents.h"
 
 // Declare our static variables
 optix::Program Sphere::m_sphereIntersect;
 optix::Program Sphere::m_sphereBB;
-bool Sphere::m_init;
+optix::Context Sphere::m_programContext;
 
 //----------------------------------------------------------------------------------------------------------------------
 Sphere::Sphere(optix::Context &_context) : AbstractOptixGeometry(_context)
@@ -11,11 +12,12 @@ Sphere::Sphere(optix::Context &_context) : AbstractOptixGeometry(_context)
     // Set path to our sphere ptx file
     setPtxPath("ptx/sphere.cu.ptx");
     // If we havent initialized our intersect & BB programs lets do it now
-    if(!m_init)
+    if(m_programContext.get()!=getContext().get())
     {
+        TraceScope trace("create sphere programs");
         m_sphereIntersect = getContext()->createProgramFromPTXFile(getPtxPath(),"intersect_sphere");
         m_sphereBB = getContext()->createProgramFromPTXFile(getPtxPath(),"bounds_sphere");
-        m_init = true;
+        m_programContext = getContext();
     }
     setIntersectionProgram(m_sphereIntersect);
     setBBProgram(m_sphereBB);
@@ -0,0 +1,107 @@
+#include "gl/FrameGraph.h"
+#include "gl/Shader.h"
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------------------------
+FrameGraph::FrameGraph(unsigned int _numSamples) : m_numSamples((_numSamples) ? _numSamples : 1),
+                                                   m_next(0),
+                                                   m_count(0)
+{
+    m_frameMs.assign(m_numSamples,0.f);
+    m_traceMs.assign(m_numSamples,0.f);
+    // A frame and a trace line for each sample, our two guides and our base line
+    m_maxVertices = m_numSamples*4 + 6;
+    m_vertices.reserve(m_maxVertices);
+
+    m_shader = new ShaderProgram();
+    Shader vert("shaders/GraphVert.glsl",GL_VERTEX_SHADER);
+    Shader frag("shaders/GraphFrag.glsl",GL_FRAGMENT_SHADER);
+    m_shader->attachShader(&vert);
+    m_shader->attachShader(&frag);
+    m_shader->bindFragDataLocation(0, "fragColour");
+    glBindAttribLocation(m_shader->getProgramID(),0,"inVert");
+    glBindAttribLocation(m_shader->getProgramID(),1,"inColour");
+    m_shader->link();
+    m_scaleXLoc = m_shader->getUniformLoc("scaleX");
+    m_scaleYLoc = m_shader->getUniformLoc("scaleY");
+
+    glGenVertexArrays(1,&m_VAO);
+    glBindVertexArray(m_VAO);
+    glGenBuffers(1,&m_VBO);
+    glBindBuffer(GL_ARRAY_BUFFER,m_VBO);
+    glBufferData(GL_ARRAY_BUFFER,m_maxVertices*sizeof(Vertex),0,GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(0,2,GL_FLOAT,GL_FALSE,sizeof(Vertex),(GLvoid*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1,3,GL_FLOAT,GL_FALSE,sizeof(Vertex),(GLvoid*)(2*sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ARRAY_BUFFER,0);
+    glBindVertexArray(0);
+}
+//----------------------------------------------------------------------------------------------------------------------
+FrameGraph::~FrameGraph()
+{
+    glDeleteBuffers(1,&m_VBO);
+    glDeleteVertexArrays(1,&m_VAO);
+    delete m_shader;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FrameGraph::addSample(float _frameMs, float _traceMs)
+{
+    m_frameMs[m_next] = _frameMs;
+    m_traceMs[m_next] = _traceMs;
+    m_next = (m_next+1)%m_numSamples;
+    if(m_count<m_numSamples) m_count++;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FrameGraph::setScreenSize(int _w, int _h)
+{
+    m_shader->use();
+    glUniform1f(m_scaleXLoc,2.f/_w);
+    glUniform1f(m_scaleYLoc,-2.f/_h);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FrameGraph::addLine(float _x0, float _y0, float _x1, float _y1, float _r, float _g, float _b)
+{
+    Vertex v0 = {_x0,_y0,_r,_g,_b};
+    Vertex v1 = {_x1,_y1,_r,_g,_b};
+    m_vertices.push_back(v0);
+    m_vertices.push_back(v1);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FrameGraph::draw(float _x, float _y, float _height)
+{
+    if(m_count==0) return;
+
+    // Fit our slowest frame, but always show at least 30 frames per second so a smooth session looks it
+    const float ms30 = 1000.f/30.f;
+    const float ms60 = 1000.f/60.f;
+    float maxMs = ms30;
+    for(unsigned int i=0;i<m_count;i++) maxMs = std::max(maxMs,m_frameMs[i]*1.1f);
+    float scale = _height/maxMs;
+    float base = _y+_height;
+
+    // Oldest frame on the left, trace drawn over the frame it was part of
+    m_vertices.clear();
+    unsigned int first = (m_next+m_numSamples-m_count)%m_numSamples;
+    for(unsigned int i=0;i<m_count;i++)
+    {
+        unsigned int s = (first+i)%m_numSamples;
+        float x = _x+i+0.5f;
+        float traceMs = std::min(m_traceMs[s],m_frameMs[s]);
+        addLine(x,base,x,base-m_frameMs[s]*scale,0.6f,0.6f,0.6f);
+        addLine(x,base,x,base-traceMs*scale,0.2f,0.9f,0.2f);
+    }
+    float right = _x+m_numSamples;
+    addLine(_x,base-ms60*scale,right,base-ms60*scale,1.f,0.9f,0.2f);
+    addLine(_x,base-ms30*scale,right,base-ms30*scale,1.f,0.2f,0.2f);
+    addLine(_x,base,right,base,1.f,1.f,1.f);
+
+    m_shader->use();
+    glBindVertexArray(m_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER,m_VBO);
+    glBufferSubData(GL_ARRAY_BUFFER,0,m_vertices.size()*sizeof(Vertex),&m_vertices[0]);
+    glBindBuffer(GL_ARRAY_BUFFER,0);
+    glDrawArrays(GL_LINES,0,m_vertices.size());
+    glBindVertexArray(0);
+}
+//----------------------------------------------------------------------------------------------------------------------
@@ -52,200 +52,121 @@ Text::Text( const QFont &_f)
   m_textShader->attachShader(&vert);
   m_textShader->attachShader(&frag);
   m_textShader->bindFragDataLocation(0, "fragColour");
+  glBindAttribLocation(m_textShader->getProgramID(),0,"inVert");
+  glBindAttribLocation(m_textShader->getProgramID(),1,"inUV");
   m_textShader->link();
   m_textShader->use();
+  // look up our uniforms once rather than by name every time we draw
+  m_texLoc=m_textShader->getUniformLoc("tex");
+  m_xPosLoc=m_textShader->getUniformLoc("xpos");
+  m_yPosLoc=m_textShader->getUniformLoc("ypos");
+  m_scaleXLoc=m_textShader->getUniformLoc("scaleX");
+  m_scaleYLoc=m_textShader->getUniformLoc("scaleY");
+  m_colourLoc=m_textShader->getUniformLoc("textColour");
+  m_transformLoc=m_textShader->getUniformLoc("transform");
 
   // so first we grab the font metric of the font being used
   QFontMetrics metric(_f);
   // this allows us to get the height which should be the same for all
   // fonts of the same class as this is the total glyph height
-  float fontHeight=metric.height();
+  m_fontHeight=metric.height();
+  m_lineHeight=metric.lineSpacing();
 
   // loop for all basic keyboard chars we will use space to ~
   // should really change this to unicode at some stage
   const static char startChar=' ';
   const static char endChar='~';
-  // Most OpenGL cards need textures to be in powers of 2 (128x512 1024X1024 etc etc) so
-  // to be safe we will conform to this and calculate the nearest power of 2 for the glyph height
-  // we will do the same for each width of the font below
-  int heightPow2=nearestPowerOfTwo(fontHeight);
-
-  // we are now going to create a texture / billboard for each font
-  // they will be the same height but will possibly have different widths
-  // as some of the fonts will be the same width, to save VAO space we will only create
-  // a vao if we don't have one of the set width. To do this we use the has below
-  QHash <int,GLuint> widthVAO;
-
+  // All of our glyphs are packed into rows of a single atlas texture so a whole string can be drawn
+  // with one texture and one draw call. Glyphs are padded so linear filtering never picks up their neighbours.
+  const static int atlasWidth=512;
+  const static int padding=2;
+  int rowHeight=m_fontHeight+padding;
+  int x=padding;
+  int y=padding;
   for(char c=startChar; c<=endChar; ++c)
   {
-    QChar ch(c);
-    FontChar fc;
-    // get the width of the font and calculate the ^2 size
     int width=metric.width(c);
-    int widthPow2=nearestPowerOfTwo(width);
-    // now we set the texture co-ords for our quad it is a simple
-    // triangle billboard with tex-cords as shown
-    //  s0/t0  ---- s1,t0
-    //         |\ |
-    //         | \|
-    //  s0,t1  ---- s1,t1
-    // each quad will have the same s0 and the range s0-s1 == 0.0 -> 1.0
-    float s0=0.0;
-    // we now need to scale the tex cord to it ranges from 0-1 based on the coverage
-    // of the glyph and not the power of 2 texture size. This will ensure that kerns
-    // / ligatures match
-    float s1=width*1.0/widthPow2;
-    // t0 will always be the same
-    float t0=0.0;
-    // this will scale the height so we only get coverage of the glyph as above
-    float t1=metric.height()*-1.0/heightPow2;
-    // we need to store the font width for later drawing
-    fc.width=width;
-    // now we will create a QImage to store the texture, basically we are going to draw
-    // into the qimage then save this in OpenGL format and load as a texture.
-    // This is relativly quick but should be done as early as possible for max performance when drawing
-    QImage finalImage(nearestPowerOfTwo(width),nearestPowerOfTwo(fontHeight),QImage::Format_ARGB32);
-    // set the background for transparent so we can avoid any areas which don't have text in them
-    finalImage.fill(Qt::transparent);
-    // we now use the QPainter class to draw into the image and create our billboards
-    QPainter painter;
-    painter.begin(&finalImage);
-    // try and use high quality text rendering (works well on the mac not as good on linux)
-    painter.setRenderHints(QPainter::HighQualityAntialiasing
-                   | QPainter::TextAntialiasing);
-    // set the font to draw with
-    painter.setFont(_f);
-    // we set the glyph to be drawn in black the shader will override the actual colour later
-    // see TextShader.h in src/shaders/
-    painter.setPen(Qt::black);
-    // finally we draw the text to the Image
-    painter.drawText(0, metric.ascent(), QString(c));
-    painter.end();
-    // for debug purposes we can save the files as .png and view them
-    // not needed just useful when developing the class/
-    /*
-    QString filename=".png";
-    filename.prepend(c);
-    finalImage.save(filename);
-    */
-
-    // now we create the OpenGL texture ID and bind to make it active
-    glGenTextures(1, &fc.textureID);
-    glBindTexture(GL_TEXTURE_2D, fc.textureID);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    // QImage has a method to convert itself to a format suitable for OpenGL
-    finalImage=finalImage.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-    // set rgba image data
-    int widthTexture=finalImage.width();
-    int heightTexture=finalImage.height();
-    unsigned char *data = new unsigned char[ widthTexture*heightTexture * 4];
-    unsigned int index=0;
-    QRgb colour;
-    for(int y=heightTexture-1; y>0; --y)
+    if(x+width+padding>atlasWidth)
     {
-      for(int x=0; x<widthTexture; ++x)
-      {
-        colour=finalImage.pixel(x,y);
-        data[index++]=qRed(colour);
-        data[index++]=qGreen(colour);
-        data[index++]=qBlue(colour);
-        data[index++]=qAlpha(colour);
-        }
+      x=padding;
+      y+=rowHeight;
     }
+    FontChar fc;
+    fc.width=width;
+    fc.x=x;
+    fc.y=y;
+    m_characters[c]=fc;
+    x+=width+padding;
+  }
+  // Most OpenGL cards need textures to be in powers of 2 (128x512 1024X1024 etc etc) so
+  // to be safe we will conform to this
+  int atlasHeight=nearestPowerOfTwo(y+rowHeight);
+
+  // now we draw every glyph into a QImage then upload this in OpenGL format as our texture.
+  QImage atlas(atlasWidth,atlasHeight,QImage::Format_ARGB32_Premultiplied);
+  // set the background for transparent so we can avoid any areas which don't have text in them
+  atlas.fill(Qt::transparent);
+  QPainter painter;
+  painter.begin(&atlas);
+  // try and use high quality text rendering (works well on the mac not as good on linux)
+  painter.setRenderHints(QPainter::HighQualityAntialiasing
+                 | QPainter::TextAntialiasing);
+  painter.setFont(_f);
+  // we set the glyph to be drawn in black the shader will override the actual colour later
+  painter.setPen(Qt::black);
+  for(QHash<char,FontChar>::iterator it=m_characters.begin(); it!=m_characters.end(); ++it)
+  {
+    FontChar &fc=it.value();
+    painter.drawText(fc.x, fc.y+metric.ascent(), QString(it.key()));
+    // now we know the size of our atlas we can work out our texture co-ords,
+    // our first row of pixels is uploaded first so v goes down our image
+    fc.s0=float(fc.x)/atlasWidth;
+    fc.s1=float(fc.x+fc.width)/atlasWidth;
+    fc.t0=float(fc.y)/atlasHeight;
+    fc.t1=float(fc.y+m_fontHeight)/atlasHeight;
+  }
+  painter.end();
 
-
-
-    // the image in in RGBA format and unsigned byte load it ready for later
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, widthTexture, heightTexture,0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-    delete [] data;
-    // see if we have a Billboard of this width already
-    if (!widthVAO.contains(width))
-    {
-        // this structure is used by the VAO to store the data to be uploaded
-        // for drawing the quad
-        struct textVertData
-        {
-        float x;
-        float y;
-        float u;
-        float v;
-        };
-        // we are creating a billboard with two triangles so we only need the
-        // 6 verts, (could use index and save some space but shouldn't be too much of an
-        // issue
-        textVertData d[6];
-        // load values for triangle 1
-        d[0].x=0;
-        d[0].y=0;
-        d[0].u=s0;
-        d[0].v=t0;
-
-        d[1].x=fc.width;
-        d[1].y=0;
-        d[1].u=s1;
-        d[1].v=t0;
-
-        d[2].x=0;
-        d[2].y=fontHeight;
-        d[2].u=s0;
-        d[2].v=t1;
-        // load values for triangle two
-        d[3].x=0;
-        d[3].y=0+fontHeight;
-        d[3].u=s0;
-        d[3].v=t1;
-
-
-        d[4].x=fc.width;
-        d[4].y=0;
-        d[4].u=s1;
-        d[4].v=t0;
-
-
-        d[5].x=fc.width;
-        d[5].y=fontHeight;
-        d[5].u=s1;
-        d[5].v=t1;
-
-
-        // now we create a VAO to store the data
-        GLuint vao;//=VertexArrayObject::createVOA(GL_TRIANGLES);
-        glGenVertexArrays(1,&vao);
-        // bind it so we can set values
-        glBindVertexArray(vao);
-        // set the vertex data (2 for x,y 2 for u,v)
-        GLuint vbo;
-        glGenBuffers(1,&vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER,6*sizeof(textVertData),&d[0].x,GL_STATIC_DRAW);
-        // now we set the attribute pointer to be 0 (as this matches vertIn in our shader)
-        glVertexAttribPointer(0,2,GL_FLOAT,GL_FALSE,sizeof(textVertData),(GLvoid*)(0*sizeof(GL_FLOAT)));
-        glEnableVertexAttribArray(0);
-        // We can now create another set of data (which will be added to the VAO)
-        // in this case the UV co-ords
-        // now we set this as the 2nd attribute pointer (1) to match inUV in the shader
-        glVertexAttribPointer(1,2,GL_FLOAT,GL_FALSE,sizeof(textVertData),((float *)NULL + (2)));
-        glEnableVertexAttribArray(1);
-        // say how many indecis to be rendered
-        //vao->setNumIndices(6);
-
-        // now unbind
-        glBindBuffer(GL_ARRAY_BUFFER,0);
-        glBindVertexArray(0);
-        // store the vao pointer for later use in the draw method
-        fc.vao=vao;
-        widthVAO[width]=vao;
-    }
-    else
+  // set rgba image data
+  std::vector<unsigned char> data(atlasWidth*atlasHeight*4);
+  unsigned int index=0;
+  for(int row=0; row<atlasHeight; ++row)
+  {
+    const QRgb *line=reinterpret_cast<const QRgb *>(atlas.constScanLine(row));
+    for(int col=0; col<atlasWidth; ++col)
     {
-      fc.vao=widthVAO[width];
+      data[index++]=qRed(line[col]);
+      data[index++]=qGreen(line[col]);
+      data[index++]=qBlue(line[col]);
+      data[index++]=qAlpha(line[col]);
     }
-    // finally add the element to the map, this must be the last
-    // thing we do
-    m_characters[c]=fc;
   }
-  std::cout<<"created "<<widthVAO.size()<<" unique billboards\n";
+  glGenTextures(1, &m_atlasID);
+  glBindTexture(GL_TEXTURE_2D, m_atlasID);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, atlasWidth, atlasHeight,0, GL_RGBA, GL_UNSIGNED_BYTE, &data[0]);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // our strings are built into this buffer each time we draw them, it grows to fit the longest string we draw
+  m_vboSize=0;
+  glGenVertexArrays(1,&m_vao);
+  glBindVertexArray(m_vao);
+  glGenBuffers(1,&m_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  // now we set the attribute pointer to be 0 (as this matches vertIn in our shader)
+  glVertexAttribPointer(0,2,GL_FLOAT,GL_FALSE,sizeof(TextVertex),(GLvoid*)0);
+  glEnableVertexAttribArray(0);
+  // and our UV co-ords as the 2nd attribute pointer (1) to match inUV in the shader
+  glVertexAttribPointer(1,2,GL_FLOAT,GL_FALSE,sizeof(TextVertex),(GLvoid*)(2*sizeof(float)));
+  glEnableVertexAttribArray(1);
+  glBindBuffer(GL_ARRAY_BUFFER,0);
+  glBindVertexArray(0);
+
+  std::cout<<"created "<<atlasWidth<<"x"<<atlasHeight<<" glyph atlas\n";
   // set a default colour (black) incase user forgets
   this->setColour(0,0,0);
   this->setTransform(1.0,1.0);
@@ -255,13 +176,11 @@ Text::Text( const QFont &_f)
 //---------------------------------------------------------------------------
 Text::~Text()
 {
-  // our dtor should clear out the textures and remove the VAO's
-  foreach( FontChar m, m_characters)
-  {
-    glDeleteTextures(1,&m.textureID);
-    glDeleteBuffers(1,&m.vao);
-  }
-
+  // our dtor should clear out our atlas and remove our VAO
+  glDeleteTextures(1,&m_atlasID);
+  glDeleteBuffers(1,&m_vbo);
+  glDeleteVertexArrays(1,&m_vao);
+  delete m_textShader;
 }
 
 
@@ -270,53 +189,74 @@ Text::~Text()
 //---------------------------------------------------------------------------
 void Text::renderText( float _x, float _y,  const QString &text ) const
 {
+  // build a quad for each of our chars, relative to _x,_y
+  m_vertices.clear();
+  float x=0;
+  float y=0;
+  unsigned int textLength=text.length();
+  for (unsigned int i = 0; i < textLength; ++i)
+  {
+    // new lines go back to our start and down a line
+    if(text[i]==QChar('\n'))
+    {
+      x=0;
+      y+=m_lineHeight;
+      continue;
+    }
+    QHash<char,FontChar>::const_iterator it=m_characters.find(text[i].toLatin1());
+    if(it==m_characters.end()) continue;
+    const FontChar &f=it.value();
+    // two triangles with tex-cords as shown
+    //  s0/t0  ---- s1,t0
+    //         |\ |
+    //         | \|
+    //  s0,t1  ---- s1,t1
+    TextVertex quad[6]={{x,y,f.s0,f.t0},
+                        {x+f.width,y,f.s1,f.t0},
+                        {x,y+m_fontHeight,f.s0,f.t1},
+                        {x,y+m_fontHeight,f.s0,f.t1},
+                        {x+f.width,y,f.s1,f.t0},
+                        {x+f.width,y+m_fontHeight,f.s1,f.t1}};
+    m_vertices.insert(m_vertices.end(),quad,quad+6);
+    // finally move to the next glyph x position by incrementing
+    // by the width of the char
+    x+=f.width;
+  }
+  if(m_vertices.empty()) return;
+
   //activate ouf shader
   m_textShader->use();
   // make sure we are in texture unit 0 as this is what the
   // shader expects
-  //set our texture uniform
   glActiveTexture(GL_TEXTURE0);
-  GLuint texLoc = m_textShader->getUniformLoc("tex");
-  glUniform1f(texLoc,0);
-
+  glUniform1i(m_texLoc,0);
+  glUniform1f(m_xPosLoc,_x);
+  glUniform1f(m_yPosLoc,_y);
+  glBindTexture(GL_TEXTURE_2D, m_atlasID);
+
+  // upload our string, growing our buffer if it is too small
+  glBindVertexArray(m_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  GLsizeiptr size=m_vertices.size()*sizeof(TextVertex);
+  if(size>m_vboSize)
+  {
+    m_vboSize=size;
+    glBufferData(GL_ARRAY_BUFFER,m_vboSize,&m_vertices[0],GL_DYNAMIC_DRAW);
+  }
+  else
+  {
+    glBufferSubData(GL_ARRAY_BUFFER,0,size,&m_vertices[0]);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER,0);
 
-  GLuint yPosLoc = m_textShader->getUniformLoc("ypos");
-  // the y pos will always be the same so set it once for each
-  // string we are rendering
-  glUniform1f(yPosLoc,_y);
   // now enable blending and disable depth sorting so the font renders
   // correctly
   glEnable(GL_BLEND);
   glDisable(GL_DEPTH_TEST);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  //get the xPos location in our shader
-  GLuint xPosLoc = m_textShader->getUniformLoc("xpos");
-  // now loop for each of the char and draw our billboard
-
-  unsigned int textLength=text.length();
-
-  for (unsigned int i = 0; i < textLength; ++i)
-  {
-    // set the shader x position this will change each time
-    // we render a glyph by the width of the char
-    glUniform1f(xPosLoc,_x);
-    // so find the FontChar data for our current char
-//    FontChar f = m_characters[text[i].toAscii()];
-    FontChar f = m_characters[text[i].toLatin1()];
-
-    // bind the pre-generated texture
-    glBindTexture(GL_TEXTURE_2D, f.textureID);
-    // bind the vao
-    glBindVertexArray(f.vao);
-    // draw
-    glDrawArrays(GL_TRIANGLES,0,6);
-    // now unbind the vao
-    glBindVertexArray(0);
-    // finally move to the next glyph x position by incrementing
-    // by the width of the char just drawn
-    _x+=f.width;
-
-  }
+  // our whole string in one draw
+  glDrawArrays(GL_TRIANGLES,0,m_vertices.size());
+  glBindVertexArray(0);
   // finally disable the blend and re-enable depth sort
   glDisable(GL_BLEND);
   glEnable(GL_DEPTH_TEST);
@@ -335,10 +275,8 @@ void Text::setScreenSize(int _w, int _h )
   // so all we need to do is calculate the scale above and pass to shader every time the
   // screen dimensions change
   m_textShader->use();
-  GLuint scaleXLoc = m_textShader->getUniformLoc("scaleX");
-  GLuint scaleYLoc = m_textShader->getUniformLoc("scaleY");
-  glUniform1f(scaleXLoc,scaleX);
-  glUniform1f(scaleYLoc,scaleY);
+  glUniform1f(m_scaleXLoc,scaleX);
+  glUniform1f(m_scaleYLoc,scaleY);
 
 }
 
@@ -358,8 +296,7 @@ void Text::setColour(float _r,  float _g, float _b)
 
 
   m_textShader->use();
-  GLuint colLoc = m_textShader->getUniformLoc("textColour");
-  glUniform3f(colLoc,_r,_g,_b);
+  glUniform3f(m_colourLoc,_r,_g,_b);
 
 }
 
@@ -367,8 +304,7 @@ void Text::setTransform(float _x, float _y)
 {
 
   m_textShader->use();
-  GLuint transLoc = m_textShader->getUniformLoc("transform");
-  glUniform2f(transLoc,_x,_y);
+  glUniform2f(m_transformLoc,_x,_y);
 }
 
 
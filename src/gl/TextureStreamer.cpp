@@ -0,0 +1,191 @@
+#include "gl/TextureStreamer.h"
+#include <iostream>
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------------------------
+TextureStreamer::TextureStreamer(unsigned int _numBuffers, bool _allowPersistent) : m_texID(0),
+                                                                                   m_width(0),
+                                                                                   m_height(0),
+                                                                                   m_internalFormat(GL_RGBA32F),
+                                                                                   m_next(0),
+                                                                                   m_persistent(false),
+                                                                                   m_immutable(false),
+                                                                                   m_hasFrame(false),
+                                                                                   m_frameNumber(0),
+                                                                                   m_editVersion(0),
+                                                                                   m_cost(false)
+{
+#ifndef DARWIN
+    // Both are core from 4.4 and 4.2 but we only ask for a 4.1 context so check for the extensions
+    m_persistent = _allowPersistent && GLEW_ARB_buffer_storage;
+    m_immutable = GLEW_ARB_texture_storage;
+#endif
+    m_buffers.resize((_numBuffers) ? _numBuffers : 1);
+    for(unsigned int i=0;i<m_buffers.size();i++)
+    {
+        m_buffers[i].m_id = 0;
+        m_buffers[i].m_mapped = 0;
+        m_buffers[i].m_fence = 0;
+    }
+    std::cerr<<"TextureStreamer: "<<m_buffers.size()<<((m_persistent) ? " persistently mapped" : " orphaned")
+             <<" pixel buffers, "<<((m_immutable) ? "immutable" : "mutable")<<" texture storage"<<std::endl;
+}
+//----------------------------------------------------------------------------------------------------------------------
+TextureStreamer::~TextureStreamer()
+{
+    freeBuffers();
+    if(m_texID) glDeleteTextures(1,&m_texID);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void TextureStreamer::freeBuffers()
+{
+    for(unsigned int i=0;i<m_buffers.size();i++)
+    {
+        PixelBuffer &buffer = m_buffers[i];
+        if(buffer.m_fence) glDeleteSync(buffer.m_fence);
+        if(buffer.m_mapped)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER,buffer.m_id);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        if(buffer.m_id) glDeleteBuffers(1,&buffer.m_id);
+        buffer.m_id = 0;
+        buffer.m_mapped = 0;
+        buffer.m_fence = 0;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER,0);
+}
+//----------------------------------------------------------------------------------------------------------------------
+GLenum TextureStreamer::getPixelType(GLenum _internalFormat, unsigned int &_bytesPerPixel)
+{
+    switch(_internalFormat)
+    {
+        case(GL_RGBA16F): _bytesPerPixel = 8; return GL_HALF_FLOAT;
+        case(GL_RGBA8): _bytesPerPixel = 4; return GL_UNSIGNED_BYTE;
+        default: _bytesPerPixel = 16; return GL_FLOAT;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void TextureStreamer::allocate(unsigned int _width, unsigned int _height, GLenum _internalFormat)
+{
+    // Immutable storage can't be resized so start again with a new texture
+    if(m_texID) glDeleteTextures(1,&m_texID);
+    glGenTextures(1,&m_texID);
+    glBindTexture(GL_TEXTURE_2D,m_texID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    unsigned int bytesPerPixel;
+    GLenum type = getPixelType(_internalFormat,bytesPerPixel);
+#ifndef DARWIN
+    if(m_immutable)
+        glTexStorage2D(GL_TEXTURE_2D,1,_internalFormat,_width,_height);
+    else
+#endif
+        glTexImage2D(GL_TEXTURE_2D,0,_internalFormat,_width,_height,0,GL_RGBA,type,0);
+
+    freeBuffers();
+    GLsizeiptr size = (GLsizeiptr)_width*_height*bytesPerPixel;
+    for(unsigned int i=0;i<m_buffers.size();i++)
+    {
+        PixelBuffer &buffer = m_buffers[i];
+        glGenBuffers(1,&buffer.m_id);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER,buffer.m_id);
+#ifndef DARWIN
+        if(m_persistent)
+        {
+            // Coherent so our writes are visible to the GL without flushing, we only write so never read back
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_PIXEL_UNPACK_BUFFER,size,0,flags);
+            buffer.m_mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,0,size,flags);
+            continue;
+        }
+#endif
+        glBufferData(GL_PIXEL_UNPACK_BUFFER,size,0,GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER,0);
+    m_width = _width;
+    m_height = _height;
+    m_internalFormat = _internalFormat;
+    m_next = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void TextureStreamer::upload(const void *_pixels, unsigned int _width, unsigned int _height, GLenum _internalFormat)
+{
+    if(_width==0 || _height==0 || !_pixels) return;
+    // We no longer know which frame our texture holds
+    m_hasFrame = false;
+    if(_width!=m_width || _height!=m_height || _internalFormat!=m_internalFormat || !m_texID)
+        allocate(_width,_height,_internalFormat);
+
+    PixelBuffer &buffer = m_buffers[m_next];
+    m_next = (m_next+1)%m_buffers.size();
+    unsigned int bytesPerPixel;
+    GLenum type = getPixelType(_internalFormat,bytesPerPixel);
+    GLsizeiptr size = (GLsizeiptr)_width*_height*bytesPerPixel;
+    // Where our texture is read from, our bound buffer unless we have to fall back to our pixels
+    const GLvoid *source = 0;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER,buffer.m_id);
+    if(buffer.m_mapped)
+    {
+        // Our ring is deep enough that this only waits if the GL is several frames behind us
+        GLenum status = GL_ALREADY_SIGNALED;
+        if(buffer.m_fence) status = glClientWaitSync(buffer.m_fence,GL_SYNC_FLUSH_COMMANDS_BIT,GLuint64(1000000000));
+        if(status==GL_ALREADY_SIGNALED || status==GL_CONDITION_SATISFIED)
+        {
+            if(buffer.m_fence) glDeleteSync(buffer.m_fence);
+            buffer.m_fence = 0;
+            memcpy(buffer.m_mapped,_pixels,size);
+        }
+        else
+        {
+            // The GL may still be reading our buffer so writing to it would tear our texture. Our fence is kept for
+            // next time round and this frame is uploaded straight from our pixels, which the GL copies before returning.
+            std::cerr<<"TextureStreamer: pixel buffer still in use, uploading without it"<<std::endl;
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER,0);
+            source = _pixels;
+        }
+    }
+    else
+    {
+        // Orphan our buffer so the GL can hand us fresh memory rather than waiting for its last upload
+        glBufferData(GL_PIXEL_UNPACK_BUFFER,size,0,GL_STREAM_DRAW);
+        void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,0,size,GL_MAP_WRITE_BIT|GL_MAP_INVALIDATE_BUFFER_BIT);
+        if(!mapped)
+        {
+            std::cerr<<"TextureStreamer: could not map pixel buffer"<<std::endl;
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER,0);
+            return;
+        }
+        memcpy(mapped,_pixels,size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+
+    // 4 channel pixels so our rows are always 4 byte aligned, our pixels come from the start of our bound buffer
+    glBindTexture(GL_TEXTURE_2D,m_texID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT,4);
+    glTexSubImage2D(GL_TEXTURE_2D,0,0,0,_width,_height,GL_RGBA,type,source);
+    if(buffer.m_mapped && !source) buffer.m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE,0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER,0);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool TextureStreamer::upload(const DisplayFrame &_frame)
+{
+    if(_frame.isEmpty()) return false;
+    // Our resolved frames are already exposed, tonemapped and in sRGB so are uploaded as they are
+    GLenum internalFormat = GL_RGBA32F;
+    if(_frame.m_format==DisplayFrame::RGBA16F) internalFormat = GL_RGBA16F;
+    if(_frame.m_format==DisplayFrame::RGBA8) internalFormat = GL_RGBA8;
+    if(m_hasFrame && _frame.m_frameNumber==m_frameNumber && _frame.m_editVersion==m_editVersion &&
+       _frame.m_cost==m_cost && internalFormat==m_internalFormat) return false;
+
+    upload(_frame.getData(),_frame.m_width,_frame.m_height,internalFormat);
+    m_hasFrame = true;
+    m_frameNumber = _frame.m_frameNumber;
+    m_editVersion = _frame.m_editVersion;
+    m_cost = _frame.m_cost;
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
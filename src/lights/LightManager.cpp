@@ -3,6 +3,7 @@
 
 #include "LightManager.h"
 #include "PathTracerCore.h"
+#include "perf/PerfMetrics.h"
 #include <iostream>
 #include <QMessageBox>
 
@@ -215,9 +216,7 @@ void LightManager::createParollelogramLight()
 
 
     // Resize the light information buffer and copy back the data
-    m_lightBuffer->setSize((unsigned int)m_numLights+1);
-    memcpy(m_lightBuffer->map(), &(m_parallelogramLights[0]), m_parallelogramLights.size()*sizeof(ParallelogramLight));
-    m_lightBuffer->unmap();
+    queueLightUpload();
 
     // Add the transform-geometry node to the vector for use when drawing the light geometry
     m_geoAndTrans.push_back(tmpLight->getGeomAndTrans());
@@ -305,9 +304,7 @@ void LightManager::deleteLight()
 
         m_parallelogramLights.erase(m_parallelogramLights.begin()+m_selectedLight);
         std::cout<<"num lights "<<m_numLights<<std::endl;
-        m_lightBuffer->setSize((unsigned int)m_numLights);
-        memcpy(m_lightBuffer->map(), &(m_parallelogramLights[0]), m_parallelogramLights.size()*sizeof(ParallelogramLight));
-        m_lightBuffer->unmap();
+        queueLightUpload();
 
         m_geoAndTrans.erase(m_geoAndTrans.begin() + m_selectedLight);
 
@@ -326,13 +323,9 @@ void LightManager::updateLight()
     }
     else
     {
-        // Changes the light parameters for the actual light
-        // A pointer to the start of the buffer of lights
-
-        ParallelogramLight* lightBuffer = (ParallelogramLight*)m_lightBuffer->map();
-        lightBuffer[m_selectedLight].emission.x = m_emissionX->value();
-        lightBuffer[m_selectedLight].emission.y = m_emissionY->value();
-        lightBuffer[m_selectedLight].emission.z = m_emissionZ->value();
+        // Changes the light parameters in our host copy of the lights.
+        // The device buffer is only touched when our queued upload is applied by the renderer.
+        ParallelogramLight &light = m_parallelogramLights[m_selectedLight];
 
         glm::mat4 rotx = glm::mat4(1.0);
         glm::mat4 roty = glm::mat4(1.0);
@@ -348,19 +341,6 @@ void LightManager::updateLight()
         roty = glm::rotate(roty, (float)m_rotateY->value()*DtoR, glm::vec3(0.0, 1.0, 0.0));
         rotz = glm::rotate(rotz, (float)m_rotateZ->value()*DtoR, glm::vec3(0.0, 0.0, 1.0));
 
-        glm::vec4 corner;
-        glm::vec4 v1;
-        glm::vec4 v2;
-        corner.x = lightBuffer[m_selectedLight].corner.x;
-        corner.y = lightBuffer[m_selectedLight].corner.y;
-        corner.z = lightBuffer[m_selectedLight].corner.z;
-        v1.x = lightBuffer[m_selectedLight].v1.x;
-        v1.y = lightBuffer[m_selectedLight].v1.y;
-        v1.z = lightBuffer[m_selectedLight].v1.z;
-        v2.x = lightBuffer[m_selectedLight].v2.x;
-        v2.y = lightBuffer[m_selectedLight].v2.y;
-        v2.z = lightBuffer[m_selectedLight].v2.z;
-
         glm::vec3 point1;
         glm::vec3 point2;
         glm::vec3 point3;
@@ -379,26 +359,11 @@ void LightManager::updateLight()
         point2 = glm::vec3(m_transGlobal * transform * glm::vec4(-0.5, 0.0, -0.5, 1.0));
         point3 = glm::vec3(m_transGlobal * transform * glm::vec4(0.5, 0.0, 0.5, 1.0));
 
-        lightBuffer[m_selectedLight].corner.x = point1.x;
-        lightBuffer[m_selectedLight].corner.y = point1.y;
-        lightBuffer[m_selectedLight].corner.z = point1.z;
-
-        lightBuffer[m_selectedLight].v1.x = (point2.x - lightBuffer[m_selectedLight].corner.x);
-        lightBuffer[m_selectedLight].v1.y = (point2.y - lightBuffer[m_selectedLight].corner.y);
-        lightBuffer[m_selectedLight].v1.z = (point2.z - lightBuffer[m_selectedLight].corner.z);
-
-        lightBuffer[m_selectedLight].v2.x = (point3.x - lightBuffer[m_selectedLight].corner.x);
-        lightBuffer[m_selectedLight].v2.y = (point3.y - lightBuffer[m_selectedLight].corner.y);
-        lightBuffer[m_selectedLight].v2.z = (point3.z - lightBuffer[m_selectedLight].corner.z);
-
-        lightBuffer[m_selectedLight].normal = normalize(-cross(lightBuffer[m_selectedLight].v1, lightBuffer[m_selectedLight].v2));
-
-        m_lightBuffer->unmap();
-
-        m_parallelogramLights[m_selectedLight].corner = optix::make_float3(point1.x,point1.y,point1.z);
-        m_parallelogramLights[m_selectedLight].v1 = optix::make_float3((point2 - point1).x, (point2 - point1).y, (point2 - point1).z);
-        m_parallelogramLights[m_selectedLight].v2 = optix::make_float3((point3 - point1).x, (point3 - point1).y, (point3 - point1).z);
-        m_parallelogramLights[m_selectedLight].emission = optix::make_float3(m_emissionX->value(), m_emissionY->value(), m_emissionZ->value());
+        light.corner = optix::make_float3(point1.x,point1.y,point1.z);
+        light.v1 = optix::make_float3((point2 - point1).x, (point2 - point1).y, (point2 - point1).z);
+        light.v2 = optix::make_float3((point3 - point1).x, (point3 - point1).y, (point3 - point1).z);
+        light.normal = normalize(-cross(light.v1, light.v2));
+        light.emission = optix::make_float3(m_emissionX->value(), m_emissionY->value(), m_emissionZ->value());
 
         // Update the vector to store transforms
         LightTransforms lightTrans;
@@ -408,18 +373,35 @@ void LightManager::updateLight()
         lightTrans.m_emission = glm::vec3(m_emissionX->value(), m_emissionY->value(), m_emissionZ->value());
         m_lightTransforms[m_selectedLight]= lightTrans;
 
-        // Translate the optix::Translate node using the new transform matrix
-        setTrans(m_geoAndTrans[m_selectedLight], transform);
-
-        // Changes the emission paramters for the light
-        m_geoAndTrans[m_selectedLight]->getChild<optix::GeometryGroup>()->getChild(0)["emission_color"]->setFloat(m_emissionX->value(), m_emissionY->value(), m_emissionZ->value());
+        // Translate the optix::Translate node using the new transform matrix and change the
+        // emission paramters of the light geometry. Merged with any pending change to this light.
+        optix::Transform geoAndTrans = m_geoAndTrans[m_selectedLight];
+        optix::float3 emission = light.emission;
+        PathTracerScene::getInstance()->getEditQueue()->push(geoAndTrans.get(),SceneEditQueue::Transform,[=](){
+            setTrans(geoAndTrans, transform);
+            geoAndTrans->getChild<optix::GeometryGroup>()->getChild(0)["emission_color"]->setFloat(emission);
+        },true);
 
-        // Update accelleration structure
-        PathTracerScene::getInstance()->cleanTopAcceleration();
+        queueLightUpload();
         updateScene();
     }
 }
 //------------------------------------------------------------------------------------------------------------------------------------
+void LightManager::queueLightUpload()
+{
+    // Take a copy of our lights so the GUI can keep editing them while the upload is pending.
+    // Any upload still waiting to be applied is replaced so we map the buffer at most once per frame.
+    optix::Buffer lightBuffer = m_lightBuffer;
+    std::vector<ParallelogramLight> lights = m_parallelogramLights;
+    PathTracerScene::getInstance()->getEditQueue()->push(this,SceneEditQueue::Lights,[=](){
+        lightBuffer->setSize(lights.size());
+        if(lights.empty()) return;
+        PerfScopedTimer timer(PerfMetrics::BufferUpload);
+        memcpy(lightBuffer->map(), &lights[0], lights.size()*sizeof(ParallelogramLight));
+        lightBuffer->unmap();
+    });
+}
+//------------------------------------------------------------------------------------------------------------------------------------
 void LightManager::transformLights(glm::mat4 _trans)
 {
     m_transGlobal = _trans;
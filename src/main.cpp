@@ -2,25 +2,211 @@
 #include <QFile>
 #include "ui/mainwindow.h"
 #include <QSplashScreen>
+#include "perf/TraceEvents.h"
+#include "perf/RenderBenchmark.h"
+#include "perf/ScalingBenchmark.h"
+#include "perf/InteractionRecorder.h"
+#include "perf/InteractionReplay.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QStringList>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief runs our render benchmark or records convergence curves without any windows
+/// @param argc - number of arguments (int)
+/// @param argv - our arguments, including --bench or --convergence (char**)
+/// @returns exit code (int)
+//----------------------------------------------------------------------------------------------------------------------
+int runBenchmark(int argc, char **argv)
+{
+    QCoreApplication app(argc,argv);
+    RenderBenchmark::Settings settings = RenderBenchmark::defaultSettings();
+    std::string output = "bench_results.json";
+    bool convergence = false;
+    for(int i=1;i<argc;i++)
+    {
+        bool hasValue = (i+1<argc);
+        if(std::strcmp(argv[i],"--bench")==0)
+        {
+            if(hasValue && argv[i+1][0]!='-') output = argv[++i];
+        }
+        else if(std::strcmp(argv[i],"--convergence")==0)
+        {
+            convergence = true;
+            output = "convergence.csv";
+            if(hasValue && argv[i+1][0]!='-') output = argv[++i];
+        }
+        else if(std::strcmp(argv[i],"--bench-size")==0 && hasValue)
+        {
+            unsigned int w,h;
+            if(std::sscanf(argv[++i],"%ux%u",&w,&h)==2){settings.m_width = w; settings.m_height = h;}
+        }
+        else if(std::strcmp(argv[i],"--bench-spp")==0 && hasValue) settings.m_targetSpp = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i],"--bench-reference-spp")==0 && hasValue) settings.m_referenceSpp = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i],"--bench-max-spp")==0 && hasValue) settings.m_maxSpp = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i],"--bench-rmse")==0 && hasValue) settings.m_targetRMSE = std::atof(argv[++i]);
+        else if(std::strcmp(argv[i],"--bench-rr-depth")==0 && hasValue) settings.m_rrBeginDepth = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i],"--bench-max-depth")==0 && hasValue) settings.m_maxDepth = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i],"--bench-killeroo")==0 && hasValue) settings.m_killerooPath = argv[++i];
+        else if(std::strcmp(argv[i],"--bench-scan")==0 && hasValue) settings.m_scanPath = argv[++i];
+        else if(std::strcmp(argv[i],"--bench-hdri")==0 && hasValue) settings.m_hdriPath = argv[++i];
+        else if(std::strcmp(argv[i],"--bench-references")==0 && hasValue) settings.m_referenceDir = argv[++i];
+        else if(std::strcmp(argv[i],"--bench-checkpoints")==0 && hasValue)
+        {
+            // Comma separated render times in milliseconds
+            settings.m_checkpointsMs.clear();
+            QStringList checkpoints = QString(argv[++i]).split(",",QString::SkipEmptyParts);
+            for(int c=0;c<checkpoints.size();c++) settings.m_checkpointsMs.push_back(checkpoints[c].toDouble());
+        }
+    }
+    if(settings.m_maxSpp<settings.m_targetSpp) settings.m_maxSpp = settings.m_targetSpp;
+    if(!settings.m_referenceDir.empty()) QDir().mkpath(QString::fromStdString(settings.m_referenceDir));
+
+    RenderBenchmark benchmark(settings);
+    bool written;
+    if(convergence)
+    {
+        benchmark.runConvergence();
+        written = benchmark.writeConvergence(output);
+    }
+    else
+    {
+        benchmark.run();
+        written = benchmark.writeJSON(output);
+    }
+    if(written) std::cerr<<"Benchmark results written to "<<output<<std::endl;
+    TraceEvents::getInstance()->flush();
+    return (written) ? 0 : 1;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief runs our procedural scene scaling sweeps without any windows
+/// @param argc - number of arguments (int)
+/// @param argv - our arguments, including --scaling (char**)
+/// @returns exit code (int)
+//----------------------------------------------------------------------------------------------------------------------
+int runScaling(int argc, char **argv)
+{
+    QCoreApplication app(argc,argv);
+    ScalingBenchmark::Settings settings = ScalingBenchmark::defaultSettings();
+    std::string output = "scaling.csv";
+    for(int i=1;i<argc;i++)
+    {
+        bool hasValue = (i+1<argc);
+        if(std::strcmp(argv[i],"--scaling")==0)
+        {
+            if(hasValue && argv[i+1][0]!='-') output = argv[++i];
+        }
+        else if(std::strcmp(argv[i],"--bench-size")==0 && hasValue)
+        {
+            unsigned int w,h;
+            if(std::sscanf(argv[++i],"%ux%u",&w,&h)==2){settings.m_width = w; settings.m_height = h;}
+        }
+        else if(std::strcmp(argv[i],"--scaling-frames")==0 && hasValue) settings.m_numFrames = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i],"--scaling-max-triangles")==0 && hasValue) settings.m_maxTriangles = std::strtoull(argv[++i],0,10);
+        else if(std::strcmp(argv[i],"--scaling-max-lights")==0 && hasValue) settings.m_maxLights = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i],"--scaling-max-instances")==0 && hasValue) settings.m_maxInstances = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i],"--scaling-spheres")==0 && hasValue) settings.m_scene.m_numSpheres = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i],"--scaling-seed")==0 && hasValue) settings.m_scene.m_seed = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i],"--scaling-distribution")==0 && hasValue)
+        {
+            ++i;
+            if(std::strcmp(argv[i],"clustered")==0) settings.m_scene.m_distribution = SceneGenerator::Clustered;
+            else if(std::strcmp(argv[i],"planar")==0) settings.m_scene.m_distribution = SceneGenerator::Planar;
+            else settings.m_scene.m_distribution = SceneGenerator::Uniform;
+        }
+    }
+
+    ScalingBenchmark benchmark(settings);
+    benchmark.run();
+    bool written = benchmark.writeCSV(output);
+    if(written) std::cerr<<"Scaling results written to "<<output<<std::endl;
+    TraceEvents::getInstance()->flush();
+    return (written) ? 0 : 1;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief replays an interaction recorded with PHENIX_RECORD without any windows and measures its latency
+/// @param argc - number of arguments (int)
+/// @param argv - our arguments, including --replay (char**)
+/// @returns exit code (int)
+//----------------------------------------------------------------------------------------------------------------------
+int runReplay(int argc, char **argv)
+{
+    QCoreApplication app(argc,argv);
+    std::string recording;
+    std::string output = "replay_results.json";
+    for(int i=1;i<argc;i++)
+    {
+        bool hasValue = (i+1<argc);
+        if(std::strcmp(argv[i],"--replay")==0 && hasValue) recording = argv[++i];
+        else if(std::strcmp(argv[i],"--replay-out")==0 && hasValue) output = argv[++i];
+    }
+    if(recording.empty())
+    {
+        std::cerr<<"Usage: --replay <recording> [--replay-out <results.json>]"<<std::endl;
+        return 1;
+    }
+
+    InteractionReplay replay;
+    bool written = replay.run(recording) && replay.writeJSON(output);
+    if(written) std::cerr<<"Replay results written to "<<output<<std::endl;
+    TraceEvents::getInstance()->flush();
+    return (written) ? 0 : 1;
+}
+//----------------------------------------------------------------------------------------------------------------------
 
 int main(int argc, char **argv)
 {
+    TraceEvents *trace = TraceEvents::getInstance();
+    trace->setThreadName("GUI");
+
+    // Run our benchmark instead of our ui if asked to
+    for(int i=1;i<argc;i++)
+    {
+        if(std::strcmp(argv[i],"--bench")==0 || std::strcmp(argv[i],"--convergence")==0) return runBenchmark(argc,argv);
+        if(std::strcmp(argv[i],"--scaling")==0) return runScaling(argc,argv);
+        if(std::strcmp(argv[i],"--replay")==0) return runReplay(argc,argv);
+    }
+
     QApplication app(argc,argv);
 
     //create our loading screen to give the user something to look at while everything loads
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
     QPixmap loadingPicture("./images/phenix_red.png");
     QSplashScreen loadingScreen(loadingPicture.scaled(400,400),Qt::WindowStaysOnTopHint);
     loadingScreen.show();
     loadingScreen.setMaximumSize(QSize(400,400));
+    trace->addEvent("splash screen","startup",start,std::chrono::steady_clock::now());
 
     // Create our mainwindow
+    start = std::chrono::steady_clock::now();
     MainWindow w;
+    trace->addEvent("create main window","startup",start,std::chrono::steady_clock::now());
+    // Checkpoint our render so it can be resumed if we are killed, resuming straight away if our checkpoint exists
+    QString checkpoint;
+    int checkpointInterval = 300;
+    for(int i=1;i<argc;i++)
+    {
+        bool hasValue = (i+1<argc);
+        if(std::strcmp(argv[i],"--checkpoint")==0 && hasValue) checkpoint = argv[++i];
+        else if(std::strcmp(argv[i],"--checkpoint-interval")==0 && hasValue) checkpointInterval = std::atoi(argv[++i]);
+    }
+    if(!checkpoint.isEmpty()) w.setCheckpoint(checkpoint,checkpointInterval);
     QFile file("styleSheet/darkOrange");
     file.open(QFile::ReadOnly);
     QString stylesheet = QLatin1String(file.readAll());
     w.setStyleSheet(stylesheet);
     w.setWindowTitle(QString("Phenix"));
+    start = std::chrono::steady_clock::now();
     w.show();
     loadingScreen.hide();
+    trace->addEvent("show main window","startup",start,std::chrono::steady_clock::now());
     app.exec();
+
+    // Write out everything we recorded if PHENIX_TRACE or PHENIX_RECORD are set
+    trace->flush();
+    InteractionRecorder::getInstance()->flush();
 }
@@ -0,0 +1,416 @@
+#include "perf/CostMap.h"
+#include "common/intersect.h"
+#include "common/random.h"
+#include "common/ParallelFor.h"
+#include <algorithm>
+#include <cmath>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief smallest number of rows worth giving a thread of their own
+//----------------------------------------------------------------------------------------------------------------------
+static const unsigned int g_rowGrain = 4;
+
+//----------------------------------------------------------------------------------------------------------------------
+const char *CostMap::getCounterName(Counter _counter, bool _gpu)
+{
+    switch(_counter)
+    {
+        case(PrimitivesTested): return "primitives tested";
+        case(NodesVisited): return (_gpu) ? "kilocycles" : "BVH nodes visited";
+        case(PathLength): return "path length";
+        case(ShadowRays): return "shadow rays";
+        default: return "unknown";
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+optix::float3 CostMap::heatMapColour(float _t)
+{
+    // Keep in sync with heatMapColour in shaders/pathTraceFrag.frag
+    float x = std::min(std::max(_t,0.f),1.f);
+    float x2 = x*x;
+    float x3 = x2*x;
+    float x4 = x2*x2;
+    float x5 = x4*x;
+    float r = 0.13572138f + 4.61539260f*x - 42.66032258f*x2 + 132.13108234f*x3 - 152.94239396f*x4 + 59.28637943f*x5;
+    float g = 0.09140261f + 2.19418839f*x + 4.84296658f*x2 - 14.18503333f*x3 + 4.27729857f*x4 + 2.82956604f*x5;
+    float b = 0.10667330f + 12.64194608f*x - 60.58204836f*x2 + 110.36276771f*x3 - 89.90310912f*x4 + 27.34824973f*x5;
+    return optix::make_float3(std::min(std::max(r,0.f),1.f),std::min(std::max(g,0.f),1.f),std::min(std::max(b,0.f),1.f));
+}
+//----------------------------------------------------------------------------------------------------------------------
+float CostMap::getMax(const DisplayFrame &_cost, Counter _counter)
+{
+    float max = 0.f;
+    for(unsigned int i=_counter;i<_cost.m_pixels.size();i+=4) max = std::max(max,_cost.m_pixels[i]);
+    return max;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void CostMap::toHeatMap(const DisplayFrame &_cost, Counter _counter, DisplayFrame &_image, float _max)
+{
+    if(_max<=0.f) _max = getMax(_cost,_counter);
+    float scale = (_max>0.f) ? 1.f/std::log(1.f+_max) : 0.f;
+    _image = _cost;
+    _image.m_cost = false;
+    for(unsigned int i=0;i+3<_image.m_pixels.size();i+=4)
+    {
+        optix::float3 colour = heatMapColour(std::log(1.f+_cost.m_pixels[i+_counter])*scale);
+        _image.m_pixels[i+0] = colour.x;
+        _image.m_pixels[i+1] = colour.y;
+        _image.m_pixels[i+2] = colour.z;
+        _image.m_pixels[i+3] = 1.f;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+CostMap::CostMap() : m_dirty(false), m_sqrtNumSamples(2u), m_rrBeginDepth(1u), m_maxDepth(16u), m_sceneEpsilon(1.e-3f)
+{
+    setFilter(Film::Box);
+    // The default camera of our path tracer
+    setCamera(optix::make_float3(278.0f,273.0f,-900.0f),optix::make_float3(278.0f,273.0f,0.0f),
+              optix::make_float3(0.0f,1.0f,0.0f),35.f,35.f);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void CostMap::setCamera(const optix::float3 &_eye, const optix::float3 &_lookat, const optix::float3 &_up, float _hfov, float _vfov)
+{
+    // The same vectors as PathTraceCamera::calcVectors
+    const float DtoR = 3.14159265358979323846f/180.f;
+    m_eye = _eye;
+    m_W = _lookat - _eye;
+    float lookdirLen = optix::length(m_W);
+    m_U = optix::normalize(optix::cross(m_W,_up));
+    m_V = optix::normalize(optix::cross(m_U,m_W));
+    m_U = m_U * (lookdirLen*std::tan(_hfov*0.5f*DtoR));
+    m_V = m_V * (lookdirLen*std::tan(_vfov*0.5f*DtoR));
+}
+//----------------------------------------------------------------------------------------------------------------------
+void CostMap::setCamera(const optix::float3 &_eye, const optix::float3 &_U, const optix::float3 &_V, const optix::float3 &_W)
+{
+    m_eye = _eye;
+    m_U = _U;
+    m_V = _V;
+    m_W = _W;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void CostMap::addTriangle(const optix::float3 &_p0, const optix::float3 &_p1, const optix::float3 &_p2,
+                          const optix::float3 &_diffuse, const optix::float3 &_emission)
+{
+    Triangle tri;
+    tri.m_p0 = _p0;
+    tri.m_p1 = _p1;
+    tri.m_p2 = _p2;
+    tri.m_diffuse = _diffuse;
+    tri.m_emission = _emission;
+    tri.m_emitter = (_emission.x>0.f || _emission.y>0.f || _emission.z>0.f);
+    m_triangles.push_back(tri);
+    m_dirty = true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void CostMap::addParallelogram(const optix::float3 &_anchor, const optix::float3 &_v1, const optix::float3 &_v2,
+                               const optix::float3 &_diffuse, const optix::float3 &_emission)
+{
+    addTriangle(_anchor,_anchor+_v1,_anchor+_v1+_v2,_diffuse,_emission);
+    addTriangle(_anchor,_anchor+_v1+_v2,_anchor+_v2,_diffuse,_emission);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void CostMap::loadCornellBox()
+{
+    ParallelogramLight light;
+    light.corner   = optix::make_float3( 418.0f, 548.6f, 152.0f);
+    light.v1       = optix::make_float3( -260.0f, 0.0f, 0.0f);
+    light.v2       = optix::make_float3( 0.0f, 0.0f, 105.0f);
+    light.normal   = optix::normalize( optix::cross(light.v1, light.v2) );
+    light.emission = optix::make_float3( 15.0f, 15.0f, 15.0f );
+    setLights(std::vector<ParallelogramLight>(1,light));
+
+    const optix::float3 white = optix::make_float3( 0.9f, 0.9f, 0.9f );
+    const optix::float3 green = optix::make_float3( 0.05f, 0.8f, 0.05f );
+    const optix::float3 red   = optix::make_float3( 0.8f, 0.05f, 0.05f );
+    const optix::float3 light_em = optix::make_float3( 15.0f, 15.0f, 5.0f );
+
+    // Our unit parallelograms once they have been scaled, rotated and positioned
+    const optix::float3 x = optix::make_float3(556.f,0.f,0.f);
+    const optix::float3 y = optix::make_float3(0.f,556.f,0.f);
+    const optix::float3 z = optix::make_float3(0.f,0.f,559.2f);
+    // Floor and ceiling
+    addParallelogram(optix::make_float3(0.f,0.f,0.f),z,x,white);
+    addParallelogram(optix::make_float3(0.f,548.8f,0.f),z,x,white);
+    // Back wall
+    addParallelogram(optix::make_float3(0.f,0.f,559.2f),optix::make_float3(0.f,559.2f,0.f),x,white);
+    // Right and left walls
+    addParallelogram(optix::make_float3(0.f,-3.6f,0.f),z,y,green);
+    addParallelogram(optix::make_float3(556.f,-3.6f,0.f),z,y,red);
+    // Light
+    addParallelogram(optix::make_float3(148.f,548.6f,174.6f),optix::make_float3(0.f,0.f,210.f),
+                     optix::make_float3(260.f,0.f,0.f),optix::make_float3(0.f),light_em);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void CostMap::build()
+{
+    m_nodes.clear();
+    m_dirty = false;
+    if(m_triangles.empty()) return;
+    m_nodes.reserve(2*m_triangles.size());
+    m_nodes.push_back(Node());
+    buildNode(0,0,m_triangles.size());
+}
+//----------------------------------------------------------------------------------------------------------------------
+void CostMap::buildNode(unsigned int _node, unsigned int _first, unsigned int _count)
+{
+    // Bounds of our triangles and of their centroids
+    optix::float3 bmin = m_triangles[_first].m_p0, bmax = bmin;
+    optix::float3 cmin = optix::make_float3(1e30f), cmax = optix::make_float3(-1e30f);
+    for(unsigned int i=_first;i<_first+_count;i++)
+    {
+        const Triangle &tri = m_triangles[i];
+        bmin = optix::fminf(bmin,optix::fminf(tri.m_p0,optix::fminf(tri.m_p1,tri.m_p2)));
+        bmax = optix::fmaxf(bmax,optix::fmaxf(tri.m_p0,optix::fmaxf(tri.m_p1,tri.m_p2)));
+        optix::float3 c = (tri.m_p0+tri.m_p1+tri.m_p2)/3.f;
+        cmin = optix::fminf(cmin,c);
+        cmax = optix::fmaxf(cmax,c);
+    }
+    m_nodes[_node].m_min = bmin;
+    m_nodes[_node].m_max = bmax;
+    m_nodes[_node].m_first = _first;
+    m_nodes[_node].m_count = _count;
+    m_nodes[_node].m_axis = 0;
+    if(_count<=m_maxLeafSize) return;
+
+    // Median split along the longest axis of our centroids
+    optix::float3 extent = cmax-cmin;
+    unsigned int axis = (extent.x>extent.y && extent.x>extent.z) ? 0 : ((extent.y>extent.z) ? 1 : 2);
+    if(optix::getByIndex(extent,axis)<=0.f) return;
+    unsigned int half = _count/2;
+    std::nth_element(m_triangles.begin()+_first,m_triangles.begin()+_first+half,m_triangles.begin()+_first+_count,
+                     [axis](const Triangle &_a, const Triangle &_b)
+                     {
+                         return optix::getByIndex(_a.m_p0+_a.m_p1+_a.m_p2,axis) < optix::getByIndex(_b.m_p0+_b.m_p1+_b.m_p2,axis);
+                     });
+
+    unsigned int left = m_nodes.size();
+    m_nodes.push_back(Node());
+    m_nodes.push_back(Node());
+    m_nodes[_node].m_first = left;
+    m_nodes[_node].m_count = 0;
+    m_nodes[_node].m_axis = axis;
+    buildNode(left,_first,half);
+    buildNode(left+1,_first+half,_count-half);
+}
+//----------------------------------------------------------------------------------------------------------------------
+int CostMap::trace(const optix::float3 &_o, const optix::float3 &_d, float _tmin, float _tmax, bool _anyHit,
+                   Counters &_counters, float &_t)
+{
+    int hit = -1;
+    _t = _tmax;
+    if(m_nodes.empty()) return hit;
+    optix::float3 invD = optix::make_float3(1.f/_d.x,1.f/_d.y,1.f/_d.z);
+    unsigned int stack[64];
+    unsigned int stackSize = 0;
+    stack[stackSize++] = 0;
+    while(stackSize)
+    {
+        const Node &node = m_nodes[stack[--stackSize]];
+        _counters.m_nodes++;
+
+        // Slab test against the bounds of our node
+        optix::float3 t0 = (node.m_min-_o)*invD;
+        optix::float3 t1 = (node.m_max-_o)*invD;
+        optix::float3 tnear = optix::fminf(t0,t1);
+        optix::float3 tfar = optix::fmaxf(t0,t1);
+        float enter = std::max(std::max(tnear.x,tnear.y),std::max(tnear.z,_tmin));
+        float exit = std::min(std::min(tfar.x,tfar.y),std::min(tfar.z,_t));
+        if(enter>exit) continue;
+
+        if(node.m_count)
+        {
+            for(unsigned int i=node.m_first;i<node.m_first+node.m_count;i++)
+            {
+                _counters.m_primitives++;
+                const Triangle &tri = m_triangles[i];
+                optix::float3 n;
+                float t, beta, gamma;
+                if(!intersectTriangle(_o,_d,_tmin,_t,tri.m_p0,tri.m_p1,tri.m_p2,n,t,beta,gamma)) continue;
+                // Our lights have no any hit program for shadow rays so they don't cast shadows
+                if(_anyHit && tri.m_emitter) continue;
+                _t = t;
+                hit = i;
+                if(_anyHit) return hit;
+            }
+        }
+        else
+        {
+            // Visit our nearest child first so we can cull the other against our closest hit
+            bool flip = optix::getByIndex(_d,node.m_axis)<0.f;
+            stack[stackSize++] = node.m_first + ((flip) ? 0 : 1);
+            stack[stackSize++] = node.m_first + ((flip) ? 1 : 0);
+        }
+    }
+    return hit;
+}
+//----------------------------------------------------------------------------------------------------------------------
+optix::float3 CostMap::tracePath(optix::float3 _o, optix::float3 _d, RandomStream &_rng, Counters &_counters,
+                                 unsigned int &_segments, unsigned int &_shadowRays)
+{
+    optix::float3 result = optix::make_float3(0.f);
+    optix::float3 attenuation = optix::make_float3(1.f);
+    unsigned int depth = 0;
+    for(;;)
+    {
+        float t;
+        int hit = trace(_o,_d,m_sceneEpsilon,1e30f,false,_counters,t);
+        _segments++;
+        // Our background is black and our lights are only seen directly, the rest of their light is our NEE
+        if(hit<0) break;
+        if(m_triangles[hit].m_emitter)
+        {
+            if(depth==0) result += m_triangles[hit].m_emission*attenuation;
+            break;
+        }
+
+        const Triangle &tri = m_triangles[hit];
+        optix::float3 n = optix::normalize(optix::cross(tri.m_p0-tri.m_p2,tri.m_p1-tri.m_p0));
+        optix::float3 ffnormal = optix::faceforward(n,-_d,n);
+        optix::float3 hitpoint = _o + t*_d;
+
+        float z1 = rnd(_rng);
+        float z2 = rnd(_rng);
+        optix::float3 p;
+        optix::cosine_sample_hemisphere(z1,z2,p);
+        optix::Onb onb(ffnormal);
+        onb.inverse_transform(p);
+        attenuation = attenuation*tri.m_diffuse;
+
+        // Next event estimation
+        optix::float3 radiance = optix::make_float3(0.f);
+        for(unsigned int l=0;l<m_lights.size();l++)
+        {
+            const ParallelogramLight &light = m_lights[l];
+            const float lz1 = rnd(_rng);
+            const float lz2 = rnd(_rng);
+            const optix::float3 lightPos = light.corner + light.v1*lz1 + light.v2*lz2;
+            const float Ldist = optix::length(lightPos-hitpoint);
+            const optix::float3 L = optix::normalize(lightPos-hitpoint);
+            const float nDl = optix::dot(ffnormal,L);
+            const float LnDl = optix::dot(light.normal,L);
+            if(nDl>0.f && LnDl>0.f)
+            {
+                float shadowT;
+                int occluder = trace(hitpoint,L,m_sceneEpsilon,Ldist-m_sceneEpsilon,true,_counters,shadowT);
+                _shadowRays++;
+                if(occluder<0)
+                {
+                    const float A = optix::length(optix::cross(light.v1,light.v2));
+                    radiance += light.emission*(nDl*LnDl*A/(M_PIf*Ldist*Ldist));
+                }
+            }
+        }
+
+        // Russian roulette termination
+        if(depth>=m_rrBeginDepth)
+        {
+            float pcont = optix::fmaxf(attenuation);
+            if(rnd(_rng)>=pcont) break;
+            attenuation = attenuation/pcont;
+        }
+        depth++;
+        result += radiance*attenuation;
+        if(depth>=m_maxDepth) break;
+        _o = hitpoint;
+        _d = p;
+    }
+    return result;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void CostMap::setFilter(Film::Filter _filter, float _radius)
+{
+    if(_radius<=0.f) _radius = Film::getDefaultRadius(_filter);
+    Film::buildSampleTable(_filter,std::min(_radius,Film::m_maxRadius),m_filterTable);
+}
+//----------------------------------------------------------------------------------------------------------------------
+float CostMap::sampleFilter(float _u)
+{
+    float f = _u*FILM_FILTER_TABLE_SIZE;
+    int i = std::min((int)f,FILM_FILTER_TABLE_SIZE-1);
+    return m_filterTable[i]+(m_filterTable[i+1]-m_filterTable[i])*(f-i);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void CostMap::render(unsigned int _width, unsigned int _height, DisplayFrame &_cost, unsigned int _frameNumber)
+{
+    if(m_dirty) build();
+    _cost.m_width = _width;
+    _cost.m_height = _height;
+    _cost.m_frameNumber = _frameNumber;
+    _cost.m_cost = true;
+    _cost.m_pixels.assign(_width*_height*4,0.f);
+
+    // The same loop as pathtrace_camera in path_tracer.cu. Our random numbers are keyed by pixel and sample rather
+    // than carried from one pixel to the next so our rows can be split across threads and still match our GPU.
+    optix::float2 invScreen = optix::make_float2(2.f/_width,2.f/_height);
+    unsigned int spp = m_sqrtNumSamples*m_sqrtNumSamples;
+    unsigned int firstSample = _frameNumber*spp;
+    parallelFor(_height,g_rowGrain,[&](unsigned int _begin, unsigned int _end, unsigned int)
+    {
+        for(unsigned int i=_begin*_width;i<_end*_width;i++)
+        {
+            unsigned int px = i%_width;
+            unsigned int py = i/_width;
+            optix::float2 pixel = optix::make_float2((float)px,(float)py)*invScreen - 1.f;
+            Counters counters = {0,0};
+            unsigned int segments = 0;
+            unsigned int shadowRays = 0;
+            for(unsigned int s=spp;s>0;s--)
+            {
+                // A stratified position in our pixel warped by our filter into an offset from its centre
+                unsigned int stratum = s-1;
+                RandomStream rng = sample_stream(_width*py+px,firstSample+stratum,0u);
+                float jx = rnd(rng);
+                float jy = rnd(rng);
+                optix::float2 u = optix::make_float2(stratum%m_sqrtNumSamples+jx,stratum/m_sqrtNumSamples+jy)/(float)m_sqrtNumSamples;
+                optix::float2 offset = optix::make_float2(sampleFilter(u.x),sampleFilter(u.y));
+                optix::float2 d = pixel + (offset+0.5f)*invScreen;
+                optix::float3 direction = optix::normalize(d.x*m_U + d.y*m_V + m_W);
+                tracePath(m_eye,direction,rng,counters,segments,shadowRays);
+            }
+
+            float *cost = &_cost.m_pixels[i*4];
+            cost[PrimitivesTested] = (float)counters.m_primitives/spp;
+            cost[NodesVisited] = (float)counters.m_nodes/spp;
+            cost[PathLength] = (float)segments/spp;
+            cost[ShadowRays] = (float)shadowRays/spp;
+        }
+    });
+}
+//----------------------------------------------------------------------------------------------------------------------
+void CostMap::renderImage(Film &_film, unsigned int _frameNumber)
+{
+    if(m_dirty) build();
+    unsigned int width = _film.getWidth();
+    unsigned int height = _film.getHeight();
+    optix::float2 invScreen = optix::make_float2(2.f/width,2.f/height);
+    unsigned int spp = m_sqrtNumSamples*m_sqrtNumSamples;
+    unsigned int firstSample = _frameNumber*spp;
+    // Each tile is rendered by one thread which splats into its own padded buffer, our film merges them after
+    _film.renderTiles([&](Film::Tile &_tile)
+    {
+        Counters counters = {0,0};
+        unsigned int segments = 0;
+        unsigned int shadowRays = 0;
+        for(unsigned int py=_tile.m_y0;py<_tile.m_y1;py++)
+        {
+            for(unsigned int px=_tile.m_x0;px<_tile.m_x1;px++)
+            {
+                for(unsigned int stratum=0;stratum<spp;stratum++)
+                {
+                    // Our film does our filtering so our samples are only stratified over our pixel
+                    RandomStream rng = sample_stream(width*py+px,firstSample+stratum,0u);
+                    float jx = rnd(rng);
+                    float jy = rnd(rng);
+                    float fx = px+(stratum%m_sqrtNumSamples+jx)/m_sqrtNumSamples;
+                    float fy = py+(stratum/m_sqrtNumSamples+jy)/m_sqrtNumSamples;
+                    optix::float2 d = optix::make_float2(fx,fy)*invScreen - 1.f;
+                    optix::float3 direction = optix::normalize(d.x*m_U + d.y*m_V + m_W);
+                    optix::float3 radiance = tracePath(m_eye,direction,rng,counters,segments,shadowRays);
+                    _film.addSample(_tile,fx,fy,radiance);
+                }
+            }
+        }
+    });
+}
+//----------------------------------------------------------------------------------------------------------------------
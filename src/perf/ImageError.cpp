@@ -0,0 +1,406 @@
+#include "perf/ImageError.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief helpers for our colour space conversions
+//----------------------------------------------------------------------------------------------------------------------
+namespace
+{
+    // D65 reference white
+    const float g_whiteX = 0.950456f;
+    const float g_whiteY = 1.0f;
+    const float g_whiteZ = 1.088754f;
+
+    inline void linearRGBToXYZ(const float *_rgb, float *_xyz)
+    {
+        _xyz[0] = 0.4124564f*_rgb[0] + 0.3575761f*_rgb[1] + 0.1804375f*_rgb[2];
+        _xyz[1] = 0.2126729f*_rgb[0] + 0.7151522f*_rgb[1] + 0.0721750f*_rgb[2];
+        _xyz[2] = 0.0193339f*_rgb[0] + 0.1191920f*_rgb[1] + 0.9503041f*_rgb[2];
+    }
+
+    inline void XYZToLinearRGB(const float *_xyz, float *_rgb)
+    {
+        _rgb[0] =  3.2404542f*_xyz[0] - 1.5371385f*_xyz[1] - 0.4985314f*_xyz[2];
+        _rgb[1] = -0.9692660f*_xyz[0] + 1.8760108f*_xyz[1] + 0.0415560f*_xyz[2];
+        _rgb[2] =  0.0556434f*_xyz[0] - 0.2040259f*_xyz[1] + 1.0572252f*_xyz[2];
+    }
+
+    inline float labF(float _t)
+    {
+        return (_t>0.008856f) ? std::cbrt(_t) : 7.787f*_t + 16.f/116.f;
+    }
+
+    inline void XYZToLab(const float *_xyz, float *_lab)
+    {
+        float fx = labF(_xyz[0]/g_whiteX);
+        float fy = labF(_xyz[1]/g_whiteY);
+        float fz = labF(_xyz[2]/g_whiteZ);
+        _lab[0] = 116.f*fy - 16.f;
+        _lab[1] = 500.f*(fx - fy);
+        _lab[2] = 200.f*(fy - fz);
+    }
+
+    inline void linearRGBToLab(const float *_rgb, float *_lab)
+    {
+        float xyz[3];
+        linearRGBToXYZ(_rgb,xyz);
+        XYZToLab(xyz,_lab);
+    }
+
+    // The HyAB distance FLIP uses, better than euclidean distance for large colour differences
+    inline float hyAB(const float *_lab1, const float *_lab2)
+    {
+        float da = _lab1[1]-_lab2[1];
+        float db = _lab1[2]-_lab2[2];
+        return std::fabs(_lab1[0]-_lab2[0]) + std::sqrt(da*da + db*db);
+    }
+
+    // Convolves a single channel image with a separable kernel, clamping at our borders
+    void convolve(const std::vector<float> &_src, unsigned int _width, unsigned int _height,
+                  const std::vector<float> &_kx, const std::vector<float> &_ky, std::vector<float> &_dst)
+    {
+        int rx = _kx.size()/2;
+        int ry = _ky.size()/2;
+        int w = _width;
+        int h = _height;
+        std::vector<float> tmp(_src.size());
+        for(int y=0;y<h;y++)
+        for(int x=0;x<w;x++)
+        {
+            float sum = 0.f;
+            for(int k=-rx;k<=rx;k++) sum += _kx[k+rx]*_src[y*w + std::min(std::max(x+k,0),w-1)];
+            tmp[y*w+x] = sum;
+        }
+        _dst.resize(_src.size());
+        for(int y=0;y<h;y++)
+        for(int x=0;x<w;x++)
+        {
+            float sum = 0.f;
+            for(int k=-ry;k<=ry;k++) sum += _ky[k+ry]*tmp[std::min(std::max(y+k,0),h-1)*w + x];
+            _dst[y*w+x] = sum;
+        }
+    }
+
+    // Gaussian and its first and second derivatives, each normalised the way FLIP normalises its feature kernels
+    void featureKernels(float _sigma, std::vector<float> &_g, std::vector<float> &_dg, std::vector<float> &_ddg)
+    {
+        int radius = std::max(1,(int)std::ceil(3.f*_sigma));
+        _g.resize(2*radius+1);
+        _dg.resize(2*radius+1);
+        _ddg.resize(2*radius+1);
+        float gSum = 0.f, dgPos = 0.f, dgNeg = 0.f, ddgPos = 0.f, ddgNeg = 0.f;
+        for(int i=-radius;i<=radius;i++)
+        {
+            float x = (float)i;
+            float g = std::exp(-(x*x)/(2.f*_sigma*_sigma));
+            _g[i+radius] = g;
+            _dg[i+radius] = -x*g;
+            _ddg[i+radius] = (x*x/(_sigma*_sigma) - 1.f)*g;
+            gSum += g;
+        }
+        for(unsigned int i=0;i<_g.size();i++)
+        {
+            _g[i] /= gSum;
+            if(_dg[i]>0.f) dgPos += _dg[i]; else dgNeg -= _dg[i];
+            if(_ddg[i]>0.f) ddgPos += _ddg[i]; else ddgNeg -= _ddg[i];
+        }
+        for(unsigned int i=0;i<_g.size();i++)
+        {
+            _dg[i] /= (_dg[i]>0.f) ? dgPos : dgNeg;
+            _ddg[i] /= (_ddg[i]>0.f) ? ddgPos : ddgNeg;
+        }
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool ImageError::matches(const DisplayFrame &_image, const DisplayFrame &_reference)
+{
+    return _image.m_width==_reference.m_width && _image.m_height==_reference.m_height &&
+           _image.m_pixels.size()==_reference.m_pixels.size() && !_reference.m_pixels.empty() &&
+           _reference.m_pixels.size()==(size_t)_reference.m_width*_reference.m_height*4;
+}
+//----------------------------------------------------------------------------------------------------------------------
+ImageError::Errors ImageError::compare(const DisplayFrame &_image, const DisplayFrame &_reference)
+{
+    Errors errors;
+    errors.m_rmse = rmse(_image,_reference);
+    errors.m_relativeRMSE = relativeRMSE(_image,_reference);
+    errors.m_relativeMSE = relativeMSE(_image,_reference);
+    errors.m_flip = flip(_image,_reference);
+    return errors;
+}
+//----------------------------------------------------------------------------------------------------------------------
+double ImageError::rmse(const DisplayFrame &_image, const DisplayFrame &_reference)
+{
+    if(!matches(_image,_reference)) return -1.0;
+    double sumSq = 0.0;
+    unsigned int numPixels = _reference.m_pixels.size()/4;
+    for(unsigned int i=0;i<numPixels;i++)
+    {
+        for(int c=0;c<3;c++)
+        {
+            double d = _image.m_pixels[i*4+c]-_reference.m_pixels[i*4+c];
+            sumSq += d*d;
+        }
+    }
+    return std::sqrt(sumSq/(numPixels*3.0));
+}
+//----------------------------------------------------------------------------------------------------------------------
+double ImageError::relativeRMSE(const DisplayFrame &_image, const DisplayFrame &_reference)
+{
+    if(!matches(_image,_reference)) return -1.0;
+    double sumRef = 0.0;
+    unsigned int numPixels = _reference.m_pixels.size()/4;
+    for(unsigned int i=0;i<numPixels;i++)
+    {
+        sumRef += _reference.m_pixels[i*4] + _reference.m_pixels[i*4+1] + _reference.m_pixels[i*4+2];
+    }
+    double mean = sumRef/(numPixels*3.0);
+    if(mean<=0.0) return -1.0;
+    return rmse(_image,_reference)/mean;
+}
+//----------------------------------------------------------------------------------------------------------------------
+double ImageError::relativeMSE(const DisplayFrame &_image, const DisplayFrame &_reference)
+{
+    if(!matches(_image,_reference)) return -1.0;
+    // Stops black pixels in our reference from dominating our error
+    const double epsilon = 1e-2;
+    double sum = 0.0;
+    unsigned int numPixels = _reference.m_pixels.size()/4;
+    for(unsigned int i=0;i<numPixels;i++)
+    {
+        for(int c=0;c<3;c++)
+        {
+            double ref = _reference.m_pixels[i*4+c];
+            double d = _image.m_pixels[i*4+c]-ref;
+            sum += (d*d)/(ref*ref + epsilon);
+        }
+    }
+    return sum/(numPixels*3.0);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void ImageError::toYCxCz(const DisplayFrame &_frame, std::vector<float> &_ycxcz)
+{
+    unsigned int numPixels = _frame.m_width*_frame.m_height;
+    _ycxcz.resize(numPixels*3);
+    for(unsigned int i=0;i<numPixels;i++)
+    {
+        // Our renders are HDR, tone map them into [0,1) before treating them as what we display
+        float rgb[3], xyz[3];
+        for(int c=0;c<3;c++)
+        {
+            float v = std::max(_frame.m_pixels[i*4+c],0.f);
+            rgb[c] = v/(1.f+v);
+        }
+        linearRGBToXYZ(rgb,xyz);
+        float y = xyz[1]/g_whiteY;
+        _ycxcz[i*3+0] = 116.f*y - 16.f;
+        _ycxcz[i*3+1] = 500.f*(xyz[0]/g_whiteX - y);
+        _ycxcz[i*3+2] = 200.f*(y - xyz[2]/g_whiteZ);
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void ImageError::blurChannel(std::vector<float> &_image, unsigned int _width, unsigned int _height, int _channel, float _sigma)
+{
+    int radius = std::max(1,(int)std::ceil(3.f*_sigma));
+    std::vector<float> kernel(2*radius+1);
+    float sum = 0.f;
+    for(int i=-radius;i<=radius;i++)
+    {
+        kernel[i+radius] = std::exp(-(float)(i*i)/(2.f*_sigma*_sigma));
+        sum += kernel[i+radius];
+    }
+    for(unsigned int i=0;i<kernel.size();i++) kernel[i] /= sum;
+
+    unsigned int numPixels = _width*_height;
+    std::vector<float> channel(numPixels);
+    for(unsigned int i=0;i<numPixels;i++) channel[i] = _image[i*3+_channel];
+    convolve(channel,_width,_height,kernel,kernel,channel);
+    for(unsigned int i=0;i<numPixels;i++) _image[i*3+_channel] = channel[i];
+}
+//----------------------------------------------------------------------------------------------------------------------
+void ImageError::features(const std::vector<float> &_luminance, unsigned int _width, unsigned int _height, float _sigma,
+                          std::vector<float> &_edges, std::vector<float> &_points)
+{
+    std::vector<float> g, dg, ddg;
+    featureKernels(_sigma,g,dg,ddg);
+
+    std::vector<float> ex, ey, px, py;
+    convolve(_luminance,_width,_height,dg,g,ex);
+    convolve(_luminance,_width,_height,g,dg,ey);
+    convolve(_luminance,_width,_height,ddg,g,px);
+    convolve(_luminance,_width,_height,g,ddg,py);
+
+    _edges.resize(_luminance.size());
+    _points.resize(_luminance.size());
+    for(unsigned int i=0;i<_luminance.size();i++)
+    {
+        _edges[i] = std::sqrt(ex[i]*ex[i] + ey[i]*ey[i]);
+        _points[i] = std::sqrt(px[i]*px[i] + py[i]*py[i]);
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+double ImageError::flip(const DisplayFrame &_image, const DisplayFrame &_reference, float _pixelsPerDegree)
+{
+    if(!matches(_image,_reference)) return -1.0;
+    const unsigned int width = _reference.m_width;
+    const unsigned int height = _reference.m_height;
+    const unsigned int numPixels = width*height;
+
+    std::vector<float> test, ref;
+    toYCxCz(_image,test);
+    toYCxCz(_reference,ref);
+
+    // Achromatic channel in [0,1] for our feature detection, taken before filtering
+    std::vector<float> testL(numPixels), refL(numPixels);
+    for(unsigned int i=0;i<numPixels;i++)
+    {
+        testL[i] = (test[i*3]+16.f)/116.f;
+        refL[i] = (ref[i*3]+16.f)/116.f;
+    }
+
+    // Our contrast sensitivity functions as gaussians in pixels, from the spreads FLIP uses for each channel
+    const float pi = 3.14159265f;
+    const float spreads[3] = {0.0047f,0.0053f,0.04f};
+    for(int c=0;c<3;c++)
+    {
+        float sigma = std::sqrt(spreads[c])/(std::sqrt(2.f)*pi)*_pixelsPerDegree;
+        blurChannel(test,width,height,c,sigma);
+        blurChannel(ref,width,height,c,sigma);
+    }
+
+    // The largest colour difference we expect, between green and blue, to normalise by
+    const float qc = 0.7f;
+    const float pc = 0.4f;
+    const float pt = 0.95f;
+    const float green[3] = {0.f,1.f,0.f};
+    const float blue[3] = {0.f,0.f,1.f};
+    float greenLab[3], blueLab[3];
+    linearRGBToLab(green,greenLab);
+    linearRGBToLab(blue,blueLab);
+    const float cmax = std::pow(hyAB(greenLab,blueLab),qc);
+
+    std::vector<float> testEdges, testPoints, refEdges, refPoints;
+    const float featureSigma = 0.5f*0.082f*_pixelsPerDegree;
+    features(testL,width,height,featureSigma,testEdges,testPoints);
+    features(refL,width,height,featureSigma,refEdges,refPoints);
+
+    double sum = 0.0;
+    for(unsigned int i=0;i<numPixels;i++)
+    {
+        // Back from our filtered opponent space to Lab via clamped linear RGB
+        float labs[2][3];
+        const float *src[2] = {&test[i*3],&ref[i*3]};
+        for(int k=0;k<2;k++)
+        {
+            float yr = (src[k][0]+16.f)/116.f;
+            float xyz[3] = {(src[k][1]/500.f + yr)*g_whiteX, yr*g_whiteY, (yr - src[k][2]/200.f)*g_whiteZ};
+            float rgb[3];
+            XYZToLinearRGB(xyz,rgb);
+            for(int c=0;c<3;c++) rgb[c] = std::min(std::max(rgb[c],0.f),1.f);
+            linearRGBToLab(rgb,labs[k]);
+        }
+
+        // Colour error, compressed so that small differences aren't drowned out by large ones
+        float colour = std::pow(hyAB(labs[0],labs[1]),qc);
+        if(colour<pc*cmax)
+            colour = colour*pt/(pc*cmax);
+        else
+            colour = pt + (colour-pc*cmax)/(cmax-pc*cmax)*(1.f-pt);
+        colour = std::min(colour,1.f);
+
+        // Feature error, where edges or points differ
+        float feature = std::max(std::fabs(testEdges[i]-refEdges[i]),std::fabs(testPoints[i]-refPoints[i]));
+        feature = std::pow(std::min(feature/std::sqrt(2.f),1.f),0.5f);
+
+        sum += std::pow(colour,1.f-feature);
+    }
+    return sum/numPixels;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool ImageError::readPFM(const std::string &_path, DisplayFrame &_frame)
+{
+    std::ifstream file(_path.c_str(),std::ios::binary);
+    if(!file.is_open()) return false;
+
+    std::string type;
+    unsigned int width = 0, height = 0;
+    float scale = 0.f;
+    file>>type>>width>>height>>scale;
+    file.get();
+    if(type!="PF" || width==0 || height==0 || scale==0.f)
+    {
+        std::cerr<<"ImageError: "<<_path<<" is not a colour PFM image"<<std::endl;
+        return false;
+    }
+
+    std::vector<float> rgb(width*height*3);
+    file.read((char*)&rgb[0],rgb.size()*sizeof(float));
+    if(!file)
+    {
+        std::cerr<<"ImageError: "<<_path<<" is truncated"<<std::endl;
+        return false;
+    }
+
+    // A positive scale means big endian data
+    unsigned int one = 1;
+    bool littleEndianHost = *((unsigned char*)&one)==1;
+    if((scale>0.f)==littleEndianHost)
+    {
+        for(unsigned int i=0;i<rgb.size();i++)
+        {
+            unsigned char *b = (unsigned char*)&rgb[i];
+            std::swap(b[0],b[3]);
+            std::swap(b[1],b[2]);
+        }
+    }
+
+    // PFM rows run bottom to top, the same as our output buffers
+    _frame.m_width = width;
+    _frame.m_height = height;
+    _frame.m_frameNumber = 0;
+    _frame.m_pixels.resize(width*height*4);
+    for(unsigned int i=0;i<width*height;i++)
+    {
+        _frame.m_pixels[i*4+0] = rgb[i*3+0];
+        _frame.m_pixels[i*4+1] = rgb[i*3+1];
+        _frame.m_pixels[i*4+2] = rgb[i*3+2];
+        _frame.m_pixels[i*4+3] = 1.f;
+    }
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool ImageError::writePFM(const std::string &_path, const DisplayFrame &_frame)
+{
+    if(_frame.m_pixels.size()!=(size_t)_frame.m_width*_frame.m_height*4 || _frame.m_pixels.empty())
+    {
+        std::cerr<<"ImageError: can only write float4 images to "<<_path<<std::endl;
+        return false;
+    }
+    std::ofstream file(_path.c_str(),std::ios::binary);
+    if(!file.is_open())
+    {
+        std::cerr<<"ImageError: could not open "<<_path<<" for writing"<<std::endl;
+        return false;
+    }
+
+    unsigned int one = 1;
+    bool littleEndianHost = *((unsigned char*)&one)==1;
+    file<<"PF\n"<<_frame.m_width<<" "<<_frame.m_height<<"\n"<<((littleEndianHost)?"-1.0":"1.0")<<"\n";
+
+    unsigned int numPixels = _frame.m_width*_frame.m_height;
+    std::vector<float> rgb(numPixels*3);
+    for(unsigned int i=0;i<numPixels;i++)
+    {
+        rgb[i*3+0] = _frame.m_pixels[i*4+0];
+        rgb[i*3+1] = _frame.m_pixels[i*4+1];
+        rgb[i*3+2] = _frame.m_pixels[i*4+2];
+    }
+    file.write((const char*)&rgb[0],rgb.size()*sizeof(float));
+    return file.good();
+}
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,150 @@
+#include "perf/InteractionRecorder.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------------------------
+InteractionRecorder *InteractionRecorder::getInstance()
+{
+    static InteractionRecorder instance;
+    return &instance;
+}
+//----------------------------------------------------------------------------------------------------------------------
+InteractionRecorder::InteractionRecorder() : m_enabled(false), m_start(std::chrono::steady_clock::now())
+{
+    const char *path = std::getenv("PHENIX_RECORD");
+    if(path && *path && std::string(path)!="0")
+    {
+        m_enabled = true;
+        m_path = (std::string(path)=="1") ? "phenix_interaction.txt" : path;
+        m_events.reserve(1<<14);
+        std::cerr<<"Recording interaction to "<<m_path<<std::endl;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+const char *InteractionRecorder::getEventTypeName(EventType _type)
+{
+    switch(_type)
+    {
+        case(MousePress): return "mouse_press";
+        case(MouseRelease): return "mouse_release";
+        case(MouseMove): return "mouse_move";
+        case(Wheel): return "wheel";
+        case(KeyPress): return "key_press";
+        case(KeyRelease): return "key_release";
+        case(Resize): return "resize";
+        case(Transform): return "transform";
+        default: return "unknown";
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+InteractionRecorder::Event InteractionRecorder::createEvent(EventType _type)
+{
+    Event event = Event();
+    event.m_timeMs = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-m_start).count();
+    event.m_type = _type;
+    return event;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void InteractionRecorder::recordInput(EventType _type, int _x, int _y, int _value)
+{
+    if(!m_enabled) return;
+    Event event = createEvent(_type);
+    event.m_x = _x;
+    event.m_y = _y;
+    event.m_value = _value;
+    m_events.push_back(event);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void InteractionRecorder::recordResize(int _width, int _height)
+{
+    if(!m_enabled) return;
+    Event event = createEvent(Resize);
+    event.m_x = _width;
+    event.m_y = _height;
+    m_events.push_back(event);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void InteractionRecorder::recordTransform(const float *_trans, const float *_invTrans)
+{
+    if(!m_enabled) return;
+    Event event = createEvent(Transform);
+    memcpy(event.m_trans,_trans,sizeof(event.m_trans));
+    memcpy(event.m_invTrans,_invTrans,sizeof(event.m_invTrans));
+    m_events.push_back(event);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool InteractionRecorder::flush()
+{
+    if(!m_enabled) return false;
+    if(!save(m_path,m_events)) return false;
+    std::cerr<<"Wrote "<<m_events.size()<<" interaction events to "<<m_path<<std::endl;
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool InteractionRecorder::save(const std::string &_path, const std::vector<Event> &_events)
+{
+    std::ofstream file(_path.c_str());
+    if(!file.is_open())
+    {
+        std::cerr<<"InteractionRecorder: could not open "<<_path<<" for writing"<<std::endl;
+        return false;
+    }
+    // Enough precision that our transforms replay exactly
+    file.precision(9);
+    file<<"# phenix interaction v1: time_ms type x y value [transform[16] inverse[16]]\n";
+    for(unsigned int i=0;i<_events.size();i++)
+    {
+        const Event &e = _events[i];
+        file<<e.m_timeMs<<" "<<getEventTypeName(e.m_type)<<" "<<e.m_x<<" "<<e.m_y<<" "<<e.m_value;
+        if(e.m_type==Transform)
+        {
+            for(int j=0;j<16;j++) file<<" "<<e.m_trans[j];
+            for(int j=0;j<16;j++) file<<" "<<e.m_invTrans[j];
+        }
+        file<<"\n";
+    }
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool InteractionRecorder::load(const std::string &_path, std::vector<Event> &_events)
+{
+    std::ifstream file(_path.c_str());
+    if(!file.is_open())
+    {
+        std::cerr<<"InteractionRecorder: could not open "<<_path<<std::endl;
+        return false;
+    }
+    _events.clear();
+    std::string line;
+    unsigned int lineNumber = 0;
+    while(std::getline(file,line))
+    {
+        lineNumber++;
+        if(line.empty() || line[0]=='#') continue;
+        std::istringstream in(line);
+        Event e = Event();
+        std::string type;
+        in>>e.m_timeMs>>type>>e.m_x>>e.m_y>>e.m_value;
+        e.m_type = NumEventTypes;
+        for(int t=0;t<NumEventTypes;t++)
+        {
+            if(type==getEventTypeName((EventType)t)) e.m_type = (EventType)t;
+        }
+        if(e.m_type==Transform)
+        {
+            for(int j=0;j<16;j++) in>>e.m_trans[j];
+            for(int j=0;j<16;j++) in>>e.m_invTrans[j];
+        }
+        if(in.fail() || e.m_type==NumEventTypes)
+        {
+            std::cerr<<"InteractionRecorder: could not read line "<<lineNumber<<" of "<<_path<<std::endl;
+            return false;
+        }
+        _events.push_back(e);
+    }
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
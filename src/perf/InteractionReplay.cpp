@@ -0,0 +1,127 @@
+#include "perf/InteractionReplay.h"
+#include "perf/PerfMetrics.h"
+#include "perf/TraceEvents.h"
+#include <fstream>
+#include <iostream>
+#include <chrono>
+
+//----------------------------------------------------------------------------------------------------------------------
+InteractionReplay::InteractionReplay() : m_numEvents(0), m_numInputs(0)
+{
+    m_latency = LatencyTracker::Percentiles();
+    m_frameTimes = LatencyTracker::Percentiles();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void InteractionReplay::apply(PathTracerScene *_renderer, InteractionRecorder::Event &_event)
+{
+    if(_event.m_type==InteractionRecorder::Resize && _event.m_x>0 && _event.m_y>0)
+        _renderer->resize(_event.m_x,_event.m_y);
+    else if(_event.m_type==InteractionRecorder::Transform)
+        _renderer->setTransform(_event.m_trans,_event.m_invTrans,false);
+}
+//----------------------------------------------------------------------------------------------------------------------
+double InteractionReplay::launch(PathTracerScene *_renderer)
+{
+    PerfMetrics *metrics = PerfMetrics::getInstance();
+    metrics->beginLaunch();
+    _renderer->trace();
+    metrics->endLaunch(_renderer->getFrameNumber(),_renderer->getWidth(),_renderer->getHeight());
+    PerfMetrics::LaunchRecord record = PerfMetrics::LaunchRecord();
+    metrics->getLatestLaunch(record);
+    return record.m_totalMs;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool InteractionReplay::run(const std::string &_path)
+{
+    TraceScope trace("replay "+_path,"benchmark");
+    std::vector<InteractionRecorder::Event> events;
+    if(!InteractionRecorder::load(_path,events)) return false;
+    m_recording = _path;
+    m_numEvents = events.size();
+    m_numInputs = 0;
+    m_frames.clear();
+
+    // The same scene our application starts with
+    PathTracerScene *renderer = new PathTracerScene();
+    renderer->initialize();
+    renderer->setSampleSeed(0u);
+
+    // Anything before our first input is our window being set up, apply it and
+    // launch once so our acceleration structures are built before we measure
+    unsigned int e = 0;
+    while(e<events.size() && !events[e].isInput()) apply(renderer,events[e++]);
+    launch(renderer);
+
+    DisplayFrame image;
+    while(e<events.size())
+    {
+        unsigned int input = e++;
+        m_numInputs++;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool changed = false;
+        for(;e<events.size() && !events[e].isInput();e++)
+        {
+            apply(renderer,events[e]);
+            changed = true;
+        }
+        // Inputs that didn't change our renderer don't produce a frame
+        if(!changed) continue;
+
+        Frame frame;
+        frame.m_event = input;
+        frame.m_recordedMs = events[input].m_timeMs;
+        frame.m_frameMs = launch(renderer);
+        renderer->copyOutput(image);
+        frame.m_latencyMs = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+        frame.m_width = renderer->getWidth();
+        frame.m_height = renderer->getHeight();
+        m_frames.push_back(frame);
+    }
+    delete renderer;
+
+    std::vector<double> latencies, frameTimes;
+    for(unsigned int i=0;i<m_frames.size();i++)
+    {
+        latencies.push_back(m_frames[i].m_latencyMs);
+        frameTimes.push_back(m_frames[i].m_frameMs);
+    }
+    m_latency = LatencyTracker::computePercentiles(latencies);
+    m_frameTimes = LatencyTracker::computePercentiles(frameTimes);
+    std::cerr<<"Replayed "<<m_numInputs<<" inputs as "<<m_frames.size()<<" frames. Latency p50 "<<m_latency.m_p50
+             <<"ms p95 "<<m_latency.m_p95<<"ms p99 "<<m_latency.m_p99<<"ms, frame time p50 "<<m_frameTimes.m_p50
+             <<"ms p95 "<<m_frameTimes.m_p95<<"ms p99 "<<m_frameTimes.m_p99<<"ms"<<std::endl;
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void InteractionReplay::dumpJSON(std::ostream &_out)
+{
+    const LatencyTracker::Percentiles *percentiles[] = {&m_latency,&m_frameTimes};
+    const char *names[] = {"latency_ms","frame_ms"};
+    _out<<"{\n  \"recording\": \""<<m_recording<<"\", \"events\": "<<m_numEvents<<", \"inputs\": "<<m_numInputs<<",\n";
+    for(int i=0;i<2;i++)
+    {
+        _out<<"  \""<<names[i]<<"\": {\"mean\": "<<percentiles[i]->m_mean<<", \"p50\": "<<percentiles[i]->m_p50
+            <<", \"p95\": "<<percentiles[i]->m_p95<<", \"p99\": "<<percentiles[i]->m_p99<<", \"max\": "<<percentiles[i]->m_max<<"},\n";
+    }
+    _out<<"  \"frames\": [";
+    for(unsigned int i=0;i<m_frames.size();i++)
+    {
+        const Frame &f = m_frames[i];
+        _out<<((i)?",":"")<<"\n    {\"event\": "<<f.m_event<<", \"recorded_ms\": "<<f.m_recordedMs<<", \"latency_ms\": "<<f.m_latencyMs
+            <<", \"frame_ms\": "<<f.m_frameMs<<", \"width\": "<<f.m_width<<", \"height\": "<<f.m_height<<"}";
+    }
+    _out<<"\n  ]\n}\n";
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool InteractionReplay::writeJSON(const std::string &_path)
+{
+    std::ofstream file(_path.c_str());
+    if(!file.is_open())
+    {
+        std::cerr<<"InteractionReplay: could not open "<<_path<<" for writing"<<std::endl;
+        return false;
+    }
+    dumpJSON(file);
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,81 @@
+#include "perf/LatencyTracker.h"
+#include "perf/TraceEvents.h"
+#include <algorithm>
+#include <cmath>
+
+//----------------------------------------------------------------------------------------------------------------------
+LatencyTracker::Percentiles LatencyTracker::computePercentiles(std::vector<double> _values)
+{
+    Percentiles percentiles = Percentiles();
+    if(_values.empty()) return percentiles;
+    std::sort(_values.begin(),_values.end());
+    double total = 0.0;
+    for(unsigned int i=0;i<_values.size();i++) total += _values[i];
+    percentiles.m_count = _values.size();
+    percentiles.m_mean = total/_values.size();
+    // Nearest rank, the smallest value at least p percent of our values are less than or equal to
+    const double ranks[] = {0.50,0.95,0.99};
+    double *results[] = {&percentiles.m_p50,&percentiles.m_p95,&percentiles.m_p99};
+    for(int i=0;i<3;i++)
+    {
+        size_t rank = (size_t)std::ceil(ranks[i]*_values.size());
+        *results[i] = _values[std::max(rank,(size_t)1)-1];
+    }
+    percentiles.m_max = _values.back();
+    return percentiles;
+}
+//----------------------------------------------------------------------------------------------------------------------
+LatencyTracker *LatencyTracker::getInstance()
+{
+    static LatencyTracker instance;
+    return &instance;
+}
+//----------------------------------------------------------------------------------------------------------------------
+LatencyTracker::LatencyTracker() : m_numRecorded(0), m_percentilesDirty(false)
+{
+    m_history.reserve(m_historySize);
+    m_percentiles = Percentiles();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void LatencyTracker::inputQueued(unsigned long _version, std::chrono::steady_clock::time_point _inputTime)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Nothing is displayed while our view is hidden, don't grow forever waiting for it
+    if(m_pending.size()>=m_historySize) m_pending.pop_front();
+    PendingInput input;
+    input.m_version = _version;
+    input.m_time = _inputTime;
+    m_pending.push_back(input);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void LatencyTracker::frameDisplayed(unsigned long _version)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    TraceEvents *trace = TraceEvents::getInstance();
+    while(!m_pending.empty() && m_pending.front().m_version<=_version)
+    {
+        const PendingInput &input = m_pending.front();
+        double ms = std::chrono::duration<double,std::milli>(now-input.m_time).count();
+        if(m_history.size()<m_historySize)
+            m_history.push_back(ms);
+        else
+            m_history[m_numRecorded%m_historySize] = ms;
+        m_numRecorded++;
+        trace->addEvent("input to photon","latency",input.m_time,now);
+        m_pending.pop_front();
+        m_percentilesDirty = true;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+LatencyTracker::Percentiles LatencyTracker::getPercentiles()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_percentilesDirty)
+    {
+        m_percentiles = computePercentiles(m_history);
+        m_percentilesDirty = false;
+    }
+    return m_percentiles;
+}
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,342 @@
+#include "perf/PerfMetrics.h"
+#include "perf/TraceEvents.h"
+#include "perf/LatencyTracker.h"
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+//----------------------------------------------------------------------------------------------------------------------
+PerfMetrics *PerfMetrics::getInstance()
+{
+    // Function local static so our metrics are safely created on first use from any thread
+    static PerfMetrics instance;
+    return &instance;
+}
+//----------------------------------------------------------------------------------------------------------------------
+const char *PerfMetrics::getSectionName(Section _section)
+{
+    switch(_section)
+    {
+        case(Trace): return "trace";
+        case(AccelBuild): return "accel_build";
+        case(CameraUpdate): return "camera_update";
+        case(BufferUpload): return "buffer_upload";
+        case(OutputReadback): return "output_readback";
+        case(TextureUpload): return "texture_upload";
+        case(MeshImport): return "mesh_import";
+        case(HDRImport): return "hdr_import";
+        case(DisplayResolve): return "display_resolve";
+        default: return "unknown";
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+const char *PerfMetrics::getTerminationName(PathTermination _reason)
+{
+    switch(_reason)
+    {
+        case(Miss): return "miss";
+        case(EmitterHit): return "emitter";
+        case(RussianRoulette): return "russian_roulette";
+        case(MaxDepth): return "max_depth";
+        default: return "unknown";
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PerfMetrics::PathStats::add(const PathStats &_stats)
+{
+    for(unsigned int i=0;i<m_pathLengthBins;i++) m_lengths[i] += _stats.m_lengths[i];
+    for(int i=0;i<NumTerminations;i++)
+    {
+        m_terminations[i] += _stats.m_terminations[i];
+        m_throughput[i] += _stats.m_throughput[i];
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+unsigned long long PerfMetrics::PathStats::getNumPaths() const
+{
+    unsigned long long paths = 0;
+    for(unsigned int i=0;i<m_pathLengthBins;i++) paths += m_lengths[i];
+    return paths;
+}
+//----------------------------------------------------------------------------------------------------------------------
+double PerfMetrics::PathStats::getMeanLength() const
+{
+    unsigned long long paths = 0;
+    double segments = 0.0;
+    for(unsigned int i=0;i<m_pathLengthBins;i++)
+    {
+        paths += m_lengths[i];
+        segments += (double)m_lengths[i]*(i+1);
+    }
+    return (paths) ? segments/paths : 0.0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+PerfMetrics::PerfMetrics() : m_start(std::chrono::steady_clock::now()), m_written(0), m_inLaunch(false),
+                             m_hostMemory(0), m_deviceMemoryUsed(0), m_deviceMemoryTotal(0)
+{
+    for(int i=0;i<NumSections;i++)
+    {
+        m_sections[i].m_count = 0;
+        m_sections[i].m_totalNs = 0;
+        m_sections[i].m_minNs = std::numeric_limits<unsigned long long>::max();
+        m_sections[i].m_maxNs = 0;
+        m_sections[i].m_lastNs = 0;
+    }
+    for(unsigned int i=0;i<m_ringSize;i++)
+    {
+        m_ring[i].m_sequence = 0;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+double PerfMetrics::getElapsedMs()
+{
+    return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-m_start).count();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PerfMetrics::addSectionTime(Section _section, double _ms)
+{
+    if(_section<0 || _section>=NumSections) return;
+    unsigned long long ns = (unsigned long long)(_ms*1e6);
+
+    AtomicSectionStats &stats = m_sections[_section];
+    stats.m_count++;
+    stats.m_totalNs += ns;
+    stats.m_lastNs = ns;
+    unsigned long long current = stats.m_minNs;
+    while(ns<current && !stats.m_minNs.compare_exchange_weak(current,ns)){}
+    current = stats.m_maxNs;
+    while(ns>current && !stats.m_maxNs.compare_exchange_weak(current,ns)){}
+
+    // Attribute this to the current launch if it was timed on the thread recording it
+    if(m_inLaunch && m_launchThread.load()==std::this_thread::get_id())
+    {
+        m_current.m_sectionMs[_section] += _ms;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+PerfMetrics::SectionStats PerfMetrics::getSectionStats(Section _section)
+{
+    SectionStats stats;
+    stats.m_count = 0;
+    stats.m_totalMs = stats.m_minMs = stats.m_maxMs = stats.m_lastMs = 0.0;
+    if(_section<0 || _section>=NumSections) return stats;
+
+    AtomicSectionStats &s = m_sections[_section];
+    stats.m_count = s.m_count;
+    if(stats.m_count==0) return stats;
+    stats.m_totalMs = s.m_totalNs/1e6;
+    stats.m_minMs = s.m_minNs/1e6;
+    stats.m_maxMs = s.m_maxNs/1e6;
+    stats.m_lastMs = s.m_lastNs/1e6;
+    return stats;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PerfMetrics::beginLaunch()
+{
+    m_current = LaunchRecord();
+    m_current.m_index = m_written;
+    m_currentStart = std::chrono::steady_clock::now();
+    m_launchThread = std::this_thread::get_id();
+    m_inLaunch = true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PerfMetrics::setLaunchRayCounts(unsigned long long _camera, unsigned long long _bounce, unsigned long long _shadow)
+{
+    if(!m_inLaunch || m_launchThread.load()!=std::this_thread::get_id()) return;
+    m_current.m_cameraRays = _camera;
+    m_current.m_bounceRays = _bounce;
+    m_current.m_shadowRays = _shadow;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PerfMetrics::setLaunchPathStats(const PathStats &_stats)
+{
+    if(!m_inLaunch || m_launchThread.load()!=std::this_thread::get_id()) return;
+    m_current.m_pathStats = _stats;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PerfMetrics::endLaunch(unsigned int _frameNumber, unsigned int _width, unsigned int _height)
+{
+    if(!m_inLaunch || m_launchThread.load()!=std::this_thread::get_id())
+    {
+        std::cerr<<"PerfMetrics: endLaunch called without a matching beginLaunch"<<std::endl;
+        return;
+    }
+    m_inLaunch = false;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    m_current.m_totalMs = std::chrono::duration<double,std::milli>(now-m_currentStart).count();
+    m_current.m_timeStampMs = std::chrono::duration<double,std::milli>(now-m_start).count();
+    m_current.m_frameNumber = _frameNumber;
+    m_current.m_width = _width;
+    m_current.m_height = _height;
+
+    // We are the only writer. Mark our slot as being written with an odd sequence, write it,
+    // then publish it with an even sequence that also tells readers which launch the slot holds.
+    unsigned long index = m_written;
+    RingSlot &slot = m_ring[index%m_ringSize];
+    slot.m_sequence.store(2*index+1,std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.m_record = m_current;
+    slot.m_sequence.store(2*index+2,std::memory_order_release);
+    m_written.store(index+1,std::memory_order_release);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PerfMetrics::cancelLaunch()
+{
+    m_inLaunch = false;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PerfMetrics::setMemoryUsage(const MemoryUsage &_usage)
+{
+    m_hostMemory = _usage.m_hostBytes;
+    m_deviceMemoryUsed = _usage.m_deviceUsedBytes;
+    m_deviceMemoryTotal = _usage.m_deviceTotalBytes;
+}
+//----------------------------------------------------------------------------------------------------------------------
+PerfMetrics::MemoryUsage PerfMetrics::getMemoryUsage()
+{
+    MemoryUsage usage;
+    usage.m_hostBytes = m_hostMemory;
+    usage.m_deviceUsedBytes = m_deviceMemoryUsed;
+    usage.m_deviceTotalBytes = m_deviceMemoryTotal;
+    return usage;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool PerfMetrics::readSlot(unsigned long _index, LaunchRecord &_record)
+{
+    RingSlot &slot = m_ring[_index%m_ringSize];
+    unsigned long before = slot.m_sequence.load(std::memory_order_acquire);
+    if(before!=2*_index+2) return false;
+    _record = slot.m_record;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // If our writer lapped us while we were copying the sequence will have moved on
+    return slot.m_sequence.load(std::memory_order_relaxed)==before;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PerfMetrics::getRecentLaunches(std::vector<LaunchRecord> &_records, unsigned int _max)
+{
+    _records.clear();
+    unsigned long written = m_written.load(std::memory_order_acquire);
+    if(_max>m_ringSize) _max = m_ringSize;
+    unsigned long first = (written>_max) ? written-_max : 0;
+    _records.reserve(written-first);
+    LaunchRecord record;
+    for(unsigned long i=first;i<written;i++)
+    {
+        // Records overwritten while we read are skipped rather than returned torn
+        if(readSlot(i,record)) _records.push_back(record);
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool PerfMetrics::getLatestLaunch(LaunchRecord &_record)
+{
+    unsigned long written = m_written.load(std::memory_order_acquire);
+    if(written==0) return false;
+    return readSlot(written-1,_record);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PerfMetrics::dumpCSV(std::ostream &_out)
+{
+    std::vector<LaunchRecord> records;
+    getRecentLaunches(records);
+
+    _out<<"index,time_ms,frame,width,height,total_ms";
+    for(int s=0;s<NumSections;s++) _out<<","<<getSectionName((Section)s)<<"_ms";
+    _out<<",camera_rays,bounce_rays,shadow_rays,mrays_per_sec,paths,mean_path_length";
+    for(int t=0;t<NumTerminations;t++)
+    {
+        const char *name = getTerminationName((PathTermination)t);
+        _out<<","<<name<<"_paths,"<<name<<"_mean_throughput";
+    }
+    for(unsigned int b=0;b<m_pathLengthBins;b++) _out<<",length_"<<b+1<<((b+1==m_pathLengthBins)?"_plus":"");
+    _out<<"\n";
+
+    for(unsigned int i=0;i<records.size();i++)
+    {
+        const LaunchRecord &r = records[i];
+        _out<<r.m_index<<","<<r.m_timeStampMs<<","<<r.m_frameNumber<<","<<r.m_width<<","<<r.m_height<<","<<r.m_totalMs;
+        for(int s=0;s<NumSections;s++) _out<<","<<r.m_sectionMs[s];
+        double traceMs = r.m_sectionMs[Trace];
+        double mrays = (traceMs>0.0) ? (r.getTotalRays()/1e6)/(traceMs/1000.0) : 0.0;
+        _out<<","<<r.m_cameraRays<<","<<r.m_bounceRays<<","<<r.m_shadowRays<<","<<mrays;
+        const PathStats &p = r.m_pathStats;
+        _out<<","<<p.getNumPaths()<<","<<p.getMeanLength();
+        for(int t=0;t<NumTerminations;t++) _out<<","<<p.m_terminations[t]<<","<<p.getMeanThroughput((PathTermination)t);
+        for(unsigned int b=0;b<m_pathLengthBins;b++) _out<<","<<p.m_lengths[b];
+        _out<<"\n";
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PerfMetrics::dumpJSON(std::ostream &_out)
+{
+    std::vector<LaunchRecord> records;
+    getRecentLaunches(records);
+
+    _out<<"{\n  \"sections\": {";
+    for(int s=0;s<NumSections;s++)
+    {
+        SectionStats stats = getSectionStats((Section)s);
+        _out<<((s)?",":"")<<"\n    \""<<getSectionName((Section)s)<<"\": {\"count\": "<<stats.m_count
+            <<", \"total_ms\": "<<stats.m_totalMs<<", \"avg_ms\": "<<stats.getAverageMs()
+            <<", \"min_ms\": "<<stats.m_minMs<<", \"max_ms\": "<<stats.m_maxMs<<", \"last_ms\": "<<stats.m_lastMs<<"}";
+    }
+    LatencyTracker::Percentiles latency = LatencyTracker::getInstance()->getPercentiles();
+    _out<<"\n  },\n  \"input_latency\": {\"count\": "<<latency.m_count<<", \"mean_ms\": "<<latency.m_mean
+        <<", \"p50_ms\": "<<latency.m_p50<<", \"p95_ms\": "<<latency.m_p95<<", \"p99_ms\": "<<latency.m_p99
+        <<", \"max_ms\": "<<latency.m_max<<"},";
+    MemoryUsage memory = getMemoryUsage();
+    _out<<"\n  \"memory\": {\"host_bytes\": "<<memory.m_hostBytes<<", \"device_used_bytes\": "<<memory.m_deviceUsedBytes
+        <<", \"device_total_bytes\": "<<memory.m_deviceTotalBytes<<"},";
+    // Our path statistics summed over every launch in our ring, to tune our russian roulette and max depth with
+    PathStats paths = PathStats();
+    for(unsigned int i=0;i<records.size();i++) paths.add(records[i].m_pathStats);
+    _out<<"\n  \"path_stats\": {\"paths\": "<<paths.getNumPaths()<<", \"mean_length\": "<<paths.getMeanLength()
+        <<", \"terminations\": {";
+    for(int t=0;t<NumTerminations;t++)
+    {
+        _out<<((t)?", ":"")<<"\""<<getTerminationName((PathTermination)t)<<"\": {\"count\": "<<paths.m_terminations[t]
+            <<", \"mean_throughput\": "<<paths.getMeanThroughput((PathTermination)t)<<"}";
+    }
+    _out<<"}, \"length_histogram\": [";
+    for(unsigned int b=0;b<m_pathLengthBins;b++) _out<<((b)?", ":"")<<paths.m_lengths[b];
+    _out<<"]},";
+    _out<<"\n  \"launches\": [";
+    for(unsigned int i=0;i<records.size();i++)
+    {
+        const LaunchRecord &r = records[i];
+        _out<<((i)?",":"")<<"\n    {\"index\": "<<r.m_index<<", \"time_ms\": "<<r.m_timeStampMs
+            <<", \"frame\": "<<r.m_frameNumber<<", \"width\": "<<r.m_width<<", \"height\": "<<r.m_height
+            <<", \"total_ms\": "<<r.m_totalMs;
+        for(int s=0;s<NumSections;s++) _out<<", \""<<getSectionName((Section)s)<<"_ms\": "<<r.m_sectionMs[s];
+        _out<<", \"camera_rays\": "<<r.m_cameraRays<<", \"bounce_rays\": "<<r.m_bounceRays
+            <<", \"shadow_rays\": "<<r.m_shadowRays<<", \"paths\": "<<r.m_pathStats.getNumPaths()
+            <<", \"mean_path_length\": "<<r.m_pathStats.getMeanLength()<<"}";
+    }
+    _out<<"\n  ]\n}\n";
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool PerfMetrics::writeToFile(const std::string &_path)
+{
+    std::ofstream file(_path.c_str());
+    if(!file.is_open())
+    {
+        std::cerr<<"PerfMetrics: could not open "<<_path<<" for writing"<<std::endl;
+        return false;
+    }
+    bool json = _path.size()>=5 && _path.compare(_path.size()-5,5,".json")==0;
+    if(json)
+        dumpJSON(file);
+    else
+        dumpCSV(file);
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+PerfScopedTimer::~PerfScopedTimer()
+{
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double,std::milli>(end-m_start).count();
+    PerfMetrics::getInstance()->addSectionTime(m_section,ms);
+    // Our sections double as the per frame phases of our trace
+    TraceEvents *trace = TraceEvents::getInstance();
+    if(trace->isEnabled()) trace->addEvent(PerfMetrics::getSectionName(m_section),"frame",m_start,end);
+}
+//----------------------------------------------------------------------------------------------------------------------
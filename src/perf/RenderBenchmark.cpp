@@ -0,0 +1,520 @@
+#include "perf/RenderBenchmark.h"
+#include "perf/TraceEvents.h"
+#include "perf/ImageError.h"
+#include "geometry/Parallelogram.h"
+#include "geometry/Sphere.h"
+#include <fstream>
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+//----------------------------------------------------------------------------------------------------------------------
+RenderBenchmark::Settings RenderBenchmark::defaultSettings()
+{
+    Settings settings;
+    settings.m_width = 1024;
+    settings.m_height = 768;
+    settings.m_targetSpp = 256;
+    settings.m_referenceSpp = 1024;
+    settings.m_maxSpp = 1024;
+    settings.m_targetRMSE = 0.05f;
+    settings.m_rrBeginDepth = 1;
+    settings.m_maxDepth = 16;
+    settings.m_killerooPath = "models/killeroo.obj";
+    settings.m_scanPath = "models/scan_1m.obj";
+    settings.m_hdriPath = "hdr/environment.hdr";
+    settings.m_referenceDir = "bench/references";
+    const double checkpoints[] = {250.0,500.0,1000.0,2000.0,4000.0,8000.0,16000.0,32000.0};
+    settings.m_checkpointsMs.assign(checkpoints,checkpoints+sizeof(checkpoints)/sizeof(checkpoints[0]));
+    return settings;
+}
+//----------------------------------------------------------------------------------------------------------------------
+RenderBenchmark::RenderBenchmark(const Settings &_settings) : m_settings(_settings)
+{
+}
+//----------------------------------------------------------------------------------------------------------------------
+const char *RenderBenchmark::getSceneName(Scene _scene)
+{
+    switch(_scene)
+    {
+        case(CornellBox): return "cornell_box";
+        case(Killeroo): return "killeroo";
+        case(Scan): return "scan_1m";
+        case(ManyLights): return "many_lights";
+        case(HDRI): return "hdri";
+        default: return "unknown";
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RenderBenchmark::run()
+{
+    m_results.clear();
+    for(int s=0;s<NumScenes;s++)
+    {
+        std::cerr<<"Benchmarking "<<getSceneName((Scene)s)<<std::endl;
+        m_results.push_back(runScene((Scene)s));
+        const Result &r = m_results.back();
+        if(r.m_skipped)
+            std::cerr<<"  skipped: "<<r.m_skipReason<<std::endl;
+        else
+            std::cerr<<"  "<<r.m_mraysPerSec<<" Mrays/s, "<<m_settings.m_targetSpp<<"spp in "<<r.m_timeToTargetSppMs<<"ms"<<std::endl;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+PerfMetrics::LaunchRecord RenderBenchmark::launch(PathTracerScene *_renderer)
+{
+    PerfMetrics *metrics = PerfMetrics::getInstance();
+    metrics->beginLaunch();
+    _renderer->trace();
+    metrics->endLaunch(_renderer->getFrameNumber(),_renderer->getWidth(),_renderer->getHeight());
+    PerfMetrics::LaunchRecord record = PerfMetrics::LaunchRecord();
+    metrics->getLatestLaunch(record);
+    return record;
+}
+//----------------------------------------------------------------------------------------------------------------------
+Mesh *RenderBenchmark::addMesh(const std::string &_path, PathTracerScene *_renderer, Result &_result)
+{
+    if(!std::ifstream(_path.c_str()).good())
+    {
+        _result.m_skipReason = "could not find "+_path;
+        return 0;
+    }
+    optix::Context context = _renderer->getContext();
+    Mesh *mesh = new Mesh(context);
+    mesh->importGeometry(_path);
+    if(mesh->getNumPolygons()==0)
+    {
+        delete mesh;
+        _result.m_skipReason = "could not import "+_path;
+        return 0;
+    }
+    _renderer->addGeometry(mesh);
+    m_geometry.push_back(mesh);
+    _result.m_numPolygons += mesh->getNumPolygons();
+    return mesh;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool RenderBenchmark::loadScene(Scene _scene, PathTracerScene *_renderer, Result &_result)
+{
+    switch(_scene)
+    {
+        case(CornellBox):
+        {
+            _renderer->loadCornellBox();
+            _result.m_numLights = 1;
+            return true;
+        }
+        case(Killeroo):
+        {
+            _renderer->loadCornellBox();
+            _result.m_numLights = 1;
+            // Placed the same as in our test scene
+            Mesh *mesh = addMesh(m_settings.m_killerooPath,_renderer,_result);
+            if(!mesh) return false;
+            mesh->setPos(556.f/2.f,0.f,559.2f/3.f);
+            mesh->setScale(15.f,15.f,15.f);
+            return true;
+        }
+        case(Scan):
+        {
+            _renderer->loadCornellBox();
+            _result.m_numLights = 1;
+            Mesh *mesh = addMesh(m_settings.m_scanPath,_renderer,_result);
+            if(!mesh) return false;
+            // Scans come in all sizes so fit it to the middle of our box sat on the floor
+            optix::float3 min,max;
+            mesh->getBounds(min,max);
+            optix::float3 size = max-min;
+            float extent = std::max(size.x,std::max(size.y,size.z));
+            float scale = (extent>0.f) ? 350.f/extent : 1.f;
+            optix::float3 centre = (min+max)*0.5f;
+            mesh->setScale(scale,scale,scale);
+            mesh->setPos(556.f/2.f-centre.x*scale,-min.y*scale,559.2f/2.f-centre.z*scale);
+            return true;
+        }
+        case(ManyLights):
+        {
+            _renderer->loadCornellBox();
+            // Split the light of our box into a grid of lights with the same total power
+            // so the image is comparable but every hit casts a shadow ray per light
+            const int gridSize = 8;
+            const optix::float3 corner = optix::make_float3( 418.0f, 548.6f, 152.0f);
+            const optix::float3 v1 = optix::make_float3( -260.0f, 0.0f, 0.0f)/(float)gridSize;
+            const optix::float3 v2 = optix::make_float3( 0.0f, 0.0f, 105.0f)/(float)gridSize;
+            std::vector<ParallelogramLight> lights;
+            for(int y=0;y<gridSize;y++)
+            for(int x=0;x<gridSize;x++)
+            {
+                ParallelogramLight light;
+                light.corner = corner + v1*(float)x + v2*(float)y;
+                light.v1 = v1;
+                light.v2 = v2;
+                light.normal = optix::normalize(optix::cross(v1,v2));
+                light.emission = optix::make_float3( 15.0f, 15.0f, 15.0f );
+                lights.push_back(light);
+            }
+            _renderer->setLights(lights);
+            _result.m_numLights = lights.size();
+            return true;
+        }
+        case(HDRI):
+        {
+            if(!std::ifstream(m_settings.m_hdriPath.c_str()).good())
+            {
+                _result.m_skipReason = "could not find "+m_settings.m_hdriPath;
+                return false;
+            }
+            if(!_renderer->setEnvironmentMap(m_settings.m_hdriPath))
+            {
+                _result.m_skipReason = "could not load "+m_settings.m_hdriPath;
+                return false;
+            }
+            // An open scene lit only by our environment
+            optix::Context context = _renderer->getContext();
+            Parallelogram *floor = new Parallelogram(context);
+            floor->setScale(4000.f,1.f,4000.f);
+            floor->setPos(556.f/2.f,0.f,559.2f/2.f);
+            _renderer->addGeometry(floor);
+            m_geometry.push_back(floor);
+            Sphere *sphere = new Sphere(context);
+            sphere->setScale(150.f,150.f,150.f);
+            sphere->setPos(556.f/2.f,150.f,559.2f/2.f);
+            _renderer->addGeometry(sphere);
+            m_geometry.push_back(sphere);
+            _result.m_numPolygons += 2;
+            if(m_settings.m_killerooPath.size() && std::ifstream(m_settings.m_killerooPath.c_str()).good())
+            {
+                Mesh *mesh = addMesh(m_settings.m_killerooPath,_renderer,_result);
+                if(mesh)
+                {
+                    mesh->setPos(556.f/4.f,0.f,559.2f/3.f);
+                    mesh->setScale(15.f,15.f,15.f);
+                }
+            }
+            return true;
+        }
+        default:
+            _result.m_skipReason = "unknown scene";
+            return false;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+PathTracerScene *RenderBenchmark::setupScene(Scene _scene, Result &_result)
+{
+    PerfMetrics *metrics = PerfMetrics::getInstance();
+    _result.m_scene = getSceneName(_scene);
+
+    // Time our setup and pick out the import and upload sections it hits
+    PerfMetrics::SectionStats importBefore = metrics->getSectionStats(PerfMetrics::MeshImport);
+    PerfMetrics::SectionStats uploadBefore = metrics->getSectionStats(PerfMetrics::BufferUpload);
+    PerfMetrics::SectionStats hdrBefore = metrics->getSectionStats(PerfMetrics::HDRImport);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    PathTracerScene *renderer = new PathTracerScene();
+    renderer->initializeContext();
+    renderer->resize(m_settings.m_width,m_settings.m_height);
+    _result.m_skipped = !loadScene(_scene,renderer,_result);
+    _result.m_setupMs = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+    _result.m_meshImportMs = metrics->getSectionStats(PerfMetrics::MeshImport).m_totalMs - importBefore.m_totalMs;
+    _result.m_bufferUploadMs = metrics->getSectionStats(PerfMetrics::BufferUpload).m_totalMs - uploadBefore.m_totalMs;
+    _result.m_hdrImportMs = metrics->getSectionStats(PerfMetrics::HDRImport).m_totalMs - hdrBefore.m_totalMs;
+    _result.m_sppPerLaunch = renderer->getNumSamples()*renderer->getNumSamples();
+
+    if(m_devices.empty())
+    {
+        std::vector<int> devices = renderer->getContext()->getEnabledDevices();
+        for(unsigned int i=0;i<devices.size();i++)
+        {
+            m_devices.push_back(renderer->getContext()->getDeviceName(devices[i]));
+        }
+    }
+    return renderer;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RenderBenchmark::teardownScene(PathTracerScene *_renderer)
+{
+    // Tear down our scene before our context goes with our renderer
+    for(unsigned int i=0;i<m_geometry.size();i++)
+    {
+        _renderer->removeGeometry(m_geometry[i]);
+        delete m_geometry[i];
+    }
+    m_geometry.clear();
+    delete _renderer;
+}
+//----------------------------------------------------------------------------------------------------------------------
+std::string RenderBenchmark::getReferencePath(Scene _scene)
+{
+    if(m_settings.m_referenceDir.empty()) return std::string();
+    std::ostringstream path;
+    path<<m_settings.m_referenceDir<<"/"<<getSceneName(_scene)<<"_"<<m_settings.m_width<<"x"<<m_settings.m_height<<".pfm";
+    return path.str();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RenderBenchmark::getReference(Scene _scene, PathTracerScene *_renderer, Result &_result, DisplayFrame &_reference)
+{
+    // Use our stored reference if we have one so every run measures against the same image
+    std::string path = getReferencePath(_scene);
+    if(!path.empty() && ImageError::readPFM(path,_reference))
+    {
+        if(_reference.m_width==m_settings.m_width && _reference.m_height==m_settings.m_height)
+        {
+            // Still launch once so that compiling our programs and building our
+            // acceleration structures is never part of our measured run
+            _result.m_referenceStored = true;
+            _result.m_firstLaunchMs = launch(_renderer).m_totalMs;
+            return;
+        }
+        std::cerr<<"RenderBenchmark: ignoring "<<path<<" as it does not match our resolution"<<std::endl;
+    }
+
+    // Otherwise render it with independent random numbers and store it for next time
+    _renderer->setSampleSeed(1u<<20);
+    for(unsigned int spp=0;spp<m_settings.m_referenceSpp;spp+=_result.m_sppPerLaunch)
+    {
+        PerfMetrics::LaunchRecord record = launch(_renderer);
+        if(spp==0) _result.m_firstLaunchMs = record.m_totalMs;
+    }
+    _renderer->copyOutput(_reference);
+    if(!path.empty() && ImageError::writePFM(path,_reference))
+    {
+        std::cerr<<"  stored reference "<<path<<std::endl;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+RenderBenchmark::Result RenderBenchmark::runScene(Scene _scene)
+{
+    TraceScope trace(std::string("benchmark ")+getSceneName(_scene),"benchmark");
+    PerfMetrics *metrics = PerfMetrics::getInstance();
+
+    Result result = Result();
+    result.m_timeToTargetSppMs = -1.0;
+    result.m_timeToTargetRMSEMs = -1.0;
+    result.m_finalRMSE = -1.0;
+    PerfMetrics::SectionStats accelBefore = metrics->getSectionStats(PerfMetrics::AccelBuild);
+
+    PathTracerScene *renderer = setupScene(_scene,result);
+    if(!result.m_skipped)
+    {
+        unsigned int sppPerLaunch = result.m_sppPerLaunch;
+        DisplayFrame reference;
+        getReference(_scene,renderer,result,reference);
+
+        // Now our measured run. Only time spent launching counts towards our times,
+        // not reading back our image to measure its error.
+        renderer->setSampleSeed(0u);
+        renderer->setRRBeginDepth(m_settings.m_rrBeginDepth);
+        renderer->setMaxRayDepth(m_settings.m_maxDepth);
+        renderer->setRayCounting(true);
+        DisplayFrame image;
+        double renderMs = 0.0;
+        double traceMs = 0.0;
+        unsigned int spp = 0;
+        while(spp<m_settings.m_targetSpp || (result.m_timeToTargetRMSEMs<0.0 && spp<m_settings.m_maxSpp))
+        {
+            PerfMetrics::LaunchRecord record = launch(renderer);
+            renderMs += record.m_totalMs;
+            traceMs += record.m_sectionMs[PerfMetrics::Trace];
+            result.m_totalRays += record.getTotalRays();
+            result.m_pathStats.add(record.m_pathStats);
+            result.m_launches++;
+            spp += sppPerLaunch;
+
+            if(spp>=m_settings.m_targetSpp && result.m_timeToTargetSppMs<0.0) result.m_timeToTargetSppMs = renderMs;
+            if(result.m_timeToTargetRMSEMs<0.0)
+            {
+                renderer->copyOutput(image);
+                result.m_finalRMSE = ImageError::relativeRMSE(image,reference);
+                if(result.m_finalRMSE>=0.0 && result.m_finalRMSE<=m_settings.m_targetRMSE)
+                {
+                    result.m_timeToTargetRMSEMs = renderMs;
+                    result.m_sppAtTargetRMSE = spp;
+                }
+            }
+        }
+        renderer->copyOutput(image);
+        result.m_finalRMSE = ImageError::relativeRMSE(image,reference);
+        result.m_mraysPerSec = (traceMs>0.0) ? (result.m_totalRays/1e6)/(traceMs/1000.0) : 0.0;
+        result.m_accelBuildMs = metrics->getSectionStats(PerfMetrics::AccelBuild).m_totalMs - accelBefore.m_totalMs;
+    }
+    teardownScene(renderer);
+
+    return result;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RenderBenchmark::runConvergence()
+{
+    m_curves.clear();
+    for(int s=0;s<NumScenes;s++)
+    {
+        std::cerr<<"Measuring convergence of "<<getSceneName((Scene)s)<<std::endl;
+        m_curves.push_back(runConvergenceScene((Scene)s));
+        const ConvergenceCurve &curve = m_curves.back();
+        if(curve.m_skipped)
+            std::cerr<<"  skipped: "<<curve.m_skipReason<<std::endl;
+        else if(!curve.m_points.empty())
+            std::cerr<<"  relative MSE "<<curve.m_points.back().m_errors.m_relativeMSE<<" after "<<curve.m_points.back().m_renderMs<<"ms"<<std::endl;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+RenderBenchmark::ConvergenceCurve RenderBenchmark::runConvergenceScene(Scene _scene)
+{
+    TraceScope trace(std::string("convergence ")+getSceneName(_scene),"benchmark");
+
+    Result result = Result();
+    PathTracerScene *renderer = setupScene(_scene,result);
+
+    ConvergenceCurve curve;
+    curve.m_scene = result.m_scene;
+    curve.m_skipped = result.m_skipped;
+    curve.m_skipReason = result.m_skipReason;
+    if(!result.m_skipped && !m_settings.m_checkpointsMs.empty())
+    {
+        DisplayFrame reference;
+        getReference(_scene,renderer,result,reference);
+
+        renderer->setSampleSeed(0u);
+        renderer->setRRBeginDepth(m_settings.m_rrBeginDepth);
+        renderer->setMaxRayDepth(m_settings.m_maxDepth);
+
+        std::vector<double> checkpoints = m_settings.m_checkpointsMs;
+        std::sort(checkpoints.begin(),checkpoints.end());
+        DisplayFrame image;
+        double renderMs = 0.0;
+        unsigned int spp = 0;
+        unsigned int next = 0;
+        while(next<checkpoints.size())
+        {
+            renderMs += launch(renderer).m_totalMs;
+            spp += result.m_sppPerLaunch;
+            if(renderMs<checkpoints[next]) continue;
+
+            // Only time spent launching counts, not reading back our image and measuring it
+            renderer->copyOutput(image);
+            ImageError::Errors errors = ImageError::compare(image,reference);
+            while(next<checkpoints.size() && renderMs>=checkpoints[next])
+            {
+                ConvergencePoint point;
+                point.m_checkpointMs = checkpoints[next];
+                point.m_renderMs = renderMs;
+                point.m_spp = spp;
+                point.m_errors = errors;
+                curve.m_points.push_back(point);
+                next++;
+            }
+        }
+    }
+    teardownScene(renderer);
+
+    return curve;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RenderBenchmark::dumpJSON(std::ostream &_out)
+{
+    _out<<"{\n  \"settings\": {\"width\": "<<m_settings.m_width<<", \"height\": "<<m_settings.m_height
+        <<", \"target_spp\": "<<m_settings.m_targetSpp<<", \"reference_spp\": "<<m_settings.m_referenceSpp
+        <<", \"max_spp\": "<<m_settings.m_maxSpp<<", \"target_relative_rmse\": "<<m_settings.m_targetRMSE
+        <<", \"rr_begin_depth\": "<<m_settings.m_rrBeginDepth<<", \"max_depth\": "<<m_settings.m_maxDepth<<"},\n";
+    _out<<"  \"devices\": [";
+    for(unsigned int i=0;i<m_devices.size();i++) _out<<((i)?", ":"")<<"\""<<m_devices[i]<<"\"";
+    _out<<"],\n  \"scenes\": [";
+    for(unsigned int i=0;i<m_results.size();i++)
+    {
+        const Result &r = m_results[i];
+        _out<<((i)?",":"")<<"\n    {\"name\": \""<<r.m_scene<<"\", \"skipped\": "<<((r.m_skipped)?"true":"false");
+        if(r.m_skipped)
+        {
+            _out<<", \"reason\": \""<<r.m_skipReason<<"\"}";
+            continue;
+        }
+        _out<<", \"polygons\": "<<r.m_numPolygons<<", \"lights\": "<<r.m_numLights<<", \"spp_per_launch\": "<<r.m_sppPerLaunch
+            <<", \"setup_ms\": "<<r.m_setupMs<<", \"mesh_import_ms\": "<<r.m_meshImportMs<<", \"buffer_upload_ms\": "<<r.m_bufferUploadMs
+            <<", \"hdr_import_ms\": "<<r.m_hdrImportMs<<", \"first_launch_ms\": "<<r.m_firstLaunchMs<<", \"accel_build_ms\": "<<r.m_accelBuildMs
+            <<", \"mrays_per_sec\": "<<r.m_mraysPerSec<<", \"total_rays\": "<<r.m_totalRays<<", \"launches\": "<<r.m_launches
+            <<", \"mean_path_length\": "<<r.m_pathStats.getMeanLength();
+        unsigned long long paths = r.m_pathStats.getNumPaths();
+        for(int t=0;t<PerfMetrics::NumTerminations;t++)
+        {
+            PerfMetrics::PathTermination reason = (PerfMetrics::PathTermination)t;
+            _out<<", \""<<PerfMetrics::getTerminationName(reason)<<"_fraction\": "
+                <<((paths) ? (double)r.m_pathStats.m_terminations[t]/paths : 0.0);
+        }
+        _out<<", \"time_to_target_spp_ms\": "<<r.m_timeToTargetSppMs<<", \"time_to_target_rmse_ms\": "<<r.m_timeToTargetRMSEMs
+            <<", \"spp_at_target_rmse\": "<<r.m_sppAtTargetRMSE<<", \"final_relative_rmse\": "<<r.m_finalRMSE
+            <<", \"reference_stored\": "<<((r.m_referenceStored)?"true":"false")<<"}";
+    }
+    _out<<"\n  ]\n}\n";
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool RenderBenchmark::writeJSON(const std::string &_path)
+{
+    std::ofstream file(_path.c_str());
+    if(!file.is_open())
+    {
+        std::cerr<<"RenderBenchmark: could not open "<<_path<<" for writing"<<std::endl;
+        return false;
+    }
+    dumpJSON(file);
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RenderBenchmark::dumpConvergenceCSV(std::ostream &_out)
+{
+    _out<<"scene,checkpoint_ms,render_ms,spp,rmse,relative_rmse,relative_mse,flip\n";
+    for(unsigned int i=0;i<m_curves.size();i++)
+    {
+        const ConvergenceCurve &curve = m_curves[i];
+        for(unsigned int p=0;p<curve.m_points.size();p++)
+        {
+            const ConvergencePoint &point = curve.m_points[p];
+            _out<<curve.m_scene<<","<<point.m_checkpointMs<<","<<point.m_renderMs<<","<<point.m_spp<<","
+                <<point.m_errors.m_rmse<<","<<point.m_errors.m_relativeRMSE<<","<<point.m_errors.m_relativeMSE<<","
+                <<point.m_errors.m_flip<<"\n";
+        }
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RenderBenchmark::dumpConvergenceJSON(std::ostream &_out)
+{
+    _out<<"{\n  \"width\": "<<m_settings.m_width<<", \"height\": "<<m_settings.m_height<<",\n  \"scenes\": [";
+    for(unsigned int i=0;i<m_curves.size();i++)
+    {
+        const ConvergenceCurve &curve = m_curves[i];
+        _out<<((i)?",":"")<<"\n    {\"name\": \""<<curve.m_scene<<"\", \"skipped\": "<<((curve.m_skipped)?"true":"false");
+        if(curve.m_skipped)
+        {
+            _out<<", \"reason\": \""<<curve.m_skipReason<<"\"}";
+            continue;
+        }
+        _out<<", \"points\": [";
+        for(unsigned int p=0;p<curve.m_points.size();p++)
+        {
+            const ConvergencePoint &point = curve.m_points[p];
+            _out<<((p)?",":"")<<"\n      {\"checkpoint_ms\": "<<point.m_checkpointMs<<", \"render_ms\": "<<point.m_renderMs
+                <<", \"spp\": "<<point.m_spp<<", \"rmse\": "<<point.m_errors.m_rmse
+                <<", \"relative_rmse\": "<<point.m_errors.m_relativeRMSE<<", \"relative_mse\": "<<point.m_errors.m_relativeMSE
+                <<", \"flip\": "<<point.m_errors.m_flip<<"}";
+        }
+        _out<<"\n    ]}";
+    }
+    _out<<"\n  ]\n}\n";
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool RenderBenchmark::writeConvergence(const std::string &_path)
+{
+    std::ofstream file(_path.c_str());
+    if(!file.is_open())
+    {
+        std::cerr<<"RenderBenchmark: could not open "<<_path<<" for writing"<<std::endl;
+        return false;
+    }
+    bool json = _path.size()>=5 && _path.compare(_path.size()-5,5,".json")==0;
+    if(json)
+        dumpConvergenceJSON(file);
+    else
+        dumpConvergenceCSV(file);
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
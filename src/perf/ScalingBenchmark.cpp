@@ -0,0 +1,173 @@
+#include "perf/ScalingBenchmark.h"
+#include "perf/TraceEvents.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <new>
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------------------------
+ScalingBenchmark::Settings ScalingBenchmark::defaultSettings()
+{
+    Settings settings;
+    settings.m_width = 1024;
+    settings.m_height = 768;
+    settings.m_numFrames = 8;
+    settings.m_maxTriangles = 100000000;
+    settings.m_maxLights = 10000;
+    settings.m_maxInstances = 1000;
+    settings.m_scene = SceneGenerator::defaultSettings();
+    return settings;
+}
+//----------------------------------------------------------------------------------------------------------------------
+ScalingBenchmark::ScalingBenchmark(const Settings &_settings) : m_settings(_settings)
+{
+}
+//----------------------------------------------------------------------------------------------------------------------
+void ScalingBenchmark::run()
+{
+    m_results.clear();
+    runSweep<unsigned long long>("triangles",&SceneGenerator::Settings::m_numTriangles,10000ull,m_settings.m_maxTriangles);
+    runSweep<unsigned int>("lights",&SceneGenerator::Settings::m_numLights,1u,m_settings.m_maxLights);
+    runSweep<unsigned int>("instances",&SceneGenerator::Settings::m_numInstances,1u,m_settings.m_maxInstances);
+}
+//----------------------------------------------------------------------------------------------------------------------
+template<typename T>
+void ScalingBenchmark::runSweep(const std::string &_name, T SceneGenerator::Settings::*_value, T _first, T _max)
+{
+    // Every sweep starts from our base scene, the instance sweep instancing a smaller mesh so its largest
+    // configuration is still 100M triangles
+    SceneGenerator::Settings scene = m_settings.m_scene;
+    if(_name=="instances") scene.m_numTriangles = std::min(scene.m_numTriangles,100000ull);
+
+    for(T value=_first;value<=_max && value>0;)
+    {
+        scene.*_value = value;
+        std::cerr<<"Scaling "<<_name<<": "<<value<<std::endl;
+        m_results.push_back(runConfig(_name,scene));
+        const Result &r = m_results.back();
+        std::cerr<<"  "<<r.m_status<<", first launch "<<r.m_firstLaunchMs<<"ms, frame "<<r.m_frameMs<<"ms, "
+                 <<r.m_deviceMB<<"MB on device"<<std::endl;
+        // Larger configurations will only fail the same way
+        if(r.m_status!="ok") break;
+
+        if(value==_max) break;
+        value = (value>_max/10) ? _max : value*10;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+PerfMetrics::LaunchRecord ScalingBenchmark::launch(PathTracerScene *_renderer)
+{
+    PerfMetrics *metrics = PerfMetrics::getInstance();
+    metrics->beginLaunch();
+    _renderer->trace();
+    metrics->endLaunch(_renderer->getFrameNumber(),_renderer->getWidth(),_renderer->getHeight());
+    PerfMetrics::LaunchRecord record = PerfMetrics::LaunchRecord();
+    metrics->getLatestLaunch(record);
+    return record;
+}
+//----------------------------------------------------------------------------------------------------------------------
+double ScalingBenchmark::getAvailableDeviceBytes(PathTracerScene *_renderer)
+{
+    std::vector<int> devices = _renderer->getContext()->getEnabledDevices();
+    if(devices.empty()) return 0.0;
+    return (double)_renderer->getContext()->getAvailableDeviceMemory(devices[0]);
+}
+//----------------------------------------------------------------------------------------------------------------------
+ScalingBenchmark::Result ScalingBenchmark::runConfig(const std::string &_sweep, const SceneGenerator::Settings &_scene)
+{
+    std::ostringstream name;
+    name<<"scaling "<<_sweep<<" "<<_scene.m_numTriangles<<" triangles "<<_scene.m_numLights<<" lights "
+        <<_scene.m_numInstances<<" instances";
+    TraceScope trace(name.str(),"benchmark");
+    PerfMetrics *metrics = PerfMetrics::getInstance();
+
+    Result result = Result();
+    result.m_sweep = _sweep;
+    result.m_numSpheres = _scene.m_numSpheres;
+    result.m_status = "ok";
+
+    SceneGenerator generator(_scene);
+    PathTracerScene *renderer = 0;
+    try
+    {
+        renderer = new PathTracerScene();
+        renderer->initializeContext();
+        renderer->resize(m_settings.m_width,m_settings.m_height);
+        double availableBefore = getAvailableDeviceBytes(renderer);
+
+        generator.generate(renderer);
+        result.m_scene = generator.getStats();
+
+        // Our first launch builds our acceleration structures
+        PerfMetrics::SectionStats accelBefore = metrics->getSectionStats(PerfMetrics::AccelBuild);
+        result.m_firstLaunchMs = launch(renderer).m_totalMs;
+        result.m_accelBuildMs = metrics->getSectionStats(PerfMetrics::AccelBuild).m_totalMs - accelBefore.m_totalMs;
+        result.m_deviceMB = (availableBefore-getAvailableDeviceBytes(renderer))/(1024.0*1024.0);
+
+        renderer->setRayCounting(true);
+        double totalMs = 0.0;
+        double traceMs = 0.0;
+        unsigned long long rays = 0;
+        for(unsigned int i=0;i<m_settings.m_numFrames;i++)
+        {
+            PerfMetrics::LaunchRecord record = launch(renderer);
+            totalMs += record.m_totalMs;
+            traceMs += record.m_sectionMs[PerfMetrics::Trace];
+            rays += record.getTotalRays();
+        }
+        result.m_frameMs = (m_settings.m_numFrames) ? totalMs/m_settings.m_numFrames : 0.0;
+        result.m_mraysPerSec = (traceMs>0.0) ? (rays/1e6)/(traceMs/1000.0) : 0.0;
+    }
+    catch(const std::bad_alloc &)
+    {
+        result.m_status = "out of host memory";
+    }
+    catch(const optix::Exception &e)
+    {
+        result.m_status = "optix error: "+e.getErrorString();
+    }
+
+    // Tear down our scene before our context goes with our renderer
+    if(renderer)
+    {
+        try
+        {
+            generator.clear(renderer);
+            delete renderer;
+        }
+        catch(const optix::Exception &e)
+        {
+            std::cerr<<"ScalingBenchmark: could not tear down our scene: "<<e.getErrorString()<<std::endl;
+        }
+    }
+    return result;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void ScalingBenchmark::dumpCSV(std::ostream &_out)
+{
+    _out<<"sweep,triangles,instanced_triangles,objects,lights,spheres,generate_ms,upload_ms,first_launch_ms,"
+        <<"accel_build_ms,host_mb,device_mb,frame_ms,mrays_per_sec,status\n";
+    for(unsigned int i=0;i<m_results.size();i++)
+    {
+        const Result &r = m_results[i];
+        _out<<r.m_sweep<<","<<r.m_scene.m_numTriangles<<","<<r.m_scene.m_numInstancedTriangles<<","<<r.m_scene.m_numObjects<<","
+            <<r.m_scene.m_numLights<<","<<r.m_numSpheres<<","<<r.m_scene.m_generateMs<<","<<r.m_scene.m_uploadMs<<","
+            <<r.m_firstLaunchMs<<","<<r.m_accelBuildMs<<","<<r.m_scene.m_hostBytes/(1024.0*1024.0)<<","
+            <<r.m_deviceMB<<","<<r.m_frameMs<<","<<r.m_mraysPerSec<<",\""<<r.m_status<<"\"\n";
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool ScalingBenchmark::writeCSV(const std::string &_path)
+{
+    std::ofstream file(_path.c_str());
+    if(!file.is_open())
+    {
+        std::cerr<<"ScalingBenchmark: could not open "<<_path<<" for writing"<<std::endl;
+        return false;
+    }
+    dumpCSV(file);
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,271 @@
+#include "perf/SceneGenerator.h"
+#include "perf/PerfMetrics.h"
+#include "perf/TraceEvents.h"
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------------------------
+SceneGenerator::Settings SceneGenerator::defaultSettings()
+{
+    Settings settings;
+    settings.m_numTriangles = 1000000;
+    settings.m_numMeshes = 1;
+    settings.m_numInstances = 0;
+    settings.m_numLights = 1;
+    settings.m_numSpheres = 0;
+    settings.m_distribution = Uniform;
+    settings.m_numClusters = 16;
+    settings.m_triangleScale = 1.f;
+    // The inside of our Cornell box so our default camera sees it all
+    settings.m_boundsMin = optix::make_float3(0.f,0.f,0.f);
+    settings.m_boundsMax = optix::make_float3(556.f,548.8f,559.2f);
+    settings.m_seed = 1;
+    return settings;
+}
+//----------------------------------------------------------------------------------------------------------------------
+SceneGenerator::SceneGenerator(const Settings &_settings) : m_settings(_settings), m_rngState(1)
+{
+    m_stats = Stats();
+}
+//----------------------------------------------------------------------------------------------------------------------
+SceneGenerator::~SceneGenerator()
+{
+    if(!m_meshes.empty() || !m_instances.empty() || !m_spheres.empty())
+    {
+        std::cerr<<"SceneGenerator: destroyed without clearing its scene, leaking its geometry"<<std::endl;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+float SceneGenerator::random()
+{
+    // xorshift, plenty for placing geometry and much faster than std::rand for a hundred million triangles
+    m_rngState ^= m_rngState<<13;
+    m_rngState ^= m_rngState>>17;
+    m_rngState ^= m_rngState<<5;
+    return (m_rngState>>8)*(1.0f/16777216.0f);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void SceneGenerator::createClusters(std::vector<optix::float3> &_clusters)
+{
+    _clusters.clear();
+    if(m_settings.m_distribution!=Clustered) return;
+    unsigned int numClusters = std::max(1u,m_settings.m_numClusters);
+    for(unsigned int i=0;i<numClusters;i++)
+    {
+        float x = random();
+        float y = random();
+        float z = random();
+        _clusters.push_back(optix::make_float3(x,y,z));
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+optix::float3 SceneGenerator::samplePosition(const optix::float3 &_min, const optix::float3 &_max, const std::vector<optix::float3> &_clusters)
+{
+    optix::float3 p;
+    switch(m_settings.m_distribution)
+    {
+        case(Clustered):
+        {
+            // Gaussian around a random cluster from the Box-Muller transform
+            const optix::float3 &centre = _clusters[std::min((unsigned int)(random()*_clusters.size()),(unsigned int)_clusters.size()-1)];
+            const float sigma = 0.05f;
+            float g[3];
+            for(int i=0;i<3;i++)
+            {
+                float u1 = std::max(random(),1e-7f);
+                float u2 = random();
+                g[i] = std::sqrt(-2.f*std::log(u1))*std::cos(2.f*3.14159265f*u2);
+            }
+            p.x = std::min(std::max(centre.x + g[0]*sigma,0.f),1.f);
+            p.y = std::min(std::max(centre.y + g[1]*sigma,0.f),1.f);
+            p.z = std::min(std::max(centre.z + g[2]*sigma,0.f),1.f);
+            break;
+        }
+        case(Planar):
+        {
+            p.x = random();
+            p.y = 0.f;
+            p.z = random();
+            break;
+        }
+        default:
+        {
+            p.x = random();
+            p.y = random();
+            p.z = random();
+            break;
+        }
+    }
+    return _min + p*(_max-_min);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void SceneGenerator::generateTriangles(unsigned long long _numTriangles, float _extent, std::vector<optix::float3> &_vertices)
+{
+    std::vector<optix::float3> clusters;
+    createClusters(clusters);
+
+    // Size our triangles so that together they roughly fill our box
+    const float halfExtent = 0.5f*_extent;
+    const float size = m_settings.m_triangleScale*_extent/std::cbrt((float)std::max(_numTriangles,1ull));
+    const optix::float3 min = optix::make_float3(-halfExtent);
+    const optix::float3 max = optix::make_float3(halfExtent);
+
+    _vertices.resize(_numTriangles*3);
+    for(unsigned long long t=0;t<_numTriangles;t++)
+    {
+        optix::float3 centre = samplePosition(min,max,clusters);
+        for(int v=0;v<3;v++)
+        {
+            float x = (random()-0.5f)*size;
+            float y = (random()-0.5f)*size;
+            float z = (random()-0.5f)*size;
+            _vertices[t*3+v] = centre + optix::make_float3(x,y,z);
+        }
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void SceneGenerator::generateLights(std::vector<ParallelogramLight> &_lights)
+{
+    _lights.clear();
+    if(m_settings.m_numLights==0) return;
+
+    // A grid of lights facing down from the top of our bounds with the same total power as our Cornell box light
+    const unsigned int gridSize = (unsigned int)std::ceil(std::sqrt((float)m_settings.m_numLights));
+    const optix::float3 extent = m_settings.m_boundsMax - m_settings.m_boundsMin;
+    const float cellX = extent.x/gridSize;
+    const float cellZ = extent.z/gridSize;
+    const float area = (0.5f*cellX)*(0.5f*cellZ);
+    const float totalPower = 15.f*130.f*105.f;
+    const float emission = totalPower/(m_settings.m_numLights*area);
+    for(unsigned int i=0;i<m_settings.m_numLights;i++)
+    {
+        unsigned int x = i%gridSize;
+        unsigned int z = i/gridSize;
+        ParallelogramLight light;
+        light.corner = optix::make_float3(m_settings.m_boundsMin.x + (x+0.75f)*cellX,
+                                          m_settings.m_boundsMax.y - 0.1f,
+                                          m_settings.m_boundsMin.z + (z+0.25f)*cellZ);
+        light.v1 = optix::make_float3(-0.5f*cellX,0.f,0.f);
+        light.v2 = optix::make_float3(0.f,0.f,0.5f*cellZ);
+        light.normal = optix::normalize(optix::cross(light.v1,light.v2));
+        light.emission = optix::make_float3(emission);
+        _lights.push_back(light);
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void SceneGenerator::generate(PathTracerScene *_renderer)
+{
+    std::ostringstream name;
+    name<<"generate scene "<<m_settings.m_numTriangles<<" triangles";
+    TraceScope trace(name.str(),"benchmark");
+
+    if(!m_meshes.empty() || !m_instances.empty() || !m_spheres.empty()) clear(_renderer);
+    m_stats = Stats();
+    m_rngState = (m_settings.m_seed) ? m_settings.m_seed : 1;
+    PerfMetrics::SectionStats uploadBefore = PerfMetrics::getInstance()->getSectionStats(PerfMetrics::BufferUpload);
+    optix::Context context = _renderer->getContext();
+
+    const optix::float3 extent = m_settings.m_boundsMax - m_settings.m_boundsMin;
+    const float minExtent = std::min(extent.x,std::min(extent.y,extent.z));
+    std::vector<optix::float3> clusters;
+    createClusters(clusters);
+
+    // Each mesh and instance is an object taking up an equal share of our scene
+    const unsigned int numMeshes = (m_settings.m_numTriangles>0) ? std::max(1u,m_settings.m_numMeshes) : 0;
+    const unsigned int numObjects = numMeshes + ((numMeshes) ? m_settings.m_numInstances : 0);
+    const float objectExtent = (numObjects>1) ? minExtent/std::cbrt((float)numObjects) : minExtent;
+    const optix::float3 objectMin = m_settings.m_boundsMin + optix::make_float3(0.5f*objectExtent);
+    const optix::float3 objectMax = optix::fmaxf(m_settings.m_boundsMax - optix::make_float3(0.5f*objectExtent),objectMin);
+
+    std::vector<optix::float3> vertices, normals;
+    for(unsigned int i=0;i<numObjects;i++)
+    {
+        Mesh *mesh;
+        if(i<numMeshes)
+        {
+            // Spread our triangles over our meshes, the first ones taking any remainder
+            unsigned long long numTriangles = m_settings.m_numTriangles/numMeshes + ((i<m_settings.m_numTriangles%numMeshes) ? 1 : 0);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            generateTriangles(numTriangles,objectExtent,vertices);
+            m_stats.m_generateMs += std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+
+            mesh = new Mesh(context);
+            mesh->setTriangles(vertices,normals);
+            m_stats.m_numTriangles += numTriangles;
+            m_stats.m_hostBytes += mesh->getHostMemoryUsage();
+            m_meshes.push_back(mesh);
+        }
+        else
+        {
+            mesh = new Mesh(context,*m_meshes[i%numMeshes]);
+            mesh->setRot(0.f,random()*360.f,0.f);
+            m_instances.push_back(mesh);
+        }
+        m_stats.m_numInstancedTriangles += mesh->getNumPolygons();
+
+        if(numObjects==1)
+        {
+            optix::float3 centre = 0.5f*(m_settings.m_boundsMin+m_settings.m_boundsMax);
+            if(m_settings.m_distribution==Planar) centre.y = objectMin.y;
+            mesh->setPos(centre.x,centre.y,centre.z);
+        }
+        else
+        {
+            optix::float3 p = samplePosition(objectMin,objectMax,clusters);
+            mesh->setPos(p.x,p.y,p.z);
+        }
+        _renderer->addGeometry(mesh);
+    }
+
+    if(m_settings.m_numSpheres>0)
+    {
+        const float radius = minExtent/(std::cbrt((float)m_settings.m_numSpheres)*6.f);
+        const optix::float3 sphereMin = m_settings.m_boundsMin + optix::make_float3(radius);
+        const optix::float3 sphereMax = optix::fmaxf(m_settings.m_boundsMax - optix::make_float3(radius),sphereMin);
+        for(unsigned int i=0;i<m_settings.m_numSpheres;i++)
+        {
+            Sphere *sphere = new Sphere(context);
+            optix::float3 p = samplePosition(sphereMin,sphereMax,clusters);
+            sphere->setScale(radius,radius,radius);
+            sphere->setPos(p.x,p.y,p.z);
+            _renderer->addGeometry(sphere);
+            m_spheres.push_back(sphere);
+        }
+    }
+    m_stats.m_numObjects = numObjects + m_settings.m_numSpheres;
+
+    std::vector<ParallelogramLight> lights;
+    generateLights(lights);
+    _renderer->setLights(lights);
+    m_stats.m_numLights = lights.size();
+    m_stats.m_hostBytes += lights.size()*sizeof(ParallelogramLight);
+
+    m_stats.m_uploadMs = PerfMetrics::getInstance()->getSectionStats(PerfMetrics::BufferUpload).m_totalMs - uploadBefore.m_totalMs;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void SceneGenerator::clear(PathTracerScene *_renderer)
+{
+    // Instances go first as they share the buffers of our meshes
+    for(unsigned int i=0;i<m_instances.size();i++)
+    {
+        _renderer->removeGeometry(m_instances[i]);
+        delete m_instances[i];
+    }
+    for(unsigned int i=0;i<m_meshes.size();i++)
+    {
+        _renderer->removeGeometry(m_meshes[i]);
+        delete m_meshes[i];
+    }
+    for(unsigned int i=0;i<m_spheres.size();i++)
+    {
+        _renderer->removeGeometry(m_spheres[i]);
+        delete m_spheres[i];
+    }
+    m_instances.clear();
+    m_meshes.clear();
+    m_spheres.clear();
+}
+//----------------------------------------------------------------------------------------------------------------------
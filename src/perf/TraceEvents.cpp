@@ -0,0 +1,107 @@
+#include "perf/TraceEvents.h"
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+
+//----------------------------------------------------------------------------------------------------------------------
+TraceEvents *TraceEvents::getInstance()
+{
+    static TraceEvents instance;
+    return &instance;
+}
+//----------------------------------------------------------------------------------------------------------------------
+TraceEvents::TraceEvents() : m_enabled(false), m_start(std::chrono::steady_clock::now())
+{
+    const char *path = std::getenv("PHENIX_TRACE");
+    if(path && *path && std::string(path)!="0")
+    {
+        m_enabled = true;
+        m_path = (std::string(path)=="1") ? "phenix_trace.json" : path;
+        m_events.reserve(1<<16);
+        std::cerr<<"Recording trace events to "<<m_path<<std::endl;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+int TraceEvents::getThreadId()
+{
+    std::map<std::thread::id,int>::iterator it = m_threadIds.find(std::this_thread::get_id());
+    if(it!=m_threadIds.end()) return it->second;
+    int id = m_threadIds.size()+1;
+    m_threadIds[std::this_thread::get_id()] = id;
+    return id;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void TraceEvents::addEvent(const std::string &_name, const char *_category, std::chrono::steady_clock::time_point _start, std::chrono::steady_clock::time_point _end)
+{
+    if(!m_enabled) return;
+    Event event;
+    event.m_name = _name;
+    event.m_category = _category;
+    event.m_startUs = std::chrono::duration<double,std::micro>(_start-m_start).count();
+    event.m_durationUs = std::chrono::duration<double,std::micro>(_end-_start).count();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    event.m_threadId = getThreadId();
+    m_events.push_back(event);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void TraceEvents::setThreadName(const std::string &_name)
+{
+    if(!m_enabled) return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_threadNames[getThreadId()] = _name;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool TraceEvents::flush()
+{
+    if(!m_enabled) return false;
+    std::ofstream file(m_path.c_str());
+    if(!file.is_open())
+    {
+        std::cerr<<"TraceEvents: could not open "<<m_path<<" for writing"<<std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    file<<"{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    for(std::map<int,std::string>::iterator it=m_threadNames.begin();it!=m_threadNames.end();++it)
+    {
+        file<<((first)?"":",\n")<<"{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "<<it->first
+            <<", \"args\": {\"name\": \""<<it->second<<"\"}}";
+        first = false;
+    }
+    for(unsigned int i=0;i<m_events.size();i++)
+    {
+        const Event &e = m_events[i];
+        // Escape anything in our names that would break our json, names can come from file paths
+        std::string name;
+        for(unsigned int c=0;c<e.m_name.size();c++)
+        {
+            if(e.m_name[c]=='"' || e.m_name[c]=='\\') name += '\\';
+            name += e.m_name[c];
+        }
+        file<<((first)?"":",\n")<<"{\"name\": \""<<name<<"\", \"cat\": \""<<e.m_category<<"\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+            <<e.m_threadId<<", \"ts\": "<<std::fixed<<e.m_startUs<<", \"dur\": "<<e.m_durationUs<<"}";
+        file.unsetf(std::ios_base::floatfield);
+        first = false;
+    }
+    file<<"\n]}\n";
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+TraceScope::TraceScope(const std::string &_name, const char *_category) : m_enabled(TraceEvents::getInstance()->isEnabled()),
+                                                                          m_category(_category)
+{
+    // Don't even copy our name unless we're recording
+    if(!m_enabled) return;
+    m_name = _name;
+    m_start = std::chrono::steady_clock::now();
+}
+//----------------------------------------------------------------------------------------------------------------------
+TraceScope::~TraceScope()
+{
+    if(!m_enabled) return;
+    TraceEvents::getInstance()->addEvent(m_name,m_category,m_start,std::chrono::steady_clock::now());
+}
+//----------------------------------------------------------------------------------------------------------------------
@@ -1,4 +1,9 @@
 #include "renderer/AbstractOptixRenderer.h"
+#include "perf/PerfMetrics.h"
+#include "perf/TraceEvents.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
 
 //----------------------------------------------------------------------------------------------------------------------
 AbstractOptixRenderer::AbstractOptixRenderer()
@@ -6,6 +11,10 @@ AbstractOptixRenderer::AbstractOptixRenderer()
     // create an instance of our OptiX engine
     m_context = optix::Context::create();
     m_devicePixelRatio = 1;
+    // Launch our whole image until we are given a region
+    m_region[0] = m_region[1] = 0.f;
+    m_region[2] = m_region[3] = 1.f;
+    m_context["region_offset"]->setUint(0u,0u);
 }
 //----------------------------------------------------------------------------------------------------------------------
 AbstractOptixRenderer::~AbstractOptixRenderer()
@@ -29,11 +38,41 @@ void AbstractOptixRenderer::resize(unsigned int _width, unsigned int _height)
 //----------------------------------------------------------------------------------------------------------------------
 void AbstractOptixRenderer::trace()
 {
-    m_context->launch(0,m_width,m_height);
+    launchRegion(0);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void AbstractOptixRenderer::setRenderRegion(float _x, float _y, float _width, float _height)
+{
+    m_region[0] = std::min(std::max(_x,0.f),1.f);
+    m_region[1] = std::min(std::max(_y,0.f),1.f);
+    m_region[2] = std::min(std::max(_width,0.f),1.f-m_region[0]);
+    m_region[3] = std::min(std::max(_height,0.f),1.f-m_region[1]);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void AbstractOptixRenderer::getRenderRegion(unsigned int &_x, unsigned int &_y, unsigned int &_width, unsigned int &_height)
+{
+    // Round outwards so our region covers every pixel it touches
+    unsigned int x0 = std::min((unsigned int)std::floor(m_region[0]*m_width),m_width-1);
+    unsigned int y0 = std::min((unsigned int)std::floor(m_region[1]*m_height),m_height-1);
+    unsigned int x1 = std::min((unsigned int)std::ceil((m_region[0]+m_region[2])*m_width),m_width);
+    unsigned int y1 = std::min((unsigned int)std::ceil((m_region[1]+m_region[3])*m_height),m_height);
+    _x = x0;
+    _y = y0;
+    _width = std::max(x1,x0+1)-x0;
+    _height = std::max(y1,y0+1)-y0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void AbstractOptixRenderer::launchRegion(unsigned int _entryPointIndex, bool _fullFrame)
+{
+    unsigned int x = 0, y = 0, width = m_width, height = m_height;
+    if(!_fullFrame && hasRenderRegion() && m_width && m_height) getRenderRegion(x,y,width,height);
+    m_context["region_offset"]->setUint(x,y);
+    m_context->launch(_entryPointIndex,width,height);
 }
 //----------------------------------------------------------------------------------------------------------------------
 void AbstractOptixRenderer::setRayGenProgram(std::string _ptxPath, std::string _name, unsigned int _entryPointIndex)
 {
+    TraceScope trace("create program "+_name);
     optix::Program rg = m_context->createProgramFromPTXFile(_ptxPath,_name);
     m_context->setRayGenerationProgram(_entryPointIndex,rg);
 }
@@ -45,6 +84,7 @@ void AbstractOptixRenderer::setRayGenProgram(optix::Program &_rayGenProg, unsign
 //----------------------------------------------------------------------------------------------------------------------
 void AbstractOptixRenderer::setExceptionProgram(std::string _ptxPath, std::string _name, unsigned int _entryPointIndex)
 {
+    TraceScope trace("create program "+_name);
     optix::Program exep = m_context->createProgramFromPTXFile(_ptxPath,_name);
     m_context->setExceptionProgram(_entryPointIndex,exep);
 }
@@ -56,6 +96,7 @@ void AbstractOptixRenderer::setExceptionProgram(optix::Program &_excepProg, unsi
 //----------------------------------------------------------------------------------------------------------------------
 void AbstractOptixRenderer::setMissProgram(std::string _ptxPath, std::string _name, unsigned int _entryPointIndex)
 {
+    TraceScope trace("create program "+_name);
     optix::Program miss = m_context->createProgramFromPTXFile(_ptxPath,_name);
     m_context->setMissProgram(_entryPointIndex,miss);
 }
@@ -65,3 +106,77 @@ void AbstractOptixRenderer::setMissProgram(optix::Program &_missProg, unsigned i
     m_context->setMissProgram(_entryPointIndex,_missProg);
 }
 //----------------------------------------------------------------------------------------------------------------------
+bool AbstractOptixRenderer::applyEdits()
+{
+    bool rebuild = false;
+    bool edited = m_editQueue.apply(&rebuild);
+    if(rebuild) rebuildScene();
+    return edited;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void AbstractOptixRenderer::copyOutput(DisplayFrame &_frame)
+{
+    copyBuffer(m_outputBuffer,_frame);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void AbstractOptixRenderer::reportMemoryUsage()
+{
+    PerfMetrics::MemoryUsage usage;
+    usage.m_hostBytes = m_context->getUsedHostMemory();
+    usage.m_deviceUsedBytes = 0;
+    usage.m_deviceTotalBytes = 0;
+    std::vector<int> devices = m_context->getEnabledDevices();
+    for(unsigned int i=0;i<devices.size();i++)
+    {
+        RTsize total = 0;
+        m_context->getDeviceAttribute(devices[i],RT_DEVICE_ATTRIBUTE_TOTAL_MEMORY,sizeof(RTsize),&total);
+        RTsize available = m_context->getAvailableDeviceMemory(devices[i]);
+        usage.m_deviceTotalBytes += total;
+        usage.m_deviceUsedBytes += (total>available) ? total-available : 0;
+    }
+    PerfMetrics::getInstance()->setMemoryUsage(usage);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void AbstractOptixRenderer::setFrameInfo(DisplayFrame &_frame, unsigned int _width, unsigned int _height, DisplayFrame::Format _format)
+{
+    _frame.m_width = _width;
+    _frame.m_height = _height;
+    _frame.m_format = _format;
+    _frame.m_frameNumber = getFrameNumber();
+    _frame.m_samples = getFrameNumber()*getSamplesPerLaunch();
+    _frame.m_editVersion = m_editQueue.getAppliedVersion();
+    _frame.m_cost = false;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void AbstractOptixRenderer::copyBuffer(optix::Buffer _buffer, DisplayFrame &_frame)
+{
+    PerfScopedTimer timer(PerfMetrics::OutputReadback);
+    RTsize width, height;
+    _buffer->getSize(width,height);
+    RTsize elementSize = _buffer->getElementSize();
+
+    setFrameInfo(_frame,width,height,DisplayFrame::RGBA32F);
+    _frame.m_display.clear();
+    _frame.m_pixels.resize((elementSize/sizeof(float))*width*height);
+    if(_frame.m_pixels.empty()) return;
+
+    // Only read so that a buffer our launches also read from isn't uploaded again before our next launch
+    memcpy(&_frame.m_pixels[0],_buffer->map(0,RT_BUFFER_MAP_READ),elementSize*width*height);
+    _buffer->unmap();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void AbstractOptixRenderer::copyDisplayBuffer(optix::Buffer _buffer, DisplayFrame::Format _format, DisplayFrame &_frame)
+{
+    PerfScopedTimer timer(PerfMetrics::OutputReadback);
+    RTsize width, height;
+    _buffer->getSize(width,height);
+
+    setFrameInfo(_frame,width,height,_format);
+    _frame.m_pixels.clear();
+    _frame.m_display.resize(DisplayFrame::getBytesPerPixel(_format)*width*height);
+    if(_frame.m_display.empty()) return;
+
+    memcpy(&_frame.m_display[0],_buffer->map(),_frame.m_display.size());
+    _buffer->unmap();
+}
+//----------------------------------------------------------------------------------------------------------------------
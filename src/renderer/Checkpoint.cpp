@@ -0,0 +1,162 @@
+#include "renderer/Checkpoint.h"
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief identifies our files, followed by our version and a word that reads differently on a host of another byte order
+//----------------------------------------------------------------------------------------------------------------------
+static const char g_magic[8] = {'P','H','X','C','K','P','T','\0'};
+static const unsigned int g_version = 1;
+static const unsigned int g_byteOrder = 0x01020304;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief writes some bytes to our file and adds them to our checksum
+//----------------------------------------------------------------------------------------------------------------------
+static void writeBytes(std::ofstream &_file, const void *_data, size_t _size, unsigned long long &_checksum)
+{
+    _file.write((const char*)_data,_size);
+    _checksum = Checkpoint::hash(_data,_size,_checksum);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief reads some bytes from our file and adds them to our checksum
+//----------------------------------------------------------------------------------------------------------------------
+static bool readBytes(std::ifstream &_file, void *_data, size_t _size, unsigned long long &_checksum)
+{
+    _file.read((char*)_data,_size);
+    if(!_file.good()) return false;
+    _checksum = Checkpoint::hash(_data,_size,_checksum);
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+Checkpoint::Checkpoint() : m_width(0),
+                           m_height(0),
+                           m_frameNumber(0),
+                           m_sampleSeed(0),
+                           m_samplesPerLaunch(0),
+                           m_sceneHash(0)
+{
+    memset(m_camera,0,sizeof(m_camera));
+    memset(m_globalTransform,0,sizeof(m_globalTransform));
+}
+//----------------------------------------------------------------------------------------------------------------------
+unsigned long long Checkpoint::hash(const void *_data, size_t _size, unsigned long long _hash)
+{
+    const unsigned char *bytes = (const unsigned char*)_data;
+    for(size_t i=0;i<_size;i++)
+    {
+        _hash ^= bytes[i];
+        _hash *= 1099511628211ULL;
+    }
+    return _hash;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool Checkpoint::write(const std::string &_path, const Checkpoint &_checkpoint)
+{
+    size_t numValues = (size_t)_checkpoint.m_width*_checkpoint.m_height*3;
+    if(numValues==0 || _checkpoint.m_accumulation.size()!=numValues ||
+       (!_checkpoint.m_variance.empty() && _checkpoint.m_variance.size()!=numValues))
+    {
+        std::cerr<<"Checkpoint: our buffers don't match our resolution, not writing "<<_path<<std::endl;
+        return false;
+    }
+
+    std::string tempPath = _path+".tmp";
+    {
+        std::ofstream file(tempPath.c_str(),std::ios::binary);
+        if(!file.is_open())
+        {
+            std::cerr<<"Checkpoint: could not open "<<tempPath<<" for writing"<<std::endl;
+            return false;
+        }
+        unsigned long long checksum = hash(0,0);
+        unsigned int hasVariance = (_checkpoint.m_variance.empty()) ? 0 : 1;
+        writeBytes(file,g_magic,sizeof(g_magic),checksum);
+        writeBytes(file,&g_version,sizeof(g_version),checksum);
+        writeBytes(file,&g_byteOrder,sizeof(g_byteOrder),checksum);
+        writeBytes(file,&_checkpoint.m_width,sizeof(unsigned int),checksum);
+        writeBytes(file,&_checkpoint.m_height,sizeof(unsigned int),checksum);
+        writeBytes(file,&_checkpoint.m_frameNumber,sizeof(unsigned int),checksum);
+        writeBytes(file,&_checkpoint.m_sampleSeed,sizeof(unsigned int),checksum);
+        writeBytes(file,&_checkpoint.m_samplesPerLaunch,sizeof(unsigned int),checksum);
+        writeBytes(file,&hasVariance,sizeof(unsigned int),checksum);
+        writeBytes(file,&_checkpoint.m_sceneHash,sizeof(unsigned long long),checksum);
+        writeBytes(file,_checkpoint.m_camera,sizeof(_checkpoint.m_camera),checksum);
+        writeBytes(file,_checkpoint.m_globalTransform,sizeof(_checkpoint.m_globalTransform),checksum);
+        writeBytes(file,&_checkpoint.m_accumulation[0],numValues*sizeof(float),checksum);
+        if(hasVariance) writeBytes(file,&_checkpoint.m_variance[0],numValues*sizeof(float),checksum);
+        file.write((const char*)&checksum,sizeof(checksum));
+        file.flush();
+        if(!file.good())
+        {
+            std::cerr<<"Checkpoint: could not write "<<tempPath<<std::endl;
+            return false;
+        }
+    }
+#ifdef WIN32
+    // rename won't replace an existing file on windows
+    std::remove(_path.c_str());
+#endif
+    if(std::rename(tempPath.c_str(),_path.c_str())!=0)
+    {
+        std::cerr<<"Checkpoint: could not move "<<tempPath<<" to "<<_path<<std::endl;
+        return false;
+    }
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool Checkpoint::read(const std::string &_path, Checkpoint &_checkpoint)
+{
+    std::ifstream file(_path.c_str(),std::ios::binary);
+    if(!file.is_open())
+    {
+        std::cerr<<"Checkpoint: could not open "<<_path<<std::endl;
+        return false;
+    }
+    unsigned long long checksum = hash(0,0);
+    char magic[8];
+    unsigned int version = 0;
+    unsigned int byteOrder = 0;
+    if(!readBytes(file,magic,sizeof(magic),checksum) || memcmp(magic,g_magic,sizeof(magic))!=0)
+    {
+        std::cerr<<"Checkpoint: "<<_path<<" is not a checkpoint"<<std::endl;
+        return false;
+    }
+    readBytes(file,&version,sizeof(version),checksum);
+    readBytes(file,&byteOrder,sizeof(byteOrder),checksum);
+    if(version!=g_version || byteOrder!=g_byteOrder)
+    {
+        std::cerr<<"Checkpoint: "<<_path<<" was written by another version or a host of another byte order"<<std::endl;
+        return false;
+    }
+    unsigned int hasVariance = 0;
+    bool ok = readBytes(file,&_checkpoint.m_width,sizeof(unsigned int),checksum) &&
+              readBytes(file,&_checkpoint.m_height,sizeof(unsigned int),checksum) &&
+              readBytes(file,&_checkpoint.m_frameNumber,sizeof(unsigned int),checksum) &&
+              readBytes(file,&_checkpoint.m_sampleSeed,sizeof(unsigned int),checksum) &&
+              readBytes(file,&_checkpoint.m_samplesPerLaunch,sizeof(unsigned int),checksum) &&
+              readBytes(file,&hasVariance,sizeof(unsigned int),checksum) &&
+              readBytes(file,&_checkpoint.m_sceneHash,sizeof(unsigned long long),checksum) &&
+              readBytes(file,_checkpoint.m_camera,sizeof(_checkpoint.m_camera),checksum) &&
+              readBytes(file,_checkpoint.m_globalTransform,sizeof(_checkpoint.m_globalTransform),checksum);
+    // Guard against a corrupt header asking us for more memory than any render could have
+    size_t numValues = (size_t)_checkpoint.m_width*_checkpoint.m_height*3;
+    if(!ok || _checkpoint.m_width==0 || _checkpoint.m_height==0 || _checkpoint.m_width>32768 || _checkpoint.m_height>32768)
+    {
+        std::cerr<<"Checkpoint: "<<_path<<" has a bad header"<<std::endl;
+        return false;
+    }
+    _checkpoint.m_accumulation.resize(numValues);
+    _checkpoint.m_variance.resize((hasVariance) ? numValues : 0);
+    ok = readBytes(file,&_checkpoint.m_accumulation[0],numValues*sizeof(float),checksum);
+    if(ok && hasVariance) ok = readBytes(file,&_checkpoint.m_variance[0],numValues*sizeof(float),checksum);
+    unsigned long long expected = 0;
+    file.read((char*)&expected,sizeof(expected));
+    if(!ok || !file.good() || expected!=checksum)
+    {
+        std::cerr<<"Checkpoint: "<<_path<<" is incomplete or corrupt"<<std::endl;
+        return false;
+    }
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,228 @@
+#include "renderer/Film.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief number of steps we integrate our filter in to build its CDF
+//----------------------------------------------------------------------------------------------------------------------
+static const unsigned int g_cdfSteps = 1024;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief smallest number of rows worth giving a thread of their own when merging
+//----------------------------------------------------------------------------------------------------------------------
+static const unsigned int g_rowGrain = 16;
+//----------------------------------------------------------------------------------------------------------------------
+const float Film::m_maxRadius = (float)FILM_MAX_RADIUS;
+//----------------------------------------------------------------------------------------------------------------------
+const char *Film::getFilterName(Filter _filter)
+{
+    switch(_filter)
+    {
+        case(Box): return "Box";
+        case(Tent): return "Tent";
+        case(Gaussian): return "Gaussian";
+        case(BlackmanHarris): return "Blackman-Harris";
+        default: return "Unknown";
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+float Film::getDefaultRadius(Filter _filter)
+{
+    switch(_filter)
+    {
+        case(Tent): return 1.f;
+        case(Gaussian): return 1.5f;
+        case(BlackmanHarris): return 2.f;
+        default: return 0.5f;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+float Film::evaluate(Filter _filter, float _x, float _radius)
+{
+    float x = std::fabs(_x);
+    if(x>=_radius) return 0.f;
+    switch(_filter)
+    {
+        case(Tent): return _radius-x;
+        case(Gaussian):
+        {
+            // Shifted down so we reach 0 at our radius rather than being cut off there
+            float sigma = _radius/3.f;
+            float alpha = 1.f/(2.f*sigma*sigma);
+            return std::max(std::exp(-alpha*x*x)-std::exp(-alpha*_radius*_radius),0.f);
+        }
+        case(BlackmanHarris):
+        {
+            const float pi = 3.14159265358979f;
+            float t = 0.5f+0.5f*_x/_radius;
+            return 0.35875f - 0.48829f*std::cos(2.f*pi*t) + 0.14128f*std::cos(4.f*pi*t) - 0.01168f*std::cos(6.f*pi*t);
+        }
+        default: return 1.f;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void Film::buildSampleTable(Filter _filter, float _radius, float *_table)
+{
+    // Integrate our filter over [-radius,radius] and invert its CDF at equal steps of u
+    std::vector<float> cdf(g_cdfSteps+1);
+    float step = 2.f*_radius/g_cdfSteps;
+    cdf[0] = 0.f;
+    for(unsigned int i=0;i<g_cdfSteps;i++)
+    {
+        float x = -_radius+(i+0.5f)*step;
+        cdf[i+1] = cdf[i]+evaluate(_filter,x,_radius)*step;
+    }
+    float total = cdf[g_cdfSteps];
+    unsigned int j = 0;
+    for(unsigned int i=0;i<=FILM_FILTER_TABLE_SIZE;i++)
+    {
+        float target = total*i/FILM_FILTER_TABLE_SIZE;
+        while(j<g_cdfSteps-1 && cdf[j+1]<target) j++;
+        float range = cdf[j+1]-cdf[j];
+        float t = (range>0.f) ? std::min(std::max((target-cdf[j])/range,0.f),1.f) : 0.f;
+        _table[i] = -_radius+(j+t)*step;
+    }
+    _table[0] = -_radius;
+    _table[FILM_FILTER_TABLE_SIZE] = _radius;
+}
+//----------------------------------------------------------------------------------------------------------------------
+Film::Film(unsigned int _width, unsigned int _height, Filter _filter, float _radius, unsigned int _tileSize) :
+    m_width(_width),
+    m_height(_height),
+    m_tileSize(std::max(_tileSize,1u)),
+    m_filter(Box),
+    m_radius(0.5f)
+{
+    setFilter(_filter,_radius);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void Film::setFilter(Filter _filter, float _radius)
+{
+    m_filter = _filter;
+    m_radius = (_radius>0.f) ? std::min(_radius,m_maxRadius) : getDefaultRadius(_filter);
+    for(int i=0;i<FILM_FILTER_TABLE_SIZE;i++)
+        m_weights[i] = evaluate(_filter,(i+0.5f)*m_radius/FILM_FILTER_TABLE_SIZE,m_radius);
+    buildTiles();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void Film::resize(unsigned int _width, unsigned int _height)
+{
+    m_width = _width;
+    m_height = _height;
+    buildTiles();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void Film::buildTiles()
+{
+    m_tiles.clear();
+    m_pixels.assign(m_width*m_height*4,0.f);
+    // A sample in our tile can reach this many pixels past its edge
+    unsigned int pad = (unsigned int)std::ceil(m_radius);
+    for(unsigned int y=0;y<m_height;y+=m_tileSize)
+    {
+        for(unsigned int x=0;x<m_width;x+=m_tileSize)
+        {
+            Tile tile;
+            tile.m_x0 = x;
+            tile.m_y0 = y;
+            tile.m_x1 = std::min(x+m_tileSize,m_width);
+            tile.m_y1 = std::min(y+m_tileSize,m_height);
+            tile.m_px0 = (x>pad) ? x-pad : 0;
+            tile.m_py0 = (y>pad) ? y-pad : 0;
+            tile.m_width = std::min(tile.m_x1+pad,m_width)-tile.m_px0;
+            tile.m_height = std::min(tile.m_y1+pad,m_height)-tile.m_py0;
+            tile.m_pixels.assign(tile.m_width*tile.m_height*4,0.f);
+            m_tiles.push_back(tile);
+        }
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void Film::clear()
+{
+    std::fill(m_pixels.begin(),m_pixels.end(),0.f);
+    for(unsigned int i=0;i<m_tiles.size();i++) std::fill(m_tiles[i].m_pixels.begin(),m_tiles[i].m_pixels.end(),0.f);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void Film::addSample(Tile &_tile, float _x, float _y, const optix::float3 &_radiance) const
+{
+    // The pixels whose centres are within our radius, clipped to our padded buffer
+    int x0 = std::max((int)std::ceil(_x-0.5f-m_radius),(int)_tile.m_px0);
+    int x1 = std::min((int)std::floor(_x-0.5f+m_radius),(int)(_tile.m_px0+_tile.m_width)-1);
+    int y0 = std::max((int)std::ceil(_y-0.5f-m_radius),(int)_tile.m_py0);
+    int y1 = std::min((int)std::floor(_y-0.5f+m_radius),(int)(_tile.m_py0+_tile.m_height)-1);
+    if(x0>x1 || y0>y1) return;
+
+    // Our filter is separable so look up each axis once
+    float scale = FILM_FILTER_TABLE_SIZE/m_radius;
+    // A sample reaches at most 2*FILM_MAX_RADIUS+1 pixels along each axis
+    float wx[2*FILM_MAX_RADIUS+2], wy[2*FILM_MAX_RADIUS+2];
+    for(int x=x0;x<=x1;x++)
+    {
+        float d = std::fabs(x+0.5f-_x);
+        wx[x-x0] = (d<m_radius) ? m_weights[std::min((int)(d*scale),FILM_FILTER_TABLE_SIZE-1)] : 0.f;
+    }
+    for(int y=y0;y<=y1;y++)
+    {
+        float d = std::fabs(y+0.5f-_y);
+        wy[y-y0] = (d<m_radius) ? m_weights[std::min((int)(d*scale),FILM_FILTER_TABLE_SIZE-1)] : 0.f;
+    }
+
+    for(int y=y0;y<=y1;y++)
+    {
+        if(wy[y-y0]==0.f) continue;
+        float *row = &_tile.m_pixels[((y-_tile.m_py0)*_tile.m_width+(x0-_tile.m_px0))*4];
+        for(int x=x0;x<=x1;x++,row+=4)
+        {
+            float w = wx[x-x0]*wy[y-y0];
+            row[0] += _radiance.x*w;
+            row[1] += _radiance.y*w;
+            row[2] += _radiance.z*w;
+            row[3] += w;
+        }
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void Film::merge()
+{
+    // Each row of our film is only written by the thread merging it, whichever tiles overlap it
+    parallelFor(m_height,g_rowGrain,[&](unsigned int _begin, unsigned int _end, unsigned int)
+    {
+        for(unsigned int y=_begin;y<_end;y++)
+        {
+            for(unsigned int t=0;t<m_tiles.size();t++)
+            {
+                Tile &tile = m_tiles[t];
+                if(y<tile.m_py0 || y>=tile.m_py0+tile.m_height) continue;
+                float *src = &tile.m_pixels[(y-tile.m_py0)*tile.m_width*4];
+                float *dst = &m_pixels[(y*m_width+tile.m_px0)*4];
+                for(unsigned int i=0;i<tile.m_width*4;i++) dst[i] += src[i];
+                memset(src,0,tile.m_width*4*sizeof(float));
+            }
+        }
+    });
+}
+//----------------------------------------------------------------------------------------------------------------------
+void Film::resolve(DisplayFrame &_frame) const
+{
+    _frame.m_format = DisplayFrame::RGBA32F;
+    _frame.m_width = m_width;
+    _frame.m_height = m_height;
+    _frame.m_cost = false;
+    _frame.m_display.clear();
+    _frame.m_pixels.resize(m_width*m_height*4);
+    unsigned int numPixels = m_width*m_height;
+    parallelFor(numPixels,g_rowGrain*m_width,[&](unsigned int _begin, unsigned int _end, unsigned int)
+    {
+        for(unsigned int i=_begin;i<_end;i++)
+        {
+            const float *src = &m_pixels[i*4];
+            float *dst = &_frame.m_pixels[i*4];
+            float invW = (src[3]>0.f) ? 1.f/src[3] : 0.f;
+            dst[0] = src[0]*invW;
+            dst[1] = src[1]*invW;
+            dst[2] = src[2]*invW;
+            dst[3] = 1.f;
+        }
+    });
+}
+//----------------------------------------------------------------------------------------------------------------------
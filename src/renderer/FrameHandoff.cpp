@@ -0,0 +1,64 @@
+#include "renderer/FrameHandoff.h"
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief converts a half to a float, resolved frames are in [0,1] so we don't bother with denormals
+//----------------------------------------------------------------------------------------------------------------------
+static float halfToFloat(unsigned short _h)
+{
+    unsigned int sign = (_h & 0x8000u) << 16;
+    unsigned int exponent = (_h >> 10) & 0x1fu;
+    unsigned int mantissa = _h & 0x3ffu;
+    unsigned int bits = sign;
+    if(exponent==31) bits |= 0x7f800000u | (mantissa << 13);
+    else if(exponent!=0) bits |= ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    float f;
+    memcpy(&f,&bits,sizeof(f));
+    return f;
+}
+//----------------------------------------------------------------------------------------------------------------------
+unsigned int DisplayFrame::getBytesPerPixel(Format _format)
+{
+    switch(_format)
+    {
+        case(RGBA16F): return 4*sizeof(unsigned short);
+        case(RGBA8): return 4;
+        default: return 4*sizeof(float);
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void DisplayFrame::getPixel(unsigned int _index, float *_rgba) const
+{
+    for(int c=0;c<4;c++)
+    {
+        switch(m_format)
+        {
+            case(RGBA16F): _rgba[c] = halfToFloat(reinterpret_cast<const unsigned short*>(&m_display[0])[_index*4+c]); break;
+            case(RGBA8): _rgba[c] = m_display[_index*4+c]/255.f; break;
+            default: _rgba[c] = m_pixels[_index*4+c]; break;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+FrameHandoff::FrameHandoff() : m_back(0), m_front(1), m_ready(2)
+{
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FrameHandoff::publish()
+{
+    // Swap our back frame with the spare frame and mark it as fresh
+    int prev = m_ready.exchange(m_back | m_freshBit, std::memory_order_acq_rel);
+    m_back = prev & m_indexMask;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool FrameHandoff::acquire()
+{
+    // Nothing new has been published since we last looked
+    if(!(m_ready.load(std::memory_order_acquire) & m_freshBit)) return false;
+    // Swap our front frame with the fresh spare frame
+    int prev = m_ready.exchange(m_front, std::memory_order_acq_rel);
+    m_front = prev & m_indexMask;
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
@@ -2,21 +2,39 @@
 #include <QColor>
 #include <QTime>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 #define GLM_FORCE_RADIANS
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/matrix_inverse.hpp>
 #include "geometry/Parallelogram.h"
 #include "geometry/Sphere.h"
+#include "common/HDRLoader.h"
+#include "perf/PerfMetrics.h"
+#include "perf/TraceEvents.h"
 
 //----------------------------------------------------------------------------------------------------------------------
 PathTracerScene::PathTracerScene()  : AbstractOptixRenderer(),
                                     m_totalNumPolygons(0),
                                     m_cameraChanged(false),
+                                    m_camera(0),
                                     m_rr_begin_depth(1u),
                                     m_sqrt_num_samples( 2u ),
                                     m_frame(0),
-                                    m_translateEnviroment(false)
+                                    m_translateEnviroment(false),
+                                    m_testMesh(0),
+                                    m_countRays(false),
+                                    m_costView(false),
+                                    m_traceFullFrame(true),
+                                    m_displayFormat(DisplayFrame::RGBA8),
+                                    m_autoExposureEnabled(true),
+                                    m_exposureMeasured(false),
+                                    m_sampleSeed(0),
+                                    m_filter(Film::Box),
+                                    m_filterRadius(0.5f),
+                                    m_fireflySigmas(0.f),
+                                    m_compensateAccumulation(true)
 {
     AbstractOptixRenderer::resize(512,512);
 }
@@ -30,14 +48,23 @@ PathTracerScene::~PathTracerScene()
 
 //----------------------------------------------------------------------------------------------------------------------
 void PathTracerScene::initialize()
+{
+    TraceScope trace("PathTracerScene::initialize");
+    initializeContext();
+
+    // Just some test geometry for now
+    loadTestGeomtry();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::initializeContext()
 {
     // Grab our context
     optix::Context context = getContext();
     // how many ray types we have
     // we have our light ray, shadow ray and a bsdf shadow ray
     context->setRayTypeCount( 2 );
-    // we only have one entry point which is our output buffer
-    context->setEntryPointCount( 1 );
+    // our path tracer writing our output buffer and the resolve of our output buffer for display
+    context->setEntryPointCount( 2 );
     // sets the stack size important for recursion
     // we want this to be as big as our hardware will allow us
     // so that we can send as many rays as the user desires
@@ -48,6 +75,7 @@ void PathTracerScene::initialize()
     context["pathtrace_ray_type"]->setUint(0u);
     context["pathtrace_shadow_ray_type"]->setUint(1u);
     context["rr_begin_depth"]->setUint(m_rr_begin_depth);
+    context["sample_seed"]->setUint(0u);
 
     // Enable printing on the GPU
     rtContextSetPrintEnabled(context->get(), 1);
@@ -55,17 +83,59 @@ void PathTracerScene::initialize()
     rtContextSetExceptionEnabled(context->get(), RT_EXCEPTION_ALL, 1);
 
     // create our output buffer and set it in our engine
+    // this is a plain optix buffer rather than an openGL one as we launch from our render thread
+    // which doesn't own the GL context. Completed frames are copied out with copyOutput().
+    // It is an input as well so that a restored checkpoint can be uploaded into it.
     optix::Variable output_buffer = context["output_buffer"];
-    GLuint vbo = 0;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER,vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 4 * m_width * m_height, 0, GL_STREAM_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER,0);
-
-    m_outputBuffer = context->createBufferFromGLBO(RT_BUFFER_OUTPUT,vbo);
-    m_outputBuffer->setFormat(RT_FORMAT_FLOAT4);
-    m_outputBuffer->setSize(m_width/m_devicePixelRatio,m_height/m_devicePixelRatio);
+    m_outputBuffer = context->createBuffer(RT_BUFFER_INPUT_OUTPUT,RT_FORMAT_FLOAT4,m_width/m_devicePixelRatio,m_height/m_devicePixelRatio);
     output_buffer->set(m_outputBuffer);
+    // the mean square of our launches accumulated alongside our output, saved in our checkpoints
+    m_varianceBuffer = context->createBuffer(RT_BUFFER_INPUT_OUTPUT,RT_FORMAT_FLOAT4,m_width/m_devicePixelRatio,m_height/m_devicePixelRatio);
+    context["variance_buffer"]->set(m_varianceBuffer);
+    // what float32 rounds away from both of them, carried into our next launch
+    m_compensationBuffer = context->createBuffer(RT_BUFFER_INPUT_OUTPUT,RT_FORMAT_FLOAT4,m_width/m_devicePixelRatio,m_height/m_devicePixelRatio);
+    context["compensation_buffer"]->set(m_compensationBuffer);
+    m_varianceCompensationBuffer = context->createBuffer(RT_BUFFER_INPUT_OUTPUT,RT_FORMAT_FLOAT4,m_width/m_devicePixelRatio,m_height/m_devicePixelRatio);
+    context["variance_compensation_buffer"]->set(m_varianceCompensationBuffer);
+    context["compensate_accumulation"]->setUint((m_compensateAccumulation) ? 1u : 0u);
+    context["firefly_sigmas"]->setFloat(m_fireflySigmas);
+
+    // the inverse CDF of our reconstruction filter our samples are placed with, a box until we are told otherwise
+    m_filterBuffer = context->createBuffer(RT_BUFFER_INPUT,RT_FORMAT_FLOAT,FILM_FILTER_TABLE_SIZE+1);
+    context["filter_table"]->set(m_filterBuffer);
+    setFilter(m_filter,m_filterRadius);
+
+    // buffer to count our rays in, only written by our path tracer when count_rays is set
+    m_rayCounterBuffer = context->createBuffer(RT_BUFFER_INPUT_OUTPUT,RT_FORMAT_UNSIGNED_INT,3);
+    memset(m_rayCounterBuffer->map(),0,3*sizeof(unsigned int));
+    m_rayCounterBuffer->unmap();
+    context["ray_counters"]->set(m_rayCounterBuffer);
+    context["count_rays"]->setUint(0u);
+    // and our path statistics, written along with our ray counts
+    m_pathStatsBuffer = context->createBuffer(RT_BUFFER_INPUT_OUTPUT,RT_FORMAT_UNSIGNED_INT,PATH_STATS_SIZE);
+    memset(m_pathStatsBuffer->map(),0,PATH_STATS_SIZE*sizeof(unsigned int));
+    m_pathStatsBuffer->unmap();
+    context["path_stats"]->set(m_pathStatsBuffer);
+    m_pathThroughputBuffer = context->createBuffer(RT_BUFFER_INPUT_OUTPUT,RT_FORMAT_FLOAT,PATH_STATS_NUM_TERMINATIONS);
+    memset(m_pathThroughputBuffer->map(),0,PATH_STATS_NUM_TERMINATIONS*sizeof(float));
+    m_pathThroughputBuffer->unmap();
+    context["path_throughput"]->set(m_pathThroughputBuffer);
+
+    // buffers for our cost view, these stay 1x1 until our cost view is enabled
+    m_costBuffer = context->createBuffer(RT_BUFFER_OUTPUT,RT_FORMAT_FLOAT4,1,1);
+    context["cost_buffer"]->set(m_costBuffer);
+    m_primTestBuffer = context->createBuffer(RT_BUFFER_INPUT_OUTPUT|RT_BUFFER_GPU_LOCAL,RT_FORMAT_UNSIGNED_INT,1,1);
+    context["prim_tests"]->set(m_primTestBuffer);
+    context["debug_cost"]->setUint(0u);
+
+    // buffer our output is resolved into for display, 4 or 8 bytes a pixel rather than our output's 16
+    m_displayBuffer = context->createBuffer(RT_BUFFER_OUTPUT,RT_FORMAT_UNSIGNED_BYTE4,m_width/m_devicePixelRatio,m_height/m_devicePixelRatio);
+    context["display_buffer_rgba8"]->set(m_displayBuffer);
+    context["display_buffer_rgba16f"]->set(m_displayBuffer);
+    context["exposure"]->setFloat(m_displayParams.m_exposure);
+    context["tonemap_enabled"]->setUint((m_displayParams.m_tonemap) ? 1u : 0u);
+    context["tonemap_log_av"]->setFloat(m_displayParams.m_logAverage);
+    context["tonemap_white"]->setFloat(m_displayParams.m_white);
 
     m_camera = new PathTraceCamera(optix::make_float3( 278.0f, 273.0f, -900.0f ),   //eye
                                  optix::make_float3( 278.0f, 273.0f,    0.0f  ),       //lookat
@@ -83,9 +153,9 @@ void PathTracerScene::initialize()
     context["aperture_radius"]->setFloat(0.0);
     context["focal_point"]->setFloat(0.0, 0.0, 0.0);
 
-    //set our max ray depth
-    context["maxDepth"]->setUint(5);
-    m_maxRayDepth = 5;
+    //set our max ray depth, deep enough that our russian roulette ends nearly all of our paths first
+    context["maxDepth"]->setUint(16);
+    m_maxRayDepth = 16;
     context["sqrt_num_samples"]->setUint(m_sqrt_num_samples );
     context["bad_color"]->setFloat( 233.f, 5.0f, 150.0f );
     context["bg_color"]->setFloat( optix::make_float3(0.f,0.f,0.f) );
@@ -98,10 +168,19 @@ void PathTracerScene::initialize()
 
     // Setup programs
     std::string ptx_path = "ptx/path_tracer.cu.ptx";
-    setRayGenProgram(ptx_path,"pathtrace_camera");
-    //optix::Program ray_gen_program = m_context->createProgramFromPTXFile( ptx_path, "depth_of_field_camera" );
-    setExceptionProgram(ptx_path,"exception");
-    setMissProgram(ptx_path,"miss");
+    {
+        TraceScope trace("create path tracer programs");
+        setRayGenProgram(ptx_path,"pathtrace_camera");
+        //optix::Program ray_gen_program = m_context->createProgramFromPTXFile( ptx_path, "depth_of_field_camera" );
+        setExceptionProgram(ptx_path,"exception");
+        setMissProgram(ptx_path,"miss");
+    }
+    {
+        TraceScope trace("create display resolve programs");
+        m_resolveRGBA8 = context->createProgramFromPTXFile("ptx/display_resolve.cu.ptx","resolve_rgba8");
+        m_resolveRGBA16F = context->createProgramFromPTXFile("ptx/display_resolve.cu.ptx","resolve_rgba16f");
+        setRayGenProgram(m_resolveRGBA8,1);
+    }
     //m_context->setMissProgram( 0, m_context->createProgramFromPTXFile( ptx_path, "envi_miss" ) );
 
 
@@ -128,20 +207,30 @@ void PathTracerScene::initialize()
     context["top_object"]->set(m_topGroup);
 
     // Finalize
-    context->validate();
-    context->compile();
+    {
+        TraceScope trace("validate and compile context");
+        context->validate();
+        context->compile();
+    }
 
     // Set our default material for any geomery we import
     // Set up material
-    Material diffuse = context->createMaterial();
-    optix::Program diffuse_ch = context->createProgramFromPTXFile( ptx_path, "diffuse" );
-    optix::Program diffuse_ah = context->createProgramFromPTXFile( ptx_path, "shadow" );
-    diffuse->setClosestHitProgram( 0, diffuse_ch );
-    diffuse->setAnyHitProgram( 1, diffuse_ah );
-    setDefaultMaterial(diffuse);
-
-    // Just some test geometry for now
-    loadTestGeomtry();
+    {
+        TraceScope trace("create default material");
+        Material diffuse = context->createMaterial();
+        optix::Program diffuse_ch = context->createProgramFromPTXFile( ptx_path, "diffuse" );
+        optix::Program diffuse_ah = context->createProgramFromPTXFile( ptx_path, "shadow" );
+        diffuse->setClosestHitProgram( 0, diffuse_ch );
+        diffuse->setAnyHitProgram( 1, diffuse_ah );
+        setDefaultMaterial(diffuse);
+    }
+
+    // Our lights, empty until some are set
+    m_lightBuffer = context->createBuffer( RT_BUFFER_INPUT );
+    m_lightBuffer->setFormat( RT_FORMAT_USER );
+    m_lightBuffer->setElementSize( sizeof( ParallelogramLight ) );
+    m_lightBuffer->setSize( 0u );
+    context["lights"]->setBuffer( m_lightBuffer );
 }
 //----------------------------------------------------------------------------------------------------------------------
 void PathTracerScene::trace()
@@ -149,9 +238,48 @@ void PathTracerScene::trace()
     //if our camera has changed then update it in our engine
     if(m_cameraChanged) updateCamera();
 
+    // Build any dirty acceleration structures with an empty launch so that
+    // the build is timed separately from our trace
+    if(m_globalTransGroup->getAcceleration()->isDirty())
+    {
+        PerfScopedTimer timer(PerfMetrics::AccelBuild);
+        getContext()->launch(0,0,0);
+    }
+
+    if(m_countRays)
+    {
+        memset(m_rayCounterBuffer->map(),0,3*sizeof(unsigned int));
+        m_rayCounterBuffer->unmap();
+        memset(m_pathStatsBuffer->map(),0,PATH_STATS_SIZE*sizeof(unsigned int));
+        m_pathStatsBuffer->unmap();
+        memset(m_pathThroughputBuffer->map(),0,PATH_STATS_NUM_TERMINATIONS*sizeof(float));
+        m_pathThroughputBuffer->unmap();
+    }
+
     //launch it
-    getContext()["frame_number"]->setUint( m_frame++ );
-    getContext()->launch(0,m_width,m_height);
+    {
+        PerfScopedTimer timer(PerfMetrics::Trace);
+        getContext()["frame_number"]->setUint( m_frame++ );
+        launchRegion(0,m_traceFullFrame);
+        m_traceFullFrame = false;
+    }
+
+    if(m_countRays)
+    {
+        unsigned int *counts = static_cast<unsigned int*>(m_rayCounterBuffer->map());
+        PerfMetrics::getInstance()->setLaunchRayCounts(counts[0],counts[1],counts[2]);
+        m_rayCounterBuffer->unmap();
+
+        PerfMetrics::PathStats stats;
+        unsigned int *paths = static_cast<unsigned int*>(m_pathStatsBuffer->map());
+        for(int i=0;i<PATH_STATS_LENGTH_BINS;i++) stats.m_lengths[i] = paths[i];
+        for(int i=0;i<PATH_STATS_NUM_TERMINATIONS;i++) stats.m_terminations[i] = paths[PATH_STATS_LENGTH_BINS+i];
+        m_pathStatsBuffer->unmap();
+        float *throughput = static_cast<float*>(m_pathThroughputBuffer->map());
+        for(int i=0;i<PATH_STATS_NUM_TERMINATIONS;i++) stats.m_throughput[i] = throughput[i];
+        m_pathThroughputBuffer->unmap();
+        PerfMetrics::getInstance()->setLaunchPathStats(stats);
+    }
 }
 //----------------------------------------------------------------------------------------------------------------------
 void PathTracerScene::addGeometry(AbstractOptixGeometry *_geo)
@@ -182,23 +310,34 @@ void PathTracerScene::resize(unsigned int _width,unsigned int _height)
     m_width = _width/m_devicePixelRatio;
     m_height = _height/m_devicePixelRatio;
 
-    unsigned int elementSize = m_outputBuffer->getElementSize();
-    GLuint handleID = m_outputBuffer->getGLBOId();
-
     float aR = (float)_width/(float)_height;
     m_camera->setParameters(m_camera->m_eye,m_camera->m_lookat,m_camera->m_up,35.f*aR,35.f);
     updateCamera();
 
     m_outputBuffer->setSize(m_width,m_height);
-    m_outputBuffer->unregisterGLBuffer();
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, handleID);
-    glBufferData(GL_PIXEL_UNPACK_BUFFER, elementSize * m_width * m_height, 0, GL_STREAM_DRAW);
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
-    m_outputBuffer->registerGLBuffer();
+    m_varianceBuffer->setSize(m_width,m_height);
+    m_compensationBuffer->setSize(m_width,m_height);
+    m_varianceCompensationBuffer->setSize(m_width,m_height);
+    m_traceFullFrame = true;
+    if(m_displayFormat!=DisplayFrame::RGBA32F) m_displayBuffer->setSize(m_width,m_height);
+    if(m_costView)
+    {
+        m_costBuffer->setSize(m_width,m_height);
+        m_primTestBuffer->setSize(m_width,m_height);
+    }
 
     m_frame = 0;
 }
 //----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::setRenderRegion(float _x, float _y, float _width, float _height)
+{
+    float last[4] = {m_region[0],m_region[1],m_region[2],m_region[3]};
+    AbstractOptixRenderer::setRenderRegion(_x,_y,_width,_height);
+    bool shrunk = m_region[0]>=last[0] && m_region[1]>=last[1] &&
+                  m_region[0]+m_region[2]<=last[0]+last[2] && m_region[1]+m_region[3]<=last[1]+last[3];
+    if(!shrunk) m_frame = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
 void PathTracerScene::rebuildScene()
 {
     // Mark our acceleration dirty so it rebuilds
@@ -209,6 +348,7 @@ void PathTracerScene::rebuildScene()
 //----------------------------------------------------------------------------------------------------------------------
 void PathTracerScene::updateCamera()
 {
+    PerfScopedTimer timer(PerfMetrics::CameraUpdate);
     float3 eye,U,V,W;
     m_camera->getEyeUVW(eye,U,V,W);
 
@@ -267,6 +407,32 @@ optix::GeometryInstance PathTracerScene::createParallelogram(const float3& ancho
 //----------------------------------------------------------------------------------------------------------------------
 void PathTracerScene::loadTestGeomtry()
 {
+    TraceScope trace("PathTracerScene::loadTestGeomtry");
+    loadCornellBox();
+
+    m_testMesh = new Mesh(getContext());
+    m_testMesh->importGeometry("models/killeroo.obj");
+    if(m_testMesh->getNumPolygons()==0)
+    {
+        std::cerr<<"Could not load our test mesh, leaving it out of our scene"<<std::endl;
+        delete m_testMesh;
+        m_testMesh = 0;
+        return;
+    }
+    m_testMesh->setPos(556.f/2.f,0.f,559.2f/3.f);
+    m_testMesh->setScale(15.f,15.f,15.f);
+    optix::Material diffuse = getDefaultMaterial();
+    m_testMesh->setMaterial(diffuse);
+    m_testMesh->getGeometryInstance()["diffuse_color"]->setFloat(optix::make_float3( 0.9f, 0.9f, 0.9f ));
+    m_globalTransGroup->addChild(m_testMesh->getGeomAndTrans());
+
+    // Mark our acceleration dirty so it rebuilds
+    m_globalTransGroup->getAcceleration()->markDirty();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::loadCornellBox()
+{
+    TraceScope trace("PathTracerScene::loadCornellBox");
     // Light buffer
     ParallelogramLight light;
     light.corner   = optix::make_float3( 418.0f, 548.6f, 152.0f);
@@ -274,19 +440,14 @@ void PathTracerScene::loadTestGeomtry()
     light.v2       = optix::make_float3( 0.0f, 0.0f, 105.0f);
     light.normal   = normalize( cross(light.v1, light.v2) );
     light.emission = optix::make_float3( 15.0f, 15.0f, 15.0f );
+    setLights(std::vector<ParallelogramLight>(1,light));
 
     optix::Context context = getContext();
-    optix::Buffer light_buffer = context->createBuffer( RT_BUFFER_INPUT );
-    light_buffer->setFormat( RT_FORMAT_USER );
-    light_buffer->setElementSize( sizeof( ParallelogramLight ) );
-    light_buffer->setSize( 1u );
-    memcpy( light_buffer->map(), &light, sizeof( light ) );
-    light_buffer->unmap();
-    context["lights"]->setBuffer( light_buffer );
 
 
     // Set up material
     std::string ptx_path = "ptx/path_tracer.cu.ptx";
+    std::chrono::steady_clock::time_point materialStart = std::chrono::steady_clock::now();
     Material diffuse = context->createMaterial();
     optix::Program diffuse_ch = context->createProgramFromPTXFile( ptx_path, "diffuse" );
     optix::Program diffuse_ah = context->createProgramFromPTXFile( ptx_path, "shadow" );
@@ -300,6 +461,7 @@ void PathTracerScene::loadTestGeomtry()
     optix::Material diffuse_light = context->createMaterial();
     optix::Program diffuse_em = context->createProgramFromPTXFile( ptx_path, "diffuseEmitter" );
     diffuse_light->setClosestHitProgram( 0, diffuse_em );
+    TraceEvents::getInstance()->addEvent("create test materials","startup",materialStart,std::chrono::steady_clock::now());
 
 
     const float3 white = optix::make_float3( 0.9f, 0.9f, 0.9f );
@@ -377,23 +539,343 @@ void PathTracerScene::loadTestGeomtry()
     l.getGeometryInstance()["emission_color"]->setFloat(light_em);
     m_globalTransGroup->addChild(l.getGeomAndTrans());
 
-    m_testMesh = new Mesh(getContext());
-    m_testMesh->importGeometry("models/killeroo.obj");
-    m_testMesh->setPos(556.f/2.f,0.f,559.2f/3.f);
-    m_testMesh->setScale(15.f,15.f,15.f);
-    m_testMesh->setMaterial(diffuse);
-    m_testMesh->getGeometryInstance()["diffuse_color"]->setFloat(white);
-    m_globalTransGroup->addChild(m_testMesh->getGeomAndTrans());
-
 
     // Mark our acceleration dirty so it rebuilds
     m_globalTransGroup->getAcceleration()->markDirty();
 }
 //----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::setLights(const std::vector<ParallelogramLight> &_lights)
+{
+    PerfScopedTimer timer(PerfMetrics::BufferUpload);
+    m_lightBuffer->setSize(_lights.size());
+    if(!_lights.empty())
+    {
+        memcpy( m_lightBuffer->map(), &_lights[0], _lights.size()*sizeof( ParallelogramLight ) );
+        m_lightBuffer->unmap();
+    }
+    m_frame = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool PathTracerScene::setEnvironmentMap(const std::string &_path)
+{
+    std::string ptx_path = "ptx/path_tracer.cu.ptx";
+    if(_path.empty())
+    {
+        setMissProgram(ptx_path,"miss");
+        m_environmentMap.clear();
+        m_frame = 0;
+        return true;
+    }
+
+    TraceScope trace("load environment map "+_path);
+    m_enviSampler = loadHDRTexture(getContext(),_path,optix::make_float3(0.f,0.f,0.f));
+    // loadHDRTexture falls back to a 1x1 texture of our default colour if it fails
+    RTsize width, height;
+    m_enviSampler->getBuffer(0u,0u)->getSize(width,height);
+    if(width<=1 && height<=1)
+    {
+        std::cerr<<"Could not load environment map "<<_path<<std::endl;
+        return false;
+    }
+    getContext()["envmap"]->setTextureSampler(m_enviSampler);
+    setMissProgram(ptx_path,"envmap_miss");
+    m_environmentMap = _path;
+    m_frame = 0;
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::setSampleSeed(unsigned int _seed)
+{
+    getContext()["sample_seed"]->setUint(_seed);
+    m_sampleSeed = _seed;
+    m_frame = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::setFilter(Film::Filter _filter, float _radius)
+{
+    m_filter = _filter;
+    m_filterRadius = (_radius>0.f) ? std::min(_radius,Film::m_maxRadius) : Film::getDefaultRadius(_filter);
+    PerfScopedTimer timer(PerfMetrics::BufferUpload);
+    Film::buildSampleTable(m_filter,m_filterRadius,static_cast<float*>(m_filterBuffer->map()));
+    m_filterBuffer->unmap();
+    m_frame = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::setFireflyClamp(float _sigmas)
+{
+    m_fireflySigmas = std::max(_sigmas,0.f);
+    getContext()["firefly_sigmas"]->setFloat(m_fireflySigmas);
+    m_frame = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::setCompensatedAccumulation(bool _enable)
+{
+    if(_enable==m_compensateAccumulation) return;
+    m_compensateAccumulation = _enable;
+    // Our compensation wasn't kept up while we were disabled so carry on from nothing rather than what it was
+    if(_enable) clearCompensation();
+    getContext()["compensate_accumulation"]->setUint((_enable) ? 1u : 0u);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::clearCompensation()
+{
+    RTsize width = 0, height = 0;
+    m_compensationBuffer->getSize(width,height);
+    memset(m_compensationBuffer->map(),0,width*height*4*sizeof(float));
+    m_compensationBuffer->unmap();
+    memset(m_varianceCompensationBuffer->map(),0,width*height*4*sizeof(float));
+    m_varianceCompensationBuffer->unmap();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::setRRBeginDepth(unsigned int _depth)
+{
+    m_rr_begin_depth = _depth;
+    getContext()["rr_begin_depth"]->setUint(_depth);
+    m_frame = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::setRayCounting(bool _count)
+{
+    m_countRays = _count;
+    getContext()["count_rays"]->setUint(_count ? 1u : 0u);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::setCostView(bool _enable)
+{
+    m_costView = _enable;
+    getContext()["debug_cost"]->setUint(_enable ? 1u : 0u);
+    // Only hold full size buffers while we need them
+    unsigned int width = (_enable) ? m_width : 1u;
+    unsigned int height = (_enable) ? m_height : 1u;
+    m_costBuffer->setSize(width,height);
+    m_primTestBuffer->setSize(width,height);
+    m_frame = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::copyOutput(DisplayFrame &_frame)
+{
+    copyBuffer((m_costView) ? m_costBuffer : m_outputBuffer,_frame);
+    _frame.m_cost = m_costView;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::copyDisplay(DisplayFrame &_frame)
+{
+    if(m_costView || m_displayFormat==DisplayFrame::RGBA32F)
+    {
+        copyOutput(_frame);
+        return;
+    }
+    {
+        PerfScopedTimer timer(PerfMetrics::DisplayResolve);
+        if(m_autoExposureEnabled) updateAutoExposure();
+        getContext()->launch(1,m_width,m_height);
+    }
+    copyDisplayBuffer(m_displayBuffer,m_displayFormat,_frame);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::updateAutoExposure()
+{
+    // Measuring means reading back our whole float output so only do it often enough for our adaptation to look smooth
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    float seconds = std::chrono::duration<float>(now-m_lastExposureUpdate).count();
+    if(m_exposureMeasured && seconds<0.1f) return;
+
+    RTsize width, height;
+    m_outputBuffer->getSize(width,height);
+    AutoExposure::LuminanceStats stats = AutoExposure::measure(static_cast<const float*>(m_outputBuffer->map(0,RT_BUFFER_MAP_READ)),width*height);
+    m_outputBuffer->unmap();
+
+    m_autoExposure.update(stats,(m_exposureMeasured) ? seconds : 0.f);
+    m_exposureMeasured = true;
+    m_lastExposureUpdate = now;
+    m_autoExposure.getParams(m_displayParams);
+    setTonemapParams(m_displayParams.m_logAverage,m_displayParams.m_white);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::setDisplayFormat(DisplayFrame::Format _format)
+{
+    m_displayFormat = _format;
+    // Only hold a full size buffer while we need it
+    if(_format==DisplayFrame::RGBA32F)
+    {
+        m_displayBuffer->setSize(1u,1u);
+        return;
+    }
+    bool half = _format==DisplayFrame::RGBA16F;
+    m_displayBuffer->setFormat((half) ? RT_FORMAT_HALF4 : RT_FORMAT_UNSIGNED_BYTE4);
+    m_displayBuffer->setSize(m_width,m_height);
+    setRayGenProgram((half) ? m_resolveRGBA16F : m_resolveRGBA8,1);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::setExposure(float _stops)
+{
+    m_displayParams.m_exposure = powf(2.f,_stops);
+    getContext()["exposure"]->setFloat(m_displayParams.m_exposure);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::setTonemap(bool _enable)
+{
+    m_displayParams.m_tonemap = _enable;
+    getContext()["tonemap_enabled"]->setUint((_enable) ? 1u : 0u);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::setTonemapParams(float _logAverage, float _white)
+{
+    m_displayParams.m_logAverage = std::max(_logAverage,1e-6f);
+    m_displayParams.m_white = std::max(_white,1e-6f);
+    getContext()["tonemap_log_av"]->setFloat(m_displayParams.m_logAverage);
+    getContext()["tonemap_white"]->setFloat(m_displayParams.m_white);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void PathTracerScene::setAutoExposure(bool _enable)
+{
+    m_autoExposureEnabled = _enable;
+    // Adapt from scratch next time we're enabled, and go back to our fixed key while we're not
+    m_autoExposure.reset();
+    m_exposureMeasured = false;
+    if(!_enable)
+    {
+        AutoExposure::Params defaults;
+        setTonemapParams(defaults.m_logAverage,defaults.m_white);
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
 void PathTracerScene::cleanTopAcceleration()
 {
     m_globalTransGroup->getAcceleration()->markDirty();
     m_frame = 0;
 }
 //----------------------------------------------------------------------------------------------------------------------
+bool PathTracerScene::saveCheckpoint(Checkpoint &_checkpoint)
+{
+    // Our cost view doesn't accumulate anything worth resuming, and with a region our pixels have had different
+    // numbers of frames so our frame number can't describe them
+    if(m_costView || m_frame==0 || hasRenderRegion()) return false;
+
+    _checkpoint.m_width = m_width;
+    _checkpoint.m_height = m_height;
+    _checkpoint.m_frameNumber = m_frame;
+    _checkpoint.m_sampleSeed = m_sampleSeed;
+    _checkpoint.m_samplesPerLaunch = getSamplesPerLaunch();
+    _checkpoint.m_sceneHash = getSceneHash();
+    float3 camera[3] = {m_camera->m_eye,m_camera->m_lookat,m_camera->m_up};
+    memcpy(_checkpoint.m_camera,camera,sizeof(camera));
+    _checkpoint.m_camera[9] = m_camera->m_hfov;
+    _checkpoint.m_camera[10] = m_camera->m_vfov;
+    m_globalTrans->getMatrix(false,_checkpoint.m_globalTransform,0);
+
+    // Keep only RGB, our alpha is always 1 in our output and 0 in our variance
+    unsigned int numPixels = m_width*m_height;
+    _checkpoint.m_accumulation.resize(numPixels*3);
+    _checkpoint.m_variance.resize(numPixels*3);
+    // Mapped only to read so our buffers aren't uploaded again before our next launch
+    const float *output = static_cast<const float*>(m_outputBuffer->map(0,RT_BUFFER_MAP_READ));
+    const float *variance = static_cast<const float*>(m_varianceBuffer->map(0,RT_BUFFER_MAP_READ));
+    for(unsigned int i=0;i<numPixels;i++)
+    {
+        for(int c=0;c<3;c++)
+        {
+            _checkpoint.m_accumulation[i*3+c] = output[i*4+c];
+            _checkpoint.m_variance[i*3+c] = variance[i*4+c];
+        }
+    }
+    m_varianceBuffer->unmap();
+    m_outputBuffer->unmap();
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool PathTracerScene::restoreCheckpoint(const Checkpoint &_checkpoint)
+{
+    if(_checkpoint.m_width!=m_width || _checkpoint.m_height!=m_height)
+    {
+        std::cerr<<"Checkpoint is "<<_checkpoint.m_width<<"x"<<_checkpoint.m_height<<" but we are rendering at "
+                 <<m_width<<"x"<<m_height<<", not resuming"<<std::endl;
+        return false;
+    }
+    if(_checkpoint.m_samplesPerLaunch!=getSamplesPerLaunch() || _checkpoint.m_sceneHash!=getSceneHash())
+    {
+        std::cerr<<"Checkpoint is of a different scene or different render settings, not resuming"<<std::endl;
+        return false;
+    }
+
+    // Put our camera and view back where they were, these restart our render so must come before our frame number
+    const float *camera = _checkpoint.m_camera;
+    m_camera->setParameters(optix::make_float3(camera[0],camera[1],camera[2]),
+                            optix::make_float3(camera[3],camera[4],camera[5]),
+                            optix::make_float3(camera[6],camera[7],camera[8]),
+                            camera[9],camera[10]);
+    updateCamera();
+    optix::Matrix4x4 trans(_checkpoint.m_globalTransform);
+    optix::Matrix4x4 invTrans = trans.inverse();
+    setTransform(trans.getData(),invTrans.getData(),false);
+    setSampleSeed(_checkpoint.m_sampleSeed);
+
+    PerfScopedTimer timer(PerfMetrics::BufferUpload);
+    unsigned int numPixels = m_width*m_height;
+    bool hasVariance = _checkpoint.m_variance.size()==numPixels*3;
+    float *output = static_cast<float*>(m_outputBuffer->map());
+    float *variance = static_cast<float*>(m_varianceBuffer->map());
+    for(unsigned int i=0;i<numPixels;i++)
+    {
+        for(int c=0;c<3;c++)
+        {
+            float mean = _checkpoint.m_accumulation[i*3+c];
+            output[i*4+c] = mean;
+            // Without our variance assume our pixels have none rather than leave our last render in there
+            variance[i*4+c] = (hasVariance) ? _checkpoint.m_variance[i*3+c] : mean*mean;
+        }
+        output[i*4+3] = 1.f;
+        variance[i*4+3] = 0.f;
+    }
+    m_varianceBuffer->unmap();
+    m_outputBuffer->unmap();
+    // What was rounded away before our checkpoint is lost, but it is far smaller than anything we have kept
+    clearCompensation();
+
+    m_frame = _checkpoint.m_frameNumber;
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+unsigned long long PathTracerScene::getSceneHash()
+{
+    unsigned int settings[5] = {m_sqrt_num_samples,(unsigned int)m_maxRayDepth,m_rr_begin_depth,(unsigned int)m_sampling_strategy,
+                                (unsigned int)m_filter};
+    unsigned long long hash = Checkpoint::hash(settings,sizeof(settings));
+    hash = Checkpoint::hash(&m_filterRadius,sizeof(m_filterRadius),hash);
+    hash = Checkpoint::hash(&m_fireflySigmas,sizeof(m_fireflySigmas),hash);
+    RTsize numLights = 0;
+    m_lightBuffer->getSize(numLights);
+    if(numLights)
+    {
+        hash = Checkpoint::hash(m_lightBuffer->map(0,RT_BUFFER_MAP_READ),numLights*sizeof(ParallelogramLight),hash);
+        m_lightBuffer->unmap();
+    }
+    hash = Checkpoint::hash(m_environmentMap.c_str(),m_environmentMap.size(),hash);
+
+    // Each of our geometry is a transform over a geometry group of instances
+    float m[16];
+    for(unsigned int i=0;i<m_globalTransGroup->getChildCount();i++)
+    {
+        Transform trans = m_globalTransGroup->getChild<Transform>(i);
+        trans->getMatrix(false,m,0);
+        hash = Checkpoint::hash(m,sizeof(m),hash);
+        optix::GeometryGroup group = trans->getChild<optix::GeometryGroup>();
+        for(unsigned int j=0;j<group->getChildCount();j++)
+        {
+            GeometryInstance gi = group->getChild(j);
+            unsigned int numPrims = gi->getGeometry()->getPrimitiveCount();
+            hash = Checkpoint::hash(&numPrims,sizeof(numPrims),hash);
+            const char *colors[2] = {"diffuse_color","emission_color"};
+            for(int c=0;c<2;c++)
+            {
+                optix::Variable var = gi->queryVariable(colors[c]);
+                if(!var) continue;
+                float3 color = var->getFloat3();
+                hash = Checkpoint::hash(&color,sizeof(color),hash);
+            }
+        }
+    }
+    return hash;
+}
+//----------------------------------------------------------------------------------------------------------------------
 
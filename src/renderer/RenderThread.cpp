@@ -0,0 +1,283 @@
+#include "renderer/RenderThread.h"
+#include "perf/PerfMetrics.h"
+#include "perf/TraceEvents.h"
+#include <QDateTime>
+#include <QMutexLocker>
+#include <iostream>
+#include <sstream>
+#include <memory>
+
+//----------------------------------------------------------------------------------------------------------------------
+RenderThread::RenderThread(AbstractOptixRenderer *_renderer, QObject *_parent) : QThread(_parent),
+                                                                                  m_renderer(_renderer),
+                                                                                  m_stop(false),
+                                                                                  m_render(true),
+                                                                                  m_timeOut(0),
+                                                                                  m_timedOut(false),
+                                                                                  m_timeOutStart(0),
+                                                                                  m_maxFrames(0),
+                                                                                  m_visible(true),
+                                                                                  m_autoSaveSamples(0),
+                                                                                  m_autoSaveFormat(ImageExporter::EXRHalf),
+                                                                                  m_lastAutoSave(0),
+                                                                                  m_checkpointInterval(0),
+                                                                                  m_lastCheckpoint(0),
+                                                                                  m_checkpointWriting(false),
+                                                                                  m_idle(false),
+                                                                                  m_wakePending(false)
+{
+    resetTimeOut();
+    // Any edit pushed by the GUI is work for us so make sure we're awake to apply it
+    m_renderer->getEditQueue()->setPushNotifier([this](){wake();});
+}
+//----------------------------------------------------------------------------------------------------------------------
+RenderThread::~RenderThread()
+{
+    stop();
+    m_renderer->getEditQueue()->setPushNotifier(std::function<void()>());
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RenderThread::stop()
+{
+    m_stop = true;
+    wake();
+    wait();
+    // Let our last checkpoint finish so we never leave a half written one behind
+    if(m_checkpointThread.joinable()) m_checkpointThread.join();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RenderThread::resetTimeOut()
+{
+    m_timeOutStart = QDateTime::currentMSecsSinceEpoch();
+    m_timedOut = false;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RenderThread::wake()
+{
+    QMutexLocker locker(&m_wakeMutex);
+    m_wakePending = true;
+    m_wakeCondition.wakeAll();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RenderThread::setAutoSave(unsigned int _samples, const std::string &_path, ImageExporter::Format _format)
+{
+    QMutexLocker locker(&m_autoSaveMutex);
+    m_autoSavePath = _path;
+    m_autoSaveFormat = _format;
+    m_autoSaveSamples = _samples;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RenderThread::autoSave(const DisplayFrame &_frame)
+{
+    unsigned int every = m_autoSaveSamples;
+    // Our accumulation has restarted since our last save
+    if(_frame.m_samples<m_lastAutoSave) m_lastAutoSave = 0;
+    if(every==0 || _frame.m_cost || _frame.m_samples/every<=m_lastAutoSave/every) return;
+    m_lastAutoSave = _frame.m_samples;
+
+    // Don't let our copies pile up if we are rendering faster than we can write them
+    ImageExporter *exporter = ImageExporter::getInstance();
+    if(exporter->getNumPending()>=ImageExporter::m_numThreads)
+    {
+        std::cerr<<"RenderThread: still writing our last auto saves, skipping "<<_frame.m_samples<<"spp"<<std::endl;
+        return;
+    }
+
+    TraceScope trace("auto save","frame");
+    std::string path;
+    ImageExporter::Format format;
+    {
+        QMutexLocker locker(&m_autoSaveMutex);
+        format = m_autoSaveFormat;
+        std::ostringstream stream;
+        stream<<m_autoSavePath<<"_"<<_frame.m_samples<<"spp."<<ImageExporter::getExtension(format);
+        path = stream.str();
+    }
+    // Our staging copy of our accumulation buffer, our frame already is one if that is what we are displaying
+    DisplayFrame staging;
+    if(_frame.m_format==DisplayFrame::RGBA32F)
+        staging = _frame;
+    else
+        m_renderer->copyOutput(staging);
+    exporter->exportAsync(path,staging,format);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RenderThread::saveOutput(const std::string &_path, ImageExporter::Format _format)
+{
+    {
+        QMutexLocker locker(&m_saveMutex);
+        PendingSave save;
+        save.m_path = _path;
+        save.m_format = _format;
+        m_pendingSaves.push_back(save);
+    }
+    // If we are sleeping wake up to make our copy
+    wake();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RenderThread::savePending()
+{
+    std::vector<PendingSave> saves;
+    {
+        QMutexLocker locker(&m_saveMutex);
+        saves.swap(m_pendingSaves);
+    }
+    if(saves.empty()) return;
+    if(m_renderer->getFrameNumber()==0)
+    {
+        std::cerr<<"RenderThread: no frame has been rendered yet. Nothing to save."<<std::endl;
+        return;
+    }
+
+    TraceScope trace("save","frame");
+    // One staging copy of our accumulation buffer serves every save asked for since our last launch
+    DisplayFrame staging;
+    m_renderer->copyOutput(staging);
+    ImageExporter *exporter = ImageExporter::getInstance();
+    for(unsigned int i=0;i<saves.size();i++)
+    {
+        // Our exporter takes our pixels so the last save can have our staging copy, the rest get their own
+        DisplayFrame frame;
+        if(i+1<saves.size()) frame = staging;
+        else std::swap(frame,staging);
+        exporter->exportAsync(saves[i].m_path,frame,saves[i].m_format);
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RenderThread::setCheckpoint(const std::string &_path, unsigned int _seconds)
+{
+    QMutexLocker locker(&m_checkpointMutex);
+    m_checkpointPath = _path;
+    m_checkpointInterval = _seconds;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool RenderThread::resume(const std::string &_path)
+{
+    // Read on the calling thread so our render isn't held up by our disk, and queue our restore as an edit so it is
+    // applied after anything queued before it
+    std::shared_ptr<Checkpoint> checkpoint(new Checkpoint);
+    if(!Checkpoint::read(_path,*checkpoint)) return false;
+    AbstractOptixRenderer *renderer = m_renderer;
+    renderer->getEditQueue()->push([renderer,checkpoint,_path](){
+        if(renderer->restoreCheckpoint(*checkpoint))
+            std::cerr<<"Resumed "<<_path<<" from frame "<<checkpoint->m_frameNumber<<std::endl;
+    });
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RenderThread::checkpoint()
+{
+    unsigned int interval = m_checkpointInterval;
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if(m_lastCheckpoint==0) m_lastCheckpoint = now;
+    if(interval==0 || now-m_lastCheckpoint<(qint64)interval*1000) return;
+    // Our last checkpoint is taking longer to write than our interval, try again next frame
+    if(m_checkpointWriting) return;
+
+    std::string path;
+    {
+        QMutexLocker locker(&m_checkpointMutex);
+        path = m_checkpointPath;
+    }
+    if(path.empty()) return;
+
+    TraceScope trace("checkpoint","frame");
+    std::shared_ptr<Checkpoint> checkpoint(new Checkpoint);
+    if(!m_renderer->saveCheckpoint(*checkpoint)) return;
+    m_lastCheckpoint = now;
+    if(m_checkpointThread.joinable()) m_checkpointThread.join();
+    m_checkpointWriting = true;
+    m_checkpointThread = std::thread([this,path,checkpoint](){
+        Checkpoint::write(path,*checkpoint);
+        m_checkpointWriting = false;
+    });
+}
+//----------------------------------------------------------------------------------------------------------------------
+void RenderThread::run()
+{
+    TraceEvents::getInstance()->setThreadName("Render");
+    // Our memory only changes with our scene so we only ask for it after the first launch following an edit,
+    // once any acceleration structures have been built
+    bool reportMemory = true;
+    while(!m_stop)
+    {
+        bool newFrame = false;
+        {
+            // Hold the context for the whole iteration so the GUI can safely make structural changes between launches
+            QMutexLocker locker(m_renderer->getContextMutex());
+
+            // Record this iteration so that uploads made by our edits are attributed to the launch they delay
+            PerfMetrics *metrics = PerfMetrics::getInstance();
+            metrics->beginLaunch();
+
+            // Apply everything the GUI has asked for since our last launch.
+            // Our scene has changed so reset our timeout.
+            bool edited = false;
+            {
+                TraceScope trace("apply edits","frame");
+                edited = m_renderer->applyEdits();
+                if(edited)
+                {
+                    resetTimeOut();
+                    reportMemory = true;
+                }
+            }
+
+            qint64 msecsPassed = QDateTime::currentMSecsSinceEpoch() - m_timeOutStart;
+            m_timedOut = (m_timeOut>0 && msecsPassed >= (qint64)m_timeOut*1000);
+            bool converged = (m_maxFrames>0 && m_renderer->getFrameNumber() >= m_maxFrames);
+
+            //if we haven't timed out then render another frame with our path tracer
+            if(m_render && m_visible && !m_timedOut && !converged)
+            {
+                TraceScope trace("launch","frame");
+                m_renderer->trace();
+                if(reportMemory)
+                {
+                    m_renderer->reportMemoryUsage();
+                    reportMemory = false;
+                }
+                DisplayFrame &frame = m_frames.backFrame();
+                m_renderer->copyDisplay(frame);
+                metrics->endLaunch(frame.m_frameNumber,frame.m_width,frame.m_height);
+                autoSave(frame);
+                checkpoint();
+                newFrame = true;
+            }
+            else
+            {
+                metrics->cancelLaunch();
+                // Edits that only change how our image is displayed don't restart our accumulation,
+                // so resolve the image we already have again rather than waiting for another launch
+                if(edited && m_renderer->getFrameNumber()>0)
+                {
+                    m_renderer->copyDisplay(m_frames.backFrame());
+                    newFrame = true;
+                }
+            }
+            // Saves the GUI asked for, whether or not we launched
+            savePending();
+        }
+
+        if(newFrame)
+        {
+            m_frames.publish();
+            emit frameReady();
+            continue;
+        }
+
+        // Nothing to do so sleep until an edit or a change of state wakes us.
+        // If we were woken since we last checked go straight round again instead.
+        QMutexLocker locker(&m_wakeMutex);
+        if(!m_wakePending && !m_stop)
+        {
+            m_idle = true;
+            emit idleChanged(true);
+            m_wakeCondition.wait(&m_wakeMutex);
+            m_idle = false;
+            emit idleChanged(false);
+        }
+        m_wakePending = false;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,96 @@
+#include "renderer/SceneEditQueue.h"
+#include <QMutexLocker>
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------------------------
+SceneEditQueue::SceneEditQueue() : m_version(0), m_appliedVersion(0)
+{
+}
+//----------------------------------------------------------------------------------------------------------------------
+unsigned long SceneEditQueue::push(Edit _edit, bool _rebuildScene)
+{
+    unsigned long version;
+    std::function<void()> notifier;
+    {
+        QMutexLocker locker(&m_mutex);
+        PendingEdit edit;
+        edit.m_edit = _edit;
+        edit.m_rebuildScene = _rebuildScene;
+        edit.m_version = version = ++m_version;
+        m_pending.push_back(edit);
+        notifier = m_pushNotifier;
+    }
+    if(notifier) notifier();
+    return version;
+}
+//----------------------------------------------------------------------------------------------------------------------
+unsigned long SceneEditQueue::push(const void *_object, EditType _type, Edit _edit, bool _rebuildScene)
+{
+    unsigned long version;
+    std::function<void()> notifier;
+    {
+        QMutexLocker locker(&m_mutex);
+        version = ++m_version;
+        notifier = m_pushNotifier;
+        EditKey key(_object,_type);
+        std::map<EditKey,unsigned int>::iterator it = m_keyed.find(key);
+        if(it!=m_keyed.end())
+        {
+            // Replace our pending edit, it is now our newest so will be applied after anything pushed before it
+            PendingEdit &edit = m_pending[it->second];
+            edit.m_edit = _edit;
+            edit.m_rebuildScene = edit.m_rebuildScene || _rebuildScene;
+            edit.m_version = version;
+        }
+        else
+        {
+            PendingEdit edit;
+            edit.m_edit = _edit;
+            edit.m_rebuildScene = _rebuildScene;
+            edit.m_version = version;
+            m_keyed[key] = m_pending.size();
+            m_pending.push_back(edit);
+        }
+    }
+    if(notifier) notifier();
+    return version;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool SceneEditQueue::apply(bool *_rebuildScene)
+{
+    if(_rebuildScene) *_rebuildScene = false;
+    // Take our pending edits so the GUI can keep pushing while we apply them
+    std::vector<PendingEdit> edits;
+    {
+        QMutexLocker locker(&m_mutex);
+        edits.swap(m_pending);
+        m_keyed.clear();
+    }
+    if(edits.empty()) return false;
+
+    // Merged edits take the version of their latest push so apply in version order
+    std::sort(edits.begin(),edits.end(),olderThan);
+    bool rebuild = false;
+    for(unsigned int i=0;i<edits.size();i++)
+    {
+        edits[i].m_edit();
+        rebuild = rebuild || edits[i].m_rebuildScene;
+    }
+    m_appliedVersion = edits.back().m_version;
+
+    if(_rebuildScene) *_rebuildScene = rebuild;
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool SceneEditQueue::isEmpty()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pending.empty();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void SceneEditQueue::setPushNotifier(std::function<void()> _notifier)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pushNotifier = _notifier;
+}
+//----------------------------------------------------------------------------------------------------------------------
@@ -96,7 +96,10 @@ void GeometryAttribEditor::setCurrentGeometry(AbstractOptixGeometry *_geo)
     _geo->getRot(rot.x,rot.y,rot.z);
     _geo->getScale(scale.x,scale.y,scale.z);
 
-    // Set the attributes
+    // Set the attributes. Block our signals while we do so that we don't queue
+    // an edit for every spinbox when nothing has actually changed.
+    QList<QDoubleSpinBox*> spinBoxes = findChildren<QDoubleSpinBox*>();
+    for(int i=0;i<spinBoxes.size();i++) spinBoxes[i]->blockSignals(true);
     m_posX->setValue(pos.x);
     m_posY->setValue(pos.y);
     m_posZ->setValue(pos.z);
@@ -106,7 +109,7 @@ void GeometryAttribEditor::setCurrentGeometry(AbstractOptixGeometry *_geo)
     m_scaleX->setValue(scale.x);
     m_scaleY->setValue(scale.y);
     m_scaleZ->setValue(scale.z);
-
+    for(int i=0;i<spinBoxes.size();i++) spinBoxes[i]->blockSignals(false);
 }
 //----------------------------------------------------------------------------------------------------------------------
 void GeometryAttribEditor::updateAttributes(double)
@@ -121,9 +124,16 @@ void GeometryAttribEditor::updateAttributes(double)
         std::cerr<<"Attribute editor renderer pointer does not point to anything"<<std::endl;
         return;
     }
-    m_geometry->setPos(m_posX->value(),m_posY->value(),m_posZ->value());
-    m_geometry->setRot(m_rotX->value(),m_rotY->value(),m_rotZ->value());
-    m_geometry->setScale(m_scaleX->value(),m_scaleY->value(),m_scaleZ->value());
-    m_renderer->rebuildScene();
+    // Our renderer lives on another thread so queue our changes to be applied before its next launch.
+    // Any change to this geometry still pending is replaced so we rebuild at most once per frame.
+    AbstractOptixGeometry *geo = m_geometry;
+    float px = m_posX->value(), py = m_posY->value(), pz = m_posZ->value();
+    float rx = m_rotX->value(), ry = m_rotY->value(), rz = m_rotZ->value();
+    float sx = m_scaleX->value(), sy = m_scaleY->value(), sz = m_scaleZ->value();
+    m_renderer->getEditQueue()->push(geo,SceneEditQueue::Transform,[=](){
+        geo->setPos(px,py,pz);
+        geo->setRot(rx,ry,rz);
+        geo->setScale(sx,sy,sz);
+    },true);
 }
 //----------------------------------------------------------------------------------------------------------------------
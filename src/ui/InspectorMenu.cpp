@@ -2,6 +2,7 @@
 #include <iostream>
 #include <QPushButton>
 #include <QInputDialog>
+#include <QMutexLocker>
 
 InspectorMenu::InspectorMenu(AbstractOptixRenderer *_renderer, QWidget *_parent) : QWidget(_parent,Qt::Window)
 {
@@ -86,11 +87,15 @@ void InspectorMenu::addGeometry(AbstractOptixGeometry *_geo, QString _name)
     // Add the item to our inspector list
     m_sceneList->addItem(new OptixQListWidgetItem(QIcon("images/icons/teapot.png"),_name,m_sceneList,OptixQListWidgetItem::Geometry,_geo));
     // Add the geometry to our renderer
+    QMutexLocker locker(m_renderer->getContextMutex());
     m_renderer->addGeometry(_geo);
 }
 //----------------------------------------------------------------------------------------------------------------------
 void InspectorMenu::removeGeometry(AbstractOptixGeometry *_geo)
 {
+    QMutexLocker locker(m_renderer->getContextMutex());
+    // Flush any edits still queued for this geometry before it goes away
+    m_renderer->applyEdits();
     // Remove the geometry from our renderer
     m_renderer->removeGeometry(_geo);
     // Delete the geometry class
@@ -11,10 +11,13 @@
 #include <QAction>
 #include <QMenuBar>
 #include <QFileInfo>
+#include <QMutexLocker>
+#include <QInputDialog>
 
 #include "geometry/Sphere.h"
 #include "geometry/Parallelogram.h"
 #include "geometry/Mesh.h"
+#include "perf/PerfMetrics.h"
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent){
 
@@ -86,6 +89,16 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent){
     QAction *exportRender = new QAction("Export Render",fileMenu);
     connect(exportRender,SIGNAL(triggered()),m_openGLWidget,SLOT(saveImage()));
     fileMenu->addAction(exportRender);
+    QAction *autoSaveBtn = new QAction("Auto Save Render",fileMenu);
+    connect(autoSaveBtn,SIGNAL(triggered()),this,SLOT(setAutoSave()));
+    fileMenu->addAction(autoSaveBtn);
+    QAction *exportMetricsBtn = new QAction("Export Metrics",fileMenu);
+    connect(exportMetricsBtn,SIGNAL(triggered()),this,SLOT(exportMetrics()));
+    fileMenu->addAction(exportMetricsBtn);
+    QAction *countRaysBtn = new QAction("Count Rays",fileMenu);
+    countRaysBtn->setCheckable(true);
+    connect(countRaysBtn,SIGNAL(toggled(bool)),this,SLOT(setRayCounting(bool)));
+    fileMenu->addAction(countRaysBtn);
     menuBar()->addAction(fileMenu->menuAction());
 
     // Geometry toolbar tab
@@ -108,6 +121,8 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent){
 }
 
 MainWindow::~MainWindow(){
+    // Make sure nothing is still launching our path tracer before we tear it down
+    m_openGLWidget->stopRendering();
     delete m_inspectorMenu;
     m_inspectorMenu = 0;
     delete m_pathTracer;
@@ -116,12 +131,23 @@ MainWindow::~MainWindow(){
 
 void MainWindow::createSphere()
 {
-    m_inspectorMenu->addGeometry(new Sphere(m_pathTracer->getContext()),"Sphere");
+    Sphere *sphere;
+    {
+        // Creating geometry touches our context so make sure we're not mid launch
+        QMutexLocker locker(m_pathTracer->getContextMutex());
+        sphere = new Sphere(m_pathTracer->getContext());
+    }
+    m_inspectorMenu->addGeometry(sphere,"Sphere");
 }
 
 void MainWindow::createPlane()
 {
-    m_inspectorMenu->addGeometry(new Parallelogram(m_pathTracer->getContext()),"Plane");
+    Parallelogram *plane;
+    {
+        QMutexLocker locker(m_pathTracer->getContextMutex());
+        plane = new Parallelogram(m_pathTracer->getContext());
+    }
+    m_inspectorMenu->addGeometry(plane,"Plane");
 }
 
 void MainWindow::importMesh()
@@ -130,6 +156,53 @@ void MainWindow::importMesh()
     if(!dir.isNull())
     {
         QFileInfo f(dir);
-        m_inspectorMenu->addGeometry(new Mesh(dir.toStdString(),m_pathTracer->getContext()),f.fileName());
+        Mesh *mesh;
+        {
+            QMutexLocker locker(m_pathTracer->getContextMutex());
+            mesh = new Mesh(dir.toStdString(),m_pathTracer->getContext());
+        }
+        m_inspectorMenu->addGeometry(mesh,f.fileName());
+    }
+}
+
+void MainWindow::exportMetrics()
+{
+    QString dir = QFileDialog::getSaveFileName(this,"Export Metrics","./metrics.csv","CSV (*.csv);;JSON (*.json)");
+    if(!dir.isNull())
+    {
+        PerfMetrics::getInstance()->writeToFile(dir.toStdString());
+    }
+}
+
+void MainWindow::setRayCounting(bool _count)
+{
+    PathTracerScene *pathTracer = m_pathTracer;
+    m_pathTracer->getEditQueue()->push([pathTracer,_count](){pathTracer->setRayCounting(_count);});
+}
+
+void MainWindow::setCheckpoint(QString _path, int _seconds)
+{
+    m_openGLWidget->setCheckpoint(_path,_seconds);
+}
+
+void MainWindow::setAutoSave()
+{
+    bool ok;
+    int samples = QInputDialog::getInt(this,"Auto Save Render","Samples per pixel between saves, 0 to stop saving",
+                                       0,0,1<<24,1,&ok);
+    if(!ok) return;
+    if(samples==0)
+    {
+        m_openGLWidget->setAutoSave(0,"",ImageExporter::EXRHalf);
+        return;
     }
+    // Each save is written to this path followed by its samples per pixel
+    QString selectedType;
+    QString path = QFileDialog::getSaveFileName(this,"Auto Save Render","./images/render",
+                                                QString::fromStdString(ImageExporter::getFileFilters()),&selectedType);
+    if(path.isNull()) return;
+    ImageExporter::Format format = ImageExporter::getFormat(selectedType.toStdString());
+    QString suffix = QString(".")+ImageExporter::getExtension(format);
+    if(path.endsWith(suffix)) path.chop(suffix.length());
+    m_openGLWidget->setAutoSave(samples,path,format);
 }
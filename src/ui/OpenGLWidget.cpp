@@ -1,10 +1,21 @@
 #include "ui/OpenGLWidget.h"
 #include <QGuiApplication>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QBuffer>
 #include <QImageWriter>
 #include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
 #include <optixu/optixpp_namespace.h>
+#include "perf/PerfMetrics.h"
+#include "perf/TraceEvents.h"
+#include "perf/InteractionRecorder.h"
+#include "perf/LatencyTracker.h"
+#include "common/AutoExposure.h"
+#include "common/accumulate.h"
+#include "common/ImageExporter.h"
 
 const static float INCREMENT=0.15;
 //------------------------------------------------------------------------------------------------------------------------------------
@@ -24,27 +35,52 @@ OpenGLWidget::OpenGLWidget(const QGLFormat _format, QWidget *_parent) : QGLWidge
     m_spinYFaceEnvironment=0;
     m_moveRenderReduction = 4;
     m_timedOut = 0;
+    m_maxFrames = 0;
+    m_autoSaveSamples = 0;
+    m_autoSaveFormat = ImageExporter::EXRHalf;
+    m_checkpointInterval = 0;
+    m_resumeCheckpoint = false;
     m_cameraMovRayDepth = 2;
     m_modelPos = glm::vec3(0);
     m_mouseGlobalTX = glm::mat4();
     m_translateEnvironment = false;
     m_drawHud = true;
     m_renderer = 0;
+    m_renderThread = 0;
     m_render = true;
+    m_heatMapCounter = 0;
+    m_frameGraph = 0;
+    m_textureStreamer = 0;
+    m_displayFormat = DisplayFrame::RGBA8;
+    m_exposure = 0.f;
+    m_tonemap = true;
+    m_autoExposure = true;
+    m_filter = Film::Box;
+    m_fireflyClamp = false;
+    m_rubberBand = new QRubberBand(QRubberBand::Rectangle,this);
+    m_selectingRegion = false;
+    m_displayMs = 0.0;
+    for(int i=0;i<CostMap::NumCounters;i++) m_costMax[i] = 0.f;
+    // We swap ourselves at the end of paintGL so we know when a frame has been presented
+    setAutoBufferSwap(false);
     // re-size the widget to that of the parent (in this case the GLFrame passed in on construction)
     this->resize(_parent->size());
 }
 //----------------------------------------------------------------------------------------------------------------------
 OpenGLWidget::~OpenGLWidget(){
     //delete m_statsLineEdit;
+    stopRendering();
     delete m_shaderProgram;
     delete m_cam;
     delete m_textDrawer;
+    delete m_frameGraph;
+    delete m_textureStreamer;
     glDeleteVertexArrays(1, &m_VAO);
     glDeleteBuffers(2, m_VBO);
 }
 //----------------------------------------------------------------------------------------------------------------------
 void OpenGLWidget::initializeGL(){
+    TraceScope trace("OpenGLWidget::initializeGL");
 #ifndef DARWIN
     glewExperimental = GL_TRUE;
     GLenum error = glewInit();
@@ -104,19 +140,9 @@ void OpenGLWidget::initializeGL(){
     glEnableVertexAttribArray(1);
     glBindBuffer(GL_ARRAY_BUFFER,0);
 
-    //now lets generate our texture for later use
-    glGenTextures(1,&m_texID);
-    glBindTexture(GL_TEXTURE_2D, m_texID);
+    //now lets create our texture and the pixel buffers we stream our frames through
+    m_textureStreamer = new TextureStreamer();
 
-    // Change these to GL_LINEAR for super- or sub-sampling
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-
-    // GL_CLAMP_TO_EDGE for linear filtering, not relevant for nearest.
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-    glBindTexture( GL_TEXTURE_2D, 0);
     //all good!
 
     // Create a shader program
@@ -136,22 +162,36 @@ void OpenGLWidget::initializeGL(){
     m_modelViewProjectionLoc = m_shaderProgram->getUniformLoc("MVP");
     m_texLoc = m_shaderProgram->getUniformLoc("pathTraceTex");
     glUniform1i(m_texLoc,0);
+    m_heatMapCounterLoc = m_shaderProgram->getUniformLoc("heatMapCounter");
+    m_heatMapMaxLoc = m_shaderProgram->getUniformLoc("heatMapMax");
+    glUniform1i(m_heatMapCounterLoc,0);
 
     m_cam = new Camera(glm::vec3(0.0, 0.0, -20.0));
 
-    //start our render time out
-    m_timeOutStart = m_timeOutStart.currentTime();
-
     //create our HUD
     m_textDrawer = new Text(QFont("Arial",14));
     m_textDrawer->setColour(255,0,0);
     m_textDrawer->setScreenSize(width(),height());
+    m_frameGraph = new FrameGraph();
+    m_frameGraph->setScreenSize(width(),height());
+    m_lastFrameTime = std::chrono::steady_clock::now();
 
     //start our FPS counter
     m_FPSTimer = QTime::currentTime();
 
-    startTimer(0);
-
+    // From here on our renderer is only launched from our render thread.
+    // We only repaint when it publishes a new frame or goes idle so our HUD is up to date,
+    // update() is queued across threads and coalesced by Qt.
+    m_renderThread = new RenderThread(m_renderer);
+    m_renderThread->setTimeOutDur(m_timedOut);
+    m_renderThread->setMaxFrames(m_maxFrames);
+    m_renderThread->setAutoSave(m_autoSaveSamples,m_autoSavePath.toStdString(),m_autoSaveFormat);
+    m_renderThread->setCheckpoint(m_checkpointPath.toStdString(),m_checkpointInterval);
+    m_renderThread->setRendering(m_render);
+    m_renderThread->setVisible(isVisible());
+    connect(m_renderThread,SIGNAL(frameReady()),this,SLOT(update()));
+    connect(m_renderThread,SIGNAL(idleChanged(bool)),this,SLOT(update()));
+    m_renderThread->start();
 }
 //----------------------------------------------------------------------------------------------------------------------
 void OpenGLWidget::resizeGL(const int _w, const int _h){
@@ -159,79 +199,141 @@ void OpenGLWidget::resizeGL(const int _w, const int _h){
     if(_w==0||_h==0)return;
     // set the viewport for openGL
     glViewport(0,0,_w,_h);
-    m_renderer->resize(_w,_h);
+    queueResize(_w,_h);
     m_cam->setShape(width(), height());
     m_textDrawer->setScreenSize(width(),height());
-}
-//----------------------------------------------------------------------------------------------------------------------
-void OpenGLWidget::timerEvent(QTimerEvent *){
-    updateGL();
+    m_frameGraph->setScreenSize(width(),height());
+    updateRubberBand();
 }
 //----------------------------------------------------------------------------------------------------------------------
 void OpenGLWidget::paintGL(){
+    TraceScope trace("paintGL","frame");
+    std::chrono::steady_clock::time_point paintStart = std::chrono::steady_clock::now();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     m_shaderProgram->use();
-    bool timedOut;
-    QTime currentTime = m_timeOutStart.currentTime();
-    int secsPassed = m_timeOutStart.secsTo(currentTime);
-    //if we haven't timed out then render another frame with our path tracer
-    if(secsPassed<m_timedOut||m_timedOut==0){
-        timedOut = false;
-        if(m_render)
-        {
-            m_renderer->trace();
-        }
+    bool timedOut = m_renderThread->hasTimedOut();
+
+    // only upload to our texture if our render thread has finished a new frame, a frame we already
+    // have in our texture is skipped so we never copy a framebuffer that hasn't changed
+    FrameHandoff *frames = m_renderThread->getFrameHandoff();
+    bool newFrame = frames->acquire();
+    const DisplayFrame &frame = frames->frontFrame();
+    bool uploaded = false;
+    if(newFrame)
+    {
+        PerfScopedTimer timer(PerfMetrics::TextureUpload);
+        uploaded = m_textureStreamer->upload(frame);
     }
-    else
+    if(uploaded && frame.m_cost)
     {
-        timedOut = true;
+        for(int i=0;i<CostMap::NumCounters;i++) m_costMax[i] = CostMap::getMax(frame,(CostMap::Counter)i);
     }
-    GLuint vboId = m_renderer->getOutputBuffer()->getGLBOId();
-
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture( GL_TEXTURE_2D, m_texID);
-    // send pbo to texture
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, vboId);
-
-    RTsize elementSize = m_renderer->getOutputBuffer()->getElementSize();
-    if      ((elementSize % 8) == 0) glPixelStorei(GL_UNPACK_ALIGNMENT, 8);
-    else if ((elementSize % 4) == 0) glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-    else if ((elementSize % 2) == 0) glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
-    else                             glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F_ARB, m_renderer->getWidth(), m_renderer->getHeight(), 0, GL_RGBA, GL_FLOAT, 0);
+    glBindTexture(GL_TEXTURE_2D, m_textureStreamer->getTextureID());
+    // Our frames can lag behind our view by a frame when it is switched so go by what our frame holds.
+    // Stale cost frames are drawn as a heat map of our first counter rather than as colours.
+    bool costFrame = frames->frontFrame().m_cost;
+    int heatMapCounter = (costFrame) ? std::max(m_heatMapCounter,1) : 0;
+    glUniform1i(m_heatMapCounterLoc,heatMapCounter);
+    glUniform1f(m_heatMapMaxLoc,(heatMapCounter) ? m_costMax[heatMapCounter-1] : 0.f);
 
     loadMatricesToShader(glm::mat4(1.0), m_cam->getViewMatrix(), m_cam->getProjectionMatrix());
-    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
     glBindVertexArray(m_VAO);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
     glBindVertexArray(0);
 
 
+    // Every new frame goes on our graph whether our HUD is showing or not so it is up to date when it is shown
+    PerfMetrics *metrics = PerfMetrics::getInstance();
+    PerfMetrics::LaunchRecord launch = PerfMetrics::LaunchRecord();
+    bool haveLaunch = metrics->getLatestLaunch(launch);
+    if(newFrame)
+    {
+        double frameMs = std::chrono::duration<double,std::milli>(paintStart-m_lastFrameTime).count();
+        m_frameGraph->addSample(frameMs,launch.m_sectionMs[PerfMetrics::Trace]);
+        m_lastFrameTime = paintStart;
+    }
+
     QTime updateTime = QTime::currentTime();
     if(m_drawHud)
     {
         //calc the update time
         int msecsto = m_FPSTimer.msecsTo(updateTime);
         QString FPS;
-        (msecsto==0)?FPS = "FPS: Too fast to calculate" : FPS = QString("FPS: %1").arg(1000.f/(float)msecsto);
+        (msecsto==0)?FPS = "FPS: Too fast to calculate" : FPS = QString("FPS: %1").arg(1000.f/(float)msecsto,0,'f',1);
         int textIndent  = (width()-height())/2;
         if(textIndent<0) textIndent = 0;
+
+        // Our whole HUD is built as one string so it is drawn in one go
+        QString hud;
         if(timedOut)
+            hud = QString("Render Timed Out, %1").arg(FPS);
+        else if(m_renderThread->isIdle())
+            hud = QString(m_render ? "Render Complete" : "Render Paused");
+        else
+            hud = QString("Rendering, %1").arg(FPS);
+        hud += QString("\n%1 spp accumulated").arg(frames->frontFrame().m_samples);
+        if(haveLaunch)
         {
-            m_textDrawer->renderText(textIndent,5,QString("Render Timed Out"));
-            m_textDrawer->renderText(textIndent,20, FPS);
+            double traceMs = launch.m_sectionMs[PerfMetrics::Trace];
+            hud += QString("\nTrace %1ms, display %2ms").arg(traceMs,0,'f',1).arg(m_displayMs,0,'f',1);
+            if(launch.getTotalRays())
+                hud += QString(", %1 Mrays/s").arg((traceMs>0.0) ? (launch.getTotalRays()/1e6)/(traceMs/1000.0) : 0.0,0,'f',1);
         }
-        else
+        // What we display, which can lag behind what we have asked for by a frame
+        const DisplayFrame &front = frames->frontFrame();
+        if(!front.m_cost)
+        {
+            if(front.m_format==DisplayFrame::RGBA32F)
+                hud += QString("\nDisplay RGBA32F, untonemapped");
+            else
+                hud += QString("\nDisplay %1, exposure %2%3, tonemap %4").arg((front.m_format==DisplayFrame::RGBA8) ? "RGBA8" : "RGBA16F")
+                                                                         .arg(m_exposure,0,'f',1)
+                                                                         .arg(m_autoExposure ? " auto" : "")
+                                                                         .arg(m_tonemap ? "on" : "off");
+            hud += QString(", filter %1%2").arg(Film::getFilterName(m_filter)).arg(m_fireflyClamp ? ", fireflies clamped" : "");
+        }
+        PerfMetrics::SectionStats accel = metrics->getSectionStats(PerfMetrics::AccelBuild);
+        if(accel.m_count)
+        {
+            hud += QString("\nAccel build %1ms").arg(accel.m_lastMs,0,'f',1);
+        }
+        PerfMetrics::MemoryUsage memory = metrics->getMemoryUsage();
+        if(memory.m_deviceTotalBytes)
+        {
+            const double mb = 1024.0*1024.0;
+            hud += QString("\nMemory host %1MB, device %2/%3MB").arg(memory.m_hostBytes/mb,0,'f',0)
+                                                                .arg(memory.m_deviceUsedBytes/mb,0,'f',0)
+                                                                .arg(memory.m_deviceTotalBytes/mb,0,'f',0);
+        }
+        LatencyTracker::Percentiles latency = LatencyTracker::getInstance()->getPercentiles();
+        if(latency.m_count)
         {
-            m_textDrawer->renderText(textIndent,5,QString("Rendering"));
-            m_textDrawer->renderText(textIndent,20, FPS);
+            hud += QString("\nLatency p50 %1ms p95 %2ms p99 %3ms").arg(latency.m_p50,0,'f',1)
+                                                                .arg(latency.m_p95,0,'f',1)
+                                                                .arg(latency.m_p99,0,'f',1);
         }
+        if(heatMapCounter)
+        {
+            CostMap::Counter counter = (CostMap::Counter)(heatMapCounter-1);
+            hud += QString("\nCost: %1 per sample, max %2").arg(CostMap::getCounterName(counter,true))
+                                                           .arg(m_costMax[counter],0,'f',1);
+        }
+        m_textDrawer->renderText(textIndent,5,hud);
+
+        // Our frame times under our text, green is the part of each frame spent tracing
+        int numLines = hud.count('\n')+1;
+        m_frameGraph->draw(textIndent+5,10+numLines*m_textDrawer->getLineHeight(),60.f);
     }
 
     //restart ouf FPS timere
     m_FPSTimer = QTime::currentTime();
 
+    // Our frame is on its way to the screen, any input it shows has now reached our user
+    swapBuffers();
+    if(newFrame) LatencyTracker::getInstance()->frameDisplayed(frames->frontFrame().m_editVersion);
+    m_displayMs = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-paintStart).count();
+
 }
 //----------------------------------------------------------------------------------------------------------------------
 void OpenGLWidget::resizeGL(QResizeEvent *_event)
@@ -242,9 +344,11 @@ void OpenGLWidget::resizeGL(QResizeEvent *_event)
     int _h = _event->size().height();
     // set the viewport for openGL
     glViewport(0,0,_w,_h);
-    m_renderer->resize(_w,_h);
+    queueResize(_w,_h);
     m_cam->setShape(width(), height());
     m_textDrawer->setScreenSize(width(),height());
+    m_frameGraph->setScreenSize(width(),height());
+    updateRubberBand();
 }
 //----------------------------------------------------------------------------------------------------------------------
 void OpenGLWidget::loadMatricesToShader(glm::mat4 _modelMatrix, glm::mat4 _viewMatrix, glm::mat4 _perspectiveMatrix){
@@ -256,7 +360,12 @@ void OpenGLWidget::loadMatricesToShader(glm::mat4 _modelMatrix, glm::mat4 _viewM
 }
 //------------------------------------------------------------------------------------------------------------------------------------
 void OpenGLWidget::mouseMoveEvent (QMouseEvent *_event){
-  if(m_rotate && _event->buttons() == Qt::LeftButton){
+  m_inputTime = std::chrono::steady_clock::now();
+  InteractionRecorder::getInstance()->recordInput(InteractionRecorder::MouseMove,_event->x(),_event->y(),_event->buttons());
+  if(m_selectingRegion){
+    m_rubberBand->setGeometry(QRect(m_regionOrigin,_event->pos()).normalized());
+  }
+  else if(m_rotate && _event->buttons() == Qt::LeftButton){
     float diffx=_event->x()-m_origX;
     float diffy=_event->y()-m_origY;
     m_spinXFace -= (float) 0.01f * diffy;
@@ -283,8 +392,8 @@ void OpenGLWidget::mouseMoveEvent (QMouseEvent *_event){
     invM[ 8] = inv[0][2];  invM[ 9] = inv[1][2];  invM[ 10] = inv[2][2];  invM[ 11] = inv[3][2];
     invM[ 12] = inv[0][3];  invM[ 13] = inv[1][3];  invM[ 14] = inv[2][3];  invM[ 15] = inv[3][3];
 
-    m_renderer->setTransform(m,invM,false);
-    m_render = true;
+    queueGlobalTransform(m,invM);
+    setRender(true);
 
     m_origX = _event->x();
     m_origY = _event->y();
@@ -315,8 +424,8 @@ void OpenGLWidget::mouseMoveEvent (QMouseEvent *_event){
     invM[ 8] = inv[0][2];  invM[ 9] = inv[1][2];  invM[ 10] = inv[2][2];  invM[ 11] = inv[3][2];
     invM[ 12] = inv[0][3];  invM[ 13] = inv[1][3];  invM[ 14] = inv[2][3];  invM[ 15] = inv[3][3];
 
-    m_renderer->setTransform(m,invM,false);
-    m_render = true;
+    queueGlobalTransform(m,invM);
+    setRender(true);
 
    }
   else if(m_translateEnvironment && _event->buttons() == Qt::MiddleButton){
@@ -341,20 +450,31 @@ void OpenGLWidget::mouseMoveEvent (QMouseEvent *_event){
       m_mouseGlobalTX[3][2] = m_modelPos.z;
       m_origX = _event->x();
       m_origY = _event->y();
-      m_render = true;
+      setRender(true);
 
   }
+  m_inputTime = std::chrono::steady_clock::time_point();
 }
 //------------------------------------------------------------------------------------------------------------------------------------
 void OpenGLWidget::mousePressEvent ( QMouseEvent * _event){
-  if(_event->button() == Qt::LeftButton)
+  m_inputTime = std::chrono::steady_clock::now();
+  InteractionRecorder::getInstance()->recordInput(InteractionRecorder::MousePress,_event->x(),_event->y(),_event->button());
+  // shift left drag selects a render region rather than moving our camera
+  if(_event->button() == Qt::LeftButton && (_event->modifiers() & Qt::ShiftModifier))
+  {
+    m_selectingRegion = true;
+    m_regionOrigin = _event->pos();
+    m_rubberBand->setGeometry(QRect(m_regionOrigin,QSize()));
+    m_rubberBand->show();
+  }
+  else if(_event->button() == Qt::LeftButton)
   {
     m_origX = _event->x();
     m_origY = _event->y();
     m_rotate = true;
     // resize our pathtracer for more responsive movement controls
     // resize amount set in general settings widget
-    m_renderer->resize(width()/m_moveRenderReduction,height()/m_moveRenderReduction);
+    queueResize(width()/m_moveRenderReduction,height()/m_moveRenderReduction);
 
   }
   // right mouse translate mode
@@ -363,7 +483,7 @@ void OpenGLWidget::mousePressEvent ( QMouseEvent * _event){
     m_origXPos = _event->x();
     m_origYPos = _event->y();
     m_translate = true;
-    m_renderer->resize(width()/m_moveRenderReduction,height()/m_moveRenderReduction);
+    queueResize(width()/m_moveRenderReduction,height()/m_moveRenderReduction);
   }
   // right mouse translate mode
   else if(_event->button() == Qt::MiddleButton)
@@ -372,31 +492,41 @@ void OpenGLWidget::mousePressEvent ( QMouseEvent * _event){
       m_origY = _event->y();
       m_translateEnvironment = true;
   }
-
+  m_inputTime = std::chrono::steady_clock::time_point();
 }
 //------------------------------------------------------------------------------------------------------------------------------------
 void OpenGLWidget::mouseReleaseEvent ( QMouseEvent * _event ){
-  if (_event->button() == Qt::LeftButton)
+  m_inputTime = std::chrono::steady_clock::now();
+  InteractionRecorder::getInstance()->recordInput(InteractionRecorder::MouseRelease,_event->x(),_event->y(),_event->button());
+  if (_event->button() == Qt::LeftButton && m_selectingRegion)
+  {
+    m_selectingRegion = false;
+    setRenderRegion(QRect(m_regionOrigin,_event->pos()).normalized().intersected(rect()));
+  }
+  else if (_event->button() == Qt::LeftButton)
   {
     m_rotate=false;
-    m_renderer->resize(width()*devicePixelRatio(),height()*devicePixelRatio());
+    queueResize(width()*devicePixelRatio(),height()*devicePixelRatio());
 
   }
         // right mouse translate mode
   if (_event->button() == Qt::RightButton)
   {
     m_translate=false;
-    m_renderer->resize(width()*devicePixelRatio(),height()*devicePixelRatio());
+    queueResize(width()*devicePixelRatio(),height()*devicePixelRatio());
 
   }
   else if(_event->button() == Qt::MiddleButton)
   {
      m_translateEnvironment = false;
   }
+  m_inputTime = std::chrono::steady_clock::time_point();
 }
 //------------------------------------------------------------------------------------------------------------------------------------
 void OpenGLWidget::wheelEvent(QWheelEvent *_event)
 {
+    m_inputTime = std::chrono::steady_clock::now();
+    InteractionRecorder::getInstance()->recordInput(InteractionRecorder::Wheel,_event->x(),_event->y(),_event->delta());
 
     // identity matrix to init our transformation
     float m[16];
@@ -415,18 +545,20 @@ void OpenGLWidget::wheelEvent(QWheelEvent *_event)
     {
         m_modelPos.z-=ZOOM;
         m_mouseGlobalTX[3][2]-=ZOOM;
-        m_renderer->setTransform(m,invM,false);
+        queueGlobalTransform(m,invM);
     }
     else if(_event->delta() <0 )
     {
         m_modelPos.z+=ZOOM;
         m_mouseGlobalTX[3][2]+=ZOOM;
-        m_renderer->setTransform(m,invM,false);
+        queueGlobalTransform(m,invM);
     }
+    m_inputTime = std::chrono::steady_clock::time_point();
 }
 //----------------------------------------------------------------------------------------------------------------------
 void OpenGLWidget::keyPressEvent(QKeyEvent *_event)
 {
+    InteractionRecorder::getInstance()->recordInput(InteractionRecorder::KeyPress,0,0,_event->key());
     switch(_event->key())
     {
     case Qt::Key_Escape:
@@ -438,6 +570,33 @@ void OpenGLWidget::keyPressEvent(QKeyEvent *_event)
     case Qt::Key_Space:
         toggleRender();
     break;
+    case Qt::Key_H:
+        cycleCostView();
+    break;
+    case Qt::Key_D:
+        cycleDisplayFormat();
+    break;
+    case Qt::Key_T:
+        toggleTonemap();
+    break;
+    case Qt::Key_A:
+        toggleAutoExposure();
+    break;
+    case Qt::Key_F:
+        cycleFilter();
+    break;
+    case Qt::Key_C:
+        toggleFireflyClamp();
+    break;
+    case Qt::Key_R:
+        setRenderRegion(QRect());
+    break;
+    case Qt::Key_BracketLeft:
+        setExposure(m_exposure-0.5f);
+    break;
+    case Qt::Key_BracketRight:
+        setExposure(m_exposure+0.5f);
+    break;
     default:
     break;
     }
@@ -445,6 +604,7 @@ void OpenGLWidget::keyPressEvent(QKeyEvent *_event)
 //----------------------------------------------------------------------------------------------------------------------
 void OpenGLWidget::keyReleaseEvent(QKeyEvent *_event)
 {
+    InteractionRecorder::getInstance()->recordInput(InteractionRecorder::KeyRelease,0,0,_event->key());
     switch(_event->key())
     {
         default:
@@ -455,57 +615,56 @@ void OpenGLWidget::keyReleaseEvent(QKeyEvent *_event)
 //----------------------------------------------------------------------------------------------------------------------
 void OpenGLWidget::saveImage()
 {
-    m_render = false;
-    QImage img(m_renderer->getWidth(),m_renderer->getHeight(),QImage::Format_RGB32);
-    QColor color;
-    // as we're using a openGL buffer rather than optix we must map it with openGL calls
-    GLint vboId = m_renderer->getOutputBuffer()->getGLBOId();
-    glBindBuffer(GL_ARRAY_BUFFER, vboId);
-    void* data = glMapBuffer(GL_ARRAY_BUFFER, GL_READ_ONLY);
-    typedef struct { float r; float g; float b; float a;} rgb;
-    rgb* rgb_data = (rgb*)data;
-
-    int x;
-    int y;
-    int h = m_renderer->getWidth()*m_renderer->getHeight();
-    for(int i=0; i<h; i++)
-    {
-        float red = rgb_data[h-i].r; if(red>1.0) red=1.0;
-        float green = rgb_data[h-i].g; if(green>1.0) green=1.0;
-        float blue = rgb_data[h-i].b; if(blue>1.0) blue=1.0;
-        float alpha = rgb_data[h-i].a; if(alpha>1.0) alpha=1.0;
-        color.setRgbF(red,green,blue,alpha);
-        y = floor((float)i/m_renderer->getWidth());
-        x = m_renderer->getWidth() - i + y*m_renderer->getWidth() - 1;
-        img.setPixel(x, y, color.rgb());
-
-    }
-    //remember to unmap the buffer after or you're going to have a bad time!
-    glUnmapBuffer(GL_ARRAY_BUFFER);
-
     QFileDialog fileDialog(this);
     fileDialog.setDefaultSuffix(".png");
     QString selectedType;
-    QString saveFile = fileDialog.getSaveFileName(this, tr("Save Image File"), "./images/",tr("PNG (*.png);;JPEG (*.jpeg);;BMP (*.bmp);;GIF (*.gif)"),&selectedType);
+    QString saveFile = fileDialog.getSaveFileName(this, tr("Save Image File"), "./images/",QString::fromStdString(ImageExporter::getFileFilters()),&selectedType);
     std::cout<<"Selected name filter is "<<selectedType.toStdString()<<std::endl;
-    QString format;
-    if(selectedType== "PNG (*.png)")
+    if(saveFile.isEmpty()) return;
+    ImageExporter::Format format = ImageExporter::getFormat(selectedType.toStdString());
+    if(QFileInfo(saveFile).suffix().isEmpty()) saveFile += QString(".")+ImageExporter::getExtension(format);
+    std::string path = saveFile.toStdString();
+
+    // Our frames are written on a background thread so we can keep rendering while we save. Take a copy of the
+    // frame we are currently displaying, this is owned by the GUI thread so no need to lock anything.
+    const DisplayFrame &frame = m_renderThread->getFrameHandoff()->frontFrame();
+    if(frame.isEmpty())
     {
-        format = "PNG";
+        std::cerr<<"No frame has been rendered yet. Nothing to save."<<std::endl;
+        return;
     }
-    else if(selectedType== "JPEG (*.jpeg)")
+    ImageExporter *exporter = ImageExporter::getInstance();
+    // save our cost as the heat map we are displaying
+    if(frame.m_cost)
     {
-        format = "JPEG";
+        DisplayFrame heatMap;
+        CostMap::Counter counter = (CostMap::Counter)std::max(m_heatMapCounter-1,0);
+        CostMap::toHeatMap(frame,counter,heatMap,m_costMax[counter]);
+        exporter->exportAsync(path,heatMap,format,AutoExposure::Params(),false);
+        return;
     }
-    else if(selectedType== "BMP (*.bmp)")
+    // Our float formats want our raw accumulation buffer, if we are displaying a resolved frame our render thread
+    // copies it out between launches, so we never wait on a launch for our context
+    if(ImageExporter::isFloat(format) && frame.m_format!=DisplayFrame::RGBA32F)
     {
-        format = "BMP";
+        m_renderThread->saveOutput(path,format);
+        return;
     }
-    else if(selectedType== "GIF (*.gif)")
+    // and our raw float frames with the same exposure and tonemap as our resolved frames
+    AutoExposure::Params params;
+    if(frame.m_format==DisplayFrame::RGBA32F)
     {
-        format = "GIF";
+        params.m_exposure = std::pow(2.f,m_exposure);
+        params.m_tonemap = m_tonemap;
+        if(m_autoExposure)
+        {
+            AutoExposure exposure;
+            exposure.update(AutoExposure::measure(&frame.m_pixels[0],frame.m_width*frame.m_height),0.f);
+            exposure.getParams(params);
+        }
     }
-    img.save(saveFile, format.toStdString().c_str());
+    DisplayFrame snapshot = frame;
+    exporter->exportAsync(path,snapshot,format,params);
 }
 //----------------------------------------------------------------------------------------------------------------------
 void OpenGLWidget::resetGlobalTrans(){
@@ -515,7 +674,200 @@ void OpenGLWidget::resetGlobalTrans(){
     m[ 4] = 0.0f;  m[ 5] = 1.0f;  m[ 6] = 0.0f;  m[ 7] = 0.0f;
     m[ 8] = 0.0f;  m[ 9] = 0.0f;  m[10] = 1.0f;  m[11] = 0.0f;
     m[12] = 0.0f;  m[13] = 0.0f;  m[14] = 0.0f;  m[15] = 1.0f;
-    m_renderer->setTransform(m, m, false);
-    m_render = true;
-
+    queueGlobalTransform(m, m);
+    setRender(true);
 }
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::cycleCostView()
+{
+    bool wasEnabled = m_heatMapCounter>0;
+    m_heatMapCounter = (m_heatMapCounter+1)%(CostMap::NumCounters+1);
+    bool enabled = m_heatMapCounter>0;
+    // Our renderer only needs to know when we switch between our image and our cost,
+    // every counter is written into each cost frame
+    if(enabled!=wasEnabled)
+    {
+        AbstractOptixRenderer *renderer = m_renderer;
+        renderer->getEditQueue()->push([=](){renderer->setCostView(enabled);});
+        setRender(true);
+    }
+    update();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::cycleDisplayFormat()
+{
+    // RGBA8, RGBA16F and then our raw accumulation buffer
+    switch(m_displayFormat)
+    {
+        case(DisplayFrame::RGBA8): m_displayFormat = DisplayFrame::RGBA16F; break;
+        case(DisplayFrame::RGBA16F): m_displayFormat = DisplayFrame::RGBA32F; break;
+        default: m_displayFormat = DisplayFrame::RGBA8; break;
+    }
+    AbstractOptixRenderer *renderer = m_renderer;
+    DisplayFrame::Format format = m_displayFormat;
+    renderer->getEditQueue()->push([=](){renderer->setDisplayFormat(format);});
+    update();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::setExposure(float _stops)
+{
+    m_exposure = _stops;
+    AbstractOptixRenderer *renderer = m_renderer;
+    renderer->getEditQueue()->push([=](){renderer->setExposure(_stops);});
+    update();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::toggleTonemap()
+{
+    m_tonemap = !m_tonemap;
+    AbstractOptixRenderer *renderer = m_renderer;
+    bool enabled = m_tonemap;
+    renderer->getEditQueue()->push([=](){renderer->setTonemap(enabled);});
+    update();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::toggleAutoExposure()
+{
+    m_autoExposure = !m_autoExposure;
+    AbstractOptixRenderer *renderer = m_renderer;
+    bool enabled = m_autoExposure;
+    renderer->getEditQueue()->push([=](){renderer->setAutoExposure(enabled);});
+    update();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::cycleFilter()
+{
+    m_filter = (Film::Filter)((m_filter+1)%Film::NumFilters);
+    AbstractOptixRenderer *renderer = m_renderer;
+    Film::Filter filter = m_filter;
+    renderer->getEditQueue()->push([=](){renderer->setFilter(filter);});
+    update();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::toggleFireflyClamp()
+{
+    m_fireflyClamp = !m_fireflyClamp;
+    AbstractOptixRenderer *renderer = m_renderer;
+    float sigmas = (m_fireflyClamp) ? FIREFLY_DEFAULT_SIGMAS : 0.f;
+    renderer->getEditQueue()->push([=](){renderer->setFireflyClamp(sigmas);});
+    update();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::setRenderRegion(QRect _rect)
+{
+    // Anything too small to have been meant is taken as a click to clear our region
+    float w = (float)width();
+    float h = (float)height();
+    if(_rect.width()<4 || _rect.height()<4 || w<=0.f || h<=0.f) m_renderRegion = QRectF();
+    else m_renderRegion = QRectF(_rect.x()/w,_rect.y()/h,(_rect.width()+1)/w,(_rect.height()+1)/h);
+    updateRubberBand();
+
+    // Our renderer counts from our bottom left rather than our top left
+    float x = 0.f, y = 0.f, rw = 1.f, rh = 1.f;
+    if(!m_renderRegion.isNull())
+    {
+        x = m_renderRegion.x();
+        y = 1.f-m_renderRegion.y()-m_renderRegion.height();
+        rw = m_renderRegion.width();
+        rh = m_renderRegion.height();
+    }
+    AbstractOptixRenderer *renderer = m_renderer;
+    renderer->getEditQueue()->push([=](){renderer->setRenderRegion(x,y,rw,rh);});
+    setRender(true);
+    update();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::updateRubberBand()
+{
+    if(m_renderRegion.isNull())
+    {
+        if(!m_selectingRegion) m_rubberBand->hide();
+        return;
+    }
+    m_rubberBand->setGeometry(QRectF(m_renderRegion.x()*width(),m_renderRegion.y()*height(),
+                                     m_renderRegion.width()*width(),m_renderRegion.height()*height()).toRect());
+    m_rubberBand->show();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::stopRendering()
+{
+    if(!m_renderThread) return;
+    m_renderThread->stop();
+    delete m_renderThread;
+    m_renderThread = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::setTimeOutDur(int _timeout)
+{
+    m_timedOut = _timeout;
+    if(m_renderThread) m_renderThread->setTimeOutDur(_timeout);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::setMaxFrames(int _maxFrames)
+{
+    m_maxFrames = (_maxFrames<0) ? 0 : _maxFrames;
+    if(m_renderThread) m_renderThread->setMaxFrames(m_maxFrames);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::setAutoSave(int _samples, QString _path, ImageExporter::Format _format)
+{
+    m_autoSaveSamples = (_samples<0) ? 0 : _samples;
+    m_autoSavePath = _path;
+    m_autoSaveFormat = _format;
+    if(m_renderThread) m_renderThread->setAutoSave(m_autoSaveSamples,m_autoSavePath.toStdString(),m_autoSaveFormat);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::setCheckpoint(QString _path, int _seconds)
+{
+    m_checkpointPath = _path;
+    m_checkpointInterval = (_seconds<0) ? 0 : _seconds;
+    // We resume once our first resize is queued so our checkpoint is restored at the size it was saved at
+    m_resumeCheckpoint = !_path.isEmpty() && QFileInfo(_path).exists();
+    if(m_renderThread) m_renderThread->setCheckpoint(m_checkpointPath.toStdString(),m_checkpointInterval);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::showEvent(QShowEvent *_event)
+{
+    QGLWidget::showEvent(_event);
+    if(m_renderThread) m_renderThread->setVisible(true);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::hideEvent(QHideEvent *_event)
+{
+    // No point rendering frames no one can see
+    if(m_renderThread) m_renderThread->setVisible(false);
+    QGLWidget::hideEvent(_event);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::setRender(bool _render)
+{
+    m_render = _render;
+    if(m_renderThread) m_renderThread->setRendering(_render);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::queueResize(int _width, int _height)
+{
+    InteractionRecorder::getInstance()->recordResize(_width,_height);
+    AbstractOptixRenderer *renderer = m_renderer;
+    unsigned long version = renderer->getEditQueue()->push(renderer,SceneEditQueue::Resize,[=](){renderer->resize(_width,_height);});
+    if(m_inputTime.time_since_epoch().count()) LatencyTracker::getInstance()->inputQueued(version,m_inputTime);
+    if(m_resumeCheckpoint && m_renderThread)
+    {
+        m_renderThread->resume(m_checkpointPath.toStdString());
+        m_resumeCheckpoint = false;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OpenGLWidget::queueGlobalTransform(float *_trans, float *_invTrans)
+{
+    // take copies of our matrices as they will be applied later on our render thread.
+    // Mouse moves faster than we can render are merged so only the latest transform is set.
+    float m[16], invM[16];
+    memcpy(m,_trans,sizeof(m));
+    memcpy(invM,_invTrans,sizeof(invM));
+    InteractionRecorder::getInstance()->recordTransform(m,invM);
+    AbstractOptixRenderer *renderer = m_renderer;
+    unsigned long version = renderer->getEditQueue()->push(renderer,SceneEditQueue::Transform,[=]() mutable {renderer->setTransform(m,invM,false);});
+    if(m_inputTime.time_since_epoch().count()) LatencyTracker::getInstance()->inputQueued(version,m_inputTime);
+}
+//----------------------------------------------------------------------------------------------------------------------